@@ -0,0 +1,33 @@
+//
+//  DCClassHierarchy.h
+//
+//  Created by Alexis Gallagher on 2012-08-26.
+//
+
+#import <Foundation/Foundation.h>
+
+// The subclasses of every class in the process, found without walking every class.
+//
+// Built the first time it is asked, from the runtime's class list: each class is
+// filed under its superclass. A query then walks down from the class asked about,
+// and costs in proportion to the answer. Classes registered since the last query,
+// by loaded bundles or at run time, e.g. by key-value observing, are filed in at the
+// next query; if classes were disposed of, it is built again.
+@interface DCClassHierarchy : NSObject
+{
+	CFMutableDictionaryRef subclassesByClass;		// class -> CFArray of its direct subclasses
+	CFMutableSetRef indexedClasses;
+	int indexedCount;
+}
+
+@property (nonatomic, readonly) NSUInteger classCount;
+
++ (DCClassHierarchy *)sharedHierarchy;
+
+// all the classes which inherit from parentClass, at any depth, without parentClass
+- (NSArray *)subclassesOfClass:(Class)parentClass;
+
+// files in the classes registered since the last call
+- (void)update;
+
+@end
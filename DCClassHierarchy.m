@@ -0,0 +1,103 @@
+//
+//  DCClassHierarchy.m
+//
+//  Created by Alexis Gallagher on 2012-08-26.
+//
+
+#import <objc/runtime.h>
+
+#import "DCClassHierarchy.h"
+
+@implementation DCClassHierarchy
+
++ (DCClassHierarchy *)sharedHierarchy
+{
+	static DCClassHierarchy *sharedHierarchy = nil;
+	if (!sharedHierarchy)
+		sharedHierarchy = [[DCClassHierarchy alloc] init];
+	return sharedHierarchy;
+}
+
+- (id)init
+{
+	self = [super init];
+	if (self)
+	{
+		subclassesByClass = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+		indexedClasses = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	CFRelease(subclassesByClass);
+	CFRelease(indexedClasses);
+
+	[super dealloc];
+}
+
+- (NSUInteger)classCount
+{
+	return CFSetGetCount(indexedClasses);
+}
+
+- (void)update
+{
+	int count = objc_getClassList(NULL, 0);
+	if (count == indexedCount)
+		return;
+
+	// a class was disposed of: its address may be reused, so start again
+	if (count < indexedCount)
+	{
+		CFDictionaryRemoveAllValues(subclassesByClass);
+		CFSetRemoveAllValues(indexedClasses);
+	}
+
+	Class *classes = malloc(sizeof(Class) * count);
+	count = objc_getClassList(classes, count);
+	for (int i = 0; i < count; i++)
+	{
+		Class class = classes[i];
+		Class superclass = class_getSuperclass(class);
+		if (!superclass || CFSetContainsValue(indexedClasses, class))
+			continue;
+		CFSetAddValue(indexedClasses, class);
+
+		CFMutableArrayRef subclasses = (CFMutableArrayRef)CFDictionaryGetValue(subclassesByClass, superclass);
+		if (!subclasses)
+		{
+			subclasses = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+			CFDictionarySetValue(subclassesByClass, superclass, subclasses);
+			CFRelease(subclasses);
+		}
+		CFArrayAppendValue(subclasses, class);
+	}
+	free(classes);
+	indexedCount = count;
+}
+
+- (void)addSubclassesOfClass:(Class)parentClass toArray:(NSMutableArray *)result
+{
+	CFArrayRef subclasses = CFDictionaryGetValue(subclassesByClass, parentClass);
+	if (!subclasses)
+		return;
+	for (CFIndex i = 0; i < CFArrayGetCount(subclasses); i++)
+	{
+		Class subclass = (Class)CFArrayGetValueAtIndex(subclasses, i);
+		[result addObject:subclass];
+		[self addSubclassesOfClass:subclass toArray:result];
+	}
+}
+
+- (NSArray *)subclassesOfClass:(Class)parentClass
+{
+	[self update];
+
+	NSMutableArray *result = [NSMutableArray array];
+	[self addSubclassesOfClass:parentClass toArray:result];
+	return result;
+}
+
+@end
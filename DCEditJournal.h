@@ -0,0 +1,66 @@
+//
+//  DCEditJournal.h
+//
+//  Created by Alexis Gallagher on 2012-08-28.
+//
+
+#import <UIKit/UIKit.h>
+
+// edits to the same view and property this close together are one edit, e.g. a run of key repeats
+#define kDCEditJournalMergeInterval 1.0
+
+typedef enum
+{
+	DCEditPropertyFrame,			// values are NSValues of CGRects
+	DCEditPropertyAlpha,			// values are NSNumbers
+} DCEditProperty;
+
+// A change of one property of one view
+@interface DCEdit : NSObject
+{
+	UIView *view;
+	DCEditProperty property;
+	NSValue *fromValue;
+	NSValue *toValue;
+	CFTimeInterval time;
+}
+
+@property (nonatomic, readonly) UIView *view;					// not retained
+@property (nonatomic, readonly) DCEditProperty property;
+@property (nonatomic, readonly) NSValue *fromValue;
+@property (nonatomic, readonly) NSValue *toValue;
+
+@end
+
+// The edits made to views through the introspector, in order, to be undone, redone and
+// logged as code, across as many views as were edited.
+//
+// Views are not retained. As DCObjectNameRegistry does for names, each edited view
+// carries a small associated object which takes its edits out of the journal when it is
+// deallocated.
+@interface DCEditJournal : NSObject
+{
+	NSMutableArray *edits;			// oldest first
+	NSMutableArray *undoneEdits;	// last undone last
+	CFMutableSetRef watchedViews;	// views carrying a sentinel
+}
+
+@property (nonatomic, readonly) NSUInteger editCount;
+@property (nonatomic, readonly) BOOL canUndo;
+@property (nonatomic, readonly) BOOL canRedo;
+
+// Records an edit already made. Clears what can be redone.
+- (void)recordEditOfView:(UIView *)view property:(DCEditProperty)property fromValue:(NSValue *)fromValue toValue:(NSValue *)toValue;
+
+// put the last edit's view back as it was, or as it was made again. The view, or nil if there was nothing to do.
+- (UIView *)undo;
+- (UIView *)redo;
+
+// Each property of each view changed, from its first value to its last, in the order they
+// were first edited: of view only, or of every view if view is nil. Properties which are
+// back where they started are left out.
+- (NSArray *)netEditsOfView:(UIView *)view;
+
+- (void)removeAllEdits;
+
+@end
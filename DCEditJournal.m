@@ -0,0 +1,281 @@
+//
+//  DCEditJournal.m
+//
+//  Created by Alexis Gallagher on 2012-08-28.
+//
+
+#import <objc/runtime.h>
+#import <QuartzCore/QuartzCore.h>
+
+#import "DCEditJournal.h"
+
+@interface DCEdit ()
+
+- (id)initWithView:(UIView *)aView property:(DCEditProperty)aProperty fromValue:(NSValue *)aFromValue toValue:(NSValue *)aToValue;
+- (void)setToValue:(NSValue *)aToValue time:(CFTimeInterval)aTime;
+- (CFTimeInterval)time;
+- (void)applyValue:(NSValue *)value;
+
+@end
+
+// Associated with an edited view, and deallocated with it
+@interface DCEditJournalSentinel : NSObject
+{
+	DCEditJournal *journal;			// not retained, nil once detached
+	void *view;
+}
+
+- (id)initWithJournal:(DCEditJournal *)aJournal view:(void *)aView;
+- (void)detach;
+
+@end
+
+@interface DCEditJournal ()
+
+- (void)forgetView:(void *)view;
+
+@end
+
+@implementation DCEdit
+@synthesize view, property, fromValue, toValue;
+
+- (id)initWithView:(UIView *)aView property:(DCEditProperty)aProperty fromValue:(NSValue *)aFromValue toValue:(NSValue *)aToValue
+{
+	self = [super init];
+	if (self)
+	{
+		view = aView;
+		property = aProperty;
+		fromValue = [aFromValue retain];
+		toValue = [aToValue retain];
+		time = CACurrentMediaTime();
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	[fromValue release];
+	[toValue release];
+
+	[super dealloc];
+}
+
+- (void)setToValue:(NSValue *)aToValue time:(CFTimeInterval)aTime
+{
+	[aToValue retain];
+	[toValue release];
+	toValue = aToValue;
+	time = aTime;
+}
+
+- (CFTimeInterval)time
+{
+	return time;
+}
+
+- (void)applyValue:(NSValue *)value
+{
+	if (property == DCEditPropertyFrame)
+		view.frame = [value CGRectValue];
+	else if (property == DCEditPropertyAlpha)
+		view.alpha = [(NSNumber *)value floatValue];
+}
+
+@end
+
+@implementation DCEditJournalSentinel
+
+- (id)initWithJournal:(DCEditJournal *)aJournal view:(void *)aView
+{
+	self = [super init];
+	if (self)
+	{
+		journal = aJournal;
+		view = aView;
+	}
+	return self;
+}
+
+- (void)detach
+{
+	journal = nil;
+}
+
+- (void)dealloc
+{
+	// the view is being deallocated: only its address may be used
+	[journal forgetView:view];
+
+	[super dealloc];
+}
+
+@end
+
+@implementation DCEditJournal
+
+- (id)init
+{
+	self = [super init];
+	if (self)
+	{
+		edits = [[NSMutableArray alloc] init];
+		undoneEdits = [[NSMutableArray alloc] init];
+		watchedViews = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	[self removeAllEdits];
+	[edits release];
+	[undoneEdits release];
+	CFRelease(watchedViews);
+
+	[super dealloc];
+}
+
+- (NSUInteger)editCount
+{
+	return edits.count;
+}
+
+- (BOOL)canUndo
+{
+	return edits.count > 0;
+}
+
+- (BOOL)canRedo
+{
+	return undoneEdits.count > 0;
+}
+
+#pragma mark Recording
+
+- (void)watchView:(UIView *)view
+{
+	if (CFSetContainsValue(watchedViews, view))
+		return;
+	CFSetAddValue(watchedViews, view);
+	DCEditJournalSentinel *sentinel = [[DCEditJournalSentinel alloc] initWithJournal:self view:view];
+	objc_setAssociatedObject(view, self, sentinel, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	[sentinel release];
+}
+
+- (void)recordEditOfView:(UIView *)view property:(DCEditProperty)property fromValue:(NSValue *)fromValue toValue:(NSValue *)toValue
+{
+	if (!view || [fromValue isEqual:toValue])
+		return;
+	[undoneEdits removeAllObjects];
+
+	CFTimeInterval now = CACurrentMediaTime();
+	DCEdit *lastEdit = [edits lastObject];
+	if (lastEdit.view == view && lastEdit.property == property && now - [lastEdit time] < kDCEditJournalMergeInterval)
+	{
+		[lastEdit setToValue:toValue time:now];
+		return;
+	}
+
+	[self watchView:view];
+	DCEdit *edit = [[DCEdit alloc] initWithView:view property:property fromValue:fromValue toValue:toValue];
+	[edits addObject:edit];
+	[edit release];
+}
+
+#pragma mark Undoing
+
+- (UIView *)undo
+{
+	DCEdit *edit = [edits lastObject];
+	if (!edit)
+		return nil;
+	[edit applyValue:edit.fromValue];
+	[undoneEdits addObject:edit];
+	[edits removeLastObject];
+	// nor are edits after an undo merged with the edit before it
+	DCEdit *lastEdit = [edits lastObject];
+	[lastEdit setToValue:lastEdit.toValue time:0.0];
+	return edit.view;
+}
+
+- (UIView *)redo
+{
+	DCEdit *edit = [undoneEdits lastObject];
+	if (!edit)
+		return nil;
+	[edit applyValue:edit.toValue];
+	// not merged with the edit before it, so that it can be undone on its own again
+	[edit setToValue:edit.toValue time:0.0];
+	[edits addObject:edit];
+	[undoneEdits removeLastObject];
+	return edit.view;
+}
+
+#pragma mark Reading
+
+- (NSArray *)netEditsOfView:(UIView *)view
+{
+	// the net edit of each view and property, by the index of its first edit
+	NSMutableArray *netEdits = [NSMutableArray array];
+	for (DCEdit *edit in edits)
+	{
+		if (view && edit.view != view)
+			continue;
+
+		NSUInteger index = [netEdits indexOfObjectPassingTest:^BOOL(DCEdit *netEdit, NSUInteger i, BOOL *stop) {
+			return netEdit.view == edit.view && netEdit.property == edit.property;
+		}];
+		if (index == NSNotFound)
+		{
+			DCEdit *netEdit = [[DCEdit alloc] initWithView:edit.view property:edit.property fromValue:edit.fromValue toValue:edit.toValue];
+			[netEdits addObject:netEdit];
+			[netEdit release];
+		}
+		else
+		{
+			[[netEdits objectAtIndex:index] setToValue:edit.toValue time:[edit time]];
+		}
+	}
+
+	NSIndexSet *unchanged = [netEdits indexesOfObjectsPassingTest:^BOOL(DCEdit *netEdit, NSUInteger i, BOOL *stop) {
+		return [netEdit.fromValue isEqual:netEdit.toValue];
+	}];
+	[netEdits removeObjectsAtIndexes:unchanged];
+	return netEdits;
+}
+
+#pragma mark Removing
+
+- (void)forgetView:(void *)view
+{
+	CFSetRemoveValue(watchedViews, view);
+	NSIndexSet *viewEdits = [edits indexesOfObjectsPassingTest:^BOOL(DCEdit *edit, NSUInteger i, BOOL *stop) {
+		return edit.view == view;
+	}];
+	[edits removeObjectsAtIndexes:viewEdits];
+	viewEdits = [undoneEdits indexesOfObjectsPassingTest:^BOOL(DCEdit *edit, NSUInteger i, BOOL *stop) {
+		return edit.view == view;
+	}];
+	[undoneEdits removeObjectsAtIndexes:viewEdits];
+}
+
+- (void)removeAllEdits
+{
+	CFIndex count = CFSetGetCount(watchedViews);
+	const void **views = malloc(MAX(count, 1) * sizeof(void *));
+	CFSetGetValues(watchedViews, views);
+	for (CFIndex i = 0; i < count; i++)
+	{
+		id view = (id)views[i];
+		[objc_getAssociatedObject(view, self) detach];
+		objc_setAssociatedObject(view, self, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+	}
+	free(views);
+	CFSetRemoveAllValues(watchedViews);
+
+	[edits removeAllObjects];
+	[undoneEdits removeAllObjects];
+}
+
+@end
@@ -15,16 +15,55 @@
 
 @end
 
-@interface DCFrameView : UIView
+// A view outline, in the frame view's coordinates
+typedef struct
+{
+	CGRect rect;
+	NSUInteger depth;		// in the view hierarchy, picks the outline's colour
+} DCOutline;
+
+typedef enum
 {
+	DCFrameViewDistanceLeft,
+	DCFrameViewDistanceRight,
+	DCFrameViewDistanceTop,
+	DCFrameViewDistanceBottom,
+	DCFrameViewDistanceCount
+} DCFrameViewDistance;
 
+@interface DCFrameView : UIView
+{
+	DCOutline *outlines;
+	NSUInteger outlineCount;
+	NSUInteger outlineCapacity;
+
+	// grid of square cells over the bounds. Each cell lists the outlines whose
+	// edges cross it, in gridEntries from gridCellStarts[cell] to gridCellStarts[cell + 1].
+	BOOL outlineGridIsStale;
+	CGSize gridSize;
+	NSUInteger gridColumns;
+	NSUInteger gridRows;
+	NSUInteger *gridCellStarts;
+	NSUInteger *gridEntries;
+
+	// scratch for drawing: the last draw each outline was seen in, and the outlines to stroke
+	NSUInteger *outlineStamps;
+	NSUInteger drawStamp;
+	NSUInteger *visibleOutlines;
+
+	// the distances from the main rect to the edges of the super rect, and their sizes,
+	// measured when the rects change rather than on every draw
+	BOOL distanceLabelsAreStale;
+	BOOL showsAntialiasingWarning;
+	NSString *distanceStrings[DCFrameViewDistanceCount];
+	CGSize distanceStringSizes[DCFrameViewDistanceCount];
 }
 
 @property (nonatomic, assign) id<DCFrameViewDelegate> delegate;
 @property (nonatomic) CGRect mainRect;
 @property (nonatomic) CGRect superRect;
 @property (nonatomic, retain) UILabel *touchPointLabel;
-@property (nonatomic, retain) NSMutableArray *rectsToOutline;
+@property (nonatomic, readonly) NSUInteger outlineCount;
 @property (nonatomic, retain) DCCrossHairView *touchPointView;
 
 ///////////
@@ -40,6 +79,14 @@
 - (void)setMainRect:(CGRect)newMainRect;
 - (void)setSuperRect:(CGRect)newSuperRect;
 
+//////////////
+// Outlines //
+//////////////
+
+// outlines are drawn instead of the main rect while there are any. Call setNeedsDisplay after changing them.
+- (void)addOutlineRect:(CGRect)rect depth:(NSUInteger)depth;
+- (void)removeAllOutlines;
+
 /////////////////////
 // Drawing/Display //
 /////////////////////
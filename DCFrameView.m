@@ -6,11 +6,18 @@
 
 #import "DCFrameView.h"
 
+// side of a cell of the outline grid, in points
+#define kDCFrameViewOutlineGridCellSize 64.0f
+// outline colours, picked by depth in the view hierarchy
+#define kDCFrameViewOutlineColorCount 8
+// distance label sizes kept, by string
+#define kDCFrameViewDistanceSizeCacheLimit 512
+
 @implementation DCFrameView
 @synthesize delegate;
 @synthesize mainRect, superRect;
 @synthesize touchPointLabel;
-@synthesize rectsToOutline;
+@synthesize outlineCount;
 @synthesize touchPointView;
 
 - (void)dealloc
@@ -18,6 +25,13 @@
 	self.delegate = nil;
 	[touchPointLabel release];
 	[touchPointView release];
+	free(outlines);
+	free(gridCellStarts);
+	free(gridEntries);
+	free(outlineStamps);
+	free(visibleOutlines);
+	for (NSUInteger i = 0; i < DCFrameViewDistanceCount; i++)
+		[distanceStrings[i] release];
 
 	[super dealloc];
 }
@@ -30,6 +44,7 @@
 	if (self)
 	{
 		self.delegate = aDelegate;
+		distanceLabelsAreStale = YES;
 		self.backgroundColor = [UIColor clearColor];
 		self.opaque = NO;
 
@@ -44,8 +59,6 @@
 		self.touchPointLabel.alpha = 0.0f;
 		[self addSubview:self.touchPointLabel];
 
-		self.rectsToOutline = [NSMutableArray array];
-
 		self.touchPointView = [[[DCCrossHairView alloc] initWithFrame:CGRectMake(0.0f, 0.0f, 17.0f, 17.0f) color:[UIColor blueColor]] autorelease];
 		self.touchPointView.alpha = 0.0f;
 		[self addSubview:self.touchPointView];
@@ -55,63 +68,264 @@
 
 #pragma Custom Setters
 
+// The area the main rect, its distance lines and their labels are drawn in
+- (CGRect)mainRectDrawingBounds
+{
+	if (CGRectIsEmpty(self.mainRect))
+		return CGRectNull;
+	return CGRectInset(CGRectUnion(self.mainRect, self.superRect), -20.0f, -20.0f);
+}
+
 - (void)setMainRect:(CGRect)newMainRect
 {
+	[self setNeedsDisplayInRect:[self mainRectDrawingBounds]];
 	mainRect = newMainRect;
-	[self setNeedsDisplay];
+	distanceLabelsAreStale = YES;
+	[self setNeedsDisplayInRect:[self mainRectDrawingBounds]];
 }
 
 - (void)setSuperRect:(CGRect)newSuperRect
 {
+	[self setNeedsDisplayInRect:[self mainRectDrawingBounds]];
 	superRect = newSuperRect;
-	[self setNeedsDisplay];
+	distanceLabelsAreStale = YES;
+	[self setNeedsDisplayInRect:[self mainRectDrawingBounds]];
 }
 
-#pragma Drawing/Display
+#pragma Outlines
 
-- (void)drawRect:(CGRect)rect
+- (void)addOutlineRect:(CGRect)rect depth:(NSUInteger)depth
 {
-	CGContextRef context = UIGraphicsGetCurrentContext();
+	if (outlineCount == outlineCapacity)
+	{
+		outlineCapacity = MAX(outlineCapacity * 2, 1024);
+		outlines = realloc(outlines, outlineCapacity * sizeof(DCOutline));
+	}
+	outlines[outlineCount].rect = rect;
+	outlines[outlineCount].depth = depth;
+	outlineCount++;
+	outlineGridIsStale = YES;
+}
+
+- (void)removeAllOutlines
+{
+	outlineCount = 0;
+	outlineGridIsStale = YES;
+}
 
-	if (self.rectsToOutline.count > 0)
+// Calls block with each cell an outline's edges cross, clipped to the grid
+static void DCFrameViewEnumerateEdgeCells(CGRect rect, NSUInteger columns, NSUInteger rows, void (^block)(NSUInteger cell))
+{
+	CGRect grid = CGRectMake(0.0f, 0.0f, columns * kDCFrameViewOutlineGridCellSize, rows * kDCFrameViewOutlineGridCellSize);
+	if (!CGRectIntersectsRect(rect, grid))
+		return;
+	NSInteger left = floorf(CGRectGetMinX(rect) / kDCFrameViewOutlineGridCellSize);
+	NSInteger right = floorf(CGRectGetMaxX(rect) / kDCFrameViewOutlineGridCellSize);
+	NSInteger top = floorf(CGRectGetMinY(rect) / kDCFrameViewOutlineGridCellSize);
+	NSInteger bottom = floorf(CGRectGetMaxY(rect) / kDCFrameViewOutlineGridCellSize);
+	for (NSInteger row = MAX(top, 0); row <= MIN(bottom, (NSInteger)rows - 1); row++)
 	{
-		for (NSValue *value in self.rectsToOutline)
+		BOOL horizontalEdge = row == top || row == bottom;
+		for (NSInteger column = MAX(left, 0); column <= MIN(right, (NSInteger)columns - 1); column++)
 		{
-			UIColor *randomColor = [UIColor colorWithRed:(arc4random() % 256) / 256.0f
-												   green:(arc4random() % 256) / 256.0f
-													blue:(arc4random() % 256) / 256.0f
-												   alpha:1.0f];
-			[randomColor set];
-			CGRect valueRect = [value CGRectValue];
-			valueRect = CGRectMake(valueRect.origin.x + 0.5f,
-                                   valueRect.origin.y + 0.5f,
-                                   valueRect.size.width - 1.0f,
-                                   valueRect.size.height - 1.0f);
-			CGContextStrokeRect(context, valueRect);
+			// inside the rect, only the cells of its edges
+			if (!horizontalEdge && column != left && column != right)
+			{
+				if (right > (NSInteger)columns - 1)
+					break;
+				column = right - 1;
+				continue;
+			}
+			block(row * columns + column);
+		}
+	}
+}
+
+// Sorts the outlines into the grid cells their edges cross
+- (void)rebuildOutlineGrid
+{
+	gridSize = self.bounds.size;
+	gridColumns = MAX(1, (NSUInteger)ceilf(gridSize.width / kDCFrameViewOutlineGridCellSize));
+	gridRows = MAX(1, (NSUInteger)ceilf(gridSize.height / kDCFrameViewOutlineGridCellSize));
+	NSUInteger cellCount = gridColumns * gridRows;
+
+	// count the entries of each cell, then place them
+	free(gridCellStarts);
+	gridCellStarts = calloc(cellCount + 1, sizeof(NSUInteger));
+	NSUInteger *starts = gridCellStarts;
+	for (NSUInteger i = 0; i < outlineCount; i++)
+		DCFrameViewEnumerateEdgeCells(outlines[i].rect, gridColumns, gridRows, ^(NSUInteger cell) {
+			starts[cell + 1]++;
+		});
+	for (NSUInteger cell = 0; cell < cellCount; cell++)
+		starts[cell + 1] += starts[cell];
+
+	free(gridEntries);
+	gridEntries = malloc(MAX(starts[cellCount], 1) * sizeof(NSUInteger));
+	NSUInteger *fill = calloc(cellCount, sizeof(NSUInteger));
+	NSUInteger *entries = gridEntries;
+	for (NSUInteger i = 0; i < outlineCount; i++)
+		DCFrameViewEnumerateEdgeCells(outlines[i].rect, gridColumns, gridRows, ^(NSUInteger cell) {
+			entries[starts[cell] + fill[cell]++] = i;
+		});
+	free(fill);
+
+	free(outlineStamps);
+	outlineStamps = calloc(MAX(outlineCount, 1), sizeof(NSUInteger));
+	drawStamp = 0;
+	free(visibleOutlines);
+	visibleOutlines = malloc(MAX(outlineCount, 1) * sizeof(NSUInteger));
+
+	outlineGridIsStale = NO;
+}
+
+// Strokes the outlines whose edges cross rect, with one path per colour
+- (void)drawOutlinesInRect:(CGRect)rect context:(CGContextRef)context
+{
+	static CGColorRef colors[kDCFrameViewOutlineColorCount];
+	if (!colors[0])
+		for (NSUInteger i = 0; i < kDCFrameViewOutlineColorCount; i++)
+			colors[i] = CGColorRetain([UIColor colorWithHue:(CGFloat)i / kDCFrameViewOutlineColorCount saturation:0.9f brightness:0.9f alpha:1.0f].CGColor);
+
+	if (outlineGridIsStale || !CGSizeEqualToSize(gridSize, self.bounds.size))
+		[self rebuildOutlineGrid];
+
+	// an outline can sit in several cells: stamp it the first time it is seen
+	drawStamp++;
+	NSUInteger visibleCount = 0;
+	NSInteger left = MAX(0, floorf(CGRectGetMinX(rect) / kDCFrameViewOutlineGridCellSize));
+	NSInteger right = MIN((NSInteger)gridColumns - 1, floorf(CGRectGetMaxX(rect) / kDCFrameViewOutlineGridCellSize));
+	NSInteger top = MAX(0, floorf(CGRectGetMinY(rect) / kDCFrameViewOutlineGridCellSize));
+	NSInteger bottom = MIN((NSInteger)gridRows - 1, floorf(CGRectGetMaxY(rect) / kDCFrameViewOutlineGridCellSize));
+	for (NSInteger row = top; row <= bottom; row++)
+	{
+		for (NSInteger column = left; column <= right; column++)
+		{
+			NSUInteger cell = row * gridColumns + column;
+			for (NSUInteger k = gridCellStarts[cell]; k < gridCellStarts[cell + 1]; k++)
+			{
+				NSUInteger i = gridEntries[k];
+				if (outlineStamps[i] == drawStamp)
+					continue;
+				outlineStamps[i] = drawStamp;
+
+				// skip outlines which hold all of rect between their edges
+				CGRect outline = outlines[i].rect;
+				if (CGRectIntersectsRect(outline, rect) && !CGRectContainsRect(CGRectInset(outline, 1.0f, 1.0f), rect))
+					visibleOutlines[visibleCount++] = i;
+			}
 		}
-		return;
 	}
 
-	if (CGRectIsEmpty(self.mainRect))
-		return;
+	for (NSUInteger color = 0; color < kDCFrameViewOutlineColorCount; color++)
+	{
+		BOOL hasPath = NO;
+		for (NSUInteger k = 0; k < visibleCount; k++)
+		{
+			const DCOutline *outline = &outlines[visibleOutlines[k]];
+			if (outline->depth % kDCFrameViewOutlineColorCount != color)
+				continue;
+			CGContextAddRect(context, CGRectMake(outline->rect.origin.x + 0.5f,
+												 outline->rect.origin.y + 0.5f,
+												 outline->rect.size.width - 1.0f,
+												 outline->rect.size.height - 1.0f));
+			hasPath = YES;
+		}
+		if (hasPath)
+		{
+			CGContextSetStrokeColorWithColor(context, colors[color]);
+			CGContextStrokePath(context);
+		}
+	}
+}
+
+#pragma Distance Labels
 
+static UIFont *DCFrameViewDistanceFont(void)
+{
+	static UIFont *font = nil;
+	if (!font)
+		font = [[UIFont systemFontOfSize:10.0f] retain];
+	return font;
+}
+
+// The size of a distance label. They are mostly the same few numbers, so they are measured once.
+static CGSize DCFrameViewDistanceStringSize(NSString *string)
+{
+	static NSMutableDictionary *sizes = nil;
+	if (!sizes)
+		sizes = [[NSMutableDictionary alloc] init];
+
+	NSValue *size = [sizes objectForKey:string];
+	if (size)
+		return [size CGSizeValue];
+
+	if (sizes.count >= kDCFrameViewDistanceSizeCacheLimit)
+		[sizes removeAllObjects];
+	CGSize stringSize = [string sizeWithFont:DCFrameViewDistanceFont()];
+	[sizes setObject:[NSValue valueWithCGSize:stringSize] forKey:string];
+	return stringSize;
+}
+
+- (void)setDistanceString:(NSString *)string forDistance:(DCFrameViewDistance)distance
+{
+	[distanceStrings[distance] release];
+	distanceStrings[distance] = [string retain];
+	distanceStringSizes[distance] = DCFrameViewDistanceStringSize(string);
+}
+
+- (void)updateDistanceLabels
+{
 	CGRect mainRectOffset = CGRectOffset(mainRect, -superRect.origin.x, -superRect.origin.y);
-	BOOL showAntialiasingWarning = NO;
+	showsAntialiasingWarning = NO;
 	if (! CGRectIsEmpty(self.superRect))
 	{
 		if ((mainRectOffset.origin.x != floorf(mainRectOffset.origin.x) && mainRect.origin.x != 0) || (mainRectOffset.origin.y != floor(mainRectOffset.origin.y) && mainRect.origin.y != 0))
-		showAntialiasingWarning = YES;
+		showsAntialiasingWarning = YES;
 	}
 
-	if (showAntialiasingWarning)
-	{
-		[[UIColor redColor] set];
+	if (showsAntialiasingWarning)
 		NSLog(@"DCIntrospect: *** WARNING: One or more values of this view's frame are non-integer values. This view will likely look blurry. ***");
+
+	CGRect adjustedMainRect = CGRectMake(self.mainRect.origin.x + 0.5f,
+										 self.mainRect.origin.y + 0.5f,
+										 self.mainRect.size.width - 1.0f,
+										 self.mainRect.size.height - 1.0f);
+
+	[self setDistanceString:(showsAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f", CGRectGetMinX(mainRectOffset)] : [NSString stringWithFormat:@"%.0f", CGRectGetMinX(mainRectOffset)]
+				forDistance:DCFrameViewDistanceLeft];
+	[self setDistanceString:(showsAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f", CGRectGetMaxX(self.superRect) - CGRectGetMaxX(adjustedMainRect) - 0.5] : [NSString stringWithFormat:@"%.0f", CGRectGetMaxX(self.superRect) - CGRectGetMaxX(adjustedMainRect) - 0.5]
+				forDistance:DCFrameViewDistanceRight];
+	[self setDistanceString:(showsAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f",  mainRectOffset.origin.y] : [NSString stringWithFormat:@"%.0f", mainRectOffset.origin.y]
+				forDistance:DCFrameViewDistanceTop];
+	[self setDistanceString:(showsAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f",  CGRectGetMaxY(self.superRect) - CGRectGetMaxY(mainRectOffset)] : [NSString stringWithFormat:@"%.0f", self.superRect.size.height - mainRectOffset.origin.y - mainRectOffset.size.height]
+				forDistance:DCFrameViewDistanceBottom];
+
+	distanceLabelsAreStale = NO;
+}
+
+#pragma Drawing/Display
+
+- (void)drawRect:(CGRect)rect
+{
+	CGContextRef context = UIGraphicsGetCurrentContext();
+
+	if (outlineCount > 0)
+	{
+		[self drawOutlinesInRect:rect context:context];
+		return;
 	}
+
+	if (CGRectIsEmpty(self.mainRect))
+		return;
+
+	if (distanceLabelsAreStale)
+		[self updateDistanceLabels];
+
+	if (showsAntialiasingWarning)
+		[[UIColor redColor] set];
 	else
-	{
 		[[UIColor blueColor] set];
-	}
 
 	CGRect adjustedMainRect = CGRectMake(self.mainRect.origin.x + 0.5f,
 										 self.mainRect.origin.y + 0.5f,
@@ -119,7 +333,7 @@
 										 self.mainRect.size.height - 1.0f);
 	CGContextStrokeRect(context, adjustedMainRect);
 
-	UIFont *font = [UIFont systemFontOfSize:10.0f];
+	UIFont *font = DCFrameViewDistanceFont();
 
 	float dash[2] = {3, 3};
 	CGContextSetLineDash(context, 0, dash, 2);
@@ -129,13 +343,12 @@
 	CGContextAddLineToPoint(context, CGRectGetMinX(adjustedMainRect), floorf(CGRectGetMidY(adjustedMainRect)) + 0.5f);
 	CGContextStrokePath(context);
 
-	NSString *leftDistanceString = (showAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f", CGRectGetMinX(mainRectOffset)] : [NSString stringWithFormat:@"%.0f", CGRectGetMinX(mainRectOffset)];
-	CGSize leftDistanceStringSize = [leftDistanceString sizeWithFont:font];
-	[leftDistanceString drawInRect:CGRectMake(CGRectGetMinX(superRect) + 1.0f,
-											  floorf(CGRectGetMidY(adjustedMainRect)) - leftDistanceStringSize.height,
-											  leftDistanceStringSize.width,
-											  leftDistanceStringSize.height)
-						  withFont:font];
+	CGSize leftDistanceStringSize = distanceStringSizes[DCFrameViewDistanceLeft];
+	[distanceStrings[DCFrameViewDistanceLeft] drawInRect:CGRectMake(CGRectGetMinX(superRect) + 1.0f,
+																	floorf(CGRectGetMidY(adjustedMainRect)) - leftDistanceStringSize.height,
+																	leftDistanceStringSize.width,
+																	leftDistanceStringSize.height)
+												withFont:font];
 
 	// right side->edge
 	if (CGRectGetMaxX(self.mainRect) < CGRectGetMaxX(self.superRect))
@@ -144,25 +357,23 @@
 		CGContextAddLineToPoint(context, CGRectGetMaxX(self.superRect), floorf(CGRectGetMidY(adjustedMainRect)) + 0.5f);
 		CGContextStrokePath(context);
 	}
-	NSString *rightDistanceString = (showAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f", CGRectGetMaxX(self.superRect) - CGRectGetMaxX(adjustedMainRect) - 0.5] : [NSString stringWithFormat:@"%.0f", CGRectGetMaxX(self.superRect) - CGRectGetMaxX(adjustedMainRect) - 0.5];
-	CGSize rightDistanceStringSize = [rightDistanceString sizeWithFont:font];
-	[rightDistanceString drawInRect:CGRectMake(CGRectGetMaxX(self.superRect) - rightDistanceStringSize.width - 1.0f,
-											   floorf(CGRectGetMidY(adjustedMainRect)) - 0.5f - rightDistanceStringSize.height,
-											   rightDistanceStringSize.width,
-											   rightDistanceStringSize.height)
-						   withFont:font];
+	CGSize rightDistanceStringSize = distanceStringSizes[DCFrameViewDistanceRight];
+	[distanceStrings[DCFrameViewDistanceRight] drawInRect:CGRectMake(CGRectGetMaxX(self.superRect) - rightDistanceStringSize.width - 1.0f,
+																	 floorf(CGRectGetMidY(adjustedMainRect)) - 0.5f - rightDistanceStringSize.height,
+																	 rightDistanceStringSize.width,
+																	 rightDistanceStringSize.height)
+												 withFont:font];
 
 	// edge->top side
 	CGContextMoveToPoint(context, floorf(CGRectGetMidX(adjustedMainRect)) + 0.5f, self.superRect.origin.y);
 	CGContextAddLineToPoint(context, floorf(CGRectGetMidX(adjustedMainRect)) + 0.5f, CGRectGetMinY(adjustedMainRect));
 	CGContextStrokePath(context);
-	NSString *topDistanceString = (showAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f",  mainRectOffset.origin.y] : [NSString stringWithFormat:@"%.0f", mainRectOffset.origin.y];
-	CGSize topDistanceStringSize = [topDistanceString sizeWithFont:font];
-	[topDistanceString drawInRect:CGRectMake(floorf(CGRectGetMidX(adjustedMainRect)) + 3.0f,
-											   floorf(CGRectGetMinY(self.superRect)),
-											   topDistanceStringSize.width,
-											   topDistanceStringSize.height)
-						   withFont:font];
+	CGSize topDistanceStringSize = distanceStringSizes[DCFrameViewDistanceTop];
+	[distanceStrings[DCFrameViewDistanceTop] drawInRect:CGRectMake(floorf(CGRectGetMidX(adjustedMainRect)) + 3.0f,
+																   floorf(CGRectGetMinY(self.superRect)),
+																   topDistanceStringSize.width,
+																   topDistanceStringSize.height)
+											   withFont:font];
 
 	// bottom side->edge
 	if (CGRectGetMaxY(self.mainRect) < CGRectGetMaxY(self.superRect))
@@ -171,13 +382,12 @@
 		CGContextAddLineToPoint(context, floorf(CGRectGetMidX(adjustedMainRect)) + 0.5f, CGRectGetMaxY(self.superRect));
 		CGContextStrokePath(context);
 	}
-	NSString *bottomDistanceString = (showAntialiasingWarning) ? [NSString stringWithFormat:@"%.1f",  CGRectGetMaxY(self.superRect) - CGRectGetMaxY(mainRectOffset)] : [NSString stringWithFormat:@"%.0f", self.superRect.size.height - mainRectOffset.origin.y - mainRectOffset.size.height];
-	CGSize bottomDistanceStringSize = [bottomDistanceString sizeWithFont:font];
-	[bottomDistanceString drawInRect:CGRectMake(floorf(CGRectGetMidX(adjustedMainRect)) + 3.0f,
-												floorf(CGRectGetMaxY(self.superRect)) - bottomDistanceStringSize.height - 1.0f,
-												bottomDistanceStringSize.width,
-												bottomDistanceStringSize.height)
-							withFont:font];
+	CGSize bottomDistanceStringSize = distanceStringSizes[DCFrameViewDistanceBottom];
+	[distanceStrings[DCFrameViewDistanceBottom] drawInRect:CGRectMake(floorf(CGRectGetMidX(adjustedMainRect)) + 3.0f,
+																	  floorf(CGRectGetMaxY(self.superRect)) - bottomDistanceStringSize.height - 1.0f,
+																	  bottomDistanceStringSize.width,
+																	  bottomDistanceStringSize.height)
+												  withFont:font];
 
 }
 
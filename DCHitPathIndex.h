@@ -0,0 +1,54 @@
+//
+//  DCHitPathIndex.h
+//
+//  Created by Alexis Gallagher on 2012-08-24.
+//
+
+#import <UIKit/UIKit.h>
+
+// A view and its frame in the coordinates of the index's root view
+typedef struct
+{
+	UIView *view;			// not retained
+	CGRect frame;
+	NSUInteger end;			// index of the first node after the view's subtree
+} DCHitPathNode;
+
+// Answers touchAtPoint: without walking the view hierarchy.
+//
+// Holds the frames of all the views under a root view, in the root's coordinates,
+// in one array in depth first order. A point query skips every subtree whose view
+// does not contain the point, like -[DCIntrospect viewsAtPoint:inView:], but
+// allocates nothing and converts no points.
+//
+// While an index is alive, UIView is hooked so that a view which is laid out, moved,
+// resized, transformed, or gains, loses or reorders subviews marks itself dirty.
+// Dirty subtrees are rebuilt at the next query. Changes made directly to layers
+// are not seen: call setNeedsUpdateForView: after them. The hooks are removed when
+// the last index is deallocated. Indexes must be created and released on the main
+// thread.
+//
+// An index retains its root view.
+@interface DCHitPathIndex : NSObject
+{
+	UIView *rootView;		// retained
+	NSArray *ignoredViews;
+	DCHitPathNode *nodes;
+	NSUInteger nodeCount;
+	NSUInteger nodeCapacity;
+	CFMutableSetRef dirtyViews;
+}
+
+@property (nonatomic, readonly) UIView *rootView;
+@property (nonatomic, readonly) NSUInteger nodeCount;
+@property (nonatomic, readonly) NSUInteger subtreeRebuildCount;
+
+// ignoredViews are left out of the index, with their subviews
+- (id)initWithRootView:(UIView *)aRootView ignoredViews:(NSArray *)someIgnoredViews;
+
+// the frontmost, deepest view under point, in the root view's coordinates, or nil
+- (UIView *)topmostViewAtPoint:(CGPoint)point;
+
+- (void)setNeedsUpdateForView:(UIView *)view;
+
+@end
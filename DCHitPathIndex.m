@@ -0,0 +1,317 @@
+//
+//  DCHitPathIndex.m
+//
+//  Created by Alexis Gallagher on 2012-08-24.
+//
+
+#import <objc/runtime.h>
+
+#import "DCHitPathIndex.h"
+
+// the indexes the UIView hooks report to, not retained
+static CFMutableArrayRef liveIndexes = NULL;
+
+static void DCHitPathViewDidChange(UIView *view)
+{
+	// hooks left installed while there is no index, see unhookViewChanges
+	if (!liveIndexes || CFArrayGetCount(liveIndexes) == 0)
+		return;
+	for (CFIndex i = 0; i < CFArrayGetCount(liveIndexes); i++)
+		[(DCHitPathIndex *)CFArrayGetValueAtIndex(liveIndexes, i) setNeedsUpdateForView:view];
+}
+
+@interface DCHitPathIndex ()
+
+@property (nonatomic, readwrite) NSUInteger subtreeRebuildCount;
+
+@end
+
+@implementation DCHitPathIndex
+@synthesize rootView, nodeCount;
+@synthesize subtreeRebuildCount;
+
+#pragma mark Hooks
+
+#define DCHitPathHookCount 10
+
+// pairs of a UIView selector and its hook
+static SEL hookedSelectors[DCHitPathHookCount][2];
+
+// the implementations of the hooked selectors while hooked, or NULL
+static IMP hookIMPs[DCHitPathHookCount];
+
+static void DCHitPathExchangeHooks(void)
+{
+	for (unsigned int i = 0; i < DCHitPathHookCount; i++)
+		method_exchangeImplementations(class_getInstanceMethod([UIView class], hookedSelectors[i][0]),
+									   class_getInstanceMethod([UIView class], hookedSelectors[i][1]));
+}
+
+// Hooks UIView while an index exists, for every view in the app. Main thread only.
++ (void)hookViewChanges
+{
+	if (hookIMPs[0])
+		return;
+	if (!hookedSelectors[0][0])
+	{
+		SEL selectors[DCHitPathHookCount][2] = {
+			{ @selector(layoutSubviews), @selector(dc_hitPathLayoutSubviews) },
+			{ @selector(didAddSubview:), @selector(dc_hitPathDidAddSubview:) },
+			{ @selector(willRemoveSubview:), @selector(dc_hitPathWillRemoveSubview:) },
+			{ @selector(bringSubviewToFront:), @selector(dc_hitPathBringSubviewToFront:) },
+			{ @selector(sendSubviewToBack:), @selector(dc_hitPathSendSubviewToBack:) },
+			{ @selector(exchangeSubviewAtIndex:withSubviewAtIndex:), @selector(dc_hitPathExchangeSubviewAtIndex:withSubviewAtIndex:) },
+			{ @selector(setFrame:), @selector(dc_hitPathSetFrame:) },
+			{ @selector(setBounds:), @selector(dc_hitPathSetBounds:) },
+			{ @selector(setCenter:), @selector(dc_hitPathSetCenter:) },
+			{ @selector(setTransform:), @selector(dc_hitPathSetTransform:) },
+		};
+		memcpy(hookedSelectors, selectors, sizeof(selectors));
+	}
+	DCHitPathExchangeHooks();
+	for (unsigned int i = 0; i < DCHitPathHookCount; i++)
+		hookIMPs[i] = method_getImplementation(class_getInstanceMethod([UIView class], hookedSelectors[i][0]));
+}
+
+// Unhooks UIView once the last index is gone. If other code has exchanged
+// the same methods since, exchanging them back would mix up both chains, so
+// the hooks stay, reduced to a check for live indexes.
++ (void)unhookViewChanges
+{
+	if (!hookIMPs[0])
+		return;
+	for (unsigned int i = 0; i < DCHitPathHookCount; i++)
+		if (method_getImplementation(class_getInstanceMethod([UIView class], hookedSelectors[i][0])) != hookIMPs[i])
+			return;
+	DCHitPathExchangeHooks();
+	memset(hookIMPs, 0, sizeof(hookIMPs));
+}
+
+#pragma mark Setup
+
+- (id)initWithRootView:(UIView *)aRootView ignoredViews:(NSArray *)someIgnoredViews
+{
+	self = [super init];
+	if (self)
+	{
+		rootView = [aRootView retain];
+		ignoredViews = [someIgnoredViews copy];
+		dirtyViews = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+		[DCHitPathIndex hookViewChanges];
+		if (!liveIndexes)
+			liveIndexes = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+		CFArrayAppendValue(liveIndexes, self);
+		[self setNeedsUpdateForView:rootView];
+		[self updateIfNeeded];
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	CFArrayRemoveValueAtIndex(liveIndexes, CFArrayGetFirstIndexOfValue(liveIndexes, CFRangeMake(0, CFArrayGetCount(liveIndexes)), self));
+	if (CFArrayGetCount(liveIndexes) == 0)
+		[DCHitPathIndex unhookViewChanges];
+	free(nodes);
+	CFRelease(dirtyViews);
+	[ignoredViews release];
+	[rootView release];
+
+	[super dealloc];
+}
+
+#pragma mark Building
+
+- (void)reserve:(NSUInteger)count
+{
+	if (nodeCount + count <= nodeCapacity)
+		return;
+	NSUInteger capacity = MAX(nodeCapacity * 2, 256);
+	while (capacity < nodeCount + count)
+		capacity *= 2;
+	nodes = realloc(nodes, capacity * sizeof(DCHitPathNode));
+	nodeCapacity = capacity;
+}
+
+// Appends nodes for view, unless it is ignored, and its subviews, to the end of the array
+- (void)appendView:(UIView *)view
+{
+	if ([ignoredViews indexOfObjectIdenticalTo:view] != NSNotFound)
+		return;
+
+	[self reserve:1];
+	NSUInteger index = nodeCount++;
+	nodes[index].view = view;
+	nodes[index].frame = [view.superview convertRect:view.frame toView:rootView];
+	for (UIView *subview in view.subviews)
+		[self appendView:subview];
+	nodes[index].end = nodeCount;
+}
+
+// Replaces the nodes from index to end with those of view's subtree, as it is now
+- (void)rebuildRangeFrom:(NSUInteger)index to:(NSUInteger)end withView:(UIView *)view
+{
+	// build the new nodes past the end of the array, then move them into place
+	NSUInteger tail = nodeCount;
+	[self appendView:view];
+	NSUInteger newCount = nodeCount - tail;
+	NSInteger delta = (NSInteger)newCount - (NSInteger)(end - index);
+
+	DCHitPathNode *built = malloc(MAX(newCount, 1) * sizeof(DCHitPathNode));
+	memcpy(built, nodes + tail, newCount * sizeof(DCHitPathNode));
+	nodeCount = tail;
+
+	if (delta > 0)
+		[self reserve:delta];
+	memmove(nodes + end + delta, nodes + end, (nodeCount - end) * sizeof(DCHitPathNode));
+	for (NSUInteger i = 0; i < newCount; i++)
+	{
+		nodes[index + i] = built[i];
+		nodes[index + i].end = built[i].end - tail + index;
+	}
+	free(built);
+	nodeCount += delta;
+
+	// ancestors of the range, and everything after it, shift along
+	for (NSUInteger i = 0; i < index; i++)
+		if (nodes[i].end >= end)
+			nodes[i].end += delta;
+	for (NSUInteger i = index + newCount; i < nodeCount; i++)
+		nodes[i].end += delta;
+
+	self.subtreeRebuildCount++;
+}
+
+- (void)updateIfNeeded
+{
+	if (CFSetGetCount(dirtyViews) == 0)
+		return;
+
+	if (CFSetContainsValue(dirtyViews, rootView))
+	{
+		nodeCount = 0;
+		for (UIView *subview in rootView.subviews)
+			[self appendView:subview];
+		self.subtreeRebuildCount++;
+		CFSetRemoveAllValues(dirtyViews);
+		return;
+	}
+
+	// the outermost dirty subtrees. Views inside them may be gone, so only
+	// their addresses are looked at. A view which left its superview made the
+	// superview dirty, so the outermost ones are all still in place.
+	NSUInteger *roots = malloc(CFSetGetCount(dirtyViews) * sizeof(NSUInteger));
+	NSUInteger rootCount = 0;
+	NSUInteger coveredEnd = 0;
+	for (NSUInteger i = 0; i < nodeCount; i++)
+	{
+		if (i < coveredEnd || !CFSetContainsValue(dirtyViews, nodes[i].view))
+			continue;
+		roots[rootCount++] = i;
+		coveredEnd = nodes[i].end;
+	}
+	CFSetRemoveAllValues(dirtyViews);
+
+	// last first, so rebuilding one does not move the others
+	while (rootCount > 0)
+	{
+		NSUInteger index = roots[--rootCount];
+		[self rebuildRangeFrom:index to:nodes[index].end withView:nodes[index].view];
+	}
+	free(roots);
+}
+
+- (void)setNeedsUpdateForView:(UIView *)view
+{
+	CFSetAddValue(dirtyViews, view);
+}
+
+#pragma mark Queries
+
+- (UIView *)topmostViewAtPoint:(CGPoint)point
+{
+	[self updateIfNeeded];
+
+	// the last view in depth first order which, like all its ancestors, contains point
+	UIView *topmost = nil;
+	NSUInteger i = 0;
+	while (i < nodeCount)
+	{
+		if (CGRectContainsPoint(nodes[i].frame, point))
+		{
+			topmost = nodes[i].view;
+			i++;
+		}
+		else
+		{
+			i = nodes[i].end;
+		}
+	}
+	return topmost;
+}
+
+@end
+
+@implementation UIView (DCHitPathIndex)
+
+- (void)dc_hitPathLayoutSubviews
+{
+	[self dc_hitPathLayoutSubviews];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathDidAddSubview:(UIView *)subview
+{
+	[self dc_hitPathDidAddSubview:subview];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathWillRemoveSubview:(UIView *)subview
+{
+	[self dc_hitPathWillRemoveSubview:subview];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathBringSubviewToFront:(UIView *)subview
+{
+	[self dc_hitPathBringSubviewToFront:subview];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathSendSubviewToBack:(UIView *)subview
+{
+	[self dc_hitPathSendSubviewToBack:subview];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathExchangeSubviewAtIndex:(NSInteger)index1 withSubviewAtIndex:(NSInteger)index2
+{
+	[self dc_hitPathExchangeSubviewAtIndex:index1 withSubviewAtIndex:index2];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathSetFrame:(CGRect)frame
+{
+	[self dc_hitPathSetFrame:frame];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathSetBounds:(CGRect)bounds
+{
+	[self dc_hitPathSetBounds:bounds];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathSetCenter:(CGPoint)center
+{
+	[self dc_hitPathSetCenter:center];
+	DCHitPathViewDidChange(self);
+}
+
+- (void)dc_hitPathSetTransform:(CGAffineTransform)transform
+{
+	[self dc_hitPathSetTransform:transform];
+	DCHitPathViewDidChange(self);
+}
+
+@end
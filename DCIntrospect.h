@@ -14,6 +14,13 @@
 #import "DCIntrospectSettings.h"
 #import "DCFrameView.h"
 #import "DCStatusBarOverlay.h"
+#import "DCHitPathIndex.h"
+#import "DCObjectNameRegistry.h"
+#import "DCPropertyPlan.h"
+#import "DCClassHierarchy.h"
+#import "DCRedrawTracker.h"
+#import "DCSnapshotWriter.h"
+#import "DCEditJournal.h"
 
 #ifdef DEBUG
 
@@ -25,8 +32,26 @@
 
 #endif
 
+// Nudges waiting for the next frame: steps of the frame, and of alpha
+typedef struct
+{
+	CGFloat dx, dy, dWidth, dHeight;
+	NSInteger alphaSteps;
+} DCNudge;
+
 @interface DCIntrospect : NSObject <DCFrameViewDelegate, UITextViewDelegate, UIWebViewDelegate>
 {
+	// key repeat nudges faster than the screen refreshes: they add up here and are applied once a frame
+	DCNudge pendingNudge;
+	UIView *nudgedView;							// not retained
+	CADisplayLink *nudgeLink;					// while nudges are coming
+
+	// from the nudged view's superview to the frame view, kept while nudges are coming
+	BOOL nudgeGeometryIsStale;
+	UIView *nudgeGeometrySuperview;				// not retained
+	CGAffineTransform nudgeGeometryTransform;
+
+	UIView *statusBarView;						// the view the status bar's name is of, nil if it shows something else
 }
 
 @property (nonatomic) BOOL keyboardBindingsOn;									// default: YES
@@ -38,15 +63,22 @@
 @property (nonatomic) BOOL viewOutlines;
 @property (nonatomic) BOOL highlightNonOpaqueViews;
 @property (nonatomic) BOOL flashOnRedraw;
+@property (nonatomic, retain) DCRedrawTracker *redrawTracker;				// flash layers and redraw counts
 @property (nonatomic, retain) DCFrameView *frameView;
 @property (nonatomic, retain) UITextView *inputTextView;
 @property (nonatomic, retain) DCStatusBarOverlay *statusBarOverlay;
+@property (nonatomic, retain) DCHitPathIndex *hitPathIndex;					// frames of the main window's views, while on
+
+@property (nonatomic, retain) DCSnapshotWriter *snapshotWriter;				// while snapshots are being written
+@property (nonatomic, copy) DCSnapshotRolesBlock snapshotRolesOfView;			// default: nil. The drag and drop roles snapshots record, as DCSnapshotRole bits.
 
-@property (nonatomic, retain) NSMutableDictionary *objectNames;
+@property (nonatomic, retain) DCObjectNameRegistry *objectNames;
+@property (nonatomic) BOOL autoNamesViewControllerIvars;						// default: NO. Names views after the ivars of their view controllers when selected.
 
 @property (nonatomic, assign) UIView *currentView;
-@property (nonatomic) CGRect originalFrame;
+@property (nonatomic) CGRect originalFrame;								// as the current view was when selected
 @property (nonatomic) CGFloat originalAlpha;
+@property (nonatomic, retain) DCEditJournal *editJournal;					// the frame and alpha changes made with the keys, to every view
 @property (nonatomic, retain) NSMutableArray *currentViewHistory;
 
 @property (nonatomic) BOOL showingHelp;
@@ -86,12 +118,17 @@
 /////////////////////////////////
 
 - (void)logCodeForCurrentViewChanges;
+- (void)logCodeForAllViewChanges;
+- (void)undoEdit;
+- (void)redoEdit;
 
-// make sure all names that are added are removed at dealloc or else they will be retained here!
+// objects are not retained, and their names are removed when they are deallocated
 - (void)setName:(NSString *)name forObject:(id)object accessedWithSelf:(BOOL)accessedWithSelf;
+- (void)setNamesForObjects:(NSDictionary *)objectsByName accessedWithSelf:(BOOL)accessedWithSelf;
 - (NSString *)nameForObject:(id)object;
 - (void)removeNamesForViewsInView:(UIView *)view;
 - (void)removeNameForObject:(id)object;
+- (void)nameViewControllerIvarsForView:(UIView *)view;
 
 ////////////
 // Layout //
@@ -100,6 +137,7 @@
 - (void)updateFrameView;
 - (void)updateStatusBar;
 - (void)updateViews;
+- (void)applyPendingNudge;					// called once a frame while nudging, and before anything that reads the current view
 - (void)showTemporaryStringInStatusBar:(NSString *)string;
 
 /////////////
@@ -118,6 +156,12 @@
 - (void)toggleRedrawFlashing;
 - (void)callDrawRectOnViewsInSubview:(UIView *)subview;
 - (void)flashRect:(CGRect)rect inView:(UIView *)view;
+- (void)toggleRedrawHeatmap;
+- (void)logRedrawHeatmap;
+- (BOOL)exportRedrawHeatmapToPath:(NSString *)path;			// JSON, while the heatmap is on
+- (void)startSnapshotsToPath:(NSString *)path;					// replaces the file
+- (void)writeSnapshot;											// of the main window, incremental after the first. Starts snapshots to Documents/DCIntrospect.dcsnap if need be.
+- (void)stopSnapshots;
 
 /////////////////////////////
 // (Somewhat) Experimental //
@@ -125,8 +169,12 @@
 
 - (void)logPropertiesForCurrentView;
 - (void)logPropertiesForObject:(id)object;
+- (NSString *)propertiesDescriptionForObject:(id)object;
 - (void)logAccessabilityPropertiesForObject:(id)object;
-- (NSArray *)subclassesOfClass:(Class)parentClass;
+- (NSArray *)subclassesOfClass:(Class)parentClass;		// from an index of the class hierarchy, built on the first call
+- (void)logHitPathBenchmark;					// logs the cost of a touch query, with and without the hit path index, for trees of 100 to 10000 views
+- (void)logClassHierarchyBenchmark;				// logs the cost of the startup class scan this used to make, and of subclass queries with and without the index
+- (void)logPropertyDumpBenchmark;				// logs how many times a second the properties of a 10000 view tree can be described
 
 /////////////////////////
 // Description Methods //
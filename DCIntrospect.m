@@ -59,6 +59,12 @@ static bool AmIBeingDebugged(void)
 @interface DCIntrospect ()
 
 - (void)takeFirstResponder;
+- (void)addNudge:(DCNudge)nudge;
+- (CGRect)nudgedFrame;
+- (void)showEditOfView:(UIView *)view string:(NSString *)string;
+- (NSString *)codeForEdits:(NSArray *)edits commentingViews:(BOOL)commentingViews;
+- (void)updateFrameViewForNudge;
+- (void)updateStatusBarFrame;
 
 @end
 
@@ -71,10 +77,14 @@ DCIntrospect *sharedInstance = nil;
 @synthesize handleArrowKeys;
 @synthesize viewOutlines, highlightNonOpaqueViews, flashOnRedraw;
 @synthesize statusBarOverlay;
+@synthesize redrawTracker;
+@synthesize snapshotWriter, snapshotRolesOfView;
+@synthesize hitPathIndex;
 @synthesize inputTextView;
 @synthesize frameView;
-@synthesize objectNames;
+@synthesize objectNames, autoNamesViewControllerIvars;
 @synthesize currentView, originalFrame, originalAlpha;
+@synthesize editJournal;
 @synthesize currentViewHistory;
 @synthesize showingHelp;
 
@@ -137,28 +147,33 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 }
 
 // See http://stackoverflow.com/questions/6617472/why-does-valueforkey-on-a-uitextfield-throws-an-exception-for-uitextinputtraits
-+ (void)workaroundUITextInputTraitsPropertiesBug
+// Done for a class, and its superclasses, the first time it is introspected, rather than
+// for every class in the process at startup.
++ (void)workaroundUITextInputTraitsPropertiesBugForClass:(Class)class
 {
+	static CFMutableSetRef checkedClasses = NULL;
+	if (!checkedClasses)
+		checkedClasses = CFSetCreateMutable(kCFAllocatorDefault, 0, NULL);
+	if (!class || CFSetContainsValue(checkedClasses, class))
+		return;
+	CFSetAddValue(checkedClasses, class);
+	
+	// textInputTraits is inherited: if class has none, neither have its superclasses
+	if (!class_getInstanceMethod(class, NSSelectorFromString(@"textInputTraits")))
+		return;
+	
+	// superclasses first, so that class chains to their replacement
+	[self workaroundUITextInputTraitsPropertiesBugForClass:class_getSuperclass(class)];
+	
 	Method valueForKey = class_getInstanceMethod([NSObject class], @selector(valueForKey:));
 	const char *valueForKeyTypeEncoding = method_getTypeEncoding(valueForKey);
+	IMP originalValueForKey = class_replaceMethod(class, @selector(valueForKey:), (IMP)UITextInputTraits_valueForKey, valueForKeyTypeEncoding);
+	if (!originalValueForKey)
+		originalValueForKey = [objc_getAssociatedObject([class superclass], originalValueForKeyIMPKey) pointerValue];
+	if (!originalValueForKey)
+		originalValueForKey = class_getMethodImplementation([class superclass], @selector(valueForKey:));
 	
-	unsigned int count = 0;
-	Class *classes = objc_copyClassList(&count);
-	for (unsigned int i = 0; i < count; i++)
-	{
-		Class class = classes[i];
-		if (class_getInstanceMethod(class, NSSelectorFromString(@"textInputTraits")))
-		{
-			IMP originalValueForKey = class_replaceMethod(class, @selector(valueForKey:), (IMP)UITextInputTraits_valueForKey, valueForKeyTypeEncoding);
-			if (!originalValueForKey)
-				originalValueForKey = [objc_getAssociatedObject([class superclass], originalValueForKeyIMPKey) pointerValue];
-			if (!originalValueForKey)
-				originalValueForKey = class_getMethodImplementation([class superclass], @selector(valueForKey:));
-			
-			objc_setAssociatedObject(class, originalValueForKeyIMPKey, [NSValue valueWithPointer:originalValueForKey], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
-		}
-	}
-	free(classes);
+	objc_setAssociatedObject(class, originalValueForKeyIMPKey, [NSValue valueWithPointer:originalValueForKey], OBJC_ASSOCIATION_RETAIN_NONATOMIC);
 }
 
 + (DCIntrospect *)sharedIntrospector
@@ -169,7 +184,6 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		sharedInstance = [[DCIntrospect alloc] init];
 		sharedInstance.keyboardBindingsOn = YES;
 		sharedInstance.showStatusBarOverlay = ![UIApplication sharedApplication].statusBarHidden;
-		[self workaroundUITextInputTraitsPropertiesBug];
 	}
 #endif
 	return sharedInstance;
@@ -240,7 +254,9 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 
 - (void)resetInputTextView
 {
-	self.inputTextView.text = @"\n2 4567 9\n";
+	// setting the text lays it out again, even if it is the same
+	if (![self.inputTextView.text isEqualToString:@"\n2 4567 9\n"])
+		self.inputTextView.text = @"\n2 4567 9\n";
 	self.handleArrowKeys = NO;
 	self.inputTextView.selectedRange = NSMakeRange(5, 0);
 	self.handleArrowKeys = YES;
@@ -276,10 +292,14 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	
 	if (self.on)
 	{
+		nudgeGeometryIsStale = YES;
 		[self updateViews];
 		[self updateStatusBar];
 		[self updateFrameView];
 		
+		self.hitPathIndex = [[[DCHitPathIndex alloc] initWithRootView:[self mainWindow]
+														ignoredViews:[NSArray arrayWithObjects:self.frameView, self.inputTextView, nil]] autorelease];
+		
 		if (keyboardBindingsOn)
 			[self.inputTextView becomeFirstResponder];
 		else
@@ -292,6 +312,7 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	}
 	else
 	{
+		[self applyPendingNudge];
 		if (self.viewOutlines)
 			[self toggleOutlines];
 		if (self.highlightNonOpaqueViews)
@@ -302,6 +323,7 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		self.statusBarOverlay.hidden = YES;
 		self.frameView.alpha = 0;
 		self.currentView = nil;
+		self.hitPathIndex = nil;
 		
 		[[NSNotificationCenter defaultCenter] postNotificationName:kDCIntrospectNotificationIntrospectionDidEnd
 															object:nil];
@@ -313,30 +335,43 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	// convert the point into the main window
 	CGPoint convertedTouchPoint = [[self mainWindow] convertPoint:point fromView:self.frameView];
 	
-	// find all the views under that point – will be added in order on screen, ie mainWindow will be index 0, main view controller at index 1 etc.
-	NSMutableArray *views = [self viewsAtPoint:convertedTouchPoint inView:[self mainWindow]];
-	if (views.count == 0)
+	// find the topmost view under that point, from the index while introspecting
+	UIView *newView = nil;
+	if (self.hitPathIndex.rootView == [self mainWindow])
+	{
+		newView = [self.hitPathIndex topmostViewAtPoint:convertedTouchPoint];
+	}
+	else
+	{
+		// find all the views under that point – will be added in order on screen, ie mainWindow will be index 0, main view controller at index 1 etc.
+		newView = [[self viewsAtPoint:convertedTouchPoint inView:[self mainWindow]] lastObject];
+	}
+	if (!newView)
 		return;
 	
-	// get the topmost view and setup the UI
+	// setup the UI
 	[self.currentViewHistory removeAllObjects];
-	UIView *newView = [views lastObject];
 	[self selectView:newView];
 }
 
 - (void)selectView:(UIView *)view
 {
+	[self applyPendingNudge];
+	nudgeGeometryIsStale = YES;
 	self.currentView = view;
 	self.originalFrame = self.currentView.frame;
 	self.originalAlpha = self.currentView.alpha;
 	
-	if (self.frameView.rectsToOutline.count > 0)
+	if (self.frameView.outlineCount > 0)
 	{
-		[self.frameView.rectsToOutline removeAllObjects];
+		[self.frameView removeAllOutlines];
 		[self.frameView setNeedsDisplay];
 		self.viewOutlines = NO;
 	}
 	
+	if (self.autoNamesViewControllerIvars)
+		[self nameViewControllerIvarsForView:view];
+	
 	[self updateFrameView];
 	[self updateStatusBar];
 	
@@ -365,48 +400,43 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	BOOL shiftKey = selectionLength != 0;
 	BOOL optionKey = selectionLocation % 2 == 1;
 	
-	CGRect frame = self.currentView.frame;
+	DCNudge nudge = { 0 };
 	if (shiftKey)
 	{
 		if (selectionLocation == 4 && selectionLength == 1)
-			frame.origin.x -= 10.0f;
+			nudge.dx = -10.0f;
 		else if (selectionLocation == 5 && selectionLength == 1)
-			frame.origin.x += 10.0f;
+			nudge.dx = 10.0f;
 		else if (selectionLocation == 0 && selectionLength == 5)
-			frame.origin.y -= 10.0f;
+			nudge.dy = -10.0f;
 		else if (selectionLocation == 5 && selectionLength == 5)
-			frame.origin.y += 10.0f;
+			nudge.dy = 10.0f;
 	}
 	else if (optionKey)
 	{
 		if (selectionLocation == 7)
-			frame.size.width += 1.0f;
+			nudge.dWidth = 1.0f;
 		else if (selectionLocation == 3)
-			frame.size.width -= 1.0f;
+			nudge.dWidth = -1.0f;
 		else if (selectionLocation == 9)
-			frame.size.height += 1.0f;
+			nudge.dHeight = 1.0f;
 		else if (selectionLocation == 1)
-			frame.size.height -= 1.0f;
+			nudge.dHeight = -1.0f;
 	}
 	else
 	{
 		if (selectionLocation == 4)
-			frame.origin.x -= 1.0f;
+			nudge.dx = -1.0f;
 		else if (selectionLocation == 6)
-			frame.origin.x += 1.0f;
+			nudge.dx = 1.0f;
 		else if (selectionLocation == 0)
-			frame.origin.y -= 1.0f;
+			nudge.dy = -1.0f;
 		else if (selectionLocation == 10)
-			frame.origin.y += 1.0f;
+			nudge.dy = 1.0f;
 	}
 	
-	self.currentView.frame = CGRectMake(floorf(frame.origin.x),
-										floorf(frame.origin.y),
-										floorf(frame.size.width),
-										floorf(frame.size.height));
-	
-	[self updateFrameView];
-	[self updateStatusBar];
+	if (self.currentView)
+		[self addNudge:nudge];
 	
 	[self resetInputTextView];
 }
@@ -443,6 +473,31 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		[self toggleRedrawFlashing];
 		return NO;
 	}
+	else if ([string isEqualToString:kDCIntrospectKeysToggleRedrawHeatmap])
+	{
+		[self toggleRedrawHeatmap];
+		return NO;
+	}
+	else if ([string isEqualToString:kDCIntrospectKeysWriteSnapshot])
+	{
+		[self writeSnapshot];
+		return NO;
+	}
+	else if ([string isEqualToString:kDCIntrospectKeysUndoEdit])
+	{
+		[self undoEdit];
+		return NO;
+	}
+	else if ([string isEqualToString:kDCIntrospectKeysRedoEdit])
+	{
+		[self redoEdit];
+		return NO;
+	}
+	else if ([string isEqualToString:kDCIntrospectKeysLogCodeForAllViewChanges])
+	{
+		[self logCodeForAllViewChanges];
+		return NO;
+	}
 	else if ([string isEqualToString:kDCIntrospectKeysToggleShowCoordinates])
 	{
 		[UIView animateWithDuration:0.15
@@ -566,38 +621,34 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 			return NO;
 		}
 		
-		CGRect frame = self.currentView.frame;
+		DCNudge nudge = { 0 };
 		if ([string isEqualToString:kDCIntrospectKeysNudgeViewLeft])
-			frame.origin.x -= 1.0f;
+			nudge.dx = -1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysNudgeViewRight])
-			frame.origin.x += 1.0f;
+			nudge.dx = 1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysNudgeViewUp])
-			frame.origin.y -= 1.0f;
+			nudge.dy = -1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysNudgeViewDown])
-			frame.origin.y += 1.0f;
+			nudge.dy = 1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysCenterInSuperview])
-			frame = CGRectMake(floorf((self.currentView.superview.frame.size.width - frame.size.width) / 2.0f),
-							   floorf((self.currentView.superview.frame.size.height - frame.size.height) / 2.0f),
-							   frame.size.width,
-							   frame.size.height);
+		{
+			// from where the nudges so far will put it
+			CGRect frame = [self nudgedFrame];
+			nudge.dx = floorf((self.currentView.superview.frame.size.width - frame.size.width) / 2.0f) - frame.origin.x;
+			nudge.dy = floorf((self.currentView.superview.frame.size.height - frame.size.height) / 2.0f) - frame.origin.y;
+		}
 		else if ([string isEqualToString:kDCIntrospectKeysIncreaseWidth])
-			frame.size.width += 1.0f;
+			nudge.dWidth = 1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysDecreaseWidth])
-			frame.size.width -= 1.0f;
+			nudge.dWidth = -1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysIncreaseHeight])
-			frame.size.height += 1.0f;
+			nudge.dHeight = 1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysDecreaseHeight])
-			frame.size.height -= 1.0f;
+			nudge.dHeight = -1.0f;
 		else if ([string isEqualToString:kDCIntrospectKeysIncreaseViewAlpha])
-		{
-			if (self.currentView.alpha < 1.0f)
-				self.currentView.alpha += 0.05f;
-		}
+			nudge.alphaSteps = 1;
 		else if ([string isEqualToString:kDCIntrospectKeysDecreaseViewAlpha])
-		{
-			if (self.currentView.alpha > 0.0f)
-				self.currentView.alpha -= 0.05f;
-		}
+			nudge.alphaSteps = -1;
 		else if ([string isEqualToString:kDCIntrospectKeysEnterGDB])
 		{
 			UIView *view = self.currentView;
@@ -607,102 +658,303 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 			return NO;
 		}
 		
-		self.currentView.frame = CGRectMake(floorf(frame.origin.x),
-											floorf(frame.origin.y),
-											floorf(frame.size.width),
-											floorf(frame.size.height));
-		
-		[self updateFrameView];
-		[self updateStatusBar];
+		[self addNudge:nudge];
 	}
 	
 	return NO;
 }
 
-#pragma mark Object Names
+#pragma mark Nudging
 
-- (void)logCodeForCurrentViewChanges
+- (void)addNudge:(DCNudge)nudge
 {
-	if (!self.currentView)
+	if (nudgedView != self.currentView)
+		[self applyPendingNudge];
+	nudgedView = self.currentView;
+	
+	pendingNudge.dx += nudge.dx;
+	pendingNudge.dy += nudge.dy;
+	pendingNudge.dWidth += nudge.dWidth;
+	pendingNudge.dHeight += nudge.dHeight;
+	pendingNudge.alphaSteps += nudge.alphaSteps;
+	
+	if (!nudgeLink)
+	{
+		// the first of a run of nudges: anything may have moved since the last
+		nudgeGeometryIsStale = YES;
+		nudgeLink = [[CADisplayLink displayLinkWithTarget:self selector:@selector(nudgeLinkDidFire:)] retain];
+		[nudgeLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+	}
+}
+
+// The current view's frame once the pending nudges are applied
+- (CGRect)nudgedFrame
+{
+	CGRect frame = self.currentView.frame;
+	if (nudgedView != self.currentView)
+		return frame;
+	return CGRectMake(frame.origin.x + pendingNudge.dx,
+					  frame.origin.y + pendingNudge.dy,
+					  frame.size.width + pendingNudge.dWidth,
+					  frame.size.height + pendingNudge.dHeight);
+}
+
+- (void)nudgeLinkDidFire:(CADisplayLink *)link
+{
+	if (nudgedView)
+	{
+		[self applyPendingNudge];
 		return;
+	}
 	
-	NSString *varName = [self nameForObject:self.currentView];
-	if ([varName isEqualToString:[NSString stringWithFormat:@"%@", self.currentView.class]])
-		varName = @"<#view#>";
+	// a frame without nudges: the keys were let go
+	[nudgeLink invalidate];
+	[nudgeLink release];
+	nudgeLink = nil;
+}
+
+- (void)applyPendingNudge
+{
+	UIView *view = nudgedView;
+	DCNudge nudge = pendingNudge;
+	nudgedView = nil;
+	pendingNudge = (DCNudge){ 0 };
+	if (!view)
+		return;
 	
-	NSMutableString *outputString = [NSMutableString string];
-	if (!CGRectEqualToRect(self.originalFrame, self.currentView.frame))
+	if (!self.editJournal)
+		self.editJournal = [[[DCEditJournal alloc] init] autorelease];
+	
+	if (nudge.dx != 0.0f || nudge.dy != 0.0f || nudge.dWidth != 0.0f || nudge.dHeight != 0.0f)
 	{
-		[outputString appendFormat:@"%@.frame = CGRectMake(%.1f, %.1f, %.1f, %.1f);\n", varName, self.currentView.frame.origin.x, self.currentView.frame.origin.y, self.currentView.frame.size.width, self.currentView.frame.size.height];
+		CGRect oldFrame = view.frame;
+		view.frame = CGRectMake(floorf(oldFrame.origin.x + nudge.dx),
+								floorf(oldFrame.origin.y + nudge.dy),
+								floorf(oldFrame.size.width + nudge.dWidth),
+								floorf(oldFrame.size.height + nudge.dHeight));
+		[self.editJournal recordEditOfView:view
+								  property:DCEditPropertyFrame
+								 fromValue:[NSValue valueWithCGRect:oldFrame]
+								   toValue:[NSValue valueWithCGRect:view.frame]];
 	}
 	
-	if (self.originalAlpha != self.currentView.alpha)
+	if (nudge.alphaSteps != 0)
+	{
+		CGFloat oldAlpha = view.alpha;
+		for (NSInteger step = 0; step < nudge.alphaSteps && view.alpha < 1.0f; step++)
+			view.alpha += 0.05f;
+		for (NSInteger step = 0; step > nudge.alphaSteps && view.alpha > 0.0f; step--)
+			view.alpha -= 0.05f;
+		[self.editJournal recordEditOfView:view
+								  property:DCEditPropertyAlpha
+								 fromValue:[NSNumber numberWithFloat:oldAlpha]
+								   toValue:[NSNumber numberWithFloat:view.alpha]];
+	}
+	
+	if (view == self.currentView)
+	{
+		[self updateFrameViewForNudge];
+		[self updateStatusBarFrame];
+	}
+}
+
+- (void)undoEdit
+{
+	[self applyPendingNudge];
+	UIView *view = [self.editJournal undo];
+	[self showEditOfView:view string:(view) ? [NSString stringWithFormat:@"Undid change to %@", [self nameForObject:view]] : @"Nothing to undo"];
+}
+
+- (void)redoEdit
+{
+	[self applyPendingNudge];
+	UIView *view = [self.editJournal redo];
+	[self showEditOfView:view string:(view) ? [NSString stringWithFormat:@"Redid change to %@", [self nameForObject:view]] : @"Nothing to redo"];
+}
+
+- (void)showEditOfView:(UIView *)view string:(NSString *)string
+{
+	if (view && view == self.currentView)
+	{
+		nudgeGeometryIsStale = YES;
+		[self updateFrameView];
+	}
+	
+	if (self.showStatusBarOverlay)
+		[self showTemporaryStringInStatusBar:string];
+	else
+		NSLog(@"DCIntrospect: %@", string);
+}
+
+#pragma mark Object Names
+
+// Code for the net edits of the edit journal, with a comment naming each view if commentingViews
+- (NSString *)codeForEdits:(NSArray *)edits commentingViews:(BOOL)commentingViews
+{
+	NSMutableString *outputString = [NSMutableString string];
+	UIView *lastView = nil;
+	for (DCEdit *edit in edits)
 	{
-		[outputString appendFormat:@"%@.alpha = %.2f;\n", varName, self.currentView.alpha];
+		UIView *view = edit.view;
+		NSString *varName = [self nameForObject:view];
+		if ([varName isEqualToString:[NSString stringWithFormat:@"%@", view.class]])
+			varName = @"<#view#>";
+		
+		if (commentingViews && view != lastView)
+			[outputString appendFormat:@"%@// <%@: %p>\n", (lastView) ? @"\n" : @"", view.class, view];
+		lastView = view;
+		
+		if (edit.property == DCEditPropertyFrame)
+		{
+			CGRect frame = [edit.toValue CGRectValue];
+			[outputString appendFormat:@"%@.frame = CGRectMake(%.1f, %.1f, %.1f, %.1f);\n", varName, frame.origin.x, frame.origin.y, frame.size.width, frame.size.height];
+		}
+		else if (edit.property == DCEditPropertyAlpha)
+		{
+			[outputString appendFormat:@"%@.alpha = %.2f;\n", varName, [(NSNumber *)edit.toValue floatValue]];
+		}
 	}
+	return outputString;
+}
+
+- (void)logCodeForCurrentViewChanges
+{
+	if (!self.currentView)
+		return;
 	
+	[self applyPendingNudge];
+	NSString *outputString = [self codeForEdits:[self.editJournal netEditsOfView:self.currentView] commentingViews:NO];
 	if (outputString.length == 0)
 		NSLog(@"DCIntrospect: No changes made to %@.", self.currentView.class);
 	else
 		printf("\n\n%s\n", [outputString UTF8String]);
 }
 
+- (void)logCodeForAllViewChanges
+{
+	[self applyPendingNudge];
+	NSString *outputString = [self codeForEdits:[self.editJournal netEditsOfView:nil] commentingViews:YES];
+	if (outputString.length == 0)
+		NSLog(@"DCIntrospect: No changes made.");
+	else
+		printf("\n\n%s\n", [outputString UTF8String]);
+}
+
 - (void)setName:(NSString *)name forObject:(id)object accessedWithSelf:(BOOL)accessedWithSelf
 {
+	statusBarView = nil;
 	if (!self.objectNames)
-		self.objectNames = [NSMutableDictionary dictionary];
+		self.objectNames = [[[DCObjectNameRegistry alloc] init] autorelease];
 	
 	if (accessedWithSelf)
 		name = [@"self." stringByAppendingString:name];
 	
-	[self.objectNames setValue:object forKey:name];
+	[self.objectNames setName:name forObject:object];
 }
 
-- (NSString *)nameForObject:(id)object
+- (void)setNamesForObjects:(NSDictionary *)objectsByName accessedWithSelf:(BOOL)accessedWithSelf
 {
-	__block NSString *objectName = [NSString stringWithFormat:@"%@", [object class]];
+	statusBarView = nil;
 	if (!self.objectNames)
-		return objectName;
+		self.objectNames = [[[DCObjectNameRegistry alloc] init] autorelease];
 	
-	[self.objectNames enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-		if (obj == object)
-		{
-			objectName = (NSString *)key;
-			*stop = YES;
-		}
+	if (!accessedWithSelf)
+	{
+		[self.objectNames setNamesForObjects:objectsByName];
+		return;
+	}
+	
+	[objectsByName enumerateKeysAndObjectsUsingBlock:^(id name, id object, BOOL *stop) {
+		[self.objectNames setName:[@"self." stringByAppendingString:name] forObject:object];
 	}];
+}
+
+- (NSString *)nameForObject:(id)object
+{
+	NSString *objectName = [self.objectNames nameForObject:object];
+	if (!objectName)
+		objectName = [NSString stringWithFormat:@"%@", [object class]];
 	
 	return objectName;
 }
 
 - (void)removeNamesForViewsInView:(UIView *)view
 {
-	if (!self.objectNames)
-		return;
+	statusBarView = nil;
+	[self.objectNames removeNamesForViewsInView:view];
+}
+
+- (void)removeNameForObject:(id)object
+{
+	statusBarView = nil;
+	[self.objectNames removeNameForObject:object];
+}
+
+// The ivars of class and its superclasses, up to UIViewController, which may hold views
++ (NSData *)viewIvarsOfViewControllerClass:(Class)class
+{
+	static NSMutableDictionary *viewIvarsByClass = nil;
+	if (!viewIvarsByClass)
+		viewIvarsByClass = [[NSMutableDictionary alloc] init];
 	
-	NSMutableArray *objectsToRemove = [NSMutableArray array];
-	[self.objectNames enumerateKeysAndObjectsUsingBlock:^(id key, id obj, BOOL *stop) {
-		if ([[obj class] isSubclassOfClass:[UIView class]])
+	NSData *viewIvars = [viewIvarsByClass objectForKey:class];
+	if (viewIvars)
+		return viewIvars;
+	
+	NSMutableData *ivars = [NSMutableData data];
+	for (Class aClass = class; aClass && aClass != [UIViewController class]; aClass = class_getSuperclass(aClass))
+	{
+		unsigned int count = 0;
+		Ivar *classIvars = class_copyIvarList(aClass, &count);
+		for (unsigned int i = 0; i < count; i++)
 		{
-			UIView *subview = (UIView *)obj;
-			if ([self view:view containsSubview:subview])
-				[objectsToRemove addObject:key];
+			// object ivars typed as views, or as id
+			const char *type = ivar_getTypeEncoding(classIvars[i]);
+			if (!type || type[0] != '@')
+				continue;
+			if (type[1] == '"' && type[2] != '<')
+			{
+				// @"ClassName"
+				const char *nameEnd = strchr(type + 2, '"');
+				NSString *className = [[[NSString alloc] initWithBytes:type + 2 length:(nameEnd ? nameEnd - (type + 2) : strlen(type + 2)) encoding:NSUTF8StringEncoding] autorelease];
+				if (![NSClassFromString(className) isSubclassOfClass:[UIView class]])
+					continue;
+			}
+			[ivars appendBytes:&classIvars[i] length:sizeof(Ivar)];
 		}
-	}];
+		free(classIvars);
+	}
 	
-	[objectsToRemove enumerateObjectsUsingBlock:^(id obj, NSUInteger idx, BOOL *stop) {
-		NSString *key = (NSString *)obj;
-		[self.objectNames removeObjectForKey:key];
-	}];
+	[viewIvarsByClass setObject:ivars forKey:class];
+	return ivars;
 }
 
-- (void)removeNameForObject:(id)object
+- (void)nameViewControllerIvarsForView:(UIView *)view
 {
 	if (!self.objectNames)
-		return;
+		self.objectNames = [[[DCObjectNameRegistry alloc] init] autorelease];
 	
-	NSString *objectName = [self nameForObject:object];
-	[self.objectNames removeObjectForKey:objectName];
+	// the view controllers of the view and its superviews, nearest first
+	for (UIView *aView = view; aView; aView = aView.superview)
+	{
+		UIViewController *viewController = (UIViewController *)aView.nextResponder;
+		if (![viewController isKindOfClass:[UIViewController class]])
+			continue;
+		
+		NSData *viewIvars = [DCIntrospect viewIvarsOfViewControllerClass:viewController.class];
+		const Ivar *ivars = viewIvars.bytes;
+		for (NSUInteger i = 0; i < viewIvars.length / sizeof(Ivar); i++)
+		{
+			id object = object_getIvar(viewController, ivars[i]);
+			if (![object isKindOfClass:[UIView class]] || [self.objectNames nameForObject:object])
+				continue;
+			
+			// names given by hand, and by nearer view controllers, win
+			NSString *name = [NSString stringWithUTF8String:ivar_getName(ivars[i])];
+			if (![self.objectNames objectForName:name])
+				[self.objectNames setName:name forObject:object];
+		}
+	}
 }
 
 #pragma mark Layout
@@ -745,8 +997,32 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	}
 }
 
+// As updateFrameView, after a nudge: the current view's superview is converted to the
+// frame view once for a run of nudges, and its rect left as it is
+- (void)updateFrameViewForNudge
+{
+	UIView *superview = self.currentView.superview;
+	if (nudgeGeometryIsStale || !superview || superview != nudgeGeometrySuperview)
+	{
+		[self updateFrameView];
+		
+		CGPoint origin = [superview convertPoint:CGPointZero toView:self.frameView];
+		CGPoint xAxis = [superview convertPoint:CGPointMake(1.0f, 0.0f) toView:self.frameView];
+		CGPoint yAxis = [superview convertPoint:CGPointMake(0.0f, 1.0f) toView:self.frameView];
+		nudgeGeometryTransform = CGAffineTransformMake(xAxis.x - origin.x, xAxis.y - origin.y,
+													   yAxis.x - origin.x, yAxis.y - origin.y,
+													   origin.x, origin.y);
+		nudgeGeometrySuperview = superview;
+		nudgeGeometryIsStale = NO;
+		return;
+	}
+	
+	self.frameView.mainRect = CGRectApplyAffineTransform(self.currentView.frame, nudgeGeometryTransform);
+}
+
 - (void)updateStatusBar
 {
+	statusBarView = self.currentView;
 	if (self.currentView)
 	{
 		NSString *nameForObject = [self nameForObject:self.currentView];
@@ -774,6 +1050,18 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		self.statusBarOverlay.hidden = YES;
 }
 
+// As updateStatusBar, after a nudge: only the frame changed
+- (void)updateStatusBarFrame
+{
+	if (statusBarView != self.currentView || !self.currentView)
+	{
+		[self updateStatusBar];
+		return;
+	}
+	
+	self.statusBarOverlay.rightLabel.text = NSStringFromCGRect(self.currentView.frame);
+}
+
 - (void)updateViews
 {
 	// current interface orientation
@@ -803,6 +1091,8 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		self.frameView.frame = CGRectMake(0, 0, screenWidth, screenHeight);
 	}
 	
+	[self applyPendingNudge];
+	nudgeGeometryIsStale = YES;
 	self.currentView = nil;
 	[self updateFrameView];
 }
@@ -811,6 +1101,7 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 {
 	[NSObject cancelPreviousPerformRequestsWithTarget:self selector:@selector(updateStatusBar) object:nil];
 	
+	statusBarView = nil;
 	self.statusBarOverlay.leftLabel.text = string;
 	self.statusBarOverlay.rightLabel.text = nil;
 	[self performSelector:@selector(updateStatusBar) withObject:nil afterDelay:0.75];
@@ -855,7 +1146,7 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	if (self.viewOutlines)
 		[self addOutlinesToFrameViewFromSubview:mainWindow];
 	else
-		[self.frameView.rectsToOutline removeAllObjects];
+		[self.frameView removeAllOutlines];
 	
 	[self.frameView setNeedsDisplay];
 	
@@ -867,6 +1158,11 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 }
 
 - (void)addOutlinesToFrameViewFromSubview:(UIView *)view
+{
+	[self addOutlinesToFrameViewFromSubview:view depth:0];
+}
+
+- (void)addOutlinesToFrameViewFromSubview:(UIView *)view depth:(NSUInteger)depth
 {
 	for (UIView *subview in view.subviews)
 	{
@@ -874,10 +1170,8 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 			continue;
 		
 		CGRect rect = [subview.superview convertRect:subview.frame toView:frameView];
-		
-		NSValue *rectValue = [NSValue valueWithCGRect:rect];
-		[self.frameView.rectsToOutline addObject:rectValue];
-		[self addOutlinesToFrameViewFromSubview:subview];
+		[self.frameView addOutlineRect:rect depth:depth];
+		[self addOutlinesToFrameViewFromSubview:subview depth:depth + 1];
 	}
 }
 
@@ -939,330 +1233,99 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 {
 	if (self.flashOnRedraw)
 	{
-		CALayer *layer = [CALayer layer];
-		layer.frame = rect;
-		layer.backgroundColor = kDCIntrospectFlashOnRedrawColor.CGColor;
-		[view.layer addSublayer:layer];
-		[layer performSelector:@selector(removeFromSuperlayer) withObject:nil afterDelay:kDCIntrospectFlashOnRedrawFlashLength];
+		if (!self.redrawTracker)
+			self.redrawTracker = [[[DCRedrawTracker alloc] init] autorelease];
+		[self.redrawTracker flashRect:rect inView:view];
 	}
 }
 
-#pragma mark Description Methods
+- (void)toggleRedrawHeatmap
+{
+	if (!self.redrawTracker)
+		self.redrawTracker = [[[DCRedrawTracker alloc] init] autorelease];
+	self.redrawTracker.ignoredViews = [NSArray arrayWithObjects:self.frameView, self.inputTextView, self.statusBarOverlay, nil];
+	
+	if (self.redrawTracker.heatmapOn)
+		[self logRedrawHeatmap];
+	self.redrawTracker.heatmapOn = !self.redrawTracker.heatmapOn;
+	
+	NSString *string = [NSString stringWithFormat:@"Redraw heatmap is %@", (self.redrawTracker.heatmapOn) ? @"on" : @"off"];
+	if (self.showStatusBarOverlay)
+		[self showTemporaryStringInStatusBar:string];
+	else
+		NSLog(@"DCIntrospect: %@", string);
+}
 
-- (NSString *)describeProperty:(NSString *)propertyName value:(id)value
+- (void)logRedrawHeatmap
 {
-	if ([propertyName isEqualToString:@"contentMode"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIViewContentModeScaleToFill";
-			case 1: return @"UIViewContentModeScaleAspectFit";
-			case 2: return @"UIViewContentModeScaleAspectFill";
-			case 3: return @"UIViewContentModeRedraw";
-			case 4: return @"UIViewContentModeCenter";
-			case 5: return @"UIViewContentModeTop";
-			case 6: return @"UIViewContentModeBottom";
-			case 7: return @"UIViewContentModeLeft";
-			case 8: return @"UIViewContentModeRight";
-			case 9: return @"UIViewContentModeTopLeft";
-			case 10: return @"UIViewContentModeTopRight";
-			case 11: return @"UIViewContentModeBottomLeft";
-			case 12: return @"UIViewContentModeBottomRight";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"textAlignment"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITextAlignmentLeft";
-			case 1: return @"UITextAlignmentCenter";
-			case 2: return @"UITextAlignmentRight";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"lineBreakMode"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UILineBreakModeWordWrap";
-			case 1: return @"UILineBreakModeCharacterWrap";
-			case 2: return @"UILineBreakModeClip";
-			case 3: return @"UILineBreakModeHeadTruncation";
-			case 4: return @"UILineBreakModeTailTruncation";
-			case 5: return @"UILineBreakModeMiddleTruncation";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"activityIndicatorViewStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIActivityIndicatorViewStyleWhiteLarge";
-			case 1: return @"UIActivityIndicatorViewStyleWhite";
-			case 2: return @"UIActivityIndicatorViewStyleGray";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"returnKeyType"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIReturnKeyDefault";
-			case 1: return @"UIReturnKeyGo";
-			case 2: return @"UIReturnKeyGoogle";
-			case 3: return @"UIReturnKeyJoin";
-			case 4: return @"UIReturnKeyNext";
-			case 5: return @"UIReturnKeyRoute";
-			case 6: return @"UIReturnKeySearch";
-			case 7: return @"UIReturnKeySend";
-			case 8: return @"UIReturnKeyYahoo";
-			case 9: return @"UIReturnKeyDone";
-			case 10: return @"UIReturnKeyEmergencyCall";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"keyboardAppearance"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIKeyboardAppearanceDefault";
-			case 1: return @"UIKeyboardAppearanceAlert";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"keyboardType"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIKeyboardTypeDefault";
-			case 1: return @"UIKeyboardTypeASCIICapable";
-			case 2: return @"UIKeyboardTypeNumbersAndPunctuation";
-			case 3: return @"UIKeyboardTypeURL";
-			case 4: return @"UIKeyboardTypeNumberPad";
-			case 5: return @"UIKeyboardTypePhonePad";
-			case 6: return @"UIKeyboardTypeNamePhonePad";
-			case 7: return @"UIKeyboardTypeEmailAddress";
-			case 8: return @"UIKeyboardTypeDecimalPad";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"autocorrectionType"])
+	NSArray *rates = [self.redrawTracker heatmapRates];
+	NSMutableString *outputString = [NSMutableString stringWithFormat:@"\n\n** redraw heatmap: %u views **\n\nper second\tpeak\ttotal\tview\n", rates.count];
+	for (NSDictionary *rate in [rates subarrayWithRange:NSMakeRange(0, MIN(rates.count, 20))])
 	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIKeyboardTypeDefault";
-			case 1: return @"UITextAutocorrectionTypeDefault";
-			case 2: return @"UITextAutocorrectionTypeNo";
-			default: return nil;
-		}
+		[outputString appendFormat:@"%@\t\t%@\t%@\t%@ %@ %@\n",
+		 [rate objectForKey:@"rate"], [rate objectForKey:@"peakRate"], [rate objectForKey:@"total"],
+		 [rate objectForKey:@"class"], [rate objectForKey:@"address"], [rate objectForKey:@"frame"]];
 	}
-	else if ([propertyName isEqualToString:@"autocapitalizationType"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITextAutocapitalizationTypeNone";
-			case 1: return @"UITextAutocapitalizationTypeWords";
-			case 2: return @"UITextAutocapitalizationTypeSentences";
-			case 3: return @"UITextAutocapitalizationTypeAllCharacters";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"clearButtonMode"] ||
-			 [propertyName isEqualToString:@"leftViewMode"] ||
-			 [propertyName isEqualToString:@"rightViewMode"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITextFieldViewModeNever";
-			case 1: return @"UITextFieldViewModeWhileEditing";
-			case 2: return @"UITextFieldViewModeUnlessEditing";
-			case 3: return @"UITextFieldViewModeAlways";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"borderStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITextBorderStyleNone";
-			case 1: return @"UITextBorderStyleLine";
-			case 2: return @"UITextBorderStyleBezel";
-			case 3: return @"UITextBorderStyleRoundedRect";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"progressViewStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UIProgressViewStyleBar";
-			case 1: return @"UIProgressViewStyleDefault";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"separatorStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITableViewCellSeparatorStyleNone";
-			case 1: return @"UITableViewCellSeparatorStyleSingleLine";
-			case 2: return @"UITableViewCellSeparatorStyleSingleLineEtched";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"selectionStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITableViewCellSelectionStyleNone";
-			case 1: return @"UITableViewCellSelectionStyleBlue";
-			case 2: return @"UITableViewCellSelectionStyleGray";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"editingStyle"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITableViewCellEditingStyleNone";
-			case 1: return @"UITableViewCellEditingStyleDelete";
-			case 2: return @"UITableViewCellEditingStyleInsert";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"accessoryType"] || [propertyName isEqualToString:@"editingAccessoryType"])
-	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITableViewCellAccessoryNone";
-			case 1: return @"UITableViewCellAccessoryDisclosureIndicator";
-			case 2: return @"UITableViewCellAccessoryDetailDisclosureButton";
-			case 3: return @"UITableViewCellAccessoryCheckmark";
-			default: return nil;
-		}
-	}
-	else if ([propertyName isEqualToString:@"style"])
+	printf("%s\n", [outputString UTF8String]);
+}
+
+- (BOOL)exportRedrawHeatmapToPath:(NSString *)path
+{
+	return [self.redrawTracker exportHeatmapToPath:path];
+}
+
+- (void)startSnapshotsToPath:(NSString *)path
+{
+	[self stopSnapshots];
+	self.snapshotWriter = [[[DCSnapshotWriter alloc] initWithPath:path] autorelease];
+	self.snapshotWriter.ignoredViews = [NSArray arrayWithObjects:self.frameView, self.inputTextView, nil];
+	self.snapshotWriter.objectNames = self.objectNames;
+	self.snapshotWriter.rolesOfView = self.snapshotRolesOfView;
+}
+
+- (void)writeSnapshot
+{
+	if (!self.snapshotWriter)
 	{
-		switch ([value intValue])
-		{
-			case 0: return @"UITableViewStylePlain";
-			case 1: return @"UITableViewStyleGrouped";
-			default: return nil;
-		}
-		
-	}
-	else if ([propertyName isEqualToString:@"autoresizingMask"])
-	{
-		UIViewAutoresizing mask = [value intValue];
-		NSMutableString *string = [NSMutableString string];
-		if (mask & UIViewAutoresizingFlexibleLeftMargin)
-			[string appendString:@"UIViewAutoresizingFlexibleLeftMargin"];
-		if (mask & UIViewAutoresizingFlexibleRightMargin)
-			[string appendString:@" | UIViewAutoresizingFlexibleRightMargin"];
-		if (mask & UIViewAutoresizingFlexibleTopMargin)
-			[string appendString:@" | UIViewAutoresizingFlexibleTopMargin"];
-		if (mask & UIViewAutoresizingFlexibleBottomMargin)
-			[string appendString:@" | UIViewAutoresizingFlexibleBottomMargin"];
-		if (mask & UIViewAutoresizingFlexibleWidth)
-			[string appendString:@" | UIViewAutoresizingFlexibleWidthMargin"];
-		if (mask & UIViewAutoresizingFlexibleHeight)
-			[string appendString:@" | UIViewAutoresizingFlexibleHeightMargin"];
-		
-		if ([string hasPrefix:@" | "])
-			[string replaceCharactersInRange:NSMakeRange(0, 3) withString:@""];
-		
-		return ([string length] > 0) ? string : @"UIViewAutoresizingNone";
-	}
-	else if ([propertyName isEqualToString:@"accessibilityTraits"])
-	{
-		UIAccessibilityTraits traits = [value intValue];
-		NSMutableString *string = [NSMutableString string];
-		if (traits & UIAccessibilityTraitButton)
-			[string appendString:@"UIAccessibilityTraitButton"];
-		if (traits & UIAccessibilityTraitLink)
-			[string appendString:@" | UIAccessibilityTraitLink"];
-		if (traits & UIAccessibilityTraitSearchField)
-			[string appendString:@" | UIAccessibilityTraitSearchField"];
-		if (traits & UIAccessibilityTraitImage)
-			[string appendString:@" | UIAccessibilityTraitImage"];
-		if (traits & UIAccessibilityTraitSelected)
-			[string appendString:@" | UIAccessibilityTraitSelected"];
-		if (traits & UIAccessibilityTraitPlaysSound)
-			[string appendString:@" | UIAccessibilityTraitPlaysSound"];
-		if (traits & UIAccessibilityTraitKeyboardKey)
-			[string appendString:@" | UIAccessibilityTraitKeyboardKey"];
-		if (traits & UIAccessibilityTraitStaticText)
-			[string appendString:@" | UIAccessibilityTraitStaticText"];
-		if (traits & UIAccessibilityTraitSummaryElement)
-			[string appendString:@" | UIAccessibilityTraitSummaryElement"];
-		if (traits & UIAccessibilityTraitNotEnabled)
-			[string appendString:@" | UIAccessibilityTraitNotEnabled"];
-		if (traits & UIAccessibilityTraitUpdatesFrequently)
-			[string appendString:@" | UIAccessibilityTraitUpdatesFrequently"];
-		if (traits & UIAccessibilityTraitStartsMediaSession)
-			[string appendString:@" | UIAccessibilityTraitStartsMediaSession"];
-		if (traits & UIAccessibilityTraitAdjustable)
-			[string appendFormat:@" | UIAccessibilityTraitAdjustable"];
-		if ([string hasPrefix:@" | "])
-			[string replaceCharactersInRange:NSMakeRange(0, 3) withString:@""];
-		
-		return ([string length] > 0) ? string : @"UIAccessibilityTraitNone";
+		NSString *documentsPath = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+		[self startSnapshotsToPath:[documentsPath stringByAppendingPathComponent:@"DCIntrospect.dcsnap"]];
+		if (!self.snapshotWriter)
+			return;
+		NSLog(@"DCIntrospect: Writing snapshots to %@", self.snapshotWriter.path);
 	}
 	
-	if ([value isKindOfClass:[NSValue class]])
-	{
-		// print out the return for each value depending on type
-		NSString *type = [NSString stringWithUTF8String:[value objCType]];
-		if ([type isEqualToString:@"c"])
-		{
-			return ([value boolValue]) ? @"YES" : @"NO";
-		}
-		else if ([type isEqualToString:@"{CGSize=ff}"])
-		{
-			CGSize size = [value CGSizeValue];
-			return CGSizeEqualToSize(size, CGSizeZero) ? @"CGSizeZero" : NSStringFromCGSize(size);
-		}
-		else if ([type isEqualToString:@"{UIEdgeInsets=ffff}"])
-		{
-			UIEdgeInsets edgeInsets = [value UIEdgeInsetsValue];
-			return UIEdgeInsetsEqualToEdgeInsets(edgeInsets, UIEdgeInsetsZero) ? @"UIEdgeInsetsZero" : NSStringFromUIEdgeInsets(edgeInsets);
-		}
-	}
-	else if ([value isKindOfClass:[UIColor class]])
-	{
-		UIColor *color = (UIColor *)value;
-		return [self describeColor:color];
-	}
-	else if ([value isKindOfClass:[UIFont class]])
-	{
-		UIFont *font = (UIFont *)value;
-		return [NSString stringWithFormat:@"%.0fpx %@", font.pointSize, font.fontName];
-	}
+	// names given since the writer started
+	self.snapshotWriter.objectNames = self.objectNames;
+	[self.snapshotWriter writeSnapshotOfView:[self mainWindow] incremental:YES];
 	
-	return value ? [value description] : @"nil";
+	// encoded in the background: the count written is the previous snapshot's
+	NSString *string = [NSString stringWithFormat:@"Snapshot %u: %u views, %u written by the last one encoded", self.snapshotWriter.snapshotCount - 1, self.snapshotWriter.lastVisitedCount, self.snapshotWriter.lastWrittenCount];
+	if (self.showStatusBarOverlay)
+		[self showTemporaryStringInStatusBar:string];
+	else
+		NSLog(@"DCIntrospect: %@", string);
 }
 
-- (NSString *)describeColor:(UIColor *)color
+- (void)stopSnapshots
+{
+	[self.snapshotWriter close];
+	self.snapshotWriter = nil;
+}
+
+#pragma mark Description Methods
+
+- (NSString *)describeProperty:(NSString *)propertyName value:(id)value
 {
-	if (!color)
-		return @"nil";
+	DCPropertyDescriber describer = DCPropertyDescriberForName(propertyName);
+	if (describer != DCPropertyDescriberNone)
+		return DCPropertyDescribeValue(describer, [value longLongValue]);
 	
-	NSString *returnString = nil;
-	if (CGColorSpaceGetModel(CGColorGetColorSpace(color.CGColor)) == kCGColorSpaceModelRGB)
-	{
-		const CGFloat *components = CGColorGetComponents(color.CGColor);
-		returnString = [NSString stringWithFormat:@"R: %.0f G: %.0f B: %.0f A: %.2f",
-						components[0] * 256,
-						components[1] * 256,
-						components[2] * 256,
-						components[3]];
-	}
-	else
-	{
-		returnString = [NSString stringWithFormat:@"%@ (incompatible color space)", color];
-	}
-	return returnString;
+	return DCPropertyDescribeObject(value);
+}
+
+- (NSString *)describeColor:(UIColor *)color
+{
+	return DCPropertyDescribeColor(color);
 }
 
 #pragma mark DCIntrospector Help
@@ -1311,6 +1374,11 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		[helpString appendFormat:@"<div><span class='name'>Toggle Highlighting Non-Opaque Views</span><div class='key'>%@</div></div>", kDCIntrospectKeysToggleNonOpaqueViews];
 		[helpString appendFormat:@"<div><span class='name'>Toggle Help</span><div class='key'>%@</div></div>", kDCIntrospectKeysToggleHelp];
 		[helpString appendFormat:@"<div><span class='name'>Toggle flash on <span class='code'>drawRect:</span> (see below)</span><div class='key'>%@</div></div>", kDCIntrospectKeysToggleFlashViewRedraws];
+		[helpString appendFormat:@"<div><span class='name'>Toggle redraw heatmap</span><div class='key'>%@</div></div>", kDCIntrospectKeysToggleRedrawHeatmap];
+		[helpString appendFormat:@"<div><span class='name'>Write view hierarchy snapshot</span><div class='key'>%@</div></div>", kDCIntrospectKeysWriteSnapshot];
+		[helpString appendFormat:@"<div><span class='name'>Undo change</span><div class='key'>%@</div></div>", kDCIntrospectKeysUndoEdit];
+		[helpString appendFormat:@"<div><span class='name'>Redo change</span><div class='key'>%@</div></div>", kDCIntrospectKeysRedoEdit];
+		[helpString appendFormat:@"<div><span class='name'>Log code for all views</span><div class='key'>%@</div></div>", kDCIntrospectKeysLogCodeForAllViewChanges];
 		[helpString appendFormat:@"<div><span class='name'>Toggle coordinates</span><div class='key'>%@</div></div>", kDCIntrospectKeysToggleShowCoordinates];
 		[helpString appendString:@"<div class='spacer'></div>"];
 		
@@ -1346,7 +1414,9 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		
 		[helpString appendFormat:@"<h1>Flash on <span class='code'>drawRect:</span> calls</h1><p>To implement, call <span class='code'>[[DCIntrospect sharedIntrospector] flashRect:inView:]</span> inside the <span class='code'>drawRect:</span> method of any view you want to track.</p><p>When Flash on <span class='code'>drawRect:</span> is toggled on (binding: <span class='code'>%@</span>) the view will flash whenever <span class='code'>drawRect:</span> is called.</p>", kDCIntrospectKeysToggleFlashViewRedraws];
 		
-		[helpString appendFormat:@"<h1>Naming objects & logging code</h1><p>By providing names for objects using <span class='code'>setName:forObject:accessedWithSelf:</span>, that name will be shown in the status bar instead of the class of the view.</p><p>This is also used when logging view code (binding: <span class='code'>%@</span>).  Logging view code prints formatted code to the console for properties that have been changed.</p><p>For example, if you resize/move a view using the nudge keys, logging the view code will print <span class='code'>view.frame = CGRectMake(50.0 ..etc);</span> to the console.  If a name is provided then <span class='code'>view</span> is replaced by the name.</p>", kDCIntrospectKeysLogCodeForCurrentViewChanges];
+		[helpString appendFormat:@"<h1>View hierarchy snapshots</h1><p>Each snapshot (binding: <span class='code'>%@</span>) appends the main window's view hierarchy to <span class='code'>Documents/DCIntrospect.dcsnap</span>: frames, flags, object names and, if <span class='code'>snapshotRolesOfView</span> is set, drag and drop roles.  After the first, only the subtrees which changed are written.</p><p>Copy the file off the device and read it with <span class='code'>Tools/dcsnapshot</span>, which lists, dumps and diffs the snapshots.</p>", kDCIntrospectKeysWriteSnapshot];
+		
+		[helpString appendFormat:@"<h1>Naming objects & logging code</h1><p>By providing names for objects using <span class='code'>setName:forObject:accessedWithSelf:</span>, that name will be shown in the status bar instead of the class of the view.</p><p>This is also used when logging view code (binding: <span class='code'>%@</span>).  Logging view code prints formatted code to the console for properties that have been changed.</p><p>For example, if you resize/move a view using the nudge keys, logging the view code will print <span class='code'>view.frame = CGRectMake(50.0 ..etc);</span> to the console.  If a name is provided then <span class='code'>view</span> is replaced by the name.  <span class='code'>%@</span> logs the code for every view changed, not only the selected one.</p><p>Changes can be undone (binding: <span class='code'>%@</span>) and redone (binding: <span class='code'>%@</span>), whichever view they were made to.  Changes made with a key held down, or pressed again within a second, are undone together.</p><p>Names are forgotten when their objects are deallocated.  Set <span class='code'>autoNamesViewControllerIvars</span> to have views named after the view controller ivars that hold them.</p>", kDCIntrospectKeysLogCodeForCurrentViewChanges, kDCIntrospectKeysLogCodeForAllViewChanges, kDCIntrospectKeysUndoEdit, kDCIntrospectKeysRedoEdit];
 		
 		[helpString appendString:@"<h1>License</h1><p>DCIntrospect is made available under the <a href='http://en.wikipedia.org/wiki/MIT_License'>MIT license</a>.</p>"];
 		
@@ -1394,14 +1464,15 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 }
 
 - (void)logPropertiesForObject:(id)object
+{
+	NSLog(@"DCIntrospect: %@", [self propertiesDescriptionForObject:object]);
+}
+
+- (NSString *)propertiesDescriptionForObject:(id)object
 {
 	Class objectClass = [object class];
 	NSString *className = [NSString stringWithFormat:@"%@", objectClass];
 	
-	unsigned int count;
-	objc_property_t *properties = class_copyPropertyList(objectClass, &count);
-    size_t buf_size = 1024;
-    char *buffer = malloc(buf_size);
 	NSMutableString *outputString = [NSMutableString stringWithFormat:@"\n\n** %@", className];
 	
 	// list the class heirachy
@@ -1424,11 +1495,11 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 		[outputString appendFormat:@"bounds: %@ | ", NSStringFromCGRect(view.bounds)];
 		[outputString appendFormat:@"center: %@\n", NSStringFromCGPoint(view.center)];
 		[outputString appendFormat:@"    transform: %@\n", NSStringFromCGAffineTransform(view.transform)];
-		[outputString appendFormat:@"    autoresizingMask: %@\n", [self describeProperty:@"autoresizingMask" value:[NSNumber numberWithInt:view.autoresizingMask]]];
+		[outputString appendFormat:@"    autoresizingMask: %@\n", DCPropertyDescribeValue(DCPropertyDescriberAutoresizingMask, view.autoresizingMask)];
 		[outputString appendFormat:@"    autoresizesSubviews: %@\n", (view.autoresizesSubviews) ? @"YES" : @"NO"];
-		[outputString appendFormat:@"    contentMode: %@ | ", [self describeProperty:@"contentMode" value:[NSNumber numberWithInt:view.contentMode]]];
+		[outputString appendFormat:@"    contentMode: %@ | ", DCPropertyDescribeValue(DCPropertyDescriberContentMode, view.contentMode)];
 		[outputString appendFormat:@"contentStretch: %@\n", NSStringFromCGRect(view.contentStretch)];
-		[outputString appendFormat:@"    backgroundColor: %@\n", [self describeColor:view.backgroundColor]];
+		[outputString appendFormat:@"    backgroundColor: %@\n", DCPropertyDescribeColor(view.backgroundColor)];
 		[outputString appendFormat:@"    alpha: %.2f | ", view.alpha];
 		[outputString appendFormat:@"opaque: %@ | ", (view.opaque) ? @"YES" : @"NO"];
 		[outputString appendFormat:@"hidden: %@ | ", (view.hidden) ? @"YES" : @"NO"];
@@ -1449,34 +1520,8 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	}
 	else
 	{
-		
-		for (unsigned int i = 0; i < count; ++i)
-		{
-			// get the property name and selector name
-			NSString *propertyName = [NSString stringWithCString:property_getName(properties[i]) encoding:NSUTF8StringEncoding];
-			
-			SEL sel = NSSelectorFromString(propertyName);
-			if ([object respondsToSelector:sel])
-			{
-				NSString *propertyDescription;
-				@try
-				{
-					// get the return object and type for the selector
-					NSString *returnType = [NSString stringWithUTF8String:[[object methodSignatureForSelector:sel] methodReturnType]];
-					id returnObject = [object valueForKey:propertyName];
-					if ([returnType isEqualToString:@"c"])
-						returnObject = [NSNumber numberWithBool:[returnObject intValue] != 0];
-					
-					propertyDescription = [self describeProperty:propertyName value:returnObject];
-				}
-				@catch (NSException *exception)
-				{
-					// Non KVC compliant properties, see also +workaroundUITextInputTraitsPropertiesBug
-					propertyDescription = @"N/A";
-				}
-				[outputString appendFormat:@"    %@: %@\n", propertyName, propertyDescription];
-			}
-		}
+		[DCIntrospect workaroundUITextInputTraitsPropertiesBugForClass:objectClass];
+		[[DCPropertyPlan planForClass:objectClass] appendDescriptionOfObject:object toString:outputString];
 	}
 	
 	// list targets if there are any
@@ -1497,10 +1542,7 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 	}
 	
 	[outputString appendString:@"\n"];
-	NSLog(@"DCIntrospect: %@", outputString);
-	
-	free(properties);
-    free(buffer);
+	return outputString;
 }
 
 - (void)logAccessabilityPropertiesForObject:(id)object
@@ -1526,6 +1568,12 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
 }
 
 - (NSArray *)subclassesOfClass:(Class)parentClass
+{
+	return [[DCClassHierarchy sharedHierarchy] subclassesOfClass:parentClass];
+}
+
+// The subclasses of parentClass found by walking up from every class, as subclassesOfClass: used to
+- (NSArray *)subclassesOfClassByScanning:(Class)parentClass
 {
 	// thanks to Matt Gallagher:
     int numClasses = objc_getClassList(NULL, 0);
@@ -1556,6 +1604,169 @@ id UITextInputTraits_valueForKey(id self, SEL _cmd, NSString *key)
     return result;
 }
 
+// Times what startup used to spend finding the classes with textInputTraits, and
+// subclass queries with and without the class hierarchy index
+- (void)logClassHierarchyBenchmark
+{
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	NSMutableString *outputString = [NSMutableString stringWithString:@"\n\n** class hierarchy benchmark **\n\n"];
+	
+	// the scan +sharedIntrospector used to make, without the method replacements
+	CFTimeInterval start = CACurrentMediaTime();
+	unsigned int classCount = 0;
+	NSUInteger textInputTraitsClassCount = 0;
+	Class *classes = objc_copyClassList(&classCount);
+	for (unsigned int i = 0; i < classCount; i++)
+		if (class_getInstanceMethod(classes[i], NSSelectorFromString(@"textInputTraits")))
+			textInputTraitsClassCount++;
+	free(classes);
+	[outputString appendFormat:@"startup scan, before:\t%.2f ms (%u classes, %u with textInputTraits)\n", (CACurrentMediaTime() - start) * 1e3, classCount, textInputTraitsClassCount];
+	
+	start = CACurrentMediaTime();
+	[DCIntrospect workaroundUITextInputTraitsPropertiesBugForClass:[UITextField class]];
+	[outputString appendFormat:@"startup scan, after:\t0 ms, then %.3f ms on first introspecting a UITextField\n\n", (CACurrentMediaTime() - start) * 1e3];
+	
+	DCClassHierarchy *hierarchy = [[[DCClassHierarchy alloc] init] autorelease];
+	start = CACurrentMediaTime();
+	[hierarchy update];
+	[outputString appendFormat:@"index build:\t%.2f ms (%u classes)\n\nclass\t\t\tsubclasses\tscan (ms)\tindex (ms)\tmismatch\n", (CACurrentMediaTime() - start) * 1e3, hierarchy.classCount];
+	
+	NSArray *parentClasses = [NSArray arrayWithObjects:[NSObject class], [UIResponder class], [UIView class], [UIControl class], [UITableViewCell class], nil];
+	for (Class parentClass in parentClasses)
+	{
+		start = CACurrentMediaTime();
+		NSArray *scanned = [self subclassesOfClassByScanning:parentClass];
+		CFTimeInterval scanTime = CACurrentMediaTime() - start;
+		
+		start = CACurrentMediaTime();
+		NSArray *indexed = [hierarchy subclassesOfClass:parentClass];
+		CFTimeInterval indexTime = CACurrentMediaTime() - start;
+		
+		BOOL mismatch = ![[NSSet setWithArray:scanned] isEqualToSet:[NSSet setWithArray:indexed]];
+		[outputString appendFormat:@"%-20s\t%u\t\t%.3f\t\t%.3f\t\t%@\n", class_getName(parentClass), indexed.count, scanTime * 1e3, indexTime * 1e3, mismatch ? @"YES" : @"no"];
+	}
+	
+	printf("%s\n", [outputString UTF8String]);
+	[pool drain];
+}
+
+// Builds a tree of views with 10 subviews per view, 2 to 4 levels deep, and times
+// random touch queries against it, the old way and through a DCHitPathIndex
+- (void)logHitPathBenchmark
+{
+	const NSUInteger queryCount = 2000;
+	NSMutableString *outputString = [NSMutableString stringWithString:@"\n\n** hit path benchmark **\n\nviews\tbuild (ms)\tviewsAtPoint (us)\tindex (us)\tmismatches\n"];
+	
+	for (NSUInteger depth = 2; depth <= 4; depth++)
+	{
+		NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+		UIView *root = [[[UIView alloc] initWithFrame:CGRectMake(0.0f, 0.0f, 1024.0f, 768.0f)] autorelease];
+		NSMutableArray *level = [NSMutableArray arrayWithObject:root];
+		NSUInteger viewCount = 0;
+		for (NSUInteger d = 0; d < depth; d++)
+		{
+			NSMutableArray *nextLevel = [NSMutableArray array];
+			for (UIView *parent in level)
+			{
+				// split the parent in 10 strips, alternately across and down, inset to leave gaps
+				CGSize size = parent.bounds.size;
+				for (NSUInteger i = 0; i < 10; i++)
+				{
+					CGRect frame = (d % 2 == 0) ? CGRectMake(size.width * i / 10.0f, 0.0f, size.width / 10.0f, size.height)
+												: CGRectMake(0.0f, size.height * i / 10.0f, size.width, size.height / 10.0f);
+					UIView *view = [[[UIView alloc] initWithFrame:CGRectInset(frame, frame.size.width / 20.0f, frame.size.height / 20.0f)] autorelease];
+					[parent addSubview:view];
+					[nextLevel addObject:view];
+					viewCount++;
+				}
+			}
+			level = nextLevel;
+		}
+		
+		CGPoint *points = malloc(queryCount * sizeof(CGPoint));
+		for (NSUInteger i = 0; i < queryCount; i++)
+			points[i] = CGPointMake(arc4random() % 1024, arc4random() % 768);
+		
+		CFTimeInterval start = CACurrentMediaTime();
+		DCHitPathIndex *index = [[[DCHitPathIndex alloc] initWithRootView:root ignoredViews:nil] autorelease];
+		CFTimeInterval buildTime = CACurrentMediaTime() - start;
+		
+		UIView **answers = malloc(queryCount * sizeof(UIView *));
+		start = CACurrentMediaTime();
+		for (NSUInteger i = 0; i < queryCount; i++)
+		{
+			NSAutoreleasePool *queryPool = [[NSAutoreleasePool alloc] init];
+			answers[i] = [[self viewsAtPoint:points[i] inView:root] lastObject];
+			[queryPool drain];
+		}
+		CFTimeInterval treeTime = CACurrentMediaTime() - start;
+		
+		NSUInteger mismatches = 0;
+		start = CACurrentMediaTime();
+		for (NSUInteger i = 0; i < queryCount; i++)
+			if ([index topmostViewAtPoint:points[i]] != answers[i])
+				mismatches++;
+		CFTimeInterval indexTime = CACurrentMediaTime() - start;
+		
+		[outputString appendFormat:@"%u\t%.2f\t\t%.2f\t\t\t%.2f\t\t%u\n", viewCount, buildTime * 1e3,
+		 treeTime * 1e6 / queryCount, indexTime * 1e6 / queryCount, mismatches];
+		free(points);
+		free(answers);
+		[pool drain];
+	}
+	
+	printf("%s\n", [outputString UTF8String]);
+}
+
+// Builds a tree of 100 containers of 100 views of assorted classes, and times
+// describing the properties of every view in it, with the plans built on the way
+// and then reused
+- (void)logPropertyDumpBenchmark
+{
+	const NSUInteger warmDumpCount = 5;
+	NSArray *leafClasses = [NSArray arrayWithObjects:[UIView class], [UILabel class], [UIImageView class], [UIProgressView class], [UIActivityIndicatorView class], [UISwitch class], [UISlider class], [UITextField class], nil];
+	
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	NSMutableArray *views = [NSMutableArray array];
+	UIView *root = [[[UIView alloc] initWithFrame:CGRectMake(0.0f, 0.0f, 1024.0f, 768.0f)] autorelease];
+	for (NSUInteger i = 0; i < 100; i++)
+	{
+		UIView *container = [[[UIView alloc] initWithFrame:CGRectMake((i % 10) * 100.0f, (i / 10) * 75.0f, 100.0f, 75.0f)] autorelease];
+		[root addSubview:container];
+		[views addObject:container];
+		for (NSUInteger j = 0; j < 100; j++)
+		{
+			Class leafClass = [leafClasses objectAtIndex:j % leafClasses.count];
+			UIView *view = [[[leafClass alloc] initWithFrame:CGRectMake((j % 10) * 10.0f, (j / 10) * 7.0f, 10.0f, 7.0f)] autorelease];
+			[container addSubview:view];
+			[views addObject:view];
+		}
+	}
+	
+	NSUInteger characterCount = 0;
+	CFTimeInterval times[2] = { 0, 0 };
+	for (NSUInteger pass = 0; pass <= warmDumpCount; pass++)
+	{
+		if (pass == 0)
+			[DCPropertyPlan removeAllPlans];
+		
+		CFTimeInterval start = CACurrentMediaTime();
+		for (NSUInteger i = 0; i < views.count; i += 100)
+		{
+			NSAutoreleasePool *dumpPool = [[NSAutoreleasePool alloc] init];
+			for (NSUInteger j = i; j < MIN(i + 100, views.count); j++)
+				characterCount += [self propertiesDescriptionForObject:[views objectAtIndex:j]].length;
+			[dumpPool drain];
+		}
+		times[pass == 0 ? 0 : 1] += CACurrentMediaTime() - start;
+	}
+	
+	printf("\n\n** property dump benchmark **\n\n%u views, %u characters per dump\n", views.count, characterCount / (warmDumpCount + 1));
+	printf("first dump, building plans:\t%.1f ms\t%.1f dumps/s\n", times[0] * 1e3, 1.0 / times[0]);
+	printf("later dumps, reusing them:\t%.1f ms\t%.1f dumps/s\n\n", times[1] * 1e3 / warmDumpCount, warmDumpCount / times[1]);
+	[pool drain];
+}
+
 #pragma mark Helper Methods
 
 - (UIWindow *)mainWindow
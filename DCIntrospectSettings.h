@@ -19,7 +19,12 @@
 #define kDCIntrospectKeysToggleNonOpaqueViews			@"O"		// changes all non-opaque view background colours to red (destructive)
 #define kDCIntrospectKeysToggleHelp						@"?"		// shows help
 #define kDCIntrospectKeysToggleFlashViewRedraws			@"f"		// toggle flashing on redraw for all views that implement [[DCIntrospect sharedIntrospector] flashRect:inView:] in drawRect:
+#define kDCIntrospectKeysToggleRedrawHeatmap			@"F"		// toggle tinting all views that implement drawRect: by how often they redraw.  Turning it off logs the busiest views.
 #define kDCIntrospectKeysToggleShowCoordinates			@"c"		// toggles the coordinates display
+#define kDCIntrospectKeysWriteSnapshot					@"s"		// writes a snapshot of the main window's view hierarchy, of only the subtrees which changed after the first, to Documents/DCIntrospect.dcsnap.  Read it with Tools/dcsnapshot.
+#define kDCIntrospectKeysUndoEdit						@"z"		// undoes the last change of a frame or alpha with the keys below, of any view.  Changes made with one key held down, or pressed repeatedly within a second, are undone together.
+#define kDCIntrospectKeysRedoEdit						@"Z"		// redoes it
+#define kDCIntrospectKeysLogCodeForAllViewChanges		@")"		// prints code to the console of the changes to every view, not only the selected one
 #define kDCIntrospectKeysEnterBlockMode					@"b"		// enters block action mode
 
 // When introspector is invoked and a view is selected //
@@ -0,0 +1,37 @@
+//
+//  DCObjectNameRegistry.h
+//
+//  Created by Alexis Gallagher on 2012-08-25.
+//
+
+#import <UIKit/UIKit.h>
+
+// Names given to objects, looked up both ways in constant time.
+//
+// Objects are not retained. Each named object carries a small associated object
+// which, when the named object is deallocated, takes its name out of the registry,
+// so names never outlive their objects and never need removing at dealloc.
+//
+// An object has at most one name and a name at most one object: naming an object
+// again renames it, and reusing a name takes it from the object it was given to.
+@interface DCObjectNameRegistry : NSObject
+{
+	CFMutableDictionaryRef namesByObject;		// object -> name, objects not retained
+	CFMutableDictionaryRef objectsByName;		// name -> object, objects not retained
+}
+
+@property (nonatomic, readonly) NSUInteger count;
+
+- (void)setName:(NSString *)name forObject:(id)object;
+// someObjectsByName maps names to the objects to give them
+- (void)setNamesForObjects:(NSDictionary *)someObjectsByName;
+
+- (NSString *)nameForObject:(id)object;			// nil if the object has no name
+- (id)objectForName:(NSString *)name;
+
+- (void)removeNameForObject:(id)object;
+// removes the names of the subviews of view, at any depth, in one walk of the tree
+- (void)removeNamesForViewsInView:(UIView *)view;
+- (void)removeAllNames;
+
+@end
@@ -0,0 +1,179 @@
+//
+//  DCObjectNameRegistry.m
+//
+//  Created by Alexis Gallagher on 2012-08-25.
+//
+
+#import <objc/runtime.h>
+
+#import "DCObjectNameRegistry.h"
+
+// Associated with a named object, and deallocated with it
+@interface DCObjectNameSentinel : NSObject
+{
+	DCObjectNameRegistry *registry;		// not retained, nil once the name is gone
+	void *object;
+}
+
+- (id)initWithRegistry:(DCObjectNameRegistry *)aRegistry object:(void *)anObject;
+- (void)detach;
+
+@end
+
+@interface DCObjectNameRegistry ()
+
+- (void)forgetObject:(void *)object;
+
+@end
+
+@implementation DCObjectNameSentinel
+
+- (id)initWithRegistry:(DCObjectNameRegistry *)aRegistry object:(void *)anObject
+{
+	self = [super init];
+	if (self)
+	{
+		registry = aRegistry;
+		object = anObject;
+	}
+	return self;
+}
+
+- (void)detach
+{
+	registry = nil;
+}
+
+- (void)dealloc
+{
+	// the object is being deallocated: only its address may be used
+	[registry forgetObject:object];
+
+	[super dealloc];
+}
+
+@end
+
+@implementation DCObjectNameRegistry
+
+- (id)init
+{
+	self = [super init];
+	if (self)
+	{
+		namesByObject = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+		objectsByName = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	[self removeAllNames];
+	CFRelease(namesByObject);
+	CFRelease(objectsByName);
+
+	[super dealloc];
+}
+
+- (NSUInteger)count
+{
+	return CFDictionaryGetCount(namesByObject);
+}
+
+#pragma mark Naming
+
+- (void)forgetObject:(void *)object
+{
+	NSString *name = (NSString *)CFDictionaryGetValue(namesByObject, object);
+	if (!name)
+		return;
+	CFDictionaryRemoveValue(objectsByName, name);
+	CFDictionaryRemoveValue(namesByObject, object);
+}
+
+- (void)setName:(NSString *)name forObject:(id)object
+{
+	if (!name || !object)
+		return;
+
+	id namedObject = (id)CFDictionaryGetValue(objectsByName, name);
+	if (namedObject == object)
+		return;
+	if (namedObject)
+		[self removeNameForObject:namedObject];
+
+	if (CFDictionaryContainsKey(namesByObject, object))
+	{
+		// renamed: the sentinel stays
+		CFDictionaryRemoveValue(objectsByName, CFDictionaryGetValue(namesByObject, object));
+	}
+	else
+	{
+		DCObjectNameSentinel *sentinel = [[DCObjectNameSentinel alloc] initWithRegistry:self object:object];
+		objc_setAssociatedObject(object, self, sentinel, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+		[sentinel release];
+	}
+
+	name = [[name copy] autorelease];
+	CFDictionarySetValue(namesByObject, object, name);
+	CFDictionarySetValue(objectsByName, name, object);
+}
+
+- (void)setNamesForObjects:(NSDictionary *)someObjectsByName
+{
+	[someObjectsByName enumerateKeysAndObjectsUsingBlock:^(id name, id object, BOOL *stop) {
+		[self setName:name forObject:object];
+	}];
+}
+
+- (NSString *)nameForObject:(id)object
+{
+	return object ? (NSString *)CFDictionaryGetValue(namesByObject, object) : nil;
+}
+
+- (id)objectForName:(NSString *)name
+{
+	return name ? (id)CFDictionaryGetValue(objectsByName, name) : nil;
+}
+
+#pragma mark Removing
+
+- (void)removeNameForObject:(id)object
+{
+	if (!object || !CFDictionaryContainsKey(namesByObject, object))
+		return;
+
+	[self forgetObject:object];
+	DCObjectNameSentinel *sentinel = objc_getAssociatedObject(object, self);
+	[sentinel detach];
+	objc_setAssociatedObject(object, self, nil, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+}
+
+- (void)removeNamesInSubviewsOfView:(UIView *)view
+{
+	for (UIView *subview in view.subviews)
+	{
+		if (CFDictionaryGetCount(namesByObject) == 0)
+			return;
+		[self removeNameForObject:subview];
+		[self removeNamesInSubviewsOfView:subview];
+	}
+}
+
+- (void)removeNamesForViewsInView:(UIView *)view
+{
+	[self removeNamesInSubviewsOfView:view];
+}
+
+- (void)removeAllNames
+{
+	CFIndex count = CFDictionaryGetCount(namesByObject);
+	const void **objects = malloc(MAX(count, 1) * sizeof(void *));
+	CFDictionaryGetKeysAndValues(namesByObject, objects, NULL);
+	for (CFIndex i = 0; i < count; i++)
+		[self removeNameForObject:(id)objects[i]];
+	free(objects);
+}
+
+@end
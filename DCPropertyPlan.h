@@ -0,0 +1,64 @@
+//
+//  DCPropertyPlan.h
+//
+//  Created by Alexis Gallagher on 2012-08-25.
+//
+
+#import <UIKit/UIKit.h>
+
+// How the value of a property is turned into text
+typedef enum
+{
+	DCPropertyDescriberNone = 0,			// the value itself
+	DCPropertyDescriberContentMode,
+	DCPropertyDescriberTextAlignment,
+	DCPropertyDescriberLineBreakMode,
+	DCPropertyDescriberActivityIndicatorViewStyle,
+	DCPropertyDescriberReturnKeyType,
+	DCPropertyDescriberKeyboardAppearance,
+	DCPropertyDescriberKeyboardType,
+	DCPropertyDescriberAutocorrectionType,
+	DCPropertyDescriberAutocapitalizationType,
+	DCPropertyDescriberTextFieldViewMode,
+	DCPropertyDescriberBorderStyle,
+	DCPropertyDescriberProgressViewStyle,
+	DCPropertyDescriberSeparatorStyle,
+	DCPropertyDescriberSelectionStyle,
+	DCPropertyDescriberEditingStyle,
+	DCPropertyDescriberAccessoryType,
+	DCPropertyDescriberTableViewStyle,
+	DCPropertyDescriberAutoresizingMask,
+	DCPropertyDescriberAccessibilityTraits,
+} DCPropertyDescriber;
+
+// the describer of the properties named propertyName, found in a hash table
+DCPropertyDescriber DCPropertyDescriberForName(NSString *propertyName);
+// the name of an enum value, or the names of a mask's flags. nil for a value out of the enum.
+NSString *DCPropertyDescribeValue(DCPropertyDescriber describer, long long value);
+NSString *DCPropertyDescribeObject(id value);
+NSString *DCPropertyDescribeColor(UIColor *color);
+
+// Describes the properties a class declares, without repeating the reflection.
+//
+// Built once per class: each property's getter is resolved to its implementation,
+// its return type decoded and its describer looked up. Describing an object then
+// calls the getters directly, with no KVC, boxing, or string comparisons, and falls
+// back to valueForKey: only for getters the class does not implement itself.
+@interface DCPropertyPlan : NSObject
+{
+	Class planClass;
+	struct DCPropertyStep *steps;
+	NSUInteger stepCount;
+}
+
+@property (nonatomic, readonly) Class planClass;
+@property (nonatomic, readonly) NSUInteger stepCount;
+
+// the plan of the properties declared by aClass itself, built the first time
++ (DCPropertyPlan *)planForClass:(Class)aClass;
++ (void)removeAllPlans;
+
+// appends a '    name: description' line for each property of object, an instance of the plan's class
+- (void)appendDescriptionOfObject:(id)object toString:(NSMutableString *)string;
+
+@end
@@ -0,0 +1,439 @@
+//
+//  DCPropertyPlan.m
+//
+//  Created by Alexis Gallagher on 2012-08-25.
+//
+
+#import <objc/runtime.h>
+
+#import "DCPropertyPlan.h"
+
+#pragma mark Describers
+
+static NSString * const contentModeNames[] = { @"UIViewContentModeScaleToFill", @"UIViewContentModeScaleAspectFit", @"UIViewContentModeScaleAspectFill", @"UIViewContentModeRedraw", @"UIViewContentModeCenter", @"UIViewContentModeTop", @"UIViewContentModeBottom", @"UIViewContentModeLeft", @"UIViewContentModeRight", @"UIViewContentModeTopLeft", @"UIViewContentModeTopRight", @"UIViewContentModeBottomLeft", @"UIViewContentModeBottomRight" };
+static NSString * const textAlignmentNames[] = { @"UITextAlignmentLeft", @"UITextAlignmentCenter", @"UITextAlignmentRight" };
+static NSString * const lineBreakModeNames[] = { @"UILineBreakModeWordWrap", @"UILineBreakModeCharacterWrap", @"UILineBreakModeClip", @"UILineBreakModeHeadTruncation", @"UILineBreakModeTailTruncation", @"UILineBreakModeMiddleTruncation" };
+static NSString * const activityIndicatorViewStyleNames[] = { @"UIActivityIndicatorViewStyleWhiteLarge", @"UIActivityIndicatorViewStyleWhite", @"UIActivityIndicatorViewStyleGray" };
+static NSString * const returnKeyTypeNames[] = { @"UIReturnKeyDefault", @"UIReturnKeyGo", @"UIReturnKeyGoogle", @"UIReturnKeyJoin", @"UIReturnKeyNext", @"UIReturnKeyRoute", @"UIReturnKeySearch", @"UIReturnKeySend", @"UIReturnKeyYahoo", @"UIReturnKeyDone", @"UIReturnKeyEmergencyCall" };
+static NSString * const keyboardAppearanceNames[] = { @"UIKeyboardAppearanceDefault", @"UIKeyboardAppearanceAlert" };
+static NSString * const keyboardTypeNames[] = { @"UIKeyboardTypeDefault", @"UIKeyboardTypeASCIICapable", @"UIKeyboardTypeNumbersAndPunctuation", @"UIKeyboardTypeURL", @"UIKeyboardTypeNumberPad", @"UIKeyboardTypePhonePad", @"UIKeyboardTypeNamePhonePad", @"UIKeyboardTypeEmailAddress", @"UIKeyboardTypeDecimalPad" };
+static NSString * const autocorrectionTypeNames[] = { @"UITextAutocorrectionTypeDefault", @"UITextAutocorrectionTypeNo", @"UITextAutocorrectionTypeYes" };
+static NSString * const autocapitalizationTypeNames[] = { @"UITextAutocapitalizationTypeNone", @"UITextAutocapitalizationTypeWords", @"UITextAutocapitalizationTypeSentences", @"UITextAutocapitalizationTypeAllCharacters" };
+static NSString * const textFieldViewModeNames[] = { @"UITextFieldViewModeNever", @"UITextFieldViewModeWhileEditing", @"UITextFieldViewModeUnlessEditing", @"UITextFieldViewModeAlways" };
+static NSString * const borderStyleNames[] = { @"UITextBorderStyleNone", @"UITextBorderStyleLine", @"UITextBorderStyleBezel", @"UITextBorderStyleRoundedRect" };
+static NSString * const progressViewStyleNames[] = { @"UIProgressViewStyleDefault", @"UIProgressViewStyleBar" };
+static NSString * const separatorStyleNames[] = { @"UITableViewCellSeparatorStyleNone", @"UITableViewCellSeparatorStyleSingleLine", @"UITableViewCellSeparatorStyleSingleLineEtched" };
+static NSString * const selectionStyleNames[] = { @"UITableViewCellSelectionStyleNone", @"UITableViewCellSelectionStyleBlue", @"UITableViewCellSelectionStyleGray" };
+static NSString * const editingStyleNames[] = { @"UITableViewCellEditingStyleNone", @"UITableViewCellEditingStyleDelete", @"UITableViewCellEditingStyleInsert" };
+static NSString * const accessoryTypeNames[] = { @"UITableViewCellAccessoryNone", @"UITableViewCellAccessoryDisclosureIndicator", @"UITableViewCellAccessoryDetailDisclosureButton", @"UITableViewCellAccessoryCheckmark" };
+static NSString * const tableViewStyleNames[] = { @"UITableViewStylePlain", @"UITableViewStyleGrouped" };
+
+#define DCNames(names) { names, sizeof(names) / sizeof(*names) }
+
+// the value names of each enum describer, by describer
+static const struct { NSString * const *names; NSUInteger count; } enumNames[] = {
+	{ NULL, 0 },
+	DCNames(contentModeNames),
+	DCNames(textAlignmentNames),
+	DCNames(lineBreakModeNames),
+	DCNames(activityIndicatorViewStyleNames),
+	DCNames(returnKeyTypeNames),
+	DCNames(keyboardAppearanceNames),
+	DCNames(keyboardTypeNames),
+	DCNames(autocorrectionTypeNames),
+	DCNames(autocapitalizationTypeNames),
+	DCNames(textFieldViewModeNames),
+	DCNames(borderStyleNames),
+	DCNames(progressViewStyleNames),
+	DCNames(separatorStyleNames),
+	DCNames(selectionStyleNames),
+	DCNames(editingStyleNames),
+	DCNames(accessoryTypeNames),
+	DCNames(tableViewStyleNames),
+};
+
+DCPropertyDescriber DCPropertyDescriberForName(NSString *propertyName)
+{
+	static CFMutableDictionaryRef describersByName = NULL;
+	if (!describersByName)
+	{
+		struct { CFStringRef name; DCPropertyDescriber describer; } describers[] = {
+			{ CFSTR("contentMode"), DCPropertyDescriberContentMode },
+			{ CFSTR("textAlignment"), DCPropertyDescriberTextAlignment },
+			{ CFSTR("lineBreakMode"), DCPropertyDescriberLineBreakMode },
+			{ CFSTR("activityIndicatorViewStyle"), DCPropertyDescriberActivityIndicatorViewStyle },
+			{ CFSTR("returnKeyType"), DCPropertyDescriberReturnKeyType },
+			{ CFSTR("keyboardAppearance"), DCPropertyDescriberKeyboardAppearance },
+			{ CFSTR("keyboardType"), DCPropertyDescriberKeyboardType },
+			{ CFSTR("autocorrectionType"), DCPropertyDescriberAutocorrectionType },
+			{ CFSTR("autocapitalizationType"), DCPropertyDescriberAutocapitalizationType },
+			{ CFSTR("clearButtonMode"), DCPropertyDescriberTextFieldViewMode },
+			{ CFSTR("leftViewMode"), DCPropertyDescriberTextFieldViewMode },
+			{ CFSTR("rightViewMode"), DCPropertyDescriberTextFieldViewMode },
+			{ CFSTR("borderStyle"), DCPropertyDescriberBorderStyle },
+			{ CFSTR("progressViewStyle"), DCPropertyDescriberProgressViewStyle },
+			{ CFSTR("separatorStyle"), DCPropertyDescriberSeparatorStyle },
+			{ CFSTR("selectionStyle"), DCPropertyDescriberSelectionStyle },
+			{ CFSTR("editingStyle"), DCPropertyDescriberEditingStyle },
+			{ CFSTR("accessoryType"), DCPropertyDescriberAccessoryType },
+			{ CFSTR("editingAccessoryType"), DCPropertyDescriberAccessoryType },
+			{ CFSTR("style"), DCPropertyDescriberTableViewStyle },
+			{ CFSTR("autoresizingMask"), DCPropertyDescriberAutoresizingMask },
+			{ CFSTR("accessibilityTraits"), DCPropertyDescriberAccessibilityTraits },
+		};
+		describersByName = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, NULL);
+		for (unsigned int i = 0; i < sizeof(describers) / sizeof(*describers); i++)
+			CFDictionarySetValue(describersByName, describers[i].name, (const void *)(uintptr_t)describers[i].describer);
+	}
+
+	if (!propertyName)
+		return DCPropertyDescriberNone;
+	return (DCPropertyDescriber)(uintptr_t)CFDictionaryGetValue(describersByName, propertyName);
+}
+
+// the names of the flags set in mask, joined by ' | ', or noneName
+static NSString *DCPropertyDescribeFlags(unsigned long long mask, const unsigned long long *flags, NSString * const *names, NSUInteger count, NSString *noneName)
+{
+	NSMutableString *string = nil;
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		if (!(mask & flags[i]))
+			continue;
+		if (!string)
+			string = [NSMutableString stringWithString:names[i]];
+		else
+			[string appendFormat:@" | %@", names[i]];
+	}
+	return string ? string : noneName;
+}
+
+NSString *DCPropertyDescribeValue(DCPropertyDescriber describer, long long value)
+{
+	if (describer == DCPropertyDescriberAutoresizingMask)
+	{
+		static const unsigned long long flags[] = { UIViewAutoresizingFlexibleLeftMargin, UIViewAutoresizingFlexibleRightMargin, UIViewAutoresizingFlexibleTopMargin, UIViewAutoresizingFlexibleBottomMargin, UIViewAutoresizingFlexibleWidth, UIViewAutoresizingFlexibleHeight };
+		static NSString * const names[] = { @"UIViewAutoresizingFlexibleLeftMargin", @"UIViewAutoresizingFlexibleRightMargin", @"UIViewAutoresizingFlexibleTopMargin", @"UIViewAutoresizingFlexibleBottomMargin", @"UIViewAutoresizingFlexibleWidth", @"UIViewAutoresizingFlexibleHeight" };
+		return DCPropertyDescribeFlags(value, flags, names, sizeof(flags) / sizeof(*flags), @"UIViewAutoresizingNone");
+	}
+	if (describer == DCPropertyDescriberAccessibilityTraits)
+	{
+		static NSString * const names[] = { @"UIAccessibilityTraitButton", @"UIAccessibilityTraitLink", @"UIAccessibilityTraitSearchField", @"UIAccessibilityTraitImage", @"UIAccessibilityTraitSelected", @"UIAccessibilityTraitPlaysSound", @"UIAccessibilityTraitKeyboardKey", @"UIAccessibilityTraitStaticText", @"UIAccessibilityTraitSummaryElement", @"UIAccessibilityTraitNotEnabled", @"UIAccessibilityTraitUpdatesFrequently", @"UIAccessibilityTraitStartsMediaSession", @"UIAccessibilityTraitAdjustable" };
+		static unsigned long long flags[sizeof(names) / sizeof(*names)];
+		if (!flags[0])
+		{
+			// the traits are variables, not constants
+			UIAccessibilityTraits traits[] = { UIAccessibilityTraitButton, UIAccessibilityTraitLink, UIAccessibilityTraitSearchField, UIAccessibilityTraitImage, UIAccessibilityTraitSelected, UIAccessibilityTraitPlaysSound, UIAccessibilityTraitKeyboardKey, UIAccessibilityTraitStaticText, UIAccessibilityTraitSummaryElement, UIAccessibilityTraitNotEnabled, UIAccessibilityTraitUpdatesFrequently, UIAccessibilityTraitStartsMediaSession, UIAccessibilityTraitAdjustable };
+			for (unsigned int i = 0; i < sizeof(names) / sizeof(*names); i++)
+				flags[i] = traits[i];
+		}
+		return DCPropertyDescribeFlags(value, flags, names, sizeof(names) / sizeof(*names), @"UIAccessibilityTraitNone");
+	}
+
+	if (describer == DCPropertyDescriberNone || describer >= sizeof(enumNames) / sizeof(*enumNames))
+		return nil;
+	if (value < 0 || value >= (long long)enumNames[describer].count)
+		return nil;
+	return enumNames[describer].names[value];
+}
+
+NSString *DCPropertyDescribeColor(UIColor *color)
+{
+	if (!color)
+		return @"nil";
+
+	if (CGColorSpaceGetModel(CGColorGetColorSpace(color.CGColor)) == kCGColorSpaceModelRGB)
+	{
+		const CGFloat *components = CGColorGetComponents(color.CGColor);
+		return [NSString stringWithFormat:@"R: %.0f G: %.0f B: %.0f A: %.2f",
+				components[0] * 256,
+				components[1] * 256,
+				components[2] * 256,
+				components[3]];
+	}
+	return [NSString stringWithFormat:@"%@ (incompatible color space)", color];
+}
+
+NSString *DCPropertyDescribeObject(id value)
+{
+	if ([value isKindOfClass:[NSValue class]])
+	{
+		const char *type = [value objCType];
+		if (strcmp(type, @encode(BOOL)) == 0)
+			return ([value boolValue]) ? @"YES" : @"NO";
+		if (strcmp(type, @encode(CGSize)) == 0)
+		{
+			CGSize size = [value CGSizeValue];
+			return CGSizeEqualToSize(size, CGSizeZero) ? @"CGSizeZero" : NSStringFromCGSize(size);
+		}
+		if (strcmp(type, @encode(UIEdgeInsets)) == 0)
+		{
+			UIEdgeInsets edgeInsets = [value UIEdgeInsetsValue];
+			return UIEdgeInsetsEqualToEdgeInsets(edgeInsets, UIEdgeInsetsZero) ? @"UIEdgeInsetsZero" : NSStringFromUIEdgeInsets(edgeInsets);
+		}
+	}
+	else if ([value isKindOfClass:[UIColor class]])
+	{
+		return DCPropertyDescribeColor(value);
+	}
+	else if ([value isKindOfClass:[UIFont class]])
+	{
+		UIFont *font = (UIFont *)value;
+		return [NSString stringWithFormat:@"%.0fpx %@", font.pointSize, font.fontName];
+	}
+
+	return value ? [value description] : @"nil";
+}
+
+#pragma mark Plans
+
+// How a getter's value is read
+typedef enum
+{
+	DCPropertyValueObject,
+	DCPropertyValueBool,
+	DCPropertyValueShort,
+	DCPropertyValueInt,
+	DCPropertyValueLong,
+	DCPropertyValueLongLong,
+	DCPropertyValueUnsignedChar,
+	DCPropertyValueUnsignedShort,
+	DCPropertyValueUnsignedInt,
+	DCPropertyValueUnsignedLong,
+	DCPropertyValueUnsignedLongLong,
+	DCPropertyValueFloat,
+	DCPropertyValueDouble,
+	DCPropertyValueSize,
+	DCPropertyValuePoint,
+	DCPropertyValueRect,
+	DCPropertyValueEdgeInsets,
+	DCPropertyValueTransform,
+	DCPropertyValueKeyValueCoding,			// anything else, and getters the class does not implement
+} DCPropertyValueKind;
+
+struct DCPropertyStep
+{
+	NSString *name;							// retained
+	SEL getter;
+	IMP implementation;						// NULL for DCPropertyValueKeyValueCoding
+	DCPropertyValueKind kind;
+	DCPropertyDescriber describer;
+};
+
+static CFMutableDictionaryRef plansByClass = NULL;
+
+@implementation DCPropertyPlan
+@synthesize planClass, stepCount;
+
++ (DCPropertyPlan *)planForClass:(Class)aClass
+{
+	if (!plansByClass)
+		plansByClass = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+
+	DCPropertyPlan *plan = (DCPropertyPlan *)CFDictionaryGetValue(plansByClass, aClass);
+	if (!plan)
+	{
+		plan = [[DCPropertyPlan alloc] initWithClass:aClass];
+		CFDictionarySetValue(plansByClass, aClass, plan);
+		[plan release];
+	}
+	return plan;
+}
+
++ (void)removeAllPlans
+{
+	if (plansByClass)
+		CFDictionaryRemoveAllValues(plansByClass);
+}
+
+// The kind of value a getter returning type gives
+static DCPropertyValueKind DCPropertyValueKindOfType(const char *type)
+{
+	// skip the type qualifiers
+	while (*type && strchr("rnNoORV", *type))
+		type++;
+
+	switch (*type)
+	{
+		case '@': return DCPropertyValueObject;
+		case 'c': return DCPropertyValueBool;		// BOOL, as it is almost always
+		case 'B': return DCPropertyValueBool;
+		case 's': return DCPropertyValueShort;
+		case 'i': return DCPropertyValueInt;
+		case 'l': return DCPropertyValueLong;
+		case 'q': return DCPropertyValueLongLong;
+		case 'C': return DCPropertyValueUnsignedChar;
+		case 'S': return DCPropertyValueUnsignedShort;
+		case 'I': return DCPropertyValueUnsignedInt;
+		case 'L': return DCPropertyValueUnsignedLong;
+		case 'Q': return DCPropertyValueUnsignedLongLong;
+		case 'f': return DCPropertyValueFloat;
+		case 'd': return DCPropertyValueDouble;
+	}
+	if (strcmp(type, @encode(CGSize)) == 0)
+		return DCPropertyValueSize;
+	if (strcmp(type, @encode(CGPoint)) == 0)
+		return DCPropertyValuePoint;
+	if (strcmp(type, @encode(CGRect)) == 0)
+		return DCPropertyValueRect;
+	if (strcmp(type, @encode(UIEdgeInsets)) == 0)
+		return DCPropertyValueEdgeInsets;
+	if (strcmp(type, @encode(CGAffineTransform)) == 0)
+		return DCPropertyValueTransform;
+	return DCPropertyValueKeyValueCoding;
+}
+
+- (id)initWithClass:(Class)aClass
+{
+	self = [super init];
+	if (self)
+	{
+		planClass = aClass;
+
+		unsigned int count = 0;
+		objc_property_t *properties = class_copyPropertyList(aClass, &count);
+		steps = calloc(MAX(count, 1), sizeof(struct DCPropertyStep));
+		for (unsigned int i = 0; i < count; i++)
+		{
+			struct DCPropertyStep *step = &steps[stepCount];
+			NSString *name = [NSString stringWithUTF8String:property_getName(properties[i])];
+			char *getterName = property_copyAttributeValue(properties[i], "G");
+			step->getter = getterName ? sel_registerName(getterName) : NSSelectorFromString(name);
+			free(getterName);
+
+			Method method = class_getInstanceMethod(aClass, step->getter);
+			if (method)
+			{
+				char *returnType = method_copyReturnType(method);
+				step->kind = DCPropertyValueKindOfType(returnType);
+				free(returnType);
+				if (step->kind != DCPropertyValueKeyValueCoding)
+					step->implementation = method_getImplementation(method);
+			}
+			else if ([aClass instancesRespondToSelector:step->getter])
+			{
+				step->kind = DCPropertyValueKeyValueCoding;
+			}
+			else
+			{
+				continue;
+			}
+
+			step->name = [name retain];
+			step->describer = DCPropertyDescriberForName(name);
+			stepCount++;
+		}
+		free(properties);
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	for (NSUInteger i = 0; i < stepCount; i++)
+		[steps[i].name release];
+	free(steps);
+
+	[super dealloc];
+}
+
+#pragma mark Describing
+
+static NSString *DCPropertyDescribeSigned(const struct DCPropertyStep *step, long long value)
+{
+	NSString *description = DCPropertyDescribeValue(step->describer, value);
+	return description ? description : [NSString stringWithFormat:@"%lld", value];
+}
+
+static NSString *DCPropertyDescribeUnsigned(const struct DCPropertyStep *step, unsigned long long value)
+{
+	NSString *description = DCPropertyDescribeValue(step->describer, (long long)value);
+	return description ? description : [NSString stringWithFormat:@"%llu", value];
+}
+
+// Calls the getter of step on object, and describes what it returns
+static NSString *DCPropertyDescribeStep(const struct DCPropertyStep *step, id object)
+{
+	IMP imp = step->implementation;
+	SEL sel = step->getter;
+	switch (step->kind)
+	{
+		case DCPropertyValueObject:
+		{
+			id value = ((id (*)(id, SEL))imp)(object, sel);
+			NSString *description = nil;
+			if (step->describer != DCPropertyDescriberNone && [value isKindOfClass:[NSNumber class]])
+				description = DCPropertyDescribeValue(step->describer, [value longLongValue]);
+			return description ? description : DCPropertyDescribeObject(value);
+		}
+		case DCPropertyValueBool:
+			return ((BOOL (*)(id, SEL))imp)(object, sel) ? @"YES" : @"NO";
+		case DCPropertyValueShort:
+			return DCPropertyDescribeSigned(step, ((short (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueInt:
+			return DCPropertyDescribeSigned(step, ((int (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueLong:
+			return DCPropertyDescribeSigned(step, ((long (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueLongLong:
+			return DCPropertyDescribeSigned(step, ((long long (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueUnsignedChar:
+			return DCPropertyDescribeUnsigned(step, ((unsigned char (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueUnsignedShort:
+			return DCPropertyDescribeUnsigned(step, ((unsigned short (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueUnsignedInt:
+			return DCPropertyDescribeUnsigned(step, ((unsigned int (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueUnsignedLong:
+			return DCPropertyDescribeUnsigned(step, ((unsigned long (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueUnsignedLongLong:
+			return DCPropertyDescribeUnsigned(step, ((unsigned long long (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueFloat:
+			return [NSString stringWithFormat:@"%g", ((float (*)(id, SEL))imp)(object, sel)];
+		case DCPropertyValueDouble:
+			return [NSString stringWithFormat:@"%g", ((double (*)(id, SEL))imp)(object, sel)];
+		case DCPropertyValueSize:
+		{
+			CGSize size = ((CGSize (*)(id, SEL))imp)(object, sel);
+			return CGSizeEqualToSize(size, CGSizeZero) ? @"CGSizeZero" : NSStringFromCGSize(size);
+		}
+		case DCPropertyValuePoint:
+			return NSStringFromCGPoint(((CGPoint (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueRect:
+			return NSStringFromCGRect(((CGRect (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueEdgeInsets:
+		{
+			UIEdgeInsets edgeInsets = ((UIEdgeInsets (*)(id, SEL))imp)(object, sel);
+			return UIEdgeInsetsEqualToEdgeInsets(edgeInsets, UIEdgeInsetsZero) ? @"UIEdgeInsetsZero" : NSStringFromUIEdgeInsets(edgeInsets);
+		}
+		case DCPropertyValueTransform:
+			return NSStringFromCGAffineTransform(((CGAffineTransform (*)(id, SEL))imp)(object, sel));
+		case DCPropertyValueKeyValueCoding:
+		{
+			id value = [object valueForKey:step->name];
+			if (step->describer != DCPropertyDescriberNone && [value isKindOfClass:[NSNumber class]])
+				return DCPropertyDescribeValue(step->describer, [value longLongValue]);
+			return DCPropertyDescribeObject(value);
+		}
+	}
+	return nil;
+}
+
+- (void)appendDescriptionOfObject:(id)object toString:(NSMutableString *)string
+{
+	// one handler for the whole walk, re-entered past a property which raised
+	NSUInteger i = 0;
+	while (i < stepCount)
+	{
+		@try
+		{
+			for (; i < stepCount; i++)
+				[string appendFormat:@"    %@: %@\n", steps[i].name, DCPropertyDescribeStep(&steps[i], object)];
+		}
+		@catch (NSException *exception)
+		{
+			// Non KVC compliant properties, see also +[DCIntrospect workaroundUITextInputTraitsPropertiesBugForClass:]
+			[string appendFormat:@"    %@: N/A\n", steps[i].name];
+			i++;
+		}
+	}
+}
+
+@end
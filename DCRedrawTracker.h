@@ -0,0 +1,61 @@
+//
+//  DCRedrawTracker.h
+//
+//  Created by Alexis Gallagher on 2012-08-26.
+//
+
+#import <UIKit/UIKit.h>
+#import <QuartzCore/QuartzCore.h>
+
+// A view seen redrawing by the heatmap
+typedef struct
+{
+	UIView *view;				// not retained, alive while layer has a superlayer
+	CALayer *layer;				// the view's heat layer, retained
+	NSUInteger count;			// redraws in the current second
+	NSUInteger rate;			// redraws in the last full second
+	NSUInteger peakRate;
+	unsigned long long total;
+	BOOL ignored;				// in one of the ignored views
+} DCRedrawEntry;
+
+// Shows which views redraw, and how often.
+//
+// Flashing: flashRect:inView: covers the rect with a layer for a moment. Layers are
+// taken from a pool and put back when they expire; one timer expires them all, in
+// the order they were shown, since they all last as long.
+//
+// Heatmap: while it is on, UIView's drawLayer:inContext:, through which every
+// drawRect: is called, is hooked to count redraws per view, in an open-addressed
+// table. Once a second the counts become rates, and each view that redrew is tinted,
+// from blue for one redraw a second to red for one per frame.
+@interface DCRedrawTracker : NSObject
+{
+	NSMutableArray *freeLayers;
+	NSMutableArray *flashingLayers;		// oldest first
+	CFTimeInterval *flashExpiries;		// of flashingLayers, in the same order
+	NSUInteger flashExpiryCapacity;
+	NSTimer *flashTimer;
+
+	DCRedrawEntry *entries;
+	NSUInteger entryCount;
+	NSUInteger *slots;					// 1 + index in entries, or 0 if free
+	NSUInteger slotCount;
+	NSTimer *heatmapTimer;
+	NSArray *ignoredViews;
+}
+
+@property (nonatomic) BOOL heatmapOn;
+@property (nonatomic, retain) NSArray *ignoredViews;			// neither counted nor tinted, with their subviews
+@property (nonatomic, readonly) NSUInteger trackedViewCount;
+
+- (void)flashRect:(CGRect)rect inView:(UIView *)view;
+
+- (void)recordRedrawOfView:(UIView *)view;
+
+// the views seen redrawing while the heatmap is on, busiest in the last second first:
+// dictionaries of class, address, frame, rate, peakRate and total
+- (NSArray *)heatmapRates;
+- (BOOL)exportHeatmapToPath:(NSString *)path;
+
+@end
@@ -0,0 +1,333 @@
+//
+//  DCRedrawTracker.m
+//
+//  Created by Alexis Gallagher on 2012-08-26.
+//
+
+#import <objc/runtime.h>
+
+#import "DCRedrawTracker.h"
+#import "DCIntrospectSettings.h"
+
+// flashes shown at once, at most: past this the oldest are taken down early
+#define kDCRedrawTrackerMaxFlashes 256
+// redraws a second shown in full red
+#define kDCRedrawTrackerHotRate 60.0
+
+// the tracker the drawLayer:inContext: hook reports to, while its heatmap is on
+static DCRedrawTracker *heatmapTracker = nil;
+
+@interface DCRedrawTracker ()
+
+- (void)expireFlashes:(NSTimer *)timer;
+- (void)updateHeatmap:(NSTimer *)timer;
+
+@end
+
+@implementation DCRedrawTracker
+@synthesize heatmapOn;
+@synthesize ignoredViews;
+
+- (id)init
+{
+	self = [super init];
+	if (self)
+	{
+		freeLayers = [[NSMutableArray alloc] init];
+		flashingLayers = [[NSMutableArray alloc] init];
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	self.heatmapOn = NO;
+	[flashTimer invalidate];
+	[ignoredViews release];
+	[freeLayers release];
+	[flashingLayers release];
+	free(flashExpiries);
+	for (NSUInteger i = 0; i < entryCount; i++)
+		[entries[i].layer release];
+	free(entries);
+	free(slots);
+
+	[super dealloc];
+}
+
+#pragma mark Flashing
+
+- (void)scheduleFlashTimer
+{
+	if (flashTimer || flashingLayers.count == 0)
+		return;
+	NSTimeInterval delay = MAX(flashExpiries[0] - CACurrentMediaTime(), 0.0);
+	flashTimer = [NSTimer scheduledTimerWithTimeInterval:delay target:self selector:@selector(expireFlashes:) userInfo:nil repeats:NO];
+}
+
+// Takes down the first count flashes, and puts their layers back in the pool
+- (void)removeFlashes:(NSUInteger)count
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	for (NSUInteger i = 0; i < count; i++)
+	{
+		CALayer *layer = [flashingLayers objectAtIndex:i];
+		[layer removeFromSuperlayer];
+		[freeLayers addObject:layer];
+	}
+	[CATransaction commit];
+
+	[flashingLayers removeObjectsInRange:NSMakeRange(0, count)];
+	memmove(flashExpiries, flashExpiries + count, flashingLayers.count * sizeof(CFTimeInterval));
+}
+
+- (void)expireFlashes:(NSTimer *)timer
+{
+	flashTimer = nil;
+
+	// all the flashes due by now, plus a little, so that flashes shown together go together
+	CFTimeInterval now = CACurrentMediaTime() + 0.002;
+	NSUInteger count = 0;
+	while (count < flashingLayers.count && flashExpiries[count] <= now)
+		count++;
+	[self removeFlashes:count];
+	[self scheduleFlashTimer];
+}
+
+- (void)flashRect:(CGRect)rect inView:(UIView *)view
+{
+	if (flashingLayers.count >= kDCRedrawTrackerMaxFlashes)
+		[self removeFlashes:flashingLayers.count - kDCRedrawTrackerMaxFlashes + 1];
+
+	CALayer *layer = [freeLayers lastObject];
+	if (layer)
+	{
+		[flashingLayers addObject:layer];
+		[freeLayers removeLastObject];
+	}
+	else
+	{
+		layer = [CALayer layer];
+		layer.backgroundColor = kDCIntrospectFlashOnRedrawColor.CGColor;
+		[flashingLayers addObject:layer];
+	}
+
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	layer.frame = rect;
+	[view.layer addSublayer:layer];
+	[CATransaction commit];
+
+	if (flashingLayers.count > flashExpiryCapacity)
+	{
+		flashExpiryCapacity = MAX(flashExpiryCapacity * 2, 32);
+		flashExpiries = realloc(flashExpiries, flashExpiryCapacity * sizeof(CFTimeInterval));
+	}
+	flashExpiries[flashingLayers.count - 1] = CACurrentMediaTime() + kDCIntrospectFlashOnRedrawFlashLength;
+	[self scheduleFlashTimer];
+}
+
+#pragma mark Heatmap
+
++ (void)hookDrawing
+{
+	static BOOL hooked = NO;
+	if (hooked)
+		return;
+	hooked = YES;
+
+	method_exchangeImplementations(class_getInstanceMethod([UIView class], @selector(drawLayer:inContext:)),
+								   class_getInstanceMethod([UIView class], @selector(dc_redrawDrawLayer:inContext:)));
+}
+
+- (void)setHeatmapOn:(BOOL)newHeatmapOn
+{
+	if (heatmapOn == newHeatmapOn)
+		return;
+	heatmapOn = newHeatmapOn;
+
+	if (heatmapOn)
+	{
+		[DCRedrawTracker hookDrawing];
+		heatmapTracker = self;
+		heatmapTimer = [NSTimer scheduledTimerWithTimeInterval:1.0 target:self selector:@selector(updateHeatmap:) userInfo:nil repeats:YES];
+	}
+	else
+	{
+		if (heatmapTracker == self)
+			heatmapTracker = nil;
+		[heatmapTimer invalidate];
+		heatmapTimer = nil;
+
+		[CATransaction begin];
+		[CATransaction setDisableActions:YES];
+		for (NSUInteger i = 0; i < entryCount; i++)
+		{
+			[entries[i].layer removeFromSuperlayer];
+			[entries[i].layer release];
+		}
+		[CATransaction commit];
+		entryCount = 0;
+		memset(slots, 0, slotCount * sizeof(NSUInteger));
+	}
+}
+
+- (NSUInteger)trackedViewCount
+{
+	return entryCount;
+}
+
+static NSUInteger DCRedrawSlotOfView(const void *view, NSUInteger slotCount)
+{
+	return (((uintptr_t)view >> 4) * 2654435761u) & (slotCount - 1);
+}
+
+// Refiles the entries in a table of slotCount slots, a power of two
+- (void)rehashToSlotCount:(NSUInteger)newSlotCount
+{
+	free(slots);
+	slotCount = newSlotCount;
+	slots = calloc(slotCount, sizeof(NSUInteger));
+	for (NSUInteger i = 0; i < entryCount; i++)
+	{
+		NSUInteger slot = DCRedrawSlotOfView(entries[i].view, slotCount);
+		while (slots[slot])
+			slot = (slot + 1) & (slotCount - 1);
+		slots[slot] = i + 1;
+	}
+}
+
+- (void)recordRedrawOfView:(UIView *)view
+{
+	if (!slots)
+		[self rehashToSlotCount:256];
+
+	NSUInteger slot = DCRedrawSlotOfView(view, slotCount);
+	while (slots[slot])
+	{
+		DCRedrawEntry *entry = &entries[slots[slot] - 1];
+		if (entry->view == view)
+		{
+			// a new view at the address of a dead one: start again
+			if (entry->layer.superlayer != view.layer)
+			{
+				[view.layer addSublayer:entry->layer];
+				entry->count = entry->rate = entry->peakRate = 0;
+				entry->total = 0;
+				entry->ignored = NO;
+				for (UIView *aView = view; aView && !entry->ignored; aView = aView.superview)
+					entry->ignored = [ignoredViews indexOfObjectIdenticalTo:aView] != NSNotFound;
+			}
+			entry->count++;
+			entry->total++;
+			return;
+		}
+		slot = (slot + 1) & (slotCount - 1);
+	}
+
+	if (entryCount % 256 == 0)
+		entries = realloc(entries, (entryCount + 256) * sizeof(DCRedrawEntry));
+	DCRedrawEntry *entry = &entries[entryCount];
+	memset(entry, 0, sizeof(*entry));
+	entry->view = view;
+	entry->count = 1;
+	entry->total = 1;
+	for (UIView *aView = view; aView && !entry->ignored; aView = aView.superview)
+		entry->ignored = [ignoredViews indexOfObjectIdenticalTo:aView] != NSNotFound;
+
+	// shown from the next update
+	entry->layer = [[CALayer alloc] init];
+	entry->layer.hidden = YES;
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+	[view.layer addSublayer:entry->layer];
+	[CATransaction commit];
+
+	slots[slot] = ++entryCount;
+	if (entryCount * 2 > slotCount)
+		[self rehashToSlotCount:slotCount * 2];
+}
+
+- (void)updateHeatmap:(NSTimer *)timer
+{
+	[CATransaction begin];
+	[CATransaction setDisableActions:YES];
+
+	// rates from the counts, and out with the views which are gone
+	NSUInteger kept = 0;
+	for (NSUInteger i = 0; i < entryCount; i++)
+	{
+		DCRedrawEntry entry = entries[i];
+		if (!entry.layer.superlayer)
+		{
+			[entry.layer release];
+			continue;
+		}
+
+		entry.rate = entry.count;
+		entry.count = 0;
+		entry.peakRate = MAX(entry.peakRate, entry.rate);
+		entry.layer.hidden = (entry.rate == 0 || entry.ignored);
+		if (!entry.layer.hidden)
+		{
+			CGFloat heat = MIN(log((double)entry.rate) / log(kDCRedrawTrackerHotRate), 1.0);
+			entry.layer.backgroundColor = [UIColor colorWithHue:0.66f * (1.0f - heat) saturation:1.0f brightness:1.0f alpha:0.45f].CGColor;
+			entry.layer.frame = entry.layer.superlayer.bounds;
+		}
+		entries[kept++] = entry;
+	}
+	entryCount = kept;
+	[self rehashToSlotCount:slotCount];
+
+	[CATransaction commit];
+}
+
+- (NSArray *)heatmapRates
+{
+	NSMutableArray *rates = [NSMutableArray arrayWithCapacity:entryCount];
+	for (NSUInteger i = 0; i < entryCount; i++)
+	{
+		if (!entries[i].layer.superlayer || entries[i].ignored)
+			continue;
+		UIView *view = entries[i].view;
+		[rates addObject:[NSDictionary dictionaryWithObjectsAndKeys:
+						  NSStringFromClass([view class]), @"class",
+						  [NSString stringWithFormat:@"%p", view], @"address",
+						  NSStringFromCGRect(view.frame), @"frame",
+						  [NSNumber numberWithUnsignedInteger:entries[i].rate], @"rate",
+						  [NSNumber numberWithUnsignedInteger:entries[i].peakRate], @"peakRate",
+						  [NSNumber numberWithUnsignedLongLong:entries[i].total], @"total",
+						  nil]];
+	}
+	[rates sortUsingDescriptors:[NSArray arrayWithObjects:
+								 [NSSortDescriptor sortDescriptorWithKey:@"rate" ascending:NO],
+								 [NSSortDescriptor sortDescriptorWithKey:@"total" ascending:NO],
+								 nil]];
+	return rates;
+}
+
+- (BOOL)exportHeatmapToPath:(NSString *)path
+{
+	NSError *error = nil;
+	NSData *data = [NSJSONSerialization dataWithJSONObject:[self heatmapRates] options:NSJSONWritingPrettyPrinted error:&error];
+	if (!data || ![data writeToFile:path options:NSDataWritingAtomic error:&error])
+	{
+		NSLog(@"DCIntrospect: Couldn't export the redraw heatmap to %@: %@", path, error);
+		return NO;
+	}
+	return YES;
+}
+
+@end
+
+@implementation UIView (DCRedrawTracker)
+
+- (void)dc_redrawDrawLayer:(CALayer *)layer inContext:(CGContextRef)context
+{
+	[self dc_redrawDrawLayer:layer inContext:context];
+	if (heatmapTracker && layer == self.layer)
+		[heatmapTracker recordRedrawOfView:self];
+}
+
+@end
@@ -0,0 +1,587 @@
+//
+//  DCSnapshotFormat.c
+//
+//  Created by Alexis Gallagher on 2012-08-27.
+//
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "DCSnapshotFormat.h"
+
+// the largest record, a string, and whatever is in the chunk must fit in one chunk
+#define kDCSnapshotMinChunkSize (5 + 0xFFFF + 64)
+#define kDCSnapshotMaxStrings 0xFFFF
+#define kDCSnapshotNodeRecordLength 43
+
+struct DCSnapshotEncoder
+{
+	uint8_t *chunk;
+	size_t chunkSize;
+	size_t length;
+	DCSnapshotFlushFunction flush;
+	void *context;
+
+	// interned strings: open-addressed, slot -> id, 0 if free
+	char **strings;					// by id - 1
+	size_t stringCount;
+	uint16_t *slots;
+	size_t slotCount;
+};
+
+#pragma mark Writing
+
+static void DCSnapshotReserve(DCSnapshotEncoder *encoder, size_t length)
+{
+	if (encoder->length + length > encoder->chunkSize)
+		DCSnapshotEncoderFlush(encoder);
+}
+
+static void DCSnapshotPutBytes(DCSnapshotEncoder *encoder, const void *bytes, size_t length)
+{
+	memcpy(encoder->chunk + encoder->length, bytes, length);
+	encoder->length += length;
+}
+
+static void DCSnapshotPut8(DCSnapshotEncoder *encoder, uint8_t value)
+{
+	encoder->chunk[encoder->length++] = value;
+}
+
+static void DCSnapshotPut16(DCSnapshotEncoder *encoder, uint16_t value)
+{
+	DCSnapshotPut8(encoder, value & 0xFF);
+	DCSnapshotPut8(encoder, value >> 8);
+}
+
+static void DCSnapshotPut32(DCSnapshotEncoder *encoder, uint32_t value)
+{
+	for (int i = 0; i < 4; i++)
+		DCSnapshotPut8(encoder, (value >> (8 * i)) & 0xFF);
+}
+
+static void DCSnapshotPut64(DCSnapshotEncoder *encoder, uint64_t value)
+{
+	for (int i = 0; i < 8; i++)
+		DCSnapshotPut8(encoder, (value >> (8 * i)) & 0xFF);
+}
+
+static void DCSnapshotPutFloat(DCSnapshotEncoder *encoder, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	DCSnapshotPut32(encoder, bits);
+}
+
+static void DCSnapshotPutDouble(DCSnapshotEncoder *encoder, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	DCSnapshotPut64(encoder, bits);
+}
+
+DCSnapshotEncoder *DCSnapshotEncoderCreate(size_t chunkSize, DCSnapshotFlushFunction flush, void *context)
+{
+	DCSnapshotEncoder *encoder = calloc(1, sizeof(DCSnapshotEncoder));
+	encoder->chunkSize = chunkSize < kDCSnapshotMinChunkSize ? kDCSnapshotMinChunkSize : chunkSize;
+	encoder->chunk = malloc(encoder->chunkSize);
+	encoder->flush = flush;
+	encoder->context = context;
+
+	DCSnapshotPutBytes(encoder, "DCSN", 4);
+	DCSnapshotPut32(encoder, DC_SNAPSHOT_VERSION);
+	return encoder;
+}
+
+void DCSnapshotEncoderDestroy(DCSnapshotEncoder *encoder)
+{
+	if (!encoder)
+		return;
+	DCSnapshotEncoderFlush(encoder);
+	for (size_t i = 0; i < encoder->stringCount; i++)
+		free(encoder->strings[i]);
+	free(encoder->strings);
+	free(encoder->slots);
+	free(encoder->chunk);
+	free(encoder);
+}
+
+void DCSnapshotEncoderFlush(DCSnapshotEncoder *encoder)
+{
+	if (encoder->length == 0)
+		return;
+	encoder->flush(encoder->chunk, encoder->length, encoder->context);
+	encoder->length = 0;
+}
+
+static uint32_t DCSnapshotHashString(const char *string, size_t length)
+{
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < length; i++)
+		hash = (hash ^ (uint8_t)string[i]) * 16777619u;
+	return hash;
+}
+
+static void DCSnapshotRehashStrings(DCSnapshotEncoder *encoder, size_t slotCount)
+{
+	free(encoder->slots);
+	encoder->slotCount = slotCount;
+	encoder->slots = calloc(slotCount, sizeof(uint16_t));
+	for (size_t i = 0; i < encoder->stringCount; i++)
+	{
+		const char *string = encoder->strings[i];
+		size_t slot = DCSnapshotHashString(string, strlen(string)) & (slotCount - 1);
+		while (encoder->slots[slot])
+			slot = (slot + 1) & (slotCount - 1);
+		encoder->slots[slot] = (uint16_t)(i + 1);
+	}
+}
+
+// The id of the string, writing it out the first time. 0, as for no string, for NULL,
+// or once the table is full.
+static uint16_t DCSnapshotInternString(DCSnapshotEncoder *encoder, const char *string)
+{
+	if (!string)
+		return 0;
+	size_t length = strlen(string);
+	if (length > 0xFFFF)
+		length = 0xFFFF;
+
+	if (!encoder->slots)
+		DCSnapshotRehashStrings(encoder, 256);
+	size_t slot = DCSnapshotHashString(string, length) & (encoder->slotCount - 1);
+	while (encoder->slots[slot])
+	{
+		const char *interned = encoder->strings[encoder->slots[slot] - 1];
+		if (strncmp(interned, string, length) == 0 && interned[length] == '\0')
+			return encoder->slots[slot];
+		slot = (slot + 1) & (encoder->slotCount - 1);
+	}
+	if (encoder->stringCount == kDCSnapshotMaxStrings)
+		return 0;
+
+	if (encoder->stringCount % 256 == 0)
+		encoder->strings = realloc(encoder->strings, (encoder->stringCount + 256) * sizeof(char *));
+	char *copy = malloc(length + 1);
+	memcpy(copy, string, length);
+	copy[length] = '\0';
+	encoder->strings[encoder->stringCount] = copy;
+	uint16_t id = (uint16_t)++encoder->stringCount;
+	encoder->slots[slot] = id;
+	if (encoder->stringCount * 2 > encoder->slotCount)
+		DCSnapshotRehashStrings(encoder, encoder->slotCount * 2);
+
+	DCSnapshotReserve(encoder, 5 + length);
+	DCSnapshotPut8(encoder, 'S');
+	DCSnapshotPut16(encoder, id);
+	DCSnapshotPut16(encoder, (uint16_t)length);
+	DCSnapshotPutBytes(encoder, copy, length);
+	return id;
+}
+
+void DCSnapshotEncoderBeginSnapshot(DCSnapshotEncoder *encoder, uint32_t sequence, bool incremental, double time)
+{
+	DCSnapshotReserve(encoder, 14);
+	DCSnapshotPut8(encoder, 'B');
+	DCSnapshotPut32(encoder, sequence);
+	DCSnapshotPut8(encoder, incremental ? 1 : 0);
+	DCSnapshotPutDouble(encoder, time);
+}
+
+void DCSnapshotEncoderBeginTree(DCSnapshotEncoder *encoder, uint64_t parentId)
+{
+	DCSnapshotReserve(encoder, 9);
+	DCSnapshotPut8(encoder, 'T');
+	DCSnapshotPut64(encoder, parentId);
+}
+
+void DCSnapshotEncoderWriteNode(DCSnapshotEncoder *encoder, const DCSnapshotNode *node)
+{
+	// the strings first, since they may need records of their own
+	uint16_t classId = DCSnapshotInternString(encoder, node->className);
+	uint16_t nameId = DCSnapshotInternString(encoder, node->name);
+
+	DCSnapshotReserve(encoder, kDCSnapshotNodeRecordLength);
+	DCSnapshotPut8(encoder, 'N');
+	DCSnapshotPut64(encoder, node->id);
+	DCSnapshotPutFloat(encoder, node->x);
+	DCSnapshotPutFloat(encoder, node->y);
+	DCSnapshotPutFloat(encoder, node->width);
+	DCSnapshotPutFloat(encoder, node->height);
+	DCSnapshotPutFloat(encoder, node->alpha);
+	DCSnapshotPut8(encoder, node->flags);
+	DCSnapshotPut8(encoder, node->roles);
+	DCSnapshotPut32(encoder, (uint32_t)node->tag);
+	DCSnapshotPut16(encoder, classId);
+	DCSnapshotPut16(encoder, nameId);
+	DCSnapshotPut32(encoder, node->childCount);
+}
+
+void DCSnapshotEncoderEndSnapshot(DCSnapshotEncoder *encoder, uint32_t visitedCount, uint32_t writtenCount)
+{
+	DCSnapshotReserve(encoder, 9);
+	DCSnapshotPut8(encoder, 'E');
+	DCSnapshotPut32(encoder, visitedCount);
+	DCSnapshotPut32(encoder, writtenCount);
+}
+
+#pragma mark Incremental writing
+
+typedef struct
+{
+	uint64_t id;
+	uint64_t ownHash;
+	uint64_t subtreeHash;
+} DCSnapshotHistoryEntry;
+
+struct DCSnapshotHistory
+{
+	uint64_t rootId;
+	DCSnapshotHistoryEntry *entries;	// open-addressed by id, id 0 if free
+	size_t slotCount;
+};
+
+DCSnapshotHistory *DCSnapshotHistoryCreate(void)
+{
+	return calloc(1, sizeof(DCSnapshotHistory));
+}
+
+void DCSnapshotHistoryDestroy(DCSnapshotHistory *history)
+{
+	if (!history)
+		return;
+	free(history->entries);
+	free(history);
+}
+
+static size_t DCSnapshotSlotOfId(uint64_t id, size_t slotCount)
+{
+	return (size_t)((id >> 4) * 11400714819323198485ull >> 20) & (slotCount - 1);
+}
+
+static const DCSnapshotHistoryEntry *DCSnapshotHistoryEntryOfId(const DCSnapshotHistory *history, uint64_t id)
+{
+	if (!history->entries)
+		return NULL;
+	size_t slot = DCSnapshotSlotOfId(id, history->slotCount);
+	while (history->entries[slot].id)
+	{
+		if (history->entries[slot].id == id)
+			return &history->entries[slot];
+		slot = (slot + 1) & (history->slotCount - 1);
+	}
+	return NULL;
+}
+
+static uint64_t DCSnapshotMix(uint64_t hash, uint64_t value)
+{
+	hash ^= value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2);
+	hash ^= hash >> 31;
+	hash *= 0xBF58476D1CE4E5B9ull;
+	return hash ^ (hash >> 29);
+}
+
+static uint64_t DCSnapshotMixFloat(uint64_t hash, float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return DCSnapshotMix(hash, bits);
+}
+
+static uint64_t DCSnapshotMixString(uint64_t hash, const char *string)
+{
+	return DCSnapshotMix(hash, string ? DCSnapshotHashString(string, strlen(string)) : 0xFFFFFFFFFFull);
+}
+
+static uint64_t DCSnapshotOwnHash(const DCSnapshotNode *node)
+{
+	uint64_t hash = DCSnapshotMix(0, node->id);
+	hash = DCSnapshotMixFloat(hash, node->x);
+	hash = DCSnapshotMixFloat(hash, node->y);
+	hash = DCSnapshotMixFloat(hash, node->width);
+	hash = DCSnapshotMixFloat(hash, node->height);
+	hash = DCSnapshotMixFloat(hash, node->alpha);
+	hash = DCSnapshotMix(hash, node->flags | (node->roles << 8) | ((uint64_t)(uint32_t)node->tag << 16));
+	hash = DCSnapshotMixString(hash, node->className);
+	hash = DCSnapshotMixString(hash, node->name);
+	return DCSnapshotMix(hash, node->childCount);
+}
+
+uint32_t DCSnapshotEncoderWriteSnapshot(DCSnapshotEncoder *encoder, DCSnapshotHistory *history, uint32_t sequence, double time,
+										const DCSnapshotNode *nodes, uint32_t count, bool incremental)
+{
+	if (count == 0)
+	{
+		DCSnapshotEncoderBeginSnapshot(encoder, sequence, false, time);
+		DCSnapshotEncoderEndSnapshot(encoder, 0, 0);
+		return 0;
+	}
+
+	// Backwards, each node comes after its subtree, and its children's results are on
+	// top of the stack, the first child on top.
+	uint64_t *ownHashes = malloc(count * sizeof(uint64_t));
+	uint64_t *subtreeHashes = malloc(count * sizeof(uint64_t));
+	uint32_t *ends = malloc(count * sizeof(uint32_t));			// index after the subtree
+	uint32_t *parents = malloc(count * sizeof(uint32_t));
+	uint32_t *stack = malloc(count * sizeof(uint32_t));
+	uint32_t stackCount = 0;
+	for (uint32_t i = count; i-- > 0; )
+	{
+		uint64_t ownHash = DCSnapshotOwnHash(&nodes[i]);
+		uint64_t subtreeHash = ownHash;
+		ends[i] = i + 1;
+		for (uint32_t c = 0; c < nodes[i].childCount && stackCount > 0; c++)
+		{
+			uint32_t child = stack[--stackCount];
+			// the child ids, for the list of subviews
+			ownHash = DCSnapshotMix(ownHash, nodes[child].id);
+			subtreeHash = DCSnapshotMix(subtreeHash, subtreeHashes[child]);
+			ends[i] = ends[child];
+			parents[child] = i;
+		}
+		ownHashes[i] = ownHash;
+		subtreeHashes[i] = DCSnapshotMix(subtreeHash, ownHash);
+		stack[stackCount++] = i;
+	}
+	free(stack);
+
+	if (history->rootId != nodes[0].id)
+		incremental = false;
+
+	DCSnapshotEncoderBeginSnapshot(encoder, sequence, incremental, time);
+	uint32_t written = 0;
+	for (uint32_t i = 0; i < count; )
+	{
+		const DCSnapshotHistoryEntry *entry = incremental ? DCSnapshotHistoryEntryOfId(history, nodes[i].id) : NULL;
+		if (entry && entry->ownHash == ownHashes[i])
+		{
+			// only something further down changed, if anything
+			i = entry->subtreeHash == subtreeHashes[i] ? ends[i] : i + 1;
+			continue;
+		}
+
+		DCSnapshotEncoderBeginTree(encoder, i == 0 ? 0 : nodes[parents[i]].id);
+		for (uint32_t j = i; j < ends[i]; j++)
+			DCSnapshotEncoderWriteNode(encoder, &nodes[j]);
+		written += ends[i] - i;
+		i = ends[i];
+	}
+	DCSnapshotEncoderEndSnapshot(encoder, count, written);
+
+	// the history, for the next snapshot
+	size_t slotCount = 256;
+	while (slotCount < (size_t)count * 2)
+		slotCount *= 2;
+	if (slotCount != history->slotCount)
+	{
+		free(history->entries);
+		history->entries = malloc(slotCount * sizeof(DCSnapshotHistoryEntry));
+		history->slotCount = slotCount;
+	}
+	memset(history->entries, 0, slotCount * sizeof(DCSnapshotHistoryEntry));
+	history->rootId = nodes[0].id;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		size_t slot = DCSnapshotSlotOfId(nodes[i].id, slotCount);
+		while (history->entries[slot].id && history->entries[slot].id != nodes[i].id)
+			slot = (slot + 1) & (slotCount - 1);
+		history->entries[slot].id = nodes[i].id;
+		history->entries[slot].ownHash = ownHashes[i];
+		history->entries[slot].subtreeHash = subtreeHashes[i];
+	}
+
+	free(ownHashes);
+	free(subtreeHashes);
+	free(ends);
+	free(parents);
+	return written;
+}
+
+#pragma mark Reading
+
+static bool DCSnapshotHas(DCSnapshotDecoder *decoder, size_t length)
+{
+	if (decoder->length - decoder->offset >= length)
+		return true;
+	decoder->error = "truncated record";
+	return false;
+}
+
+static uint8_t DCSnapshotGet8(DCSnapshotDecoder *decoder)
+{
+	return decoder->bytes[decoder->offset++];
+}
+
+static uint16_t DCSnapshotGet16(DCSnapshotDecoder *decoder)
+{
+	uint16_t value = decoder->bytes[decoder->offset] | (decoder->bytes[decoder->offset + 1] << 8);
+	decoder->offset += 2;
+	return value;
+}
+
+static uint32_t DCSnapshotGet32(DCSnapshotDecoder *decoder)
+{
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++)
+		value |= (uint32_t)decoder->bytes[decoder->offset + i] << (8 * i);
+	decoder->offset += 4;
+	return value;
+}
+
+static uint64_t DCSnapshotGet64(DCSnapshotDecoder *decoder)
+{
+	uint64_t value = 0;
+	for (int i = 0; i < 8; i++)
+		value |= (uint64_t)decoder->bytes[decoder->offset + i] << (8 * i);
+	decoder->offset += 8;
+	return value;
+}
+
+static float DCSnapshotGetFloat(DCSnapshotDecoder *decoder)
+{
+	uint32_t bits = DCSnapshotGet32(decoder);
+	float value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static double DCSnapshotGetDouble(DCSnapshotDecoder *decoder)
+{
+	uint64_t bits = DCSnapshotGet64(decoder);
+	double value;
+	memcpy(&value, &bits, sizeof(value));
+	return value;
+}
+
+static const char *DCSnapshotStringWithId(DCSnapshotDecoder *decoder, uint16_t id)
+{
+	if (id == 0 || id > decoder->stringCount)
+		return NULL;
+	return decoder->strings[id - 1];
+}
+
+bool DCSnapshotDecoderInit(DCSnapshotDecoder *decoder, const uint8_t *bytes, size_t length)
+{
+	memset(decoder, 0, sizeof(*decoder));
+	decoder->bytes = bytes;
+	decoder->length = length;
+
+	if (length < 8 || memcmp(bytes, "DCSN", 4) != 0)
+	{
+		decoder->error = "not a snapshot stream";
+		return false;
+	}
+	decoder->offset = 4;
+	if (DCSnapshotGet32(decoder) != DC_SNAPSHOT_VERSION)
+	{
+		decoder->error = "unknown snapshot version";
+		return false;
+	}
+	return true;
+}
+
+void DCSnapshotDecoderFree(DCSnapshotDecoder *decoder)
+{
+	for (size_t i = 0; i < decoder->stringCount; i++)
+		free(decoder->strings[i]);
+	free(decoder->strings);
+	decoder->strings = NULL;
+	decoder->stringCount = 0;
+}
+
+static DCSnapshotRecordType DCSnapshotReadNode(DCSnapshotDecoder *decoder, DCSnapshotRecord *record)
+{
+	if (!DCSnapshotHas(decoder, kDCSnapshotNodeRecordLength - 1))
+		return DCSnapshotRecordError;
+	DCSnapshotNode *node = &record->node;
+	node->id = DCSnapshotGet64(decoder);
+	node->x = DCSnapshotGetFloat(decoder);
+	node->y = DCSnapshotGetFloat(decoder);
+	node->width = DCSnapshotGetFloat(decoder);
+	node->height = DCSnapshotGetFloat(decoder);
+	node->alpha = DCSnapshotGetFloat(decoder);
+	node->flags = DCSnapshotGet8(decoder);
+	node->roles = DCSnapshotGet8(decoder);
+	node->tag = (int32_t)DCSnapshotGet32(decoder);
+	node->className = DCSnapshotStringWithId(decoder, DCSnapshotGet16(decoder));
+	node->name = DCSnapshotStringWithId(decoder, DCSnapshotGet16(decoder));
+	node->childCount = DCSnapshotGet32(decoder);
+	if (!node->className)
+		node->className = "?";
+
+	// each child is a node record still to come
+	if (node->childCount > (decoder->length - decoder->offset) / kDCSnapshotNodeRecordLength)
+	{
+		decoder->error = "more children than there is data for";
+		return DCSnapshotRecordError;
+	}
+	return DCSnapshotRecordNode;
+}
+
+DCSnapshotRecordType DCSnapshotDecoderNext(DCSnapshotDecoder *decoder, DCSnapshotRecord *record)
+{
+	memset(record, 0, sizeof(*record));
+	if (decoder->error)
+		return record->type = DCSnapshotRecordError;
+
+	for (;;)
+	{
+		if (decoder->offset == decoder->length)
+			return record->type = DCSnapshotRecordEnd;
+
+		uint8_t tag = DCSnapshotGet8(decoder);
+		switch (tag)
+		{
+			case 'S':
+			{
+				if (!DCSnapshotHas(decoder, 4))
+					return record->type = DCSnapshotRecordError;
+				uint16_t id = DCSnapshotGet16(decoder);
+				uint16_t length = DCSnapshotGet16(decoder);
+				if (!DCSnapshotHas(decoder, length))
+					return record->type = DCSnapshotRecordError;
+				if (id != decoder->stringCount + 1)
+				{
+					decoder->error = "string out of order";
+					return record->type = DCSnapshotRecordError;
+				}
+				if (decoder->stringCount % 256 == 0)
+					decoder->strings = realloc(decoder->strings, (decoder->stringCount + 256) * sizeof(char *));
+				char *string = malloc(length + 1);
+				memcpy(string, decoder->bytes + decoder->offset, length);
+				string[length] = '\0';
+				decoder->strings[decoder->stringCount++] = string;
+				decoder->offset += length;
+				break;
+			}
+
+			case 'B':
+				if (!DCSnapshotHas(decoder, 13))
+					return record->type = DCSnapshotRecordError;
+				record->sequence = DCSnapshotGet32(decoder);
+				record->incremental = DCSnapshotGet8(decoder) != 0;
+				record->time = DCSnapshotGetDouble(decoder);
+				return record->type = DCSnapshotRecordBeginSnapshot;
+
+			case 'T':
+				if (!DCSnapshotHas(decoder, 8))
+					return record->type = DCSnapshotRecordError;
+				record->parentId = DCSnapshotGet64(decoder);
+				return record->type = DCSnapshotRecordTree;
+
+			case 'N':
+				return record->type = DCSnapshotReadNode(decoder, record);
+
+			case 'E':
+				if (!DCSnapshotHas(decoder, 8))
+					return record->type = DCSnapshotRecordError;
+				record->visitedCount = DCSnapshotGet32(decoder);
+				record->writtenCount = DCSnapshotGet32(decoder);
+				return record->type = DCSnapshotRecordEndSnapshot;
+
+			default:
+				decoder->error = "unknown record";
+				return record->type = DCSnapshotRecordError;
+		}
+	}
+}
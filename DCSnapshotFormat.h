@@ -0,0 +1,140 @@
+//
+//  DCSnapshotFormat.h
+//
+//  Created by Alexis Gallagher on 2012-08-27.
+//
+
+#ifndef DCSnapshotFormat_h
+#define DCSnapshotFormat_h
+
+// A compact binary record of view hierarchies, written as a stream of snapshots.
+//
+// Plain C, with no UIKit, so that the decoder also builds into the Linux tool in
+// Tools/dcsnapshot.c, which lists, dumps and diffs snapshot files.
+//
+// A full snapshot holds the whole tree. An incremental one holds only the subtrees
+// which changed since the snapshot before it, each replacing the subtree of the same
+// root: a subtree is written again when its root's own values or its list of
+// subviews changed. Views are identified by address, so a view which is deallocated
+// and another allocated at the same address look like one view which changed.
+//
+// Format, all integers little-endian, floats as IEEE 754 single precision:
+//   header:    "DCSN", uint32 version
+//   'B':       begin snapshot: uint32 sequence, uint8 incremental, float64 time in seconds
+//   'S':       string: uint16 id, uint16 length, bytes. Ids count from 1 in each stream.
+//   'T':       tree: uint64 id of the parent of its root, 0 for the root of the hierarchy,
+//              then its nodes in depth first order, each with its child count
+//   'N':       node: uint64 id, float32 x, y, width, height, alpha, uint8 flags, uint8 roles,
+//              int32 tag, uint16 class string id, uint16 name string id or 0, uint32 child count
+//   'E':       end snapshot: uint32 views visited, uint32 nodes written
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define DC_SNAPSHOT_VERSION 1
+
+typedef enum
+{
+	DCSnapshotFlagHidden					= 1 << 0,
+	DCSnapshotFlagOpaque					= 1 << 1,
+	DCSnapshotFlagClipsToBounds				= 1 << 2,
+	DCSnapshotFlagUserInteractionEnabled	= 1 << 3,
+} DCSnapshotFlag;
+
+// Drag and drop roles, as the host reports them. The values are those of MCKDragDropRole.
+typedef enum
+{
+	DCSnapshotRoleDraggable					= 1 << 0,
+	DCSnapshotRoleDonor						= 1 << 1,
+	DCSnapshotRoleAbsorber					= 1 << 2,
+} DCSnapshotRole;
+
+typedef struct
+{
+	uint64_t id;
+	float x, y, width, height;				// frame, in the superview's coordinates
+	float alpha;
+	uint8_t flags;
+	uint8_t roles;
+	int32_t tag;
+	const char *className;
+	const char *name;						// or NULL
+	uint32_t childCount;
+} DCSnapshotNode;
+
+/////////////
+// Writing //
+/////////////
+
+// receives the stream in chunks, each at most the encoder's chunk size
+typedef void (*DCSnapshotFlushFunction)(const uint8_t *bytes, size_t length, void *context);
+
+typedef struct DCSnapshotEncoder DCSnapshotEncoder;
+
+// writes the header. Strings are interned for the life of the encoder.
+DCSnapshotEncoder *DCSnapshotEncoderCreate(size_t chunkSize, DCSnapshotFlushFunction flush, void *context);
+// flushes what is left
+void DCSnapshotEncoderDestroy(DCSnapshotEncoder *encoder);
+
+void DCSnapshotEncoderBeginSnapshot(DCSnapshotEncoder *encoder, uint32_t sequence, bool incremental, double time);
+void DCSnapshotEncoderBeginTree(DCSnapshotEncoder *encoder, uint64_t parentId);
+void DCSnapshotEncoderWriteNode(DCSnapshotEncoder *encoder, const DCSnapshotNode *node);
+void DCSnapshotEncoderEndSnapshot(DCSnapshotEncoder *encoder, uint32_t visitedCount, uint32_t writtenCount);
+void DCSnapshotEncoderFlush(DCSnapshotEncoder *encoder);
+
+// What the last snapshot written held, by hashes of each view's own values and list of
+// subviews, and of its whole subtree: enough to tell which subtrees changed since.
+typedef struct DCSnapshotHistory DCSnapshotHistory;
+
+DCSnapshotHistory *DCSnapshotHistoryCreate(void);
+void DCSnapshotHistoryDestroy(DCSnapshotHistory *history);
+
+// Writes a snapshot of a hierarchy given in depth first order: in full, or only the
+// subtrees which changed since the last one written with history. It is written in full
+// anyway when it has a different root. Returns the count of nodes written.
+uint32_t DCSnapshotEncoderWriteSnapshot(DCSnapshotEncoder *encoder, DCSnapshotHistory *history, uint32_t sequence, double time,
+										const DCSnapshotNode *nodes, uint32_t count, bool incremental);
+
+/////////////
+// Reading //
+/////////////
+
+typedef enum
+{
+	DCSnapshotRecordEnd = 0,				// end of the data
+	DCSnapshotRecordError,
+	DCSnapshotRecordBeginSnapshot,
+	DCSnapshotRecordTree,
+	DCSnapshotRecordNode,
+	DCSnapshotRecordEndSnapshot,
+} DCSnapshotRecordType;
+
+typedef struct
+{
+	DCSnapshotRecordType type;
+	uint32_t sequence;						// begin snapshot
+	bool incremental;
+	double time;
+	uint64_t parentId;						// tree
+	DCSnapshotNode node;					// node. Its strings belong to the decoder.
+	uint32_t visitedCount, writtenCount;	// end snapshot
+} DCSnapshotRecord;
+
+typedef struct
+{
+	const uint8_t *bytes;
+	size_t length;
+	size_t offset;
+	char **strings;							// by id
+	size_t stringCount;
+	const char *error;
+} DCSnapshotDecoder;
+
+// checks the header. false, with decoder->error set, if the data is not a snapshot stream.
+bool DCSnapshotDecoderInit(DCSnapshotDecoder *decoder, const uint8_t *bytes, size_t length);
+void DCSnapshotDecoderFree(DCSnapshotDecoder *decoder);
+// reads the next record, taking in the string records on the way
+DCSnapshotRecordType DCSnapshotDecoderNext(DCSnapshotDecoder *decoder, DCSnapshotRecord *record);
+
+#endif
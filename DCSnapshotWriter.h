@@ -0,0 +1,70 @@
+//
+//  DCSnapshotWriter.h
+//
+//  Created by Alexis Gallagher on 2012-08-27.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "DCSnapshotFormat.h"
+#import "DCObjectNameRegistry.h"
+
+// chunks the encoder writes to the file, and how many snapshots may wait to be encoded
+#define kDCSnapshotWriterChunkSize (128 * 1024)
+#define kDCSnapshotWriterMaxPendingSnapshots 2
+
+// the DCSnapshotRole bits of a view
+typedef NSUInteger (^DCSnapshotRolesBlock)(UIView *view);
+
+// Writes snapshots of a view hierarchy to a file, in the format of DCSnapshotFormat.h,
+// to be read with Tools/dcsnapshot.
+//
+// The hierarchy is read on the main thread into an array of nodes, which a serial queue
+// then encodes, in chunks appended to the file as they fill. The main thread only walks
+// the views: hashing the subtrees, encoding them and writing the file happen on the
+// queue. Once kDCSnapshotWriterMaxPendingSnapshots are waiting, the main thread waits
+// for the queue, so at most that many arrays of nodes, and never a whole encoded
+// snapshot, are in memory. After the first, snapshots are incremental unless asked
+// otherwise: only the subtrees which changed since the last one are written.
+//
+// The array holds the whole hierarchy, and is not encoded subtree by subtree as the
+// walk goes, because what changed is only known once the hash of each subtree is, and
+// because UIKit may only be read on the main thread.
+@interface DCSnapshotWriter : NSObject
+{
+	NSString *path;
+	FILE *file;
+	dispatch_queue_t queue;
+	dispatch_semaphore_t pendingSnapshots;
+	DCSnapshotEncoder *encoder;				// used on the queue only
+	DCSnapshotHistory *history;				// used on the queue only
+
+	DCSnapshotNode *nodes;					// the snapshot being read, handed to the queue
+	NSUInteger nodeCount;
+	NSUInteger nodeCapacity;
+
+	NSUInteger snapshotCount;
+	NSUInteger lastVisitedCount;
+	NSUInteger lastWrittenCount;
+	NSArray *ignoredViews;
+	DCObjectNameRegistry *objectNames;
+	DCSnapshotRolesBlock rolesOfView;
+}
+
+@property (nonatomic, readonly) NSString *path;
+@property (nonatomic, retain) NSArray *ignoredViews;				// left out, with their subviews
+@property (nonatomic, retain) DCObjectNameRegistry *objectNames;	// for the views' names, if any
+@property (nonatomic, copy) DCSnapshotRolesBlock rolesOfView;		// for the views' drag and drop roles, if any
+@property (nonatomic, readonly) NSUInteger snapshotCount;
+@property (nonatomic, readonly) NSUInteger lastVisitedCount;		// views in the last snapshot
+@property (nonatomic, readonly) NSUInteger lastWrittenCount;		// views written by the last snapshot encoded, set on the main thread
+
+// replaces the file. nil if it can't be opened.
+- (id)initWithPath:(NSString *)path;
+
+- (void)writeSnapshotOfView:(UIView *)view incremental:(BOOL)incremental;
+
+// waits for the file to be written, and closes it. Snapshots can't be written after.
+- (void)close;
+
+@end
@@ -0,0 +1,162 @@
+//
+//  DCSnapshotWriter.m
+//
+//  Created by Alexis Gallagher on 2012-08-27.
+//
+
+#import <objc/runtime.h>
+
+#import "DCSnapshotWriter.h"
+
+// called on the queue, which owns the encoder
+static void DCSnapshotWriterFlush(const uint8_t *bytes, size_t length, void *context)
+{
+	fwrite(bytes, 1, length, (FILE *)context);
+}
+
+@implementation DCSnapshotWriter
+@synthesize path;
+@synthesize ignoredViews, objectNames, rolesOfView;
+@synthesize snapshotCount, lastVisitedCount, lastWrittenCount;
+
+- (id)initWithPath:(NSString *)aPath
+{
+	self = [super init];
+	if (self)
+	{
+		path = [aPath copy];
+		file = fopen([path fileSystemRepresentation], "wb");
+		if (!file)
+		{
+			NSLog(@"DCIntrospect: Couldn't open %@ for snapshots: %s", path, strerror(errno));
+			[self release];
+			return nil;
+		}
+		queue = dispatch_queue_create("DCSnapshotWriter", DISPATCH_QUEUE_SERIAL);
+		pendingSnapshots = dispatch_semaphore_create(kDCSnapshotWriterMaxPendingSnapshots);
+		encoder = DCSnapshotEncoderCreate(kDCSnapshotWriterChunkSize, DCSnapshotWriterFlush, file);
+		history = DCSnapshotHistoryCreate();
+	}
+	return self;
+}
+
+- (void)dealloc
+{
+	[self close];
+	[path release];
+	[ignoredViews release];
+	[objectNames release];
+	[rolesOfView release];
+	free(nodes);
+
+	[super dealloc];
+}
+
+- (void)close
+{
+	if (!file)
+		return;
+
+	// after the snapshots waiting on the queue, flushes the last chunk
+	FILE *closingFile = file;
+	NSString *closingPath = path;
+	DCSnapshotEncoder *closingEncoder = encoder;
+	DCSnapshotHistory *closingHistory = history;
+	dispatch_sync(queue, ^{
+		DCSnapshotEncoderDestroy(closingEncoder);
+		DCSnapshotHistoryDestroy(closingHistory);
+		if (ferror(closingFile))
+			NSLog(@"DCIntrospect: Couldn't write all the snapshots to %@", closingPath);
+		fclose(closingFile);
+	});
+	encoder = NULL;
+	history = NULL;
+	file = NULL;
+	dispatch_release(queue);
+	queue = NULL;
+	dispatch_release(pendingSnapshots);
+	pendingSnapshots = NULL;
+}
+
+- (void)addNodesOfView:(UIView *)view
+{
+	if (nodeCount == nodeCapacity)
+	{
+		nodeCapacity = MAX(nodeCapacity * 2, 256);
+		nodes = realloc(nodes, nodeCapacity * sizeof(DCSnapshotNode));
+	}
+
+	// filled before the subviews, which may move the array
+	NSUInteger index = nodeCount++;
+	DCSnapshotNode *node = &nodes[index];
+	CGRect frame = view.frame;
+	node->id = (uintptr_t)view;
+	node->x = frame.origin.x;
+	node->y = frame.origin.y;
+	node->width = frame.size.width;
+	node->height = frame.size.height;
+	node->alpha = view.alpha;
+	node->flags = ((view.hidden) ? DCSnapshotFlagHidden : 0) |
+				  ((view.opaque) ? DCSnapshotFlagOpaque : 0) |
+				  ((view.clipsToBounds) ? DCSnapshotFlagClipsToBounds : 0) |
+				  ((view.userInteractionEnabled) ? DCSnapshotFlagUserInteractionEnabled : 0);
+	node->roles = (rolesOfView) ? (uint8_t)rolesOfView(view) : 0;
+	node->tag = (int32_t)view.tag;
+	// class names live as long as the process. Names are copied for the queue, which frees them.
+	node->className = class_getName([view class]);
+	NSString *name = [objectNames nameForObject:view];
+	node->name = (name) ? strdup([name UTF8String]) : NULL;
+
+	uint32_t childCount = 0;
+	for (UIView *subview in view.subviews)
+	{
+		if ([ignoredViews indexOfObjectIdenticalTo:subview] != NSNotFound)
+			continue;
+		[self addNodesOfView:subview];
+		childCount++;
+	}
+	nodes[index].childCount = childCount;
+}
+
+- (void)writeSnapshotOfView:(UIView *)view incremental:(BOOL)incremental
+{
+	if (!file || !view)
+		return;
+
+	// bounds the snapshots waiting for the queue, by waiting for it
+	dispatch_semaphore_wait(pendingSnapshots, DISPATCH_TIME_FOREVER);
+
+	NSAutoreleasePool *pool = [[NSAutoreleasePool alloc] init];
+	nodeCount = 0;
+	[self addNodesOfView:view];
+	[pool drain];
+
+	// the queue takes the array, and the next snapshot starts one of the same size
+	DCSnapshotNode *snapshotNodes = nodes;
+	uint32_t count = (uint32_t)nodeCount;
+	uint32_t sequence = (uint32_t)snapshotCount;
+	double time = CFAbsoluteTimeGetCurrent();
+	DCSnapshotEncoder *snapshotEncoder = encoder;
+	DCSnapshotHistory *snapshotHistory = history;
+	dispatch_semaphore_t semaphore = pendingSnapshots;
+	nodes = malloc(nodeCapacity * sizeof(DCSnapshotNode));
+
+	dispatch_async(queue, ^{
+		uint32_t writtenCount = DCSnapshotEncoderWriteSnapshot(snapshotEncoder, snapshotHistory, sequence, time,
+															   snapshotNodes, count, incremental);
+		// a snapshot is on its way to the file as soon as it is encoded
+		DCSnapshotEncoderFlush(snapshotEncoder);
+		for (uint32_t i = 0; i < count; i++)
+			free((char *)snapshotNodes[i].name);
+		free(snapshotNodes);
+		dispatch_semaphore_signal(semaphore);
+		dispatch_async(dispatch_get_main_queue(), ^{
+			lastWrittenCount = writtenCount;
+		});
+	});
+
+	snapshotCount++;
+	lastVisitedCount = nodeCount;
+}
+
+@end
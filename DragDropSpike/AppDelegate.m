@@ -10,6 +10,10 @@
 
 #ifdef DEBUG
   #import "DCIntrospect.h"
+  #import "MCKDragDropServer.h"
+  #import "MCKScaleBenchmarkRunner.h"
+  #import "MCKAbsorberIndexBenchmark.h"
+  #import "MCKRegistrationBenchmark.h"
 #endif
 
 @implementation AppDelegate
@@ -22,6 +26,56 @@
   // enable DCIntrospect for debug builds
 #ifdef DEBUG
   [[DCIntrospect sharedIntrospector] start];
+  // record the DnD roles in view hierarchy snapshots. MCKDragDropRole and
+  // DCSnapshotRole share their bits.
+  [[DCIntrospect sharedIntrospector] setSnapshotRolesOfView:^NSUInteger(UIView *view) {
+    return [[MCKDragDropServer sharedServer] rolesOfView:view];
+  }];
+
+  // print the DnD trace as it is written. In release builds, the last
+  // records of each thread stay in memory, for PSLogTraceDump(stderr) from
+  // the debugger.
+  PSLogTraceStartFlushing(stderr, 0.5);
+
+  // run the DnD scale benchmark up to the depth given by the launch argument
+  // -MCKScaleBenchmarkMaxDepth N, once the app is up, into Documents
+  NSInteger benchmarkDepth = [[NSUserDefaults standardUserDefaults] integerForKey:@"MCKScaleBenchmarkMaxDepth"];
+  if ( benchmarkDepth > 0 ) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSString * documents = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+      [MCKScaleBenchmarkRunner runScenesFromDepth:2
+                                          toDepth:benchmarkDepth
+                                             spec:MCKScaleSceneSpecDefault
+                                              run:MCKScaleRunSpecDefault
+                                           toPath:[documents stringByAppendingPathComponent:@"MCKScaleBenchmark.json"]];
+    });
+  }
+
+  // compare drop resolution by hit-testing and by the absorber index, with
+  // the launch argument -MCKAbsorberIndexBenchmark YES
+  if ( [[NSUserDefaults standardUserDefaults] boolForKey:@"MCKAbsorberIndexBenchmark"] ) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSString * documents = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+      NSArray * viewCounts = [NSArray arrayWithObjects:[NSNumber numberWithInt:10000], [NSNumber numberWithInt:20000],
+                              [NSNumber numberWithInt:50000], [NSNumber numberWithInt:100000], nil];
+      [MCKAbsorberIndexBenchmark runWithViewCounts:viewCounts
+                                           queries:1000
+                                            toPath:[documents stringByAppendingPathComponent:@"MCKAbsorberIndexBenchmark.json"]];
+    });
+  }
+
+  // compare per-view and shared recognizers at 1k, 10k and 50k draggables,
+  // with the launch argument -MCKRegistrationBenchmark YES
+  if ( [[NSUserDefaults standardUserDefaults] boolForKey:@"MCKRegistrationBenchmark"] ) {
+    dispatch_async(dispatch_get_main_queue(), ^{
+      NSString * documents = [NSSearchPathForDirectoriesInDomains(NSDocumentDirectory, NSUserDomainMask, YES) lastObject];
+      NSArray * draggableCounts = [NSArray arrayWithObjects:[NSNumber numberWithInt:1000], [NSNumber numberWithInt:10000],
+                                   [NSNumber numberWithInt:50000], nil];
+      [MCKRegistrationBenchmark runWithDraggableCounts:draggableCounts
+                                               touches:1000
+                                                toPath:[documents stringByAppendingPathComponent:@"MCKRegistrationBenchmark.json"]];
+    });
+  }
   
 //  // define gesture recognizer for invoking DCIntrospect on the device
 //  UIPanGestureRecognizer * introspectGesture = [[UIPanGestureRecognizer alloc] init];
@@ -0,0 +1,88 @@
+//
+//  MCKAbsorberIndex.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-02.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ The region of window space over which the answer to an absorber query stays
+ the same: every point inside bounds, except the points inside a hole.
+ */
+@interface MCKAbsorberHitRegion : NSObject
+@property (assign) CGRect bounds;
+@property (strong) NSArray * holes; // NSValue-wrapped CGRects
+-(BOOL) containsPoint:(CGPoint)windowPoint;
+@end
+
+/**
+ A spatial index of registered absorber views, keyed on their frames in window
+ coordinates.
+
+ The index is a uniform grid. Every cell lists the absorbers whose window frame
+ overlaps that cell, so finding the absorber under a drop point only requires
+ looking at the handful of absorbers in one cell, instead of hit-testing the
+ whole window.
+
+ DESIGN NOTES:
+ The index holds its views weakly, in a table keyed by their address. Views
+ which have been deallocated are pruned when a query comes across them, or
+ at the next rebuild.
+
+ Cached frames go stale when an absorber (or any of its ancestors) moves, and
+ the index cannot tell by itself. Call -absorberViewDidMove: for a single
+ absorber, or -setNeedsUpdate if the layout may have changed arbitrarily.
+ Until then, a stale frame can make a query miss the absorber, or name it
+ somewhere it no longer is in the hit region. It can never make a query
+ return an absorber which is not under the point: the candidates of the cell
+ are re-checked against the live view hierarchy before one is returned.
+ */
+@interface MCKAbsorberIndex : NSObject
+
+/** Incremented whenever an entry is added, removed or moved */
+@property (readonly) NSUInteger generation;
+
+-(void) addAbsorberView:(UIView*)view;
+-(void) removeAbsorberView:(UIView*)view;
+
+/** Recompute the cached window frame of one absorber */
+-(void) absorberViewDidMove:(UIView*)view;
+
+/** Recompute all cached window frames before the next query */
+-(void) setNeedsUpdate;
+
+/** Index the absorbers which were added, or last moved, while outside any window, and are now in one */
+-(void) indexAbsorberViewsWhichAppeared;
+
+/**
+ Returns the absorber the hit-test rules would choose at a window point.
+
+ @param windowPoint point in the coordinates of window
+ @param window window being searched
+ @param excludedView view which, along with its descendants, is ignored. Usually
+        the view being dropped.
+ @return the first absorber in hit-test order, or nil if none is found
+
+ This never mutates the view hierarchy.
+ */
+-(UIView*) absorberAtPoint:(CGPoint)windowPoint
+                  inWindow:(UIWindow*)window
+             excludingView:(UIView*)excludedView;
+
+/**
+ As absorberAtPoint:inWindow:excludingView:, but also reports where the answer holds.
+
+ @param region if not nil, filled in with a region around windowPoint where
+        the query would return the same absorber, assuming the index and the
+        view hierarchy do not change. The region is conservative: a point
+        outside it may still have the same answer.
+ */
+-(UIView*) absorberAtPoint:(CGPoint)windowPoint
+                  inWindow:(UIWindow*)window
+             excludingView:(UIView*)excludedView
+                 hitRegion:(MCKAbsorberHitRegion*)region;
+
+@end
@@ -0,0 +1,363 @@
+//
+//  MCKAbsorberIndex.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-02.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKAbsorberIndex.h"
+
+// width and height of one grid cell, in points
+#define MCK_ABSORBER_INDEX_CELL_SIZE 128.0f
+
+// a cell is keyed by its column and row, packed into one pointer-sized integer
+static inline uintptr_t MCKCellKey(NSInteger column, NSInteger row) {
+  return ((uintptr_t)(uint16_t)column << 16) | (uintptr_t)(uint16_t)row;
+}
+
+static inline NSInteger MCKCellCoordinate(CGFloat value) {
+  NSInteger c = (NSInteger)floorf(value / MCK_ABSORBER_INDEX_CELL_SIZE);
+  return MAX(INT16_MIN, MIN(INT16_MAX, c));
+}
+
+/*
+ One absorber, as seen by the index.
+ */
+@interface MCKAbsorberIndexEntry : NSObject
+@property (weak) UIView * view;
+// the view's address, its key in the index, which outlives it
+@property (assign) const void * address;
+@property (weak) UIWindow * window;
+@property (assign) CGRect windowFrame;
+@end
+
+@implementation MCKAbsorberIndexEntry
+@synthesize view, address, window, windowFrame;
+@end
+
+
+@implementation MCKAbsorberHitRegion
+@synthesize bounds, holes;
+
+-(BOOL) containsPoint:(CGPoint)windowPoint
+{
+  if ( !CGRectContainsPoint(self.bounds, windowPoint) )
+    return NO;
+  for (NSValue * hole in self.holes)
+    if ( CGRectContainsPoint([hole CGRectValue], windowPoint) )
+      return NO;
+  return YES;
+}
+
+@end
+
+
+@interface MCKAbsorberIndex ()
+{
+  // key = packed cell coordinates, value = NSMutableArray of MCKAbsorberIndexEntry
+  CFMutableDictionaryRef cells;
+  // key = absorber view, unretained, value = its MCKAbsorberIndexEntry. A key
+  // may outlive its view, so the entry's view is checked on lookup.
+  CFMutableDictionaryRef entries;
+  // entries of absorbers which were not in a window when last indexed
+  NSMutableArray * offscreenEntries;
+  BOOL needsUpdate;
+}
+@end
+
+@implementation MCKAbsorberIndex
+@synthesize generation;
+
+-(id) init
+{
+  self = [super init];
+  if ( self ) {
+    cells = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    offscreenEntries = [NSMutableArray array];
+  }
+  return self;
+}
+
+-(void) dealloc
+{
+  CFRelease(cells);
+  CFRelease(entries);
+}
+
+#pragma mark registration
+
+-(void) addAbsorberView:(UIView*)view
+{
+  if ( !view || [self entryForView:view] )
+    return;
+  // an entry left by a dead view at the same address
+  MCKAbsorberIndexEntry * stale = (__bridge MCKAbsorberIndexEntry*)CFDictionaryGetValue(entries, (__bridge const void*)view);
+  if ( stale ) {
+    [self removeEntryFromCells:stale];
+    [offscreenEntries removeObjectIdenticalTo:stale];
+  }
+  MCKAbsorberIndexEntry * entry = [[MCKAbsorberIndexEntry alloc] init];
+  entry.view = view;
+  entry.address = (__bridge const void*)view;
+  CFDictionarySetValue(entries, (__bridge const void*)view, (__bridge const void*)entry);
+  [self insertEntry:entry];
+  generation++;
+}
+
+-(void) removeAbsorberView:(UIView*)view
+{
+  MCKAbsorberIndexEntry * entry = [self entryForView:view];
+  if ( !entry )
+    return;
+  [self removeEntryFromCells:entry];
+  [offscreenEntries removeObjectIdenticalTo:entry];
+  CFDictionaryRemoveValue(entries, (__bridge const void*)view);
+  generation++;
+}
+
+-(void) absorberViewDidMove:(UIView*)view
+{
+  MCKAbsorberIndexEntry * entry = [self entryForView:view];
+  if ( !entry )
+    return;
+  [self removeEntryFromCells:entry];
+  [offscreenEntries removeObjectIdenticalTo:entry];
+  [self insertEntry:entry];
+  generation++;
+}
+
+-(void) setNeedsUpdate
+{
+  needsUpdate = YES;
+}
+
+-(void) indexAbsorberViewsWhichAppeared
+{
+  if ( [offscreenEntries count] == 0 )
+    return;
+  NSArray * candidates = [offscreenEntries copy];
+  for (MCKAbsorberIndexEntry * entry in candidates) {
+    if ( !entry.view )
+      [self removeDeadEntry:entry];
+    else if ( entry.view.window ) {
+      [offscreenEntries removeObjectIdenticalTo:entry];
+      [self insertEntry:entry];
+      generation++;
+    }
+  }
+}
+
+#pragma mark queries
+
+-(UIView*) absorberAtPoint:(CGPoint)windowPoint
+                  inWindow:(UIWindow*)window
+             excludingView:(UIView*)excludedView
+{
+  return [self absorberAtPoint:windowPoint inWindow:window excludingView:excludedView hitRegion:nil];
+}
+
+-(UIView*) absorberAtPoint:(CGPoint)windowPoint
+                  inWindow:(UIWindow*)window
+             excludingView:(UIView*)excludedView
+                 hitRegion:(MCKAbsorberHitRegion*)region
+{
+  if ( needsUpdate )
+    [self rebuild];
+
+  NSInteger column = MCKCellCoordinate(windowPoint.x);
+  NSInteger row = MCKCellCoordinate(windowPoint.y);
+  NSArray * cell = (__bridge NSArray*)CFDictionaryGetValue(cells, (const void*)MCKCellKey(column, row));
+
+  // absorbers in this cell which could change the answer if the point moved onto them
+  NSMutableArray * rivals = region ? [NSMutableArray array] : nil;
+
+  UIView * retval = nil;
+  NSMutableArray * deadEntries = nil;
+  for (MCKAbsorberIndexEntry * entry in cell) {
+    UIView * candidate = entry.view;
+    if ( !candidate ) {
+      if ( !deadEntries )
+        deadEntries = [NSMutableArray array];
+      [deadEntries addObject:entry];
+      continue;
+    }
+    if ( entry.window != window
+        || (excludedView && [candidate isDescendantOfView:excludedView]) )
+      continue;
+
+    [rivals addObject:entry];
+
+    if ( !CGRectContainsPoint(entry.windowFrame, windowPoint)
+        || ![MCKAbsorberIndex view:candidate isHitTestableAtPoint:windowPoint inWindow:window] )
+      continue;
+
+    if ( !retval || [MCKAbsorberIndex view:candidate precedesViewInHitTestOrder:retval] )
+      retval = candidate;
+  }
+  for (MCKAbsorberIndexEntry * entry in deadEntries)
+    [self removeDeadEntry:entry];
+
+  if ( region ) {
+    CGRect bounds = CGRectMake(column * MCK_ABSORBER_INDEX_CELL_SIZE, row * MCK_ABSORBER_INDEX_CELL_SIZE,
+                               MCK_ABSORBER_INDEX_CELL_SIZE, MCK_ABSORBER_INDEX_CELL_SIZE);
+    // the winner stays the winner only while the point is inside it and all its ancestors
+    for (UIView * v = retval; v && v != window; v = v.superview)
+      bounds = CGRectIntersection(bounds, [v convertRect:v.bounds toView:nil]);
+
+    NSMutableArray * holes = [NSMutableArray arrayWithCapacity:rivals.count];
+    for (MCKAbsorberIndexEntry * entry in rivals) {
+      // ancestors of the winner can never overtake it
+      if ( retval && [retval isDescendantOfView:entry.view] )
+        continue;
+      if ( CGRectIntersectsRect(bounds, entry.windowFrame) )
+        [holes addObject:[NSValue valueWithCGRect:entry.windowFrame]];
+    }
+    region.bounds = bounds;
+    region.holes = holes;
+  }
+  return retval;
+}
+
+/*
+ Returns YES if hitTest:withEvent: would descend all the way down to view.
+
+ This applies the default UIView rules at every level from the window down: the
+ view must be unhidden, have userInteractionEnabled, be at least minimally
+ opaque, and contain the point within its bounds.
+ */
++(BOOL) view:(UIView*)view isHitTestableAtPoint:(CGPoint)windowPoint inWindow:(UIWindow*)window
+{
+  for (UIView * v = view; v; v = v.superview) {
+    if ( v.hidden || !v.userInteractionEnabled || v.alpha < 0.01f )
+      return NO;
+    if ( ![v pointInside:[window convertPoint:windowPoint toView:v] withEvent:nil] )
+      return NO;
+    if ( v == window )
+      return YES;
+  }
+  return NO;
+}
+
+/*
+ Returns YES if hitTest:withEvent: would reach view before otherView.
+
+ The hit test prefers descendants to their ancestors, and among siblings it
+ prefers later subviews (the ones in front) to earlier ones.
+ */
++(BOOL) view:(UIView*)view precedesViewInHitTestOrder:(UIView*)otherView
+{
+  if ( [view isDescendantOfView:otherView] )
+    return YES;
+  if ( [otherView isDescendantOfView:view] )
+    return NO;
+
+  // find the children of the closest common ancestor which lead to each view
+  NSMutableArray * otherAncestors = [NSMutableArray array];
+  for (UIView * v = otherView; v; v = v.superview)
+    [otherAncestors addObject:v];
+
+  UIView * branch = view;
+  while ( branch.superview && ![otherAncestors containsObject:branch.superview] )
+    branch = branch.superview;
+  UIView * commonAncestor = branch.superview;
+  if ( !commonAncestor )
+    return NO;
+
+  NSUInteger otherIndex = [otherAncestors indexOfObjectIdenticalTo:commonAncestor];
+  UIView * otherBranch = [otherAncestors objectAtIndex:otherIndex - 1];
+
+  NSArray * siblings = commonAncestor.subviews;
+  return [siblings indexOfObjectIdenticalTo:branch] > [siblings indexOfObjectIdenticalTo:otherBranch];
+}
+
+#pragma mark grid maintenance
+
+-(MCKAbsorberIndexEntry*) entryForView:(UIView*)view
+{
+  if ( !view )
+    return nil;
+  MCKAbsorberIndexEntry * entry = (__bridge MCKAbsorberIndexEntry*)CFDictionaryGetValue(entries, (__bridge const void*)view);
+  return entry.view == view ? entry : nil;
+}
+
+/* Forgets an entry whose view is gone */
+-(void) removeDeadEntry:(MCKAbsorberIndexEntry*)entry
+{
+  [self removeEntryFromCells:entry];
+  [offscreenEntries removeObjectIdenticalTo:entry];
+  if ( CFDictionaryGetValue(entries, entry.address) == (__bridge const void*)entry )
+    CFDictionaryRemoveValue(entries, entry.address);
+  generation++;
+}
+
+-(void) rebuild
+{
+  needsUpdate = NO;
+  CFDictionaryRemoveAllValues(cells);
+  [offscreenEntries removeAllObjects];
+
+  CFIndex count = CFDictionaryGetCount(entries);
+  const void ** keys = malloc(count * sizeof(void*));
+  const void ** values = malloc(count * sizeof(void*));
+  CFDictionaryGetKeysAndValues(entries, keys, values);
+  for (CFIndex i = 0; i < count; ++i) {
+    MCKAbsorberIndexEntry * entry = (__bridge MCKAbsorberIndexEntry*)values[i];
+    if ( entry.view )
+      [self insertEntry:entry];
+    else
+      CFDictionaryRemoveValue(entries, keys[i]);
+  }
+  free(keys);
+  free(values);
+  generation++;
+}
+
+-(void) insertEntry:(MCKAbsorberIndexEntry*)entry
+{
+  UIView * view = entry.view;
+  entry.window = view.window;
+  if ( !entry.window ) {
+    // offscreen absorbers cannot be dropped on. Index them once they appear.
+    entry.windowFrame = CGRectNull;
+    [offscreenEntries addObject:entry];
+    return;
+  }
+  entry.windowFrame = [view convertRect:view.bounds toView:nil];
+
+  [self enumerateCellsOfRect:entry.windowFrame usingBlock:^(uintptr_t key) {
+    NSMutableArray * cell = (__bridge NSMutableArray*)CFDictionaryGetValue(cells, (const void*)key);
+    if ( !cell ) {
+      cell = [NSMutableArray array];
+      CFDictionarySetValue(cells, (const void*)key, (__bridge const void*)cell);
+    }
+    [cell addObject:entry];
+  }];
+}
+
+-(void) removeEntryFromCells:(MCKAbsorberIndexEntry*)entry
+{
+  if ( CGRectIsNull(entry.windowFrame) )
+    return;
+  [self enumerateCellsOfRect:entry.windowFrame usingBlock:^(uintptr_t key) {
+    NSMutableArray * cell = (__bridge NSMutableArray*)CFDictionaryGetValue(cells, (const void*)key);
+    [cell removeObjectIdenticalTo:entry];
+  }];
+  entry.windowFrame = CGRectNull;
+}
+
+-(void) enumerateCellsOfRect:(CGRect)rect usingBlock:(void (^)(uintptr_t key))block
+{
+  if ( CGRectIsNull(rect) || CGRectIsEmpty(rect) )
+    return;
+  NSInteger minColumn = MCKCellCoordinate(CGRectGetMinX(rect));
+  NSInteger maxColumn = MCKCellCoordinate(CGRectGetMaxX(rect));
+  NSInteger minRow    = MCKCellCoordinate(CGRectGetMinY(rect));
+  NSInteger maxRow    = MCKCellCoordinate(CGRectGetMaxY(rect));
+  for (NSInteger column = minColumn; column <= maxColumn; ++column)
+    for (NSInteger row = minRow; row <= maxRow; ++row)
+      block(MCKCellKey(column, row));
+}
+
+@end
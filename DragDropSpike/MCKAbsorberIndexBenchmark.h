@@ -0,0 +1,39 @@
+//
+//  MCKAbsorberIndexBenchmark.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-02.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/*
+ Compares the two ways the server has found the absorber under a drop, on a
+ device: the hide-and-rehitTest search it used before MCKAbsorberIndex, and a
+ query on the index.
+
+ Each scene is a synthetic tree of plain UIViews, the mirror of a scene of
+ MCKScaleBenchmark.h capped at a number of views, in a window of its own. The
+ same drop points, drawn from MCKScaleScript, are resolved both ways, and
+ the answers compared.
+
+ DESIGN NOTES:
+ The old search is reproduced as it was: hide each hit-test winner which is
+ not an absorber, hit-test the window again, and unhide them all at the end.
+ It is timed without a drawing pass, so it shows the traversals alone; on
+ screen, each hidden view also invalidates rendering.
+ */
+@interface MCKAbsorberIndexBenchmark : NSObject
+
+/**
+ Runs queries drop points over a scene of each of viewCounts views, and
+ writes a JSON array of one object per scene to the file at path: the
+ latency percentiles of each search, the time to build the index, and the
+ number of points where the two disagreed.
+
+ @return the number of disagreements, over all scenes
+ */
++(NSUInteger) runWithViewCounts:(NSArray*)viewCounts queries:(NSUInteger)queries toPath:(NSString*)path;
+
+@end
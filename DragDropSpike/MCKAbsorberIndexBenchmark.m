@@ -0,0 +1,144 @@
+//
+//  MCKAbsorberIndexBenchmark.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-02.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKAbsorberIndexBenchmark.h"
+#import "MCKAbsorberIndex.h"
+#include "MCKScaleBenchmark.h"
+
+/* Adds a view for each node below node, under view, and collects the absorbers */
+static void MCKMirrorChildren(MCKNode * node, UIView * view, CFMutableSetRef absorberSet, NSMutableArray * absorbers)
+{
+  for (size_t i = 0; i < node->child_count; ++i) {
+    MCKNode * child = node->children[i];
+    MCKRect frame = MCKNodeGetFrame(child);
+    UIView * childView = [[UIView alloc] initWithFrame:CGRectMake(frame.origin.x, frame.origin.y,
+                                                                  frame.size.width, frame.size.height)];
+    childView.hidden = child->hidden;
+    childView.userInteractionEnabled = child->user_interaction_enabled;
+    childView.alpha = child->alpha;
+    [view addSubview:childView];
+    if ( child->roles & MCKDragDropRoleAbsorber ) {
+      CFSetAddValue(absorberSet, (__bridge const void*)childView);
+      [absorbers addObject:childView];
+    }
+    MCKMirrorChildren(child, childView, absorberSet, absorbers);
+  }
+}
+
+/* The search of -[MCKDragDropServer firstAbsorberOfView:] before the absorber index */
+static UIView * MCKRehitTestAbsorberAt(UIWindow * window, CGPoint point, CFSetRef absorberSet)
+{
+  UIView * retval = nil;
+  NSMutableArray * viewsToUnhide = [NSMutableArray array];
+  while ( (retval = [window hitTest:point withEvent:nil]) ) {
+    if ( CFSetContainsValue(absorberSet, (__bridge const void*)retval) )
+      break;
+    retval.hidden = YES;
+    [viewsToUnhide addObject:retval];
+  }
+  for (UIView * view in viewsToUnhide)
+    view.hidden = NO;
+  return retval;
+}
+
+@implementation MCKAbsorberIndexBenchmark
+
++(NSUInteger) runWithViewCount:(NSUInteger)viewCount queries:(NSUInteger)queries toFile:(FILE*)file
+{
+  UIWindow * appWindow = [[UIApplication sharedApplication] keyWindow];
+  UIWindow * window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]];
+  window.rootViewController = [[UIViewController alloc] init];
+  [window makeKeyAndVisible];
+  UIView * rootView = window.rootViewController.view;
+
+  MCKScaleSceneSpec spec = MCKScaleSceneSpecDefault;
+  spec.depth = 5;
+  spec.max_views = viewCount;
+  spec.width = rootView.bounds.size.width;
+  spec.height = rootView.bounds.size.height;
+  size_t views = 0;
+  MCKNode * scene = MCKScaleSceneCreate(&spec, &views);
+  CFMutableSetRef absorberSet = CFSetCreateMutable(NULL, 0, NULL);
+  NSMutableArray * absorbers = [NSMutableArray array];
+  MCKMirrorChildren(scene, rootView, absorberSet, absorbers);
+
+  double start = MCKTraceNow();
+  MCKAbsorberIndex * index = [[MCKAbsorberIndex alloc] init];
+  for (UIView * absorber in absorbers)
+    [index addAbsorberView:absorber];
+  double buildTime = MCKTraceNow() - start;
+
+  MCKScaleScript script;
+  MCKScaleScriptInit(&script, scene, spec.seed);
+  double * rehitTestSamples = malloc((queries + 1) * sizeof(double));
+  double * indexSamples = malloc((queries + 1) * sizeof(double));
+  NSUInteger disagreements = 0;
+  for (NSUInteger n = 0; n < queries; ++n) {
+    @autoreleasepool {
+      MCKNode * drag;
+      MCKPoint target;
+      MCKScaleScriptNextDrag(&script, &drag, &target);
+      CGPoint point = [rootView convertPoint:CGPointMake(target.x, target.y) toView:nil];
+
+      start = MCKTraceNow();
+      UIView * rehitTestAnswer = MCKRehitTestAbsorberAt(window, point, absorberSet);
+      rehitTestSamples[n] = MCKTraceNow() - start;
+
+      start = MCKTraceNow();
+      UIView * indexAnswer = [index absorberAtPoint:point inWindow:window excludingView:nil];
+      indexSamples[n] = MCKTraceNow() - start;
+
+      if ( indexAnswer != rehitTestAnswer )
+        disagreements++;
+    }
+  }
+  MCKLatencySummary rehitTest = MCKLatencySummarize(rehitTestSamples, queries);
+  MCKLatencySummary indexed = MCKLatencySummarize(indexSamples, queries);
+
+  fprintf(file, "{\"views\":%zu,\"absorbers\":%u,\"queries\":%u,\"index_build_s\":%.6f,",
+          views, [absorbers count], queries, buildTime);
+  MCKLatencySummaryWriteJSON("rehittest", rehitTest, file);
+  fputc(',', file);
+  MCKLatencySummaryWriteJSON("index", indexed, file);
+  fprintf(file, ",\"disagreements\":%u}", disagreements);
+  PSLogInfo(@"%zu views: rehitTest p50 %.1f us p99 %.1f us, index p50 %.1f us p99 %.1f us, %u disagreements",
+            views, rehitTest.p50 * 1e6, rehitTest.p99 * 1e6, indexed.p50 * 1e6, indexed.p99 * 1e6, disagreements);
+
+  free(rehitTestSamples);
+  free(indexSamples);
+  MCKScaleScriptDispose(&script);
+  CFRelease(absorberSet);
+  MCKNodeDestroy(scene);
+  window.hidden = YES;
+  [appWindow makeKeyWindow];
+  return disagreements;
+}
+
++(NSUInteger) runWithViewCounts:(NSArray*)viewCounts queries:(NSUInteger)queries toPath:(NSString*)path
+{
+  FILE * file = fopen([path fileSystemRepresentation], "w");
+  if ( !file ) {
+    PSLogError(@"could not write the benchmark results to %@", path);
+    return 0;
+  }
+
+  NSUInteger disagreements = 0;
+  fputs("[", file);
+  for (NSUInteger i = 0; i < [viewCounts count]; ++i) {
+    fputs(i == 0 ? "\n" : ",\n", file);
+    disagreements += [self runWithViewCount:[[viewCounts objectAtIndex:i] unsignedIntegerValue]
+                                     queries:queries
+                                      toFile:file];
+    fflush(file);
+  }
+  fputs("\n]\n", file);
+  fclose(file);
+  return disagreements;
+}
+
+@end
@@ -0,0 +1,62 @@
+//
+//  MCKAcceptanceCache.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-17.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "MCKDragDropProtocol.h"
+
+/**
+ Answers of -absorberView:canAbsorbPayload:, worked out ahead of the drop.
+
+ While a drag hovers over a candidate absorber, the server asks the cache to
+ prefetch that absorber's answer for the drag's payload. The delegate is then
+ asked on a concurrent background queue. At the drop, the answer is usually
+ there already; if not, the drop waits for it only up to a deadline.
+
+ DESIGN NOTES:
+ Answers are found with two hash lookups, by payload, then by absorber, both
+ compared by identity, as a drag hovers. The server forgets a payload's
+ answers when its drag ends, and an absorber's answers when it absorbs a
+ drop, since that may change what it accepts next.
+
+ The cache holds the payloads strongly, but not the absorbers: a view must
+ not be released, and possibly deallocated, off the main thread. An answer
+ is keyed by the absorber's address and keeps a weak reference to it. Once
+ the view is gone the reference is nil, so a new view at the same address
+ does not get the old view's answer. The background queue sees the absorber
+ and its delegate only through weak references, and hands its own references
+ back to the main thread to be released there.
+ */
+@interface MCKAcceptanceCache : NSObject
+
+/** Start working out the answer in the background, unless it is cached or under way */
+-(void) prefetchAbsorberView:(UIView*)absorber
+                    delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+                     payload:(id<NSObject>)payload;
+
+/**
+ The delegate's answer, waiting for it at most deadline seconds.
+
+ @param fallback answer returned if the deadline passes first. The answer
+        still being worked out is kept, for a later drop of the same payload.
+ */
+-(BOOL) acceptanceOfAbsorberView:(UIView*)absorber
+                        delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+                         payload:(id<NSObject>)payload
+                        deadline:(NSTimeInterval)deadline
+                        fallback:(BOOL)fallback;
+
+-(void) forgetAbsorberView:(UIView*)absorber;
+-(void) forgetPayload:(id<NSObject>)payload;
+
+/** Number of drops answered without waiting */
+@property (readonly) NSUInteger hitCount;
+/** Number of drops which fell back because the deadline passed */
+@property (readonly) NSUInteger deadlineMissCount;
+
+@end
@@ -0,0 +1,180 @@
+//
+//  MCKAcceptanceCache.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-17.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKAcceptanceCache.h"
+#import "MCKPayloadPromise.h"
+
+/*
+ One answer, pending until the delegate has given it.
+ */
+@interface MCKAcceptanceEntry : NSObject
+// nil once the absorber is gone: the entry is then stale
+@property (weak) UIView * absorber;
+@property (assign) BOOL answered;
+@property (assign) BOOL accepted;
+@end
+
+@implementation MCKAcceptanceEntry
+@synthesize absorber, answered, accepted;
+@end
+
+
+@interface MCKAcceptanceCache ()
+{
+  // guards the tables and the entries' answers, and is signalled with each answer
+  NSCondition * condition;
+  // key = payload, retained and compared by identity, or kCFNull for a nil
+  // payload. value = CFMutableDictionary of key = absorber's address, value =
+  // its MCKAcceptanceEntry for the payload
+  CFMutableDictionaryRef entriesByPayload;
+}
+@property (readwrite) NSUInteger hitCount;
+@property (readwrite) NSUInteger deadlineMissCount;
+@end
+
+@implementation MCKAcceptanceCache
+@synthesize hitCount, deadlineMissCount;
+
+-(id) init
+{
+  self = [super init];
+  if ( self ) {
+    condition = [[NSCondition alloc] init];
+    CFDictionaryKeyCallBacks payloadKeys = kCFTypeDictionaryKeyCallBacks;
+    payloadKeys.equal = NULL;
+    payloadKeys.hash = NULL;
+    entriesByPayload = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, &payloadKeys,
+                                                 &kCFTypeDictionaryValueCallBacks);
+  }
+  return self;
+}
+
+-(void) dealloc
+{
+  CFRelease(entriesByPayload);
+}
+
+static const void * MCKAcceptancePayloadKey(id<NSObject> payload)
+{
+  return payload ? (__bridge const void*)payload : kCFNull;
+}
+
+/* The answers for payload, created if need be. The caller holds the lock. */
+-(CFMutableDictionaryRef) entriesOfPayload:(id<NSObject>)payload
+{
+  const void * key = MCKAcceptancePayloadKey(payload);
+  CFMutableDictionaryRef entries = (CFMutableDictionaryRef)CFDictionaryGetValue(entriesByPayload, key);
+  if ( !entries ) {
+    entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+    CFDictionarySetValue(entriesByPayload, key, entries);
+    CFRelease(entries);
+  }
+  return entries;
+}
+
+/* The entry for absorber and payload, which is created, and its answer requested, if need be */
+-(MCKAcceptanceEntry*) requestAbsorberView:(UIView*)absorber
+                                  delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+                                   payload:(id<NSObject>)payload
+{
+  [condition lock];
+  CFMutableDictionaryRef entries = [self entriesOfPayload:payload];
+  MCKAcceptanceEntry * entry = (__bridge MCKAcceptanceEntry*)CFDictionaryGetValue(entries, (__bridge const void*)absorber);
+  // an entry left by a deallocated view at the same address is stale
+  BOOL isNew = !entry || entry.absorber != absorber;
+  if ( isNew ) {
+    entry = [[MCKAcceptanceEntry alloc] init];
+    entry.absorber = absorber;
+    CFDictionarySetValue(entries, (__bridge const void*)absorber, (__bridge const void*)entry);
+  }
+  [condition unlock];
+
+  if ( isNew ) {
+    __weak UIView * weakAbsorber = absorber;
+    __weak NSObject<MCKDragDropAbsorberDelegate> * weakDelegate = delegate;
+    dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+      // a promised payload can be waited for here, off the main thread
+      id<NSObject> built = payload;
+      if ( [built isKindOfClass:[MCKPayloadPromise class]] )
+        built = [(MCKPayloadPromise*)built payload];
+      UIView * strongAbsorber = weakAbsorber;
+      NSObject<MCKDragDropAbsorberDelegate> * strongDelegate = weakDelegate;
+      BOOL accepted = strongAbsorber && strongDelegate
+        && [strongDelegate absorberView:strongAbsorber canAbsorbPayload:built];
+
+      [condition lock];
+      entry.accepted = accepted;
+      entry.answered = YES;
+      [condition broadcast];
+      [condition unlock];
+
+      // these may be the last references: release them on the main thread
+      if ( strongAbsorber || strongDelegate )
+        dispatch_async(dispatch_get_main_queue(), ^{
+          (void)strongAbsorber;
+          (void)strongDelegate;
+        });
+    });
+  }
+  return entry;
+}
+
+-(void) prefetchAbsorberView:(UIView*)absorber
+                    delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+                     payload:(id<NSObject>)payload
+{
+  [self requestAbsorberView:absorber delegate:delegate payload:payload];
+}
+
+-(BOOL) acceptanceOfAbsorberView:(UIView*)absorber
+                        delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+                         payload:(id<NSObject>)payload
+                        deadline:(NSTimeInterval)deadline
+                        fallback:(BOOL)fallback
+{
+  MCKAcceptanceEntry * entry = [self requestAbsorberView:absorber delegate:delegate payload:payload];
+  NSDate * limit = [NSDate dateWithTimeIntervalSinceNow:deadline];
+
+  [condition lock];
+  BOOL waited = NO;
+  while ( !entry.answered && [condition waitUntilDate:limit] )
+    waited = YES;
+  BOOL answered = entry.answered;
+  BOOL accepted = answered ? entry.accepted : fallback;
+  [condition unlock];
+
+  if ( !answered ) {
+    self.deadlineMissCount++;
+    PSLogWarning(@"no answer from absorber=%@ within %g s, falling back to %d",absorber,deadline,fallback);
+  }
+  else if ( !waited )
+    self.hitCount++;
+  return accepted;
+}
+
+static void MCKAcceptanceForgetAbsorber(const void * payload, const void * entries, void * absorber)
+{
+  CFDictionaryRemoveValue((CFMutableDictionaryRef)entries, absorber);
+}
+
+-(void) forgetAbsorberView:(UIView*)absorber
+{
+  // one lookup per payload, that is per drag in progress
+  [condition lock];
+  CFDictionaryApplyFunction(entriesByPayload, MCKAcceptanceForgetAbsorber, (__bridge void*)absorber);
+  [condition unlock];
+}
+
+-(void) forgetPayload:(id<NSObject>)payload
+{
+  [condition lock];
+  CFDictionaryRemoveValue(entriesByPayload, MCKAcceptancePayloadKey(payload));
+  [condition unlock];
+}
+
+@end
@@ -0,0 +1,778 @@
+//
+//  MCKDragDropCore.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKDragDropCore.h"
+#include "MCKSessionTrace.h"
+#include "MCKSessionMetrics.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- Geometry ---------- */
+
+const MCKTransform MCKTransformIdentity = { 1, 0, 0, 1, 0, 0 };
+
+bool MCKRectContainsPoint(MCKRect rect, MCKPoint point)
+{
+  return point.x >= rect.origin.x && point.x < rect.origin.x + rect.size.width
+      && point.y >= rect.origin.y && point.y < rect.origin.y + rect.size.height;
+}
+
+bool MCKTransformIsIdentity(MCKTransform t)
+{
+  return t.a == 1 && t.b == 0 && t.c == 0 && t.d == 1 && t.tx == 0 && t.ty == 0;
+}
+
+MCKPoint MCKPointApplyTransform(MCKPoint p, MCKTransform t)
+{
+  return MCKPointMake(t.a * p.x + t.c * p.y + t.tx,
+                      t.b * p.x + t.d * p.y + t.ty);
+}
+
+MCKTransform MCKTransformInvert(MCKTransform t)
+{
+  double det = t.a * t.d - t.b * t.c;
+  if ( det == 0 )
+    return t; // singular, like CGAffineTransformInvert
+  MCKTransform inv;
+  inv.a  =  t.d / det;
+  inv.b  = -t.b / det;
+  inv.c  = -t.c / det;
+  inv.d  =  t.a / det;
+  inv.tx = -(inv.a * t.tx + inv.c * t.ty);
+  inv.ty = -(inv.b * t.tx + inv.d * t.ty);
+  return inv;
+}
+
+MCKRect MCKRectApplyTransform(MCKRect r, MCKTransform t)
+{
+  MCKPoint corners[4] = {
+    MCKPointApplyTransform(MCKPointMake(r.origin.x, r.origin.y), t),
+    MCKPointApplyTransform(MCKPointMake(r.origin.x + r.size.width, r.origin.y), t),
+    MCKPointApplyTransform(MCKPointMake(r.origin.x, r.origin.y + r.size.height), t),
+    MCKPointApplyTransform(MCKPointMake(r.origin.x + r.size.width, r.origin.y + r.size.height), t)
+  };
+  double minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+  for (int i = 1; i < 4; ++i) {
+    minX = fmin(minX, corners[i].x); maxX = fmax(maxX, corners[i].x);
+    minY = fmin(minY, corners[i].y); maxY = fmax(maxY, corners[i].y);
+  }
+  return MCKRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+/* ---------- Metrics ---------- */
+
+/* The start of a timed step, if the host collects metrics, else 0 */
+static double MCKMetricsStart(const MCKDragDropHost * host)
+{
+  return host->metrics ? MCKSessionMetricsNow(host->metrics) : 0;
+}
+
+/* Counts a timed step, unless it started while the host was not collecting metrics */
+static void MCKMetricsEnd(const MCKDragDropHost * host, MCKMetric metric, MCKHandle view, double start)
+{
+  if ( host->metrics && start != 0 )
+    MCKSessionMetricsRecord(host->metrics, metric, view, start);
+}
+
+/* ---------- Hierarchy helpers ---------- */
+
+/* Moves view into parent at index, and gives it frame, in parent's coordinates */
+static void MCKInsertWithFrame(const MCKDragDropHost * host, MCKHandle parent, MCKHandle view, size_t index,
+                               MCKRect frame)
+{
+  double start = MCKMetricsStart(host);
+  host->tree.insert_child(host->context, parent, view, index);
+  host->tree.set_frame(host->context, view, frame);
+  MCKMetricsEnd(host, MCKMetricReparent, NULL, start);
+
+  if ( host->recorder )
+    MCKTraceRecordView(host->recorder, host, MCKTraceEventInsert, parent,
+                       index == MCKIndexEnd ? -1 : (int32_t)index);
+}
+
+void MCKMotionlessInsert(const MCKDragDropHost * host, MCKHandle parent, MCKHandle view, size_t index)
+{
+  const MCKTreeOps * tree = &host->tree;
+  MCKRect newFrame = tree->convert_rect(host->context, tree->frame_of(host->context, view),
+                                        tree->parent_of(host->context, view), parent);
+  MCKInsertWithFrame(host, parent, view, index, newFrame);
+}
+
+/* ---------- Session ---------- */
+
+static void MCKRetain(const MCKDragDropHost * host, void * object)
+{
+  if ( object && host->tree.retain )
+    host->tree.retain(host->context, object);
+}
+
+static void MCKRelease(const MCKDragDropHost * host, void * object)
+{
+  if ( object && host->tree.release )
+    host->tree.release(host->context, object);
+}
+
+static void MCKBeginBatch(const MCKDragDropHost * host)
+{
+  if ( host->tree.begin_batch )
+    host->tree.begin_batch(host->context);
+}
+
+static void MCKEndBatch(const MCKDragDropHost * host)
+{
+  if ( host->tree.end_batch )
+    host->tree.end_batch(host->context);
+}
+
+void MCKSessionInit(MCKSession * session, const MCKDragDropHost * host, void * user_data)
+{
+  memset(session, 0, sizeof(*session));
+  session->host = host;
+  session->user_data = user_data;
+  session->items = &session->first_item;
+  session->item_capacity = 1;
+  session->insertion_index = MCKIndexEnd;
+}
+
+void MCKSessionDispose(MCKSession * session)
+{
+  if ( session->items != &session->first_item )
+    free(session->items);
+  session->items = &session->first_item;
+  session->item_capacity = 1;
+}
+
+/* Appends an item for view, and retains the view */
+static MCKSessionItem * MCKSessionAddItem(MCKSession * session, MCKHandle view)
+{
+  if ( session->item_count == session->item_capacity ) {
+    size_t capacity = session->item_capacity < 8 ? 8 : 2 * session->item_capacity;
+    MCKSessionItem * items = malloc(capacity * sizeof(MCKSessionItem));
+    memcpy(items, session->items, session->item_count * sizeof(MCKSessionItem));
+    MCKSessionDispose(session);
+    session->items = items;
+    session->item_capacity = capacity;
+  }
+  MCKSessionItem * item = &session->items[session->item_count++];
+  memset(item, 0, sizeof(*item));
+  item->view = view;
+  MCKRetain(session->host, view);
+  return item;
+}
+
+static void MCKSessionPoolRelease(MCKSessionPool * pool, MCKSession * session);
+
+/* Releases everything the session holds, returns it to idle, and to its pool */
+static void MCKSessionEnd(MCKSession * session)
+{
+  const MCKDragDropHost * host = session->host;
+  MCKSessionPool * pool = session->pool;
+  MCKMetricsEnd(host, MCKMetricSession, NULL, session->pickup_time);
+  if ( host->tree.session_did_end )
+    host->tree.session_did_end(host->context, session);
+  for (size_t i = 0; i < session->item_count; ++i) {
+    MCKRelease(host, session->items[i].view);
+    MCKRelease(host, session->items[i].initial_superview);
+    MCKRelease(host, session->items[i].initial_anchor);
+  }
+  MCKRelease(host, session->donor_view);
+  MCKRelease(host, session->payload);
+  MCKRelease(host, session->hover_absorber_view);
+  MCKRelease(host, session->absorber_view);
+
+  // keep grown item storage for the next drag
+  MCKSessionItem * items = session->items;
+  size_t capacity = session->item_capacity;
+  bool ownsItems = items != &session->first_item;
+  MCKSessionInit(session, host, session->user_data);
+  if ( ownsItems ) {
+    session->items = items;
+    session->item_capacity = capacity;
+  }
+  session->pool = pool;
+  if ( pool )
+    MCKSessionPoolRelease(pool, session);
+}
+
+/* Moves the hover to absorber, sending exit and enter callbacks if it changed */
+static void MCKSessionSetHoverAbsorber(MCKSession * session, MCKHandle absorber)
+{
+  const MCKDragDropHost * host = session->host;
+  MCKHandle previous = session->hover_absorber_view;
+  if ( previous == absorber )
+    return;
+
+  session->hover_absorber_view = absorber;
+  MCKRetain(host, absorber);
+  if ( host->recorder )
+    MCKTraceRecordView(host->recorder, host, MCKTraceEventHover, absorber, 0);
+  if ( previous && host->callbacks.absorber_did_exit ) {
+    double start = MCKMetricsStart(host);
+    host->callbacks.absorber_did_exit(host->context, previous, session->drag_view, session->payload);
+    MCKMetricsEnd(host, MCKMetricAbsorberDidExit, previous, start);
+  }
+  if ( absorber && host->callbacks.absorber_did_enter ) {
+    double start = MCKMetricsStart(host);
+    host->callbacks.absorber_did_enter(host->context, absorber, session->drag_view, session->payload);
+    MCKMetricsEnd(host, MCKMetricAbsorberDidEnter, absorber, start);
+  }
+  MCKRelease(host, previous);
+}
+
+/*
+ Sends a donor notification about the session's views: once through the
+ array callback if there are several views and the host has one, otherwise
+ once per view.
+ */
+static void MCKSessionNotifyDonor(const MCKSession * session, MCKMetric metric,
+                                  void (*items_callback)(void *, MCKHandle, const MCKSession *),
+                                  void (*view_callback)(void *, MCKHandle, MCKHandle))
+{
+  const MCKDragDropHost * host = session->host;
+  double start = MCKMetricsStart(host);
+  if ( session->item_count > 1 && items_callback )
+    items_callback(host->context, session->donor_view, session);
+  else if ( view_callback )
+    for (size_t i = 0; i < session->item_count; ++i)
+      view_callback(host->context, session->donor_view, session->items[i].view);
+  else
+    return;
+  MCKMetricsEnd(host, metric, session->donor_view, start);
+}
+
+/*
+ Sessions whose views may come from the same superviews as session's: the
+ active sessions of its pool, session included, or session alone. Idle
+ sessions have no items, so callers need not skip them.
+ */
+static size_t MCKSessionRelatedCount(const MCKSession * session)
+{
+  return session->pool ? session->pool->capacity : 1;
+}
+
+static MCKSession * MCKSessionRelated(const MCKSession * session, size_t i)
+{
+  return session->pool ? &session->pool->sessions[i] : (MCKSession*)session;
+}
+
+/* The item of a related session which drags view, or NULL */
+static MCKSessionItem * MCKSessionItemOfView(const MCKSession * session, MCKHandle view)
+{
+  for (size_t i = 0; i < MCKSessionRelatedCount(session); ++i) {
+    MCKSession * other = MCKSessionRelated(session, i);
+    for (size_t k = 0; k < other->item_count; ++k)
+      if ( other->items[k].view == view )
+        return &other->items[k];
+  }
+  return NULL;
+}
+
+/*
+ The other item, of any related session, from the same superview as item,
+ which is anchored to anchor, or NULL. There is at most one: see
+ MCKSessionFindAnchor.
+
+ Items of proxy drags do not count. Their views never leave the superview,
+ so they sit in no gap.
+ */
+static MCKSessionItem * MCKSessionItemAnchoredTo(const MCKSession * session, const MCKSessionItem * item,
+                                                 MCKHandle anchor)
+{
+  for (size_t i = 0; i < MCKSessionRelatedCount(session); ++i) {
+    MCKSession * other = MCKSessionRelated(session, i);
+    for (size_t k = 0; k < other->item_count; ++k) {
+      MCKSessionItem * candidate = &other->items[k];
+      if ( candidate != item && !candidate->proxy && candidate->initial_superview == item->initial_superview
+          && candidate->initial_anchor == anchor )
+        return candidate;
+    }
+  }
+  return NULL;
+}
+
+/*
+ The sibling the item's view should be put back below, if reclaimed: the one
+ just in front of it. Siblings away in drags count, so if some of them sit in
+ the same gap, the anchor is the lowest of them.
+ */
+static MCKHandle MCKSessionFindAnchor(const MCKSession * session, const MCKSessionItem * item)
+{
+  const MCKDragDropHost * host = session->host;
+  MCKHandle anchor = host->tree.child_at(host->context, item->initial_superview, item->initial_index + 1);
+  MCKSessionItem * other;
+  while ( (other = MCKSessionItemAnchoredTo(session, item, anchor)) )
+    anchor = other->view;
+  return anchor;
+}
+
+/* The item's view is leaving its superview for good: items anchored to it inherit its anchor */
+static void MCKSessionForgetAnchor(MCKSession * session, const MCKSessionItem * item)
+{
+  const MCKDragDropHost * host = session->host;
+  MCKSessionItem * other = MCKSessionItemAnchoredTo(session, item, item->view);
+  if ( other ) {
+    MCKRetain(host, item->initial_anchor);
+    MCKRelease(host, other->initial_anchor);
+    other->initial_anchor = item->initial_anchor;
+  }
+}
+
+static int MCKSessionItemCompareIndex(const void * a, const void * b)
+{
+  size_t x = ((const MCKSessionItem*)a)->initial_index, y = ((const MCKSessionItem*)b)->initial_index;
+  return x < y ? -1 : x > y;
+}
+
+bool MCKSessionCanBegin(const MCKDragDropHost * host, MCKHandle drag, MCKHandle * donor_out)
+{
+  MCKHandle donor = host->tree.donor_of(host->context, drag);
+  if ( donor_out )
+    *donor_out = donor;
+  if ( !donor )
+    return false;
+  if ( !host->callbacks.donor_should_begin )
+    return true;
+  double start = MCKMetricsStart(host);
+  bool shouldBegin = host->callbacks.donor_should_begin(host->context, donor, drag);
+  MCKMetricsEnd(host, MCKMetricDonorShouldBegin, donor, start);
+  return shouldBegin;
+}
+
+bool MCKSessionPickUp(MCKSession * session, MCKHandle drag)
+{
+  return MCKSessionPickUpItems(session, drag, NULL, 0);
+}
+
+bool MCKSessionPickUpItems(MCKSession * session, MCKHandle drag,
+                           const MCKHandle * others, size_t other_count)
+{
+  const MCKDragDropHost * host = session->host;
+  const MCKTreeOps * tree = &host->tree;
+  if ( session->phase != MCKSessionPhaseIdle )
+    return false;
+
+  double start = MCKMetricsStart(host);
+  bool proxied = host->drag_proxies && tree->create_proxy && tree->destroy_proxy && tree->set_hidden;
+  if ( host->recorder ) {
+    for (size_t i = 0; i < other_count; ++i)
+      if ( others[i] )
+        MCKTraceRecordView(host->recorder, host, MCKTraceEventCompanion, others[i], 0);
+    if ( proxied )
+      MCKTraceRecordValue(host->recorder, MCKTraceEventProxies, 0);
+    MCKTraceRecordView(host->recorder, host, MCKTraceEventPickUp, drag, 0);
+  }
+  MCKHandle donor = tree->donor_of(host->context, drag);
+  if ( host->recorder )
+    MCKTraceRecordView(host->recorder, host, MCKTraceEventDonor, donor, 0);
+  if ( !donor )
+    return false;
+
+  session->phase = MCKSessionPhaseDragging;
+  session->pickup_time = start;
+  session->drag_view = drag;
+  session->donor_view = donor;
+  MCKRetain(host, donor);
+  MCKSessionAddItem(session, drag);
+  for (size_t i = 0; i < other_count; ++i) {
+    MCKHandle other = others[i];
+    if ( other && tree->donor_of(host->context, other) == donor && !MCKSessionItemOfView(session, other) )
+      MCKSessionAddItem(session, other);
+  }
+
+  // tell donor that the views are about to be detached, and take the payload it returns
+  double willBeginStart = MCKMetricsStart(host);
+  if ( session->item_count > 1 && host->callbacks.donor_will_begin_items )
+    session->payload = host->callbacks.donor_will_begin_items(host->context, donor, session);
+  else if ( host->callbacks.donor_will_begin )
+    session->payload = host->callbacks.donor_will_begin(host->context, donor, drag);
+  if ( host->callbacks.donor_will_begin_items || host->callbacks.donor_will_begin )
+    MCKMetricsEnd(host, MCKMetricDonorWillBegin, donor, willBeginStart);
+
+  // take the views back to front, so they keep their stacking order in the
+  // group, and so that each anchor is the view in front in the original order
+  if ( session->item_count > 1 ) {
+    for (size_t i = 0; i < session->item_count; ++i)
+      session->items[i].initial_index = tree->index_in_parent(host->context, session->items[i].view);
+    qsort(session->items, session->item_count, sizeof(MCKSessionItem), MCKSessionItemCompareIndex);
+  }
+
+  // float the views, or their proxies, above everything else, carried by a
+  // group if there are several
+  session->proxied = proxied;
+  MCKHandle layer = tree->drag_layer_of(host->context, drag);
+  if ( session->item_count > 1 && tree->create_group )
+    session->float_view = tree->create_group(host->context, layer);
+  MCKHandle carrier = session->item_count > 1 && session->float_view ? session->float_view : layer;
+
+  MCKBeginBatch(host);
+  for (size_t i = 0; i < session->item_count; ++i) {
+    MCKSessionItem * item = &session->items[i];
+    // cache original frame, superview and index
+    item->initial_frame = tree->frame_of(host->context, item->view);
+    item->initial_superview = tree->parent_of(host->context, item->view);
+    item->initial_index = tree->index_in_parent(host->context, item->view);
+    item->initial_anchor = MCKSessionFindAnchor(session, item);
+    MCKRetain(host, item->initial_superview);
+    MCKRetain(host, item->initial_anchor);
+
+    if ( session->proxied ) {
+      item->proxy = tree->create_proxy(host->context, carrier, item->view);
+      tree->set_hidden(host->context, item->view, true);
+    }
+    else {
+      MCKMotionlessInsert(host, carrier, item->view, MCKIndexEnd);
+      session->reparent_count++;
+    }
+    if ( item->view == drag )
+      session->lead_view = MCKSessionItemFloatingView(item);
+  }
+  MCKEndBatch(host);
+  if ( session->item_count == 1 )
+    session->float_view = session->lead_view;
+
+  if ( tree->apply_pickup_effect )
+    tree->apply_pickup_effect(host->context, session);
+
+  MCKSessionNotifyDonor(session, MCKMetricDonorDidBegin,
+                        host->callbacks.donor_did_begin_items, host->callbacks.donor_did_begin);
+  MCKMetricsEnd(host, MCKMetricPickUp, NULL, start);
+  return true;
+}
+
+/* Where the session's views would go in absorber, see MCKTreeOps.insertion_index */
+static size_t MCKSessionInsertionIndex(MCKSession * session, MCKHandle absorber)
+{
+  const MCKDragDropHost * host = session->host;
+  if ( !absorber || !host->tree.insertion_index )
+    return MCKIndexEnd;
+  return host->tree.insertion_index(host->context, absorber, session);
+}
+
+static void MCKTranslate(const MCKDragDropHost * host, MCKHandle view, double dx, double dy)
+{
+  MCKPoint center = host->tree.center_of(host->context, view);
+  host->tree.set_center(host->context, view, MCKPointMake(center.x + dx, center.y + dy));
+}
+
+void MCKSessionMove(MCKSession * session, double dx, double dy)
+{
+  const MCKDragDropHost * host = session->host;
+  if ( session->phase != MCKSessionPhaseDragging )
+    return;
+
+  double start = MCKMetricsStart(host);
+  if ( host->recorder )
+    MCKTraceRecordMove(host->recorder, dx, dy);
+  if ( session->float_view )
+    MCKTranslate(host, session->float_view, dx, dy);
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKTranslate(host, MCKSessionItemFloatingView(&session->items[i]), dx, dy);
+
+  if ( host->hover_tracking_enabled ) {
+    double hitTestStart = MCKMetricsStart(host);
+    MCKHandle absorber = host->tree.absorber_under(host->context, session);
+    size_t index = MCKSessionInsertionIndex(session, absorber);
+    MCKMetricsEnd(host, MCKMetricHitTest, NULL, hitTestStart);
+    MCKSessionSetHoverAbsorber(session, absorber);
+    session->insertion_index = index;
+
+    double hoverStart = MCKMetricsStart(host);
+    bool hovered = false;
+    if ( absorber && host->callbacks.absorber_did_hover ) {
+      host->callbacks.absorber_did_hover(host->context, absorber, session->drag_view, session->payload);
+      hovered = true;
+    }
+    if ( session->insertion_index != MCKIndexEnd && host->callbacks.absorber_did_hover_at_index ) {
+      host->callbacks.absorber_did_hover_at_index(host->context, absorber, session);
+      hovered = true;
+    }
+    if ( hovered )
+      MCKMetricsEnd(host, MCKMetricAbsorberDidHover, absorber, hoverStart);
+  }
+  MCKMetricsEnd(host, MCKMetricMove, NULL, start);
+}
+
+/* Gets rid of the group which carried the views, once they have left it */
+static void MCKSessionDestroyGroup(MCKSession * session)
+{
+  const MCKDragDropHost * host = session->host;
+  if ( session->float_view && session->item_count > 1 && host->tree.destroy_group )
+    host->tree.destroy_group(host->context, session->float_view);
+  session->float_view = NULL;
+}
+
+/* Shows the item's view again in place of its proxy, and gets rid of the proxy */
+static void MCKSessionDestroyProxy(MCKSession * session, MCKSessionItem * item)
+{
+  const MCKDragDropHost * host = session->host;
+  if ( !item->proxy )
+    return;
+  host->tree.set_hidden(host->context, item->view, false);
+  host->tree.destroy_proxy(host->context, item->proxy);
+  item->proxy = NULL;
+}
+
+/*
+ Moves the item's view into parent at index, where what floats for it is
+ onscreen. A proxied view jumps there from its original superview, in the
+ only hierarchy change of its drag.
+ */
+static void MCKSessionLandItem(MCKSession * session, MCKSessionItem * item, MCKHandle parent, size_t index)
+{
+  const MCKDragDropHost * host = session->host;
+  const MCKTreeOps * tree = &host->tree;
+  if ( item->proxy ) {
+    // the view leaves its place first, if it moves within the same parent
+    if ( index != MCKIndexEnd && tree->parent_of(host->context, item->view) == parent
+        && tree->index_in_parent(host->context, item->view) < index )
+      index--;
+    MCKRect frame = tree->convert_rect(host->context, tree->frame_of(host->context, item->proxy),
+                                       tree->parent_of(host->context, item->proxy), parent);
+    MCKInsertWithFrame(host, parent, item->view, index, frame);
+    MCKSessionDestroyProxy(session, item);
+  }
+  else
+    MCKMotionlessInsert(host, parent, item->view, index);
+  session->reparent_count++;
+}
+
+static void MCKSessionReclaim(MCKSession * session);
+
+/*
+ Where to put the item's view back in its original superview.
+
+ Other drags may have taken views from the superview, or put some back, since
+ pickup, so initial_index may be stale. The view goes back below its anchor
+ instead. If the anchor is itself away in a drag from the same superview, the
+ view goes below that item's anchor, and so on.
+ */
+static size_t MCKSessionRestoreIndex(const MCKSession * session, const MCKSessionItem * item)
+{
+  const MCKDragDropHost * host = session->host;
+  MCKHandle anchor = item->initial_anchor;
+  size_t hops = 0;
+  for (size_t i = 0; i < MCKSessionRelatedCount(session); ++i)
+    hops += MCKSessionRelated(session, i)->item_count;
+  for (;;) {
+    if ( !anchor )
+      return MCKIndexEnd; // it was in front of all its siblings
+    if ( host->tree.parent_of(host->context, anchor) == item->initial_superview )
+      return host->tree.index_in_parent(host->context, anchor);
+
+    const MCKSessionItem * other = MCKSessionItemOfView(session, anchor);
+    if ( !other || other->initial_superview != item->initial_superview || hops-- == 0 )
+      return item->initial_index; // the anchor left for good
+    anchor = other->initial_anchor;
+  }
+}
+
+/* Completion of the reclaim animation: put the views back where they came from */
+static void MCKSessionFinishReclaim(MCKSession * session)
+{
+  const MCKDragDropHost * host = session->host;
+  if ( host->tree.undo_pickup_effect )
+    host->tree.undo_pickup_effect(host->context, session);
+
+  // front to back, so the anchor of each view is back before the view is.
+  // Proxied views never left.
+  MCKBeginBatch(host);
+  for (size_t i = session->item_count; i > 0; --i) {
+    MCKSessionItem * item = &session->items[i - 1];
+    if ( item->proxy )
+      MCKSessionDestroyProxy(session, item);
+    else
+      MCKSessionLandItem(session, item, item->initial_superview, MCKSessionRestoreIndex(session, item));
+  }
+  MCKEndBatch(host);
+  MCKSessionDestroyGroup(session);
+
+  MCKSessionNotifyDonor(session, MCKMetricDonorDidReclaim,
+                        host->callbacks.donor_did_reclaim_items, host->callbacks.donor_did_reclaim);
+  MCKMetricsEnd(host, MCKMetricReclaim, NULL, session->reclaim_time);
+  MCKSessionEnd(session);
+}
+
+MCKDropOutcome MCKSessionDrop(MCKSession * session)
+{
+  const MCKDragDropHost * host = session->host;
+  const MCKTreeOps * tree = &host->tree;
+  const MCKDragDropCallbacks * callbacks = &host->callbacks;
+  if ( session->phase != MCKSessionPhaseDragging )
+    return MCKDropOutcomeNone;
+
+  double start = MCKMetricsStart(host);
+  if ( host->recorder )
+    MCKTraceRecordValue(host->recorder, MCKTraceEventDrop, 0);
+  double hitTestStart = MCKMetricsStart(host);
+  MCKHandle absorber = tree->absorber_under(host->context, session);
+  MCKMetricsEnd(host, MCKMetricHitTest, NULL, hitTestStart);
+  if ( host->recorder )
+    MCKTraceRecordView(host->recorder, host, MCKTraceEventAbsorber, absorber, 0);
+  session->absorber_view = absorber;
+  MCKRetain(host, absorber);
+
+  // hovering is over
+  MCKSessionSetHoverAbsorber(session, NULL);
+
+  // it is required to have an absorber. absorbers default to accepting drops,
+  // and their delegate can veto it.
+  bool dropWasAccepted = absorber != NULL;
+  double canAbsorbStart = MCKMetricsStart(host);
+  if ( absorber && session->item_count > 1 && callbacks->absorber_can_absorb_items )
+    dropWasAccepted = callbacks->absorber_can_absorb_items(host->context, absorber, session);
+  else if ( absorber && callbacks->absorber_can_absorb )
+    dropWasAccepted = callbacks->absorber_can_absorb(host->context, absorber, session->drag_view, session->payload);
+  if ( absorber && (callbacks->absorber_can_absorb_items || callbacks->absorber_can_absorb) )
+    MCKMetricsEnd(host, MCKMetricAbsorberCanAbsorb, absorber, canAbsorbStart);
+
+  if ( dropWasAccepted ) {
+    MCKSessionNotifyDonor(session, MCKMetricDonorWillDonate,
+                          callbacks->donor_will_donate_items, callbacks->donor_will_donate);
+
+    if ( tree->undo_pickup_effect )
+      tree->undo_pickup_effect(host->context, session);
+    // back to front, so the views keep their stacking order, at consecutive
+    // indices if the absorber keeps its children in order
+    size_t index = session->insertion_index = MCKSessionInsertionIndex(session, absorber);
+    MCKBeginBatch(host);
+    for (size_t i = 0; i < session->item_count; ++i) {
+      MCKSessionForgetAnchor(session, &session->items[i]);
+      MCKSessionLandItem(session, &session->items[i], absorber, index == MCKIndexEnd ? index : index + i);
+    }
+    MCKEndBatch(host);
+    // proxied views may have been counted at their old place in the absorber
+    if ( index != MCKIndexEnd )
+      session->insertion_index = tree->index_in_parent(host->context, session->items[0].view);
+    MCKSessionDestroyGroup(session);
+
+    double didAbsorbStart = MCKMetricsStart(host);
+    bool absorbed = false;
+    if ( session->item_count > 1 && callbacks->absorber_did_absorb_items ) {
+      callbacks->absorber_did_absorb_items(host->context, absorber, session);
+      absorbed = true;
+    }
+    else if ( callbacks->absorber_did_absorb ) {
+      for (size_t i = 0; i < session->item_count; ++i)
+        callbacks->absorber_did_absorb(host->context, absorber, session->items[i].view, session->payload);
+      absorbed = true;
+    }
+    if ( index != MCKIndexEnd && callbacks->absorber_did_absorb_at_index ) {
+      callbacks->absorber_did_absorb_at_index(host->context, absorber, session);
+      absorbed = true;
+    }
+    if ( absorbed )
+      MCKMetricsEnd(host, MCKMetricAbsorberDidAbsorb, absorber, didAbsorbStart);
+    MCKSessionNotifyDonor(session, MCKMetricDonorDidDonate,
+                          callbacks->donor_did_donate_items, callbacks->donor_did_donate);
+    if ( host->recorder )
+      MCKTraceRecordValue(host->recorder, MCKTraceEventOutcome, MCKDropOutcomeAccepted);
+    MCKMetricsEnd(host, MCKMetricDrop, NULL, start);
+    MCKSessionEnd(session);
+    return MCKDropOutcomeAccepted;
+  }
+
+  if ( host->recorder )
+    MCKTraceRecordValue(host->recorder, MCKTraceEventOutcome, MCKDropOutcomeRejected);
+  MCKSessionReclaim(session);
+  MCKMetricsEnd(host, MCKMetricDrop, NULL, start);
+  return MCKDropOutcomeRejected;
+}
+
+void MCKSessionCancel(MCKSession * session)
+{
+  if ( session->phase != MCKSessionPhaseDragging )
+    return;
+  MCKSessionSetHoverAbsorber(session, NULL);
+  MCKSessionReclaim(session);
+}
+
+/* Starts sliding the dragged views back to where they were picked up */
+static void MCKSessionReclaim(MCKSession * session)
+{
+  const MCKDragDropHost * host = session->host;
+  const MCKTreeOps * tree = &host->tree;
+
+  // slide back to the original positions, in the coordinates of the current
+  // superviews. A proxy slides back over its view, which has not moved.
+  session->phase = MCKSessionPhaseReclaiming;
+  session->reclaim_time = MCKMetricsStart(host);
+  for (size_t i = 0; i < session->item_count; ++i) {
+    MCKSessionItem * item = &session->items[i];
+    MCKHandle floating = MCKSessionItemFloatingView(item);
+    MCKRect from = item->proxy ? tree->frame_of(host->context, item->view) : item->initial_frame;
+    item->restore_frame = tree->convert_rect(host->context, from, item->initial_superview,
+                                             tree->parent_of(host->context, floating));
+  }
+  if ( tree->animate_reclaim )
+    tree->animate_reclaim(host->context, session, MCKSessionFinishReclaim);
+  else {
+    for (size_t i = 0; i < session->item_count; ++i)
+      tree->set_frame(host->context, MCKSessionItemFloatingView(&session->items[i]), session->items[i].restore_frame);
+    MCKSessionFinishReclaim(session);
+  }
+}
+
+/* ---------- Session pool ---------- */
+
+void MCKSessionPoolInit(MCKSessionPool * pool, const MCKDragDropHost * host,
+                        MCKSession * storage, size_t capacity)
+{
+  pool->sessions = storage;
+  pool->capacity = capacity;
+  pool->active_count = 0;
+  pool->free_list = NULL;
+  for (size_t i = capacity; i > 0; --i) {
+    MCKSession * session = &storage[i - 1];
+    MCKSessionInit(session, host, NULL);
+    session->pool = pool;
+    session->next_free = pool->free_list;
+    pool->free_list = session;
+  }
+}
+
+static void MCKSessionPoolRelease(MCKSessionPool * pool, MCKSession * session)
+{
+  session->next_free = pool->free_list;
+  pool->free_list = session;
+  pool->active_count--;
+}
+
+MCKSession * MCKSessionPoolPickUp(MCKSessionPool * pool, MCKHandle drag, void * user_data)
+{
+  return MCKSessionPoolPickUpItems(pool, drag, NULL, 0, user_data);
+}
+
+MCKSession * MCKSessionPoolPickUpItems(MCKSessionPool * pool, MCKHandle drag,
+                                       const MCKHandle * others, size_t other_count, void * user_data)
+{
+  MCKSession * session = pool->free_list;
+  if ( !session || MCKSessionPoolSessionOfView(pool, drag) )
+    return NULL;
+
+  pool->free_list = session->next_free;
+  session->next_free = NULL;
+  session->user_data = user_data;
+  pool->active_count++;
+  if ( !MCKSessionPickUpItems(session, drag, others, other_count) ) {
+    MCKSessionPoolRelease(pool, session);
+    return NULL;
+  }
+  return session;
+}
+
+MCKSession * MCKSessionPoolSessionOfView(const MCKSessionPool * pool, MCKHandle drag)
+{
+  for (size_t i = 0; i < pool->capacity; ++i)
+    for (size_t k = 0; k < pool->sessions[i].item_count; ++k)
+      if ( pool->sessions[i].items[k].view == drag )
+        return &pool->sessions[i];
+  return NULL;
+}
@@ -0,0 +1,412 @@
+//
+//  MCKDragDropCore.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKDragDropCore_h
+#define MCKDragDropCore_h
+
+/*
+ The platform-neutral core of the DnD system: plain C99, no UIKit, no
+ Foundation.
+
+ It holds the DnD session state machine (pickup / move / drop / reclaim) and
+ the rules for finding donors and absorbers and for moving a view between
+ superviews without moving it onscreen. Everything it knows about views goes
+ through an MCKDragDropHost, a table of function pointers supplied by the
+ platform layer:
+
+ - MCKDragDropServer is the UIKit host. Its handles are UIViews.
+ - MCKNodeTree.h provides a headless host over an in-memory tree of nodes, so
+   the session logic can be driven, tested and measured without a device.
+
+ DESIGN NOTES:
+ A "handle" is an opaque pointer to a view in the host's tree. The core never
+ dereferences it. Handles the session must keep alive between events (the
+ dragged views, their donor, their original superviews, the payload) are passed
+ to the host's retain and release functions.
+
+ A session may drag several views at once, for instance a selection. They
+ are all picked up from the same donor, float together in a group view the
+ host creates, and are absorbed or reclaimed together.
+
+ By default the dragged views themselves float in the drag layer, so they
+ change superview at pickup and again at the drop. A host which can make
+ proxies may instead have the session drag a proxy of each view, leaving the
+ views in place, hidden. The hierarchy then changes only when a drop is
+ accepted, and the view moves into the absorber; a rejected drop leaves it
+ where it always was.
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ---------- Geometry ---------- */
+
+typedef struct { double x, y; } MCKPoint;
+typedef struct { double width, height; } MCKSize;
+typedef struct { MCKPoint origin; MCKSize size; } MCKRect;
+
+/** Affine transform, laid out like CGAffineTransform */
+typedef struct { double a, b, c, d, tx, ty; } MCKTransform;
+
+extern const MCKTransform MCKTransformIdentity;
+
+static inline MCKPoint MCKPointMake(double x, double y) { MCKPoint p = { x, y }; return p; }
+static inline MCKSize MCKSizeMake(double width, double height) { MCKSize s = { width, height }; return s; }
+static inline MCKRect MCKRectMake(double x, double y, double width, double height) {
+  MCKRect r = { { x, y }, { width, height } }; return r;
+}
+static inline MCKPoint MCKRectGetMid(MCKRect r) {
+  return MCKPointMake(r.origin.x + r.size.width / 2, r.origin.y + r.size.height / 2);
+}
+
+bool MCKRectContainsPoint(MCKRect rect, MCKPoint point);
+bool MCKTransformIsIdentity(MCKTransform t);
+MCKPoint MCKPointApplyTransform(MCKPoint point, MCKTransform t);
+MCKTransform MCKTransformInvert(MCKTransform t);
+/** The bounding box of the transformed corners of rect */
+MCKRect MCKRectApplyTransform(MCKRect rect, MCKTransform t);
+
+/* ---------- Roles ---------- */
+
+/** Roles a view can play in DnD. A view may have several. */
+typedef enum {
+  MCKDragDropRoleNone      = 0,
+  MCKDragDropRoleDraggable = 1 << 0,
+  MCKDragDropRoleDonor     = 1 << 1,
+  MCKDragDropRoleAbsorber  = 1 << 2
+} MCKDragDropRole;
+
+/* ---------- Host ---------- */
+
+typedef void * MCKHandle;
+typedef struct MCKSession MCKSession;
+typedef struct MCKTraceRecorder MCKTraceRecorder;
+typedef struct MCKSessionMetrics MCKSessionMetrics;
+typedef struct MCKSessionPool MCKSessionPool;
+
+/** Pass as an index to insert a view in front of all its new siblings */
+#define MCKIndexEnd ((size_t)-1)
+
+/**
+ What the core needs to know about the host's view tree.
+
+ All functions receive the host's context as their first argument.
+ */
+typedef struct {
+  MCKHandle (*parent_of)(void * context, MCKHandle view);
+  size_t    (*index_in_parent)(void * context, MCKHandle view);
+  /** The child of parent at index, or NULL if index is out of range */
+  MCKHandle (*child_at)(void * context, MCKHandle parent, size_t index);
+  /** Insert child into parent at index, or in front if index is MCKIndexEnd or past the end */
+  void      (*insert_child)(void * context, MCKHandle parent, MCKHandle child, size_t index);
+
+  MCKRect   (*frame_of)(void * context, MCKHandle view);
+  void      (*set_frame)(void * context, MCKHandle view, MCKRect frame);
+  MCKPoint  (*center_of)(void * context, MCKHandle view);
+  void      (*set_center)(void * context, MCKHandle view, MCKPoint center);
+  /** Convert rect from the coordinates of one view to another's */
+  MCKRect   (*convert_rect)(void * context, MCKRect rect, MCKHandle from, MCKHandle to);
+
+  /** The view a dragged view floats in during a drag */
+  MCKHandle (*drag_layer_of)(void * context, MCKHandle view);
+  /** The closest ancestor of view registered as a donor, or NULL */
+  MCKHandle (*donor_of)(void * context, MCKHandle view);
+  /**
+   The absorber under the center of the session's lead_view, or NULL.
+   Views inside the session's float_view are never candidates.
+   */
+  MCKHandle (*absorber_under)(void * context, MCKSession * session);
+  /**
+   Optional. The child index at which the session's views would go if dropped
+   into absorber, for an absorber which keeps its children in order, or
+   MCKIndexEnd. If NULL, dropped views always go in front.
+   */
+  size_t    (*insertion_index)(void * context, MCKHandle absorber, MCKSession * session);
+
+  /**
+   Optional. Create an empty view covering parent, to carry the views of a
+   multi-item drag, and destroy it once it is empty again. The handle
+   create_group returns is owned by the session. If NULL, the views of a
+   multi-item drag float, and move, one by one.
+   */
+  MCKHandle (*create_group)(void * context, MCKHandle parent);
+  void      (*destroy_group)(void * context, MCKHandle group);
+  /**
+   Optional. Bracket a run of hierarchy changes, so the host can apply them
+   as one update, e.g. in a single CATransaction.
+   */
+  void      (*begin_batch)(void * context);
+  void      (*end_batch)(void * context);
+
+  /**
+   Optional. Create a view in layer which looks like view, and is over it
+   onscreen, and destroy it. The handle create_proxy returns is owned by the
+   session. With set_hidden, these make proxy drags possible.
+   */
+  MCKHandle (*create_proxy)(void * context, MCKHandle layer, MCKHandle view);
+  void      (*destroy_proxy)(void * context, MCKHandle proxy);
+  /** Optional. Hide, or show again, a view left in place during a proxy drag */
+  void      (*set_hidden)(void * context, MCKHandle view, bool hidden);
+
+  /** Optional. Change the dragged view's look at pickup, and restore it. */
+  void      (*apply_pickup_effect)(void * context, MCKSession * session);
+  void      (*undo_pickup_effect)(void * context, MCKSession * session);
+  /**
+   Optional. Animate what floats for each of the session's items, see
+   MCKSessionItemFloatingView, to its restore_frame, all in one animation,
+   then call completion once. If NULL, the frames are set and completion runs
+   immediately.
+   */
+  void      (*animate_reclaim)(void * context, MCKSession * session,
+                               void (*completion)(MCKSession * session));
+
+  /** Optional. The session is over, and its views have settled. Called before it goes idle. */
+  void      (*session_did_end)(void * context, MCKSession * session);
+
+  void      (*retain)(void * context, void * object);
+  void      (*release)(void * context, void * object);
+} MCKTreeOps;
+
+/**
+ The delegate protocols, as C callbacks. See MCKDragDropProtocol.h for what
+ each one means. Any callback may be NULL, which behaves as if the delegate
+ did not implement the method.
+
+ The _items callbacks are the array versions, for sessions dragging more than
+ one view: the views are session->items[0 .. item_count). If one is NULL, the
+ core falls back to the single-view callback, called for each view, except
+ for donor_will_begin and absorber_can_absorb which are asked about the
+ session's drag_view only. Hover callbacks always name the drag_view.
+ */
+typedef struct {
+  bool   (*donor_should_begin)(void * context, MCKHandle donor, MCKHandle drag);
+  /** Returns the payload, owned by the caller: it is released when the session ends */
+  void * (*donor_will_begin)(void * context, MCKHandle donor, MCKHandle drag);
+  void   (*donor_did_begin)(void * context, MCKHandle donor, MCKHandle drag);
+  void   (*donor_will_donate)(void * context, MCKHandle donor, MCKHandle drag);
+  void   (*donor_did_donate)(void * context, MCKHandle donor, MCKHandle drag);
+  void   (*donor_did_reclaim)(void * context, MCKHandle donor, MCKHandle drag);
+
+  bool   (*absorber_can_absorb)(void * context, MCKHandle absorber, MCKHandle drag, void * payload);
+  void   (*absorber_did_absorb)(void * context, MCKHandle absorber, MCKHandle drag, void * payload);
+  void   (*absorber_did_enter)(void * context, MCKHandle absorber, MCKHandle drag, void * payload);
+  void   (*absorber_did_hover)(void * context, MCKHandle absorber, MCKHandle drag, void * payload);
+  void   (*absorber_did_exit)(void * context, MCKHandle absorber, MCKHandle drag, void * payload);
+
+  void * (*donor_will_begin_items)(void * context, MCKHandle donor, const MCKSession * session);
+  void   (*donor_did_begin_items)(void * context, MCKHandle donor, const MCKSession * session);
+  void   (*donor_will_donate_items)(void * context, MCKHandle donor, const MCKSession * session);
+  void   (*donor_did_donate_items)(void * context, MCKHandle donor, const MCKSession * session);
+  void   (*donor_did_reclaim_items)(void * context, MCKHandle donor, const MCKSession * session);
+  bool   (*absorber_can_absorb_items)(void * context, MCKHandle absorber, const MCKSession * session);
+  void   (*absorber_did_absorb_items)(void * context, MCKHandle absorber, const MCKSession * session);
+
+  // For absorbers which keep their children in order, the position of the
+  // views in the absorber is session->insertion_index. These are sent along
+  // with absorber_did_hover and absorber_did_absorb(_items), and only when
+  // insertion_index is not MCKIndexEnd.
+  void   (*absorber_did_hover_at_index)(void * context, MCKHandle absorber, const MCKSession * session);
+  void   (*absorber_did_absorb_at_index)(void * context, MCKHandle absorber, const MCKSession * session);
+} MCKDragDropCallbacks;
+
+typedef struct {
+  void * context;
+  MCKTreeOps tree;
+  MCKDragDropCallbacks callbacks;
+  /** Resolve the absorber and send hover callbacks on every move */
+  bool hover_tracking_enabled;
+  /**
+   Drag proxies of the views, and leave the views in place until the drop.
+   Taken into account at pickup, and only if the host has create_proxy,
+   destroy_proxy and set_hidden.
+   */
+  bool drag_proxies;
+  /** Optional. Receives every session event and decision, see MCKSessionTrace.h */
+  MCKTraceRecorder * recorder;
+  /** Optional. Times every session phase and callback, see MCKSessionMetrics.h */
+  MCKSessionMetrics * metrics;
+} MCKDragDropHost;
+
+/* ---------- Hierarchy helpers ---------- */
+
+/** Move view into parent at index, adjusting its frame so it does not move onscreen */
+void MCKMotionlessInsert(const MCKDragDropHost * host, MCKHandle parent, MCKHandle view, size_t index);
+
+/* ---------- Session ---------- */
+
+typedef enum {
+  MCKSessionPhaseIdle = 0,   // no drag in progress
+  MCKSessionPhaseDragging,   // picked up, following the finger
+  MCKSessionPhaseReclaiming  // rejected or cancelled, animating back to the donor
+} MCKSessionPhase;
+
+typedef enum {
+  MCKDropOutcomeNone = 0,
+  MCKDropOutcomeAccepted,   // the view now belongs to the absorber
+  MCKDropOutcomeRejected    // the view is being reclaimed by its donor
+} MCKDropOutcome;
+
+/** One dragged view of a session, and where it came from */
+typedef struct {
+  MCKHandle view;
+  // where the view came from, to reclaim it after a rejected drop
+  MCKHandle initial_superview;
+  size_t initial_index;
+  MCKRect initial_frame;
+  // sibling just in front of the view at pickup. Restoring below it, rather
+  // than at initial_index, stays right when other drags change the superview.
+  MCKHandle initial_anchor;
+  // what floats in the view's place in a proxy drag, else NULL
+  MCKHandle proxy;
+  // initial_frame in the coordinates of the superview of what floats for the
+  // item, during a reclaim
+  MCKRect restore_frame;
+} MCKSessionItem;
+
+/** What floats in the drag layer for item: its proxy in a proxy drag, else its view */
+static inline MCKHandle MCKSessionItemFloatingView(const MCKSessionItem * item) {
+  return item->proxy ? item->proxy : item->view;
+}
+
+/**
+ State of one drag, from pickup until its views have settled in an absorber
+ or been reclaimed by their donor.
+
+ Sessions are independent of each other, so several drags can run at once.
+ */
+struct MCKSession {
+  const MCKDragDropHost * host;
+  /** Free for the host's use, e.g. to point back at its gesture recognizer */
+  void * user_data;
+  /** The pool the session returns to when it ends, or NULL */
+  MCKSessionPool * pool;
+  MCKSession * next_free;
+
+  MCKSessionPhase phase;
+  // the view under the finger, one of the items
+  MCKHandle drag_view;
+  // what floats under the finger: drag_view, or its proxy
+  MCKHandle lead_view;
+  // what follows the finger in the drag layer: lead_view, or the group
+  // carrying all the items. NULL if the items float one by one.
+  MCKHandle float_view;
+  // the items float as proxies, and their views stay in place
+  bool proxied;
+  MCKHandle donor_view;
+  void * payload;
+
+  // the dragged views, in the order they were stacked in their superviews.
+  // Storage grows as needed and is kept from one drag to the next.
+  MCKSessionItem * items;
+  size_t item_count;
+  size_t item_capacity;
+  MCKSessionItem first_item;
+
+  // absorber last told the view entered it, if hover tracking is on
+  MCKHandle hover_absorber_view;
+  // absorber of the drop, once it has been resolved
+  MCKHandle absorber_view;
+  // where the views go in the hover or drop absorber, if it orders its
+  // children, else MCKIndexEnd. The views take consecutive indices from it.
+  // While hovering, views left in place by a proxy drag are counted; after
+  // the drop, it is where the first view ended up.
+  size_t insertion_index;
+
+  // views the session has moved from one superview to another, so far. Each
+  // move has the host lay out both superviews again.
+  size_t reparent_count;
+
+  // when the session was picked up, and started reclaiming, on the clock of
+  // the host's metrics, or 0 if it was not collecting them then
+  double pickup_time;
+  double reclaim_time;
+};
+
+/** Prepares session for use with host */
+void MCKSessionInit(MCKSession * session, const MCKDragDropHost * host, void * user_data);
+
+/** Frees the item storage of an idle session */
+void MCKSessionDispose(MCKSession * session);
+
+/**
+ Decides if drag may be picked up: it needs a donor, and the donor's delegate
+ must not refuse.
+
+ @param donor_out if not NULL, set to the donor found
+ */
+bool MCKSessionCanBegin(const MCKDragDropHost * host, MCKHandle drag, MCKHandle * donor_out);
+
+/**
+ Picks up drag: asks its donor for the payload, saves its slot in the view
+ hierarchy, and floats it, or its proxy, into the drag layer.
+
+ @return false if the session was not idle or drag has no donor
+ */
+bool MCKSessionPickUp(MCKSession * session, MCKHandle drag);
+
+/**
+ Picks up drag, and the views of others along with it, as one drag. drag is
+ the view under the finger. Views of others with a different donor than
+ drag, or already in a drag, are left where they are.
+
+ The views are moved into a group in the drag layer in a single batch, so
+ the host can redraw once however many there are.
+ */
+bool MCKSessionPickUpItems(MCKSession * session, MCKHandle drag,
+                           const MCKHandle * others, size_t other_count);
+
+/** Moves the dragged views by a translation, in the drag layer's coordinates */
+void MCKSessionMove(MCKSession * session, double dx, double dy);
+
+/**
+ Drops the dragged view onto the absorber under it, if that absorber accepts.
+ Otherwise starts reclaiming it, and the session stays in the reclaiming
+ phase until the host's animation completes.
+ */
+MCKDropOutcome MCKSessionDrop(MCKSession * session);
+
+/** Abandons the drag, and starts reclaiming the view as for a rejected drop */
+void MCKSessionCancel(MCKSession * session);
+
+/* ---------- Session pool ---------- */
+
+/**
+ A fixed set of sessions, reused from one drag to the next.
+
+ A session is taken from the pool at pickup and goes back to it by itself
+ when it ends, that is after a drop is absorbed or a reclaim completes. Its
+ sessions live in storage supplied by the caller, so single-view drags never
+ allocate; a session only allocates to hold the views of its largest
+ multi-item drag so far.
+ */
+struct MCKSessionPool {
+  MCKSession * sessions;
+  size_t capacity;
+  size_t active_count;
+  MCKSession * free_list;
+};
+
+void MCKSessionPoolInit(MCKSessionPool * pool, const MCKDragDropHost * host,
+                        MCKSession * storage, size_t capacity);
+
+/**
+ Takes a session from the pool and picks up drag with it.
+
+ @return the session, or NULL if drag is already in a session, the pool is
+ exhausted, or the pickup failed
+ */
+MCKSession * MCKSessionPoolPickUp(MCKSessionPool * pool, MCKHandle drag, void * user_data);
+
+/** Takes a session from the pool and picks up drag and others with it, see MCKSessionPickUpItems */
+MCKSession * MCKSessionPoolPickUpItems(MCKSessionPool * pool, MCKHandle drag,
+                                       const MCKHandle * others, size_t other_count, void * user_data);
+
+/** The session dragging or reclaiming drag, as one of its items, or NULL */
+MCKSession * MCKSessionPoolSessionOfView(const MCKSessionPool * pool, MCKHandle drag);
+
+#endif
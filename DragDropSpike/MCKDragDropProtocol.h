@@ -26,6 +26,10 @@
  @return payload an object that will be retained by the DnD system,
          made available to the asorber via the MCKDragDropAbsorberDelegate, and
          released after the drag is ended
+
+ If the payload is slow to build, return an MCKPayloadPromise instead: it is
+ built in the background, and only for drags which may be absorbed. See
+ MCKPayloadPromise.h.
  */
 -(id<NSObject>) donorView:(UIView*)donor willBeginDraggingView:(UIView*)draggingSubview;
 
@@ -51,6 +55,21 @@
   This will be called after the draggedView is re-inserted back into the donor VH.
  */
 -(void) donorView:(UIView*)donor didReclaimDraggingView:(UIView*)draggingSubview;
+
+// Multi-item drags. When the user drags a selection (see
+// MCKDragDropServer.selectedDraggableViews), each step above is reported once
+// for all the dragged views, in the order they were stacked in the donor.
+// A delegate which does not implement one of these gets the single-view
+// method once per view instead, except for willBeginDraggingView:, which is
+// asked only about the view under the finger.
+
+/** Tells delegate the user will remove draggingSubviews from the donor. @return payload, as above */
+-(id<NSObject>) donorView:(UIView*)donor willBeginDraggingViews:(NSArray*)draggingSubviews;
+-(void) donorView:(UIView*)donor didBeginDraggingViews:(NSArray*)draggingSubviews;
+-(void) donorView:(UIView*)donor willDonateDraggingViews:(NSArray*)draggingSubviews;
+-(void) donorView:(UIView*)donor didDonateDraggingViews:(NSArray*)draggingSubviews;
+/** Tells donor draggingSubviews are all back in its VH, after a rejected drop */
+-(void) donorView:(UIView*)donor didReclaimDraggingViews:(NSArray*)draggingSubviews;
 @end
 
 
@@ -83,6 +102,10 @@
  
  If this optional method is not implemented, the DnD framework defaults to 
  assuming the absorber CAN accept the view.
+
+ If the donor promised the payload, payload is the built payload, and the
+ drop waits on the main thread for it to be built. To decide without
+ waiting, implement absorberView:canAbsorbPayload: instead.
  
  */
 -(BOOL)       absorberView:(UIView*)absorber
@@ -100,8 +123,90 @@
  Absorber should perform any work necessary after having been given the dropped
  view. For example, the absorber could actually integrate the draggingSubview object
  into its own view hierarchy or it could remove it and replace it with a lookalike.
+
+ If the donor promised the payload, payload is the built payload, not the
+ MCKPayloadPromise, as for absorberView:canAbsorbDraggingView:payload:. The
+ hover callbacks receive the promise.
  */
 -(void)     absorberView:(UIView*)absorber
    didAbsorbDraggingView:(UIView*)draggingSubview
                  payload:(id<NSObject>)payload;
+
+/**
+ Reports if an absorber will accept drops of payload, whatever the view.
+
+ Implement this instead of absorberView:canAbsorbDraggingView:payload: when
+ the decision is slow, for instance because it queries a database. It is
+ called on a background queue, so it must not touch UIKit, and it is called
+ ahead of the drop, while the dragged view hovers over the absorber (with
+ hover tracking on). The drop then uses the answer, waiting for it at most
+ MCKDragDropServer.acceptanceDeadline. Answers are cached per absorber and
+ payload, until the drag ends or the absorber absorbs a drop.
+
+ If the donor promised the payload, payload is the built payload.
+ */
+-(BOOL) absorberView:(UIView*)absorber canAbsorbPayload:(id<NSObject>)payload;
+
+// Ordered absorbers, see -[MCKDragDropServer setSlotAxis:forAbsorberView:].
+// The index is where the dragged views go among the absorber's subviews, so
+// that the absorber can preview, and then make, room at that position only.
+
+/**
+ Tells delegate draggingSubview moved over the absorber, and would be inserted
+ at index if dropped now. Sent along with draggingViewDidHover:, with hover
+ tracking on.
+ */
+-(void)     absorberView:(UIView*)absorber
+            draggingView:(UIView*)draggingSubview
+         didHoverAtIndex:(NSUInteger)index
+                 payload:(id<NSObject>)payload;
+
+/**
+ Tells delegate draggingSubviews have been inserted into the absorber's
+ subviews from index on. Sent along with the didAbsorb methods, with a single
+ view for a single-view drag.
+ */
+-(void)     absorberView:(UIView*)absorber
+  didAbsorbDraggingViews:(NSArray*)draggingSubviews
+                 atIndex:(NSUInteger)index
+                 payload:(id<NSObject>)payload;
+
+// Multi-item drops. The views are accepted or rejected together. If these
+// are not implemented, canAbsorbDraggingView:payload: is asked about the view
+// under the finger only, and didAbsorbDraggingView:payload: is sent per view.
+
+/** Reports if an absorber will accept the drop of all of draggingSubviews */
+-(BOOL)       absorberView:(UIView*)absorber
+    canAbsorbDraggingViews:(NSArray*)draggingSubviews
+                   payload:(id<NSObject>)payload;
+
+/** Tells delegate draggingSubviews have all been inserted into absorber's VH, in one batch */
+-(void)     absorberView:(UIView*)absorber
+  didAbsorbDraggingViews:(NSArray*)draggingSubviews
+                 payload:(id<NSObject>)payload;
+
+// Hover tracking. Sent only if MCKDragDropServer.hoverTrackingEnabled is YES.
+// The candidate absorber under the dragged view is found with the same rules
+// as the absorber for a drop, so these let an absorber highlight itself as a
+// valid target while the user is still dragging.
+
+/** Tells delegate the center of draggingSubview moved onto the absorber */
+-(void)     absorberView:(UIView*)absorber
+    draggingViewDidEnter:(UIView*)draggingSubview
+                 payload:(id<NSObject>)payload;
+
+/** Tells delegate draggingSubview moved and is still over the absorber */
+-(void)     absorberView:(UIView*)absorber
+    draggingViewDidHover:(UIView*)draggingSubview
+                 payload:(id<NSObject>)payload;
+
+/**
+ Tells delegate draggingSubview left the absorber.
+
+ This is also sent when the drag ends over the absorber, just before
+ absorberView:canAbsorbDraggingView:payload:.
+ */
+-(void)     absorberView:(UIView*)absorber
+     draggingViewDidExit:(UIView*)draggingSubview
+                 payload:(id<NSObject>)payload;
 @end
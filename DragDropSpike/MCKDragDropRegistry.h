@@ -0,0 +1,60 @@
+//
+//  MCKDragDropRegistry.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-06.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "MCKDragDropProtocol.h"
+#import "MCKDragDropCore.h"
+
+/**
+ Table of the roles and delegates registered for views.
+
+ DESIGN NOTES:
+ Views are keyed by address, without being retained. Each view's role bits
+ live in a plain CFDictionary of integers, so testing a view for a role is a
+ single hash lookup which takes no lock and makes no Objective-C runtime call.
+ That is what makes an ancestor walk cheap.
+
+ Delegates, and the views themselves, are held weakly in a separate entry. A
+ view which is deallocated leaves its bits behind under an address that may
+ later be reused. So a hit in the bit table is confirmed once against the
+ entry's weak reference before it is trusted, and dead entries are swept as
+ registrations accumulate.
+ */
+@interface MCKDragDropRegistry : NSObject
+
+/** Incremented on every change to any role or delegate */
+@property (readonly) NSUInteger generation;
+
+-(void) addRole:(MCKDragDropRole)role toView:(UIView*)view;
+/** As addRole:toView: for each view, with a single generation change */
+-(void) addRole:(MCKDragDropRole)role toViews:(NSArray*)views;
+-(void) removeRole:(MCKDragDropRole)role fromView:(UIView*)view;
+-(MCKDragDropRole) rolesOfView:(UIView*)view;
+-(BOOL) view:(UIView*)view hasRole:(MCKDragDropRole)role;
+
+-(void) setDonorDelegate:(NSObject<MCKDragDropDonorDelegate>*)delegate forView:(UIView*)view;
+-(NSObject<MCKDragDropDonorDelegate>*) donorDelegateForView:(UIView*)view;
+
+-(void) setAbsorberDelegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate forView:(UIView*)view;
+-(NSObject<MCKDragDropAbsorberDelegate>*) absorberDelegateForView:(UIView*)view;
+
+/**
+ The registered view at address, or nil if none is registered there or it has
+ been deallocated. Safe to call with the address of a dead view.
+ */
+-(UIView*) liveViewAtAddress:(const void*)address;
+
+/**
+ Returns the closest strict ancestor of view having role, or nil.
+
+ This is a single walk up the superview chain.
+ */
+-(UIView*) closestAncestorOfView:(UIView*)view withRole:(MCKDragDropRole)role;
+
+@end
@@ -0,0 +1,210 @@
+//
+//  MCKDragDropRegistry.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-06.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKDragDropRegistry.h"
+
+/*
+ Weak references to a registered view and its delegates.
+ */
+@interface MCKDragDropRegistryEntry : NSObject
+@property (weak) UIView * view;
+@property (weak) NSObject<MCKDragDropDonorDelegate> * donorDelegate;
+@property (weak) NSObject<MCKDragDropAbsorberDelegate> * absorberDelegate;
+@end
+
+@implementation MCKDragDropRegistryEntry
+@synthesize view, donorDelegate, absorberDelegate;
+@end
+
+
+@interface MCKDragDropRegistry ()
+{
+  // key = view address, value = MCKDragDropRole bits
+  CFMutableDictionaryRef roleBits;
+  // key = view address, value = MCKDragDropRegistryEntry
+  CFMutableDictionaryRef entries;
+  // registrations since dead entries were last swept
+  NSUInteger registrationsSinceSweep;
+}
+@property (readwrite) NSUInteger generation;
+@end
+
+@implementation MCKDragDropRegistry
+@synthesize generation;
+
+-(id) init
+{
+  self = [super init];
+  if ( self ) {
+    roleBits = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, NULL);
+    entries = CFDictionaryCreateMutable(kCFAllocatorDefault, 0, NULL, &kCFTypeDictionaryValueCallBacks);
+  }
+  return self;
+}
+
+-(void) dealloc
+{
+  CFRelease(roleBits);
+  CFRelease(entries);
+}
+
+#pragma mark roles
+
+-(void) addRole:(MCKDragDropRole)role toView:(UIView*)view
+{
+  if ( !view )
+    return;
+  [self setRoleBits:role ofView:view];
+  self.generation++;
+
+  if ( ++registrationsSinceSweep > (NSUInteger)CFDictionaryGetCount(entries) )
+    [self removeDeallocatedEntries];
+}
+
+-(void) addRole:(MCKDragDropRole)role toViews:(NSArray*)views
+{
+  for (UIView * view in views)
+    [self setRoleBits:role ofView:view];
+  self.generation++;
+
+  registrationsSinceSweep += [views count];
+  if ( registrationsSinceSweep > (NSUInteger)CFDictionaryGetCount(entries) )
+    [self removeDeallocatedEntries];
+}
+
+-(void) setRoleBits:(MCKDragDropRole)role ofView:(UIView*)view
+{
+  MCKDragDropRegistryEntry * entry = [self liveEntryForView:view create:YES];
+  uintptr_t bits = (uintptr_t)CFDictionaryGetValue(roleBits, (__bridge const void*)view);
+  CFDictionarySetValue(roleBits, (__bridge const void*)view, (const void*)(bits | role));
+  entry.view = view;
+}
+
+-(void) removeRole:(MCKDragDropRole)role fromView:(UIView*)view
+{
+  if ( !view )
+    return;
+  uintptr_t bits = (uintptr_t)CFDictionaryGetValue(roleBits, (__bridge const void*)view) & ~(uintptr_t)role;
+  if ( bits )
+    CFDictionarySetValue(roleBits, (__bridge const void*)view, (const void*)bits);
+  else
+    [self removeEntryForAddress:(__bridge const void*)view];
+  self.generation++;
+}
+
+-(MCKDragDropRole) rolesOfView:(UIView*)view
+{
+  if ( !view )
+    return MCKDragDropRoleNone;
+  uintptr_t bits = (uintptr_t)CFDictionaryGetValue(roleBits, (__bridge const void*)view);
+  // most views have no roles, and are answered without touching an entry
+  if ( !bits || ![self liveEntryForView:view create:NO] )
+    return MCKDragDropRoleNone;
+  return (MCKDragDropRole)bits;
+}
+
+-(BOOL) view:(UIView*)view hasRole:(MCKDragDropRole)role
+{
+  return ([self rolesOfView:view] & role) != 0;
+}
+
+-(UIView*) closestAncestorOfView:(UIView*)view withRole:(MCKDragDropRole)role
+{
+  for (UIView * ancestor = view.superview; ancestor; ancestor = ancestor.superview) {
+    uintptr_t bits = (uintptr_t)CFDictionaryGetValue(roleBits, (__bridge const void*)ancestor);
+    // confirm a hit only once, since the address may belong to a dead view
+    if ( (bits & role) && [self liveEntryForView:ancestor create:NO] )
+      return ancestor;
+  }
+  return nil;
+}
+
+#pragma mark delegates
+
+-(void) setDonorDelegate:(NSObject<MCKDragDropDonorDelegate>*)delegate forView:(UIView*)view
+{
+  if ( !view )
+    return;
+  [self liveEntryForView:view create:YES].donorDelegate = delegate;
+  self.generation++;
+}
+
+-(NSObject<MCKDragDropDonorDelegate>*) donorDelegateForView:(UIView*)view
+{
+  if ( !view )
+    return nil;
+  return [self liveEntryForView:view create:NO].donorDelegate;
+}
+
+-(void) setAbsorberDelegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate forView:(UIView*)view
+{
+  if ( !view )
+    return;
+  [self liveEntryForView:view create:YES].absorberDelegate = delegate;
+  self.generation++;
+}
+
+-(NSObject<MCKDragDropAbsorberDelegate>*) absorberDelegateForView:(UIView*)view
+{
+  if ( !view )
+    return nil;
+  return [self liveEntryForView:view create:NO].absorberDelegate;
+}
+
+-(UIView*) liveViewAtAddress:(const void*)address
+{
+  if ( !address )
+    return nil;
+  MCKDragDropRegistryEntry * entry = (__bridge MCKDragDropRegistryEntry*)CFDictionaryGetValue(entries, address);
+  return entry.view;
+}
+
+#pragma mark housekeeping
+
+/*
+ Returns the entry for view, discarding any entry left at this address by a
+ deallocated view.
+ */
+-(MCKDragDropRegistryEntry*) liveEntryForView:(UIView*)view create:(BOOL)create
+{
+  const void * key = (__bridge const void*)view;
+  MCKDragDropRegistryEntry * entry = (__bridge MCKDragDropRegistryEntry*)CFDictionaryGetValue(entries, key);
+  if ( entry && entry.view != view ) {
+    [self removeEntryForAddress:key];
+    entry = nil;
+  }
+  if ( !entry && create ) {
+    entry = [[MCKDragDropRegistryEntry alloc] init];
+    entry.view = view;
+    CFDictionarySetValue(entries, key, (__bridge const void*)entry);
+  }
+  return entry;
+}
+
+-(void) removeEntryForAddress:(const void*)key
+{
+  CFDictionaryRemoveValue(entries, key);
+  CFDictionaryRemoveValue(roleBits, key);
+}
+
+-(void) removeDeallocatedEntries
+{
+  registrationsSinceSweep = 0;
+
+  CFIndex count = CFDictionaryGetCount(entries);
+  const void ** keys = malloc(sizeof(void*) * count);
+  const void ** values = malloc(sizeof(void*) * count);
+  CFDictionaryGetKeysAndValues(entries, keys, values);
+  for (CFIndex i = 0; i < count; ++i)
+    if ( ((__bridge MCKDragDropRegistryEntry*)values[i]).view == nil )
+      [self removeEntryForAddress:keys[i]];
+  free(keys);
+  free(values);
+}
+
+@end
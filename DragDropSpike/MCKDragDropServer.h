@@ -8,6 +8,9 @@
 
 #import <Foundation/Foundation.h>
 #import "MCKDragDropProtocol.h"
+#import "MCKSlotIndex.h"
+#import "MCKPickupEffect.h"
+#import "MCKFrameMeter.h"
 
 /** This class registers views to participate in Drag and Drop (DnD).
  
@@ -37,13 +40,202 @@
  ancestor to the dragged view. Absorbers can be nested. The candidate absorber 
  for a given drop is the absorber that is the hit test view at the drop location.
  
- *Warning:* It is an error to assign a donor or an absorber a nil delegate (FIXME)
+ A donor or an absorber may be registered with a nil delegate. It then plays its
+ role with the default behaviour and receives no callbacks.
 
 */
 @interface MCKDragDropServer : NSObject
 
 +(MCKDragDropServer*)sharedServer;
 
+/**
+ Report the candidate absorber on every move of a drag. Default: NO.
+
+ When on, absorber delegates receive the enter/hover/exit callbacks of
+ MCKDragDropAbsorberDelegate. A candidate is cached with the region of the
+ window where it remains valid, so a full resolution only happens when the
+ dragged view crosses an absorber boundary.
+ */
+@property (assign) BOOL hoverTrackingEnabled;
+
+/** Number of absorber lookups which needed a full resolution */
+@property (readonly) NSUInteger absorberResolutionCount;
+
+/** Number of absorber lookups answered from the cached region */
+@property (readonly) NSUInteger absorberCacheHitCount;
+
+-(void) resetAbsorberResolutionCounters;
+
+/**
+ Longest wait at a drop for the answer of -absorberView:canAbsorbPayload:,
+ in seconds. Default: 0.016, about one frame.
+
+ The answer is usually ready: it is worked out in the background while the
+ drag hovers over the absorber. If it is not ready in time, the drop is
+ decided by acceptsDropsPastDeadline.
+ */
+@property (assign) NSTimeInterval acceptanceDeadline;
+
+/** Whether a drop is accepted when its answer misses acceptanceDeadline. Default: NO. */
+@property (assign) BOOL acceptsDropsPastDeadline;
+
+/**
+ Number of DnD sessions in progress, counting views still sliding back to
+ their donor. Several people can drag at once, up to a fixed number of
+ sessions; a pickup beyond that is refused.
+ */
+@property (readonly) NSUInteger activeSessionCount;
+
+/**
+ Start recording DnD sessions into a trace, discarding any trace in progress.
+
+ The trace holds the pan events, the donor and absorber decisions and the
+ view hierarchy changes of every session. See MCKSessionTrace.h for the
+ format, and MCKTraceReplay.h to replay it off device.
+ */
+-(void) startRecordingTrace;
+
+/** Stop recording, and return the trace, or nil if none was being recorded */
+-(NSData*) stopRecordingTrace;
+
+/**
+ Time each phase of DnD sessions, and each delegate callback. Default: NO.
+
+ Durations are counted in histograms, see MCKSessionMetrics.h. When off, the
+ sessions only test a pointer at each step they would time. Turning it off
+ discards what was collected.
+ */
+@property (assign) BOOL collectsPerformanceMetrics;
+
+/**
+ What has been collected since collection started, or the last reset, or nil
+ if collectsPerformanceMetrics is off. Times are in milliseconds.
+
+ - "phases": for each phase or callback with at least one sample, keyed by
+   its MCKMetricName, a dictionary of "count", "mean", "p50", "p90", "p99"
+   and "max".
+ - "delegates": an array of the callbacks to each donor and absorber view,
+   slowest first by "max", each a dictionary of "callback", "view" (the
+   view's class), "delegate" (the delegate's class and address, or "none" if
+   the view or its delegate is gone), "count", "mean" and "max".
+ - "untracked": callbacks left out of "delegates" because too many views
+   were called.
+
+ Made of property list objects only, so it can be saved as is.
+ */
+-(NSDictionary*) performanceMetrics;
+
+-(void) resetPerformanceMetrics;
+
+/**
+ Write performanceMetrics, as JSON, to the file at path every interval
+ seconds, replacing it each time. A nil path stops the export.
+
+ For collecting numbers from a device during a test session. Writes happen
+ on the main thread, and are skipped while collectsPerformanceMetrics is off.
+ */
+-(void) exportPerformanceMetricsToPath:(NSString*)path interval:(NSTimeInterval)interval;
+
+/**
+ Give each donor a single recognizer for all its draggable descendants,
+ instead of one recognizer per draggable view. Default: NO.
+
+ For scenes with thousands of draggables. The touched draggable is found when
+ the gesture begins, by walking up from the view UIKit hit-tested. Only one
+ view at a time can be dragged out of a given donor.
+
+ Set it before registering any view.
+ */
+@property (assign) BOOL donorsShareRecognizers;
+
+/**
+ Move dragged views once per display refresh, rather than on every touch
+ event. Default: NO.
+
+ The translations of the touch events received between two refreshes are
+ added up, and applied in one move when the display is about to refresh,
+ so hover callbacks also come at most once per frame. See MCKMovePipeline.h.
+
+ Taken into account when a drag begins.
+ */
+@property (assign) BOOL coalescesMoves;
+
+/**
+ How far ahead of the finger's last reported position to place a dragged
+ view, in seconds, extrapolating from the finger's recent velocity. Default:
+ 0, no prediction.
+
+ Only with coalescesMoves. About 0.03 makes up for the time from a touch to
+ the display of its frame. A drop always lands under the finger itself.
+ */
+@property (assign) NSTimeInterval movePrediction;
+
+/**
+ Drag proxies of the views, leaving the views in place until the drop.
+ Default: NO.
+
+ A proxy is a snapshot of the view, taken at pickup, which floats in an
+ overlay at the top of the root view controller's view. The dragged view
+ stays in its superview, hidden, and keeps tracking the touch. The view
+ hierarchy then changes only when a drop is accepted, and the view moves
+ into the absorber; after a rejected drop, the proxy slides back over the
+ view and the view is shown again. Siblings of the view can come and go
+ during the drag without changing where it ends up.
+
+ Taken into account when a drag begins.
+ */
+@property (assign) BOOL usesDragProxies;
+
+/**
+ The look of picked-up views. Default: MCKPickupEffect's defaultEffect.
+
+ Applied to the dragged views, or to their proxies, at pickup. Its strategy
+ decides what moving a picked-up view costs: see MCKPickupEffectStrategy.
+ */
+@property (copy) MCKPickupEffect * pickupEffect;
+
+/**
+ Measure frames during drags. Default: NO.
+
+ Frames are measured from the first pickup until no DnD session is left, by
+ the frame meter of the strategy of the pickup effect at that first pickup.
+ */
+@property (assign) BOOL measuresFrames;
+
+/** The frame meter of drags with a pickup effect drawn with strategy */
+-(MCKFrameMeter*) frameMeterForPickupEffectStrategy:(MCKPickupEffectStrategy)strategy;
+
+/**
+ Count the layout passes of each DnD session. Default: NO.
+
+ A layout pass is a call to -[UIView layoutSubviews], anywhere in the app,
+ from the pickup until the views have settled, including the layout of the
+ last hierarchy change. Views whose class overrides layoutSubviews without
+ calling super are not counted, and drags which overlap count each other's
+ layout. Sessions with and without drag proxies are counted apart.
+ */
+@property (assign) BOOL countsLayoutPasses;
+
+@property (readonly) NSUInteger reparentingSessionCount;
+@property (readonly) NSUInteger reparentingLayoutPassCount;
+@property (readonly) NSUInteger proxySessionCount;
+@property (readonly) NSUInteger proxyLayoutPassCount;
+
+-(void) resetLayoutPassCounters;
+
+/**
+ Draggable views which move together. Default: nil.
+
+ A drag starting on one of these views picks up, along with it, every other
+ one with the same donor which is not already being dragged. They float as
+ one group, are reparented in a single batch at pickup and drop, and slide
+ back in a single animation if the drop is rejected. Delegates receive the
+ array callbacks of MCKDragDropProtocol.h.
+
+ A drag starting on any other view moves that view alone.
+ */
+@property (copy) NSArray * selectedDraggableViews;
+
 /**
  Make view draggable
 
@@ -53,26 +245,117 @@
  */
 -(void) registerDraggableView:(UIView*)draggableView;
 
+/** Make every view in draggableViews draggable, as registerDraggableView: */
+-(void) registerDraggableViews:(NSArray*)draggableViews;
+
 /**
  Make view able to donate a descendant view via a drag operation.
 
  @param view view that will become a designated donor
- @param delegate object to receive callbacks during the DnD session. Must not be nil.
+ @param delegate object to receive callbacks during the DnD session, or nil.
 
  Views hold only weak references to their delegates.
  */
 -(void) registerDonorView:(UIView*)view delegate:(NSObject<MCKDragDropDonorDelegate>*)delegate;
 
+/**
+ Stop a view from donating its descendants.
+
+ @param view view previously registered as a donor
+ */
+-(void) unregisterDonorView:(UIView*)view;
+
 /**
  Make view able to absorb a dropped view into its view hierarchy.
 
  @param view view that will become a designated absorber
- @param delegate object to receive callbacks during the DnD session. Must not be nil.
+ @param delegate object to receive callbacks during the DnD session, or nil.
 
  Views hold only weak references to their delegates.
  */
 -(void) registerAbsorberView:(UIView*)view delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate;
 
+/**
+ Stop a view from absorbing drops.
+
+ @param view view previously registered as an absorber
+ */
+-(void) unregisterAbsorberView:(UIView*)view;
+
+/**
+ Keep an absorber's subviews in order along axis.
+
+ @param axis how the absorber lays out its subviews: in a column, a row, or a
+        grid filled row by row, in subview order.
+ @param view a registered absorber view
+
+ A view dropped into the absorber is then inserted among its subviews at the
+ position under the drop point, rather than in front of them all. Its delegate
+ learns that position through the atIndex: callbacks of
+ MCKDragDropAbsorberDelegate, during hover and at the drop.
+
+ The server finds the position by binary search over the frames of the
+ subviews. It keeps those frames in step with the views it inserts and
+ removes, assuming the absorber reflows its subviews to make, or close, room.
+ If the absorber lays out differently, or changes its subviews itself, call
+ absorberViewDidLayoutSlots: afterwards.
+ */
+-(void) setSlotAxis:(MCKSlotAxis)axis forAbsorberView:(UIView*)view;
+
+/** Tells the server the subviews of an ordered absorber changed, or moved */
+-(void) absorberViewDidLayoutSlots:(UIView*)view;
+
+/**
+ Tells the server a view changed position on screen, and the absorbers in it
+ with it.
+
+ @param view a registered absorber view, or a view containing absorbers
+
+ Absorber frames are cached in window coordinates. The server refreshes them
+ for the views it moves itself, in drops and reclaims, and for the subviews
+ of ordered absorbers given to absorberViewDidLayoutSlots:. Call this after
+ anything else moves an absorber or one of its superviews, for instance a
+ container which scrolls or animates. Until then, drops over the absorber's
+ new position can miss it.
+ */
+-(void) absorberViewDidMove:(UIView*)view;
+
+/**
+ Tells the server any absorber may have moved, for instance after a rotation.
+ All absorber frames are refreshed before the next drop.
+ */
+-(void) absorberViewsDidMove;
+
+/**
+ Drag view without a touch, as a pan gesture starting on it would. For
+ benchmarks and tests which drive whole DnD sessions through the server.
+
+ @return a token for the drag, to pass to the methods below, or nil if view
+ cannot be picked up, for instance because it has no donor or its donor's
+ delegate refuses.
+
+ A scripted drag goes through the same donor and absorber lookups, delegate
+ callbacks and pickup effect as a gesture, and takes a session from the same
+ pool. Its moves are applied at once, even with coalescesMoves.
+ */
+-(id) beginScriptedDragOfView:(UIView*)view;
+
+/** What follows the finger in a scripted drag: the dragged view, or its proxy. nil once dropped. */
+-(UIView*) leadViewOfScriptedDrag:(id)drag;
+
+/** Move the views of a scripted drag, in the coordinates of the drag layer: see MCKSessionMove */
+-(void) moveScriptedDrag:(id)drag byTranslation:(CGPoint)translation;
+
+/**
+ Drop a scripted drag where it is. After a rejection, the views slide back
+ to their donor as after a gesture, and activeSessionCount counts the drag
+ until they are back.
+ */
+-(MCKDropOutcome) dropScriptedDrag:(id)drag;
+
+/** The roles view is registered for, e.g. for DCIntrospect's view hierarchy snapshots */
+-(MCKDragDropRole) rolesOfView:(UIView*)view;
+
 //
 // TODO: restrict visibility to MCKPanGestureRecognizer
 //
@@ -80,4 +363,8 @@
 /** Lookup delegate of donor */
 -(NSObject<MCKDragDropDonorDelegate>*) delegateForDonorView:(UIView*)view;
 -(UIView*) donorViewOfView:(UIView*)pickedUpView;
+/** YES if view has a donor, and the donor's delegate does not veto the drag */
+-(BOOL) canBeginDraggingView:(UIView*)view;
+/** The draggable view a gesture starting on touchedView drags, for donorView's shared recognizer */
+-(UIView*) draggableViewOfTouchedView:(UIView*)touchedView inDonorView:(UIView*)donorView;
 @end
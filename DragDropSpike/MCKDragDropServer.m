@@ -12,27 +12,165 @@
 
 #import "MCKDragDropServer.h"
 #import "MCKPanGestureRecognizer.h"
+#import "MCKAbsorberIndex.h"
+#import "MCKDragDropRegistry.h"
+#import "MCKSessionTrace.h"
+#import "MCKPayloadPromise.h"
+#import "MCKAcceptanceCache.h"
+#import "MCKPickupEffect.h"
+#import "MCKMovePipeline.h"
+#import "MCKSessionMetrics.h"
 
 #define MCK_RECLAIM_ANIMATION_DURATION 0.3f
+// most drags that can run at once
+#define MCK_MAX_DRAG_SESSIONS 16
 
-// helpers for moving views in the view hierarchy but not onscreen
-@implementation UIView (MCKmotionless)
--(void)motionlessAddSubview:(UIView*)view
+// traces a view's frame without building any string, see PSLogTrace.h
+#define MCK_TRACE_FRAME(label, view) do { \
+    CGRect mckTraceFrame = (view).frame; \
+    PSLogTrace(label " = {{%g, %g}, {%g, %g}}", mckTraceFrame.origin.x, mckTraceFrame.origin.y, \
+               mckTraceFrame.size.width, mckTraceFrame.size.height); \
+  } while(0)
+
+/*
+ The slots of an absorber which keeps its subviews in order.
+ */
+@interface MCKOrderedAbsorber : NSObject
 {
-  CGRect newFrame = [view.superview convertRect:view.frame toView:self];
-  [self addSubview:view];
-  view.frame = newFrame;
+@public
+  MCKSlotIndex slots;
 }
+@property (weak) UIView * view;
+// the slots must be read from the subviews again before the next query
+@property (assign) BOOL needsLayout;
+-(id) initWithView:(UIView*)view axis:(MCKSlotAxis)axis;
+@end
 
--(void)motionlessInsertSubview:(UIView*)view atIndex:(NSUInteger)index
+@implementation MCKOrderedAbsorber
+@synthesize view, needsLayout;
+
+-(id) initWithView:(UIView*)aView axis:(MCKSlotAxis)axis
 {
-  CGRect newFrame = [view.superview convertRect:view.frame toView:self];
-  [self insertSubview:view atIndex:index];
-  view.frame = newFrame;
+  self = [super init];
+  if ( self ) {
+    view = aView;
+    MCKSlotIndexInit(&slots, axis);
+    needsLayout = YES;
+  }
+  return self;
 }
+
+-(void) dealloc
+{
+  MCKSlotIndexDispose(&slots);
+}
+
 @end
 
-@implementation MCKDragDropServer
+
+/*
+ What proxies float in: a transparent view at the top of the root view
+ controller's view, which lets touches through.
+ */
+@interface MCKDragOverlayView : UIView
+@end
+
+@implementation MCKDragOverlayView
+@end
+
+/*
+ Calls to -[UIView layoutSubviews], counted once the method has been swapped
+ for the one below. See countsLayoutPasses.
+ */
+static NSUInteger MCKLayoutPassCount = 0;
+static BOOL MCKLayoutPassCounting = NO;
+
+@interface UIView (MCKLayoutPassCounting)
+-(void) mck_countedLayoutSubviews;
+@end
+
+@implementation UIView (MCKLayoutPassCounting)
+
+// once swapped, this is -layoutSubviews, and the call below is the original
+-(void) mck_countedLayoutSubviews
+{
+  if ( MCKLayoutPassCounting )
+    MCKLayoutPassCount++;
+  [self mck_countedLayoutSubviews];
+}
+
+@end
+
+
+@interface MCKDragDropServer ()
+// window-space index of registered absorbers, used to resolve drops
+@property (strong) MCKAbsorberIndex * absorberIndex;
+// roles and delegates of registered views
+@property (strong) MCKDragDropRegistry * registry;
+// answers of absorbers which decide off the main thread
+@property (strong) MCKAcceptanceCache * acceptanceCache;
+// key = NSValue of an absorber view, value = its MCKOrderedAbsorber
+@property (strong) NSMutableDictionary * orderedAbsorbers;
+// one MCKFrameMeter per MCKPickupEffectStrategy
+@property (strong) NSArray * frameMeters;
+// fires before each display refresh while there are coalesced drags
+@property (strong) CADisplayLink * moveLink;
+// recognizers of scripted drags, until their session ends
+@property (strong) NSMutableSet * scriptedRecognizers;
+// writes the performance metrics to metricsExportPath
+@property (strong) NSTimer * metricsExportTimer;
+@property (copy) NSString * metricsExportPath;
+@property (readwrite) NSUInteger absorberResolutionCount;
+@property (readwrite) NSUInteger absorberCacheHitCount;
+@property (readwrite) NSUInteger reparentingSessionCount;
+@property (readwrite) NSUInteger reparentingLayoutPassCount;
+@property (readwrite) NSUInteger proxySessionCount;
+@property (readwrite) NSUInteger proxyLayoutPassCount;
+
+-(UIView*) absorberUnderView:(UIView*)dragView
+                excludingView:(UIView*)floatView
+                   recognizer:(MCKPanGestureRecognizer*)recognizer;
+-(NSObject<MCKDragDropAbsorberDelegate>*) delegateForAbsorberView:(UIView*)view;
++(void) cancelPayloadPromise:(id<NSObject>)payload;
+-(MCKOrderedAbsorber*) orderedAbsorberOfView:(UIView*)view;
+-(void) reindexAbsorbersInView:(UIView*)view;
+-(void) sessionDidEnd:(MCKSession*)session;
+-(void) flushMovesOfSession:(MCKSession*)session;
+-(void) applyPickupEffectToSession:(MCKSession*)session;
+-(void) undoPickupEffectOfSession:(MCKSession*)session;
+-(void) pickUpViewOfRecognizer:(MCKPanGestureRecognizer*)recognizer coalescingMoves:(BOOL)coalesces;
+-(void) moveSessionOfRecognizer:(MCKPanGestureRecognizer*)recognizer byTranslation:(CGPoint)translation;
+-(MCKDropOutcome) dropSessionOfRecognizer:(MCKPanGestureRecognizer*)recognizer;
+@end
+
+static void MCKDragDropServerHostInit(MCKDragDropHost * host, MCKDragDropServer * server);
+static NSArray * MCKUIKitFloatingViewsOfSession(const MCKSession * session);
+
+@implementation MCKDragDropServer {
+  // the UIKit side of the C core: its handles are UIViews
+  MCKDragDropHost host;
+  // sessions of the drags in progress, and of the views being reclaimed
+  MCKSession sessionStorage[MCK_MAX_DRAG_SESSIONS];
+  MCKSessionPool sessionPool;
+  // MCKLayoutPassCount at the pickup of each session, or NSNotFound if it was not counting
+  NSUInteger layoutPassCountAtPickup[MCK_MAX_DRAG_SESSIONS];
+  // the moves of each session, if it coalesces them
+  MCKMovePipeline movePipelines[MCK_MAX_DRAG_SESSIONS];
+  BOOL coalescedSessions[MCK_MAX_DRAG_SESSIONS];
+  // how to undo the pickup effect of each session, until its views settle.
+  // Per session, as a shared recognizer starts new sessions while its
+  // previous ones are still reclaiming.
+  MCKPickupEffectUndo * pickupEffectUndos[MCK_MAX_DRAG_SESSIONS];
+}
+@synthesize absorberIndex, registry, acceptanceCache, orderedAbsorbers, frameMeters, moveLink, scriptedRecognizers;
+@synthesize metricsExportTimer, metricsExportPath;
+@synthesize acceptanceDeadline, acceptsDropsPastDeadline;
+@synthesize absorberResolutionCount, absorberCacheHitCount;
+@synthesize reparentingSessionCount, reparentingLayoutPassCount, proxySessionCount, proxyLayoutPassCount;
+@synthesize donorsShareRecognizers;
+@synthesize selectedDraggableViews;
+@synthesize pickupEffect, measuresFrames;
+@synthesize coalescesMoves, movePrediction;
 
 #pragma mark - Singleton boilerplate
 
@@ -47,161 +185,368 @@ static MCKDragDropServer* sharedServer = nil;
   return sharedServer;
 }
 
+-(id) init
+{
+  self = [super init];
+  if ( self ) {
+    absorberIndex = [[MCKAbsorberIndex alloc] init];
+    registry = [[MCKDragDropRegistry alloc] init];
+    acceptanceCache = [[MCKAcceptanceCache alloc] init];
+    orderedAbsorbers = [NSMutableDictionary dictionary];
+    scriptedRecognizers = [NSMutableSet set];
+    pickupEffect = [MCKPickupEffect defaultEffect];
+    frameMeters = [NSArray arrayWithObjects:[[MCKFrameMeter alloc] init], [[MCKFrameMeter alloc] init],
+                   [[MCKFrameMeter alloc] init], nil];
+    acceptanceDeadline = 0.016;
+    MCKDragDropServerHostInit(&host, self);
+    MCKSessionPoolInit(&sessionPool, &host, sessionStorage, MCK_MAX_DRAG_SESSIONS);
+    // the same clock as CADisplayLink timestamps
+    for (size_t i = 0; i < MCK_MAX_DRAG_SESSIONS; ++i)
+      MCKMovePipelineInit(&movePipelines[i], MCKClockMonotonic(), 0);
+  }
+  return self;
+}
+
+-(BOOL) hoverTrackingEnabled
+{
+  return host.hover_tracking_enabled;
+}
+
+-(void) setHoverTrackingEnabled:(BOOL)enabled
+{
+  host.hover_tracking_enabled = enabled;
+}
+
+-(BOOL) usesDragProxies
+{
+  return host.drag_proxies;
+}
+
+-(void) setUsesDragProxies:(BOOL)uses
+{
+  host.drag_proxies = uses;
+}
+
+-(NSUInteger) activeSessionCount
+{
+  return sessionPool.active_count;
+}
+
+-(MCKFrameMeter*) frameMeterForPickupEffectStrategy:(MCKPickupEffectStrategy)strategy
+{
+  return [self.frameMeters objectAtIndex:strategy];
+}
+
+#pragma mark Layout pass counting
+
+-(BOOL) countsLayoutPasses
+{
+  return MCKLayoutPassCounting;
+}
+
+-(void) setCountsLayoutPasses:(BOOL)counts
+{
+  static dispatch_once_t swapped;
+  if ( counts )
+    dispatch_once(&swapped, ^{
+      method_exchangeImplementations(class_getInstanceMethod([UIView class], @selector(layoutSubviews)),
+                                     class_getInstanceMethod([UIView class], @selector(mck_countedLayoutSubviews)));
+    });
+  MCKLayoutPassCounting = counts;
+}
+
+-(void) resetLayoutPassCounters
+{
+  self.reparentingSessionCount = 0;
+  self.reparentingLayoutPassCount = 0;
+  self.proxySessionCount = 0;
+  self.proxyLayoutPassCount = 0;
+}
+
+/*
+ The layout of a session's last hierarchy changes runs when the current
+ transaction is committed, at the end of this pass of the run loop, so its
+ count is taken from a timer, which fires on a later pass.
+ */
+-(void) sessionDidEnd:(MCKSession*)session
+{
+  // the pool still counts the session
+  if ( sessionPool.active_count == 1 )
+    [self.frameMeters makeObjectsPerformSelector:@selector(stop)];
+  // nothing uses the recognizer past this point
+  [self.scriptedRecognizers removeObject:(__bridge id)session->user_data];
+  // the views have settled, along with any absorbers inside them
+  for (size_t i = 0; i < session->item_count; ++i)
+    [self reindexAbsorbersInView:(__bridge UIView*)session->items[i].view];
+
+  NSUInteger atPickup = layoutPassCountAtPickup[session - sessionStorage];
+  if ( atPickup == NSNotFound || !MCKLayoutPassCounting )
+    return;
+  NSArray * counts = [NSArray arrayWithObjects:[NSNumber numberWithUnsignedInteger:atPickup],
+                      [NSNumber numberWithBool:session->proxied],
+                      [NSNumber numberWithUnsignedInteger:session->reparent_count], nil];
+  [self performSelector:@selector(countLayoutPassesOfEndedSession:) withObject:counts afterDelay:0];
+}
+
+-(void) countLayoutPassesOfEndedSession:(NSArray*)counts
+{
+  NSUInteger passes = MCKLayoutPassCount - [[counts objectAtIndex:0] unsignedIntegerValue];
+  BOOL proxied = [[counts objectAtIndex:1] boolValue];
+  if ( proxied ) {
+    self.proxySessionCount++;
+    self.proxyLayoutPassCount += passes;
+  }
+  else {
+    self.reparentingSessionCount++;
+    self.reparentingLayoutPassCount += passes;
+  }
+  PSLogInfo(@"%@ session: %u layout passes, %u views reparented", proxied ? @"proxy" : @"reparenting",
+            passes, [[counts objectAtIndex:2] unsignedIntegerValue]);
+}
+
 #pragma mark DnD framework internal methods
 
 /*
- Handle a pan gesture from a MCKPanGestureRecognizer
+ Handle a pan gesture from a MCKPanGestureRecognizer.
+
+ The DnD session itself is run by the C core (MCKDragDropCore.h) through the
+ UIKit host below. This only translates gesture states into session events.
  */
 -(void)handlePan:(MCKPanGestureRecognizer*)recognizer
 {
-  UIView * dragView = recognizer.view;
+  UIView * dragView = recognizer.dragView;
+  MCKSession * session = recognizer.session;
+  if ( !session && recognizer.state != UIGestureRecognizerStateBegan )
+    return; // the pickup was refused
   
   if (recognizer.state == UIGestureRecognizerStatePossible) {
-    PSLogInfo(@"1. state = %u. Possible",recognizer.state);
+    PSLogTrace("1. state = %g. Possible", recognizer.state);
   }
   
   // PICKUP EVENT
   else if (recognizer.state == UIGestureRecognizerStateBegan) {
-    PSLogInfo(@"2. state = %u. StateBegan => pickup",recognizer.state);
-    
-    /* 
-     Assert:
-     recgonizer.donorView has already been initialized in the GR itself.
-     
-     Assert:
-     If defined, [MCKDragDropDonor donorView:shouldBeginDraggingView:] has already returned YES.
-
-     */
-   
-    UIView * donorView = recognizer.donorView;
-    NSObject <MCKDragDropDonorDelegate>  * donorDelegate = [self delegateForDonorView:donorView];
-
-    PSLogInfo(@"3. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
-
-    NSObject * payload;
-    // tell donor that view is about to be detached
-    if ([donorDelegate respondsToSelector:@selector(donorView:willBeginDraggingView:)])
-      payload = [donorDelegate donorView:donorView willBeginDraggingView:dragView];
-    
-    // cache payload
-    recognizer.payload = payload;
-   
-    // cache original frame, donor, superview, etc.
-    recognizer.initialViewFrame = dragView.frame;
-    recognizer.donorView = donorView;
-    [MCKDragDropServer saveViewHierarchySlotOfView:dragView toRecognizer:recognizer];
-    
-    PSLogInfo(@"5. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
-
-    // move to top of rootVC's view
-    [dragView.window.rootViewController.view motionlessAddSubview:dragView];
-    
-    PSLogInfo(@"6. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
-
-    // apply pickup effects & cache undo function
-    [MCKDragDropServer applyPickupEffectToView:dragView saveUndoToRecognizer:recognizer];
-    
-    PSLogInfo(@"7. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
-    
-    // tell just-picked-up object's Donor's delegate about the drag
-    if ([donorDelegate respondsToSelector:@selector(donorView:didBeginDraggingView:)])
-      [donorDelegate donorView:donorView didBeginDraggingView:dragView];
-    
-    PSLogInfo(@"8. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
+    PSLogTrace("2. state = %g. StateBegan => pickup", recognizer.state);
+    MCK_TRACE_FRAME("3. dragView.frame", dragView);
+    [self pickUpViewOfRecognizer:recognizer coalescingMoves:self.coalescesMoves];
+    MCK_TRACE_FRAME("4. dragView.frame", dragView);
   }
   
   // MOVE EVENT
   else if (recognizer.state == UIGestureRecognizerStateChanged) {
-    PSLogInfo(@"9. state = %u. StateChanged => movement",recognizer.state);
-    PSLogInfo(@"10. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
-    
-    // move the view to follow the finger's translational motion
-    CGPoint translation = [recognizer translationInView:dragView.superview];
-    dragView.center = CGPointMake(dragView.center.x + translation.x,
-                                  dragView.center.y + translation.y);
-    [recognizer setTranslation:CGPointMake(0, 0) inView:dragView.superview];
-    PSLogInfo(@"11. dragView.frame = %@",NSStringFromCGRect(dragView.frame));
+    PSLogTrace("5. state = %g. StateChanged => movement", recognizer.state);
     
+    // move the view, or its proxy, to follow the finger's translational motion
+    UIView * leadView = (__bridge UIView*)session->lead_view;
+    CGPoint translation = [recognizer translationInView:leadView.superview];
+    [self moveSessionOfRecognizer:recognizer byTranslation:translation];
+    [recognizer setTranslation:CGPointMake(0, 0) inView:leadView.superview];
+    MCK_TRACE_FRAME("6. leadView.frame", leadView);
   }
   
   // DROP EVENT
   else if (recognizer.state == UIGestureRecognizerStateEnded) {
-    PSLogInfo(@"state = %u. StateEnded => drop",recognizer.state);
-    PSLogInfo(@"theView.frame=%@",NSStringFromCGRect(dragView.frame));
-    
-    UIView * absorberView = [self firstAbsorberOfView:dragView];
-    NSObject <MCKDragDropAbsorberDelegate> * absorberDelegate = [self delegateForAbsorberView:absorberView];
-    UIView * donorView = recognizer.donorView;
-    NSObject <MCKDragDropDonorDelegate>  * donorDelegate = [self delegateForDonorView:donorView];
-    id<NSObject> payload = recognizer.payload;
-
-    BOOL dropWasAccepted = NO;
-    if (!absorberView)
-    {
-      dropWasAccepted = NO; // it is required to have an absorber
-      PSLogError(@"no absorberView found for dropped view=%@",dragView);
-    }
-    else {
-      dropWasAccepted = YES; // absorbers default to accepting drops. their delegate can veto it.
-      
-      if (absorberDelegate &&
-          [absorberDelegate respondsToSelector:@selector(absorberView:canAbsorbDraggingView:payload:)]) {
-        dropWasAccepted = [absorberDelegate absorberView:absorberView
-                                   canAbsorbDraggingView:dragView
-                                                 payload:payload];
-      }
-    }
-    
-    // DROP EVENT : DROP ACCEPTED
-    if ( dropWasAccepted ) {
-      PSLogInfo(@"absorber accepted the drop");
-      if ([donorDelegate respondsToSelector:@selector(donorView:willDonateDraggingView:)])
-        [donorDelegate donorView:donorView willDonateDraggingView:dragView];
-      
-      recognizer.undoPickupEffectOnView();
-      [absorberView motionlessAddSubview:dragView];
-      
-      if ([absorberDelegate respondsToSelector:@selector(absorberView:didAbsorbDraggingView:payload:)])
-        [absorberDelegate absorberView:absorberView
-                 didAbsorbDraggingView:dragView
-                               payload:payload];
-      
-      if ([donorDelegate respondsToSelector:@selector(donorView:didDonateDraggingView:)])
-        [donorDelegate donorView:donorView didDonateDraggingView:dragView];
-    }
-    
-    // DROP EVENT : DROP REJECTED
-    else {
-      PSLogInfo(@"absorber rejected the drop, or there was no absorber.");
-      
-      // animate slide-back to original position ...
-      dispatch_block_t UndoPickupEffects = recognizer.undoPickupEffectOnView;
-      CGRect restoredFrame = [dragView.superview convertRect:recognizer.initialViewFrame
-                                                    fromView:recognizer.initialViewSuperview];
-      NSUInteger restoredIndex = recognizer.initialSubviewIndex;
-      
-      [UIView animateWithDuration:MCK_RECLAIM_ANIMATION_DURATION
-                       animations:^{
-                         // ... restore absolute frame
-                         dragView.frame = restoredFrame;
-                       }
-                       completion:^(BOOL finished) {
-                         // ... then restore appearance
-                         UndoPickupEffects();
-                         // restore view hierarchy
-                         [recognizer.initialViewSuperview motionlessInsertSubview:dragView
-                                                                          atIndex:restoredIndex];
-                         
-                         if ([donorDelegate respondsToSelector:@selector(donorView:didReclaimDraggingView:)])
-                           [donorDelegate donorView:donorView didReclaimDraggingView:dragView];
-                       }];
-    }
+    PSLogTrace("state = %g. StateEnded => drop", recognizer.state);
+    MCK_TRACE_FRAME("theView.frame", dragView);
+    [self dropSessionOfRecognizer:recognizer];
+  }
+
+  // CANCEL EVENT
+  else if (recognizer.state == UIGestureRecognizerStateCancelled) {
+    PSLogTrace("state = %g. StateCancelled => reclaim", recognizer.state);
+    [MCKDragDropServer cancelPayloadPromise:(__bridge id<NSObject>)session->payload];
+    [self.acceptanceCache forgetPayload:(__bridge id<NSObject>)session->payload];
+    [self flushMovesOfSession:session];
+    MCKSessionCancel(session);
+    recognizer.session = NULL;
   }
   else {
-    PSLogInfo(@"UIGestureRecognizerState unrecognized=%u",recognizer.state);
+    PSLogTrace("UIGestureRecognizerState unrecognized=%g", recognizer.state);
+  }
+}
+
+/* Starts the session of recognizer, dragging its dragView */
+-(void) pickUpViewOfRecognizer:(MCKPanGestureRecognizer*)recognizer coalescingMoves:(BOOL)coalesces
+{
+  UIView * dragView = recognizer.dragView;
+
+  // absorbers registered offscreen may have appeared since the last drag
+  [self.absorberIndex indexAbsorberViewsWhichAppeared];
+  recognizer.cachedAbsorberRegion = nil;
+  recognizer.cachedAbsorberView = nil;
+
+  // the rest of the selection goes along, if the drag starts on it
+  NSArray * selection = self.selectedDraggableViews;
+  size_t otherCount = 0;
+  MCKHandle * others = NULL;
+  if ( [selection count] > 1 && [selection indexOfObjectIdenticalTo:dragView] != NSNotFound ) {
+    others = malloc([selection count] * sizeof(MCKHandle));
+    for (UIView * view in selection)
+      if ( view != dragView )
+        others[otherCount++] = (__bridge MCKHandle)view;
+  }
+
+  // fails if the view is still sliding back from a rejected drop, or if
+  // every session is taken
+  recognizer.session = MCKSessionPoolPickUpItems(&sessionPool, (__bridge MCKHandle)dragView,
+                                                 others, otherCount, (__bridge void*)recognizer);
+  free(others);
+  if ( !recognizer.session ) {
+    PSLogError(@"could not pick up view=%@",dragView);
+    return;
+  }
+  // the donor's address, in decimal, as a trace record takes only numbers
+  PSLogTrace("picked up %g views from donor = %.0f", (double)recognizer.session->item_count,
+             (double)(uintptr_t)recognizer.session->donor_view);
+
+  size_t index = recognizer.session - sessionStorage;
+  layoutPassCountAtPickup[index] = MCKLayoutPassCounting ? MCKLayoutPassCount : NSNotFound;
+  if ( self.measuresFrames && sessionPool.active_count == 1 )
+    [[self frameMeterForPickupEffectStrategy:self.pickupEffect.strategy] start];
+  coalescedSessions[index] = coalesces;
+  if ( coalesces ) {
+    movePipelines[index].prediction = self.movePrediction;
+    MCKMovePipelineReset(&movePipelines[index]);
+    [self startMoveLink];
   }
 }
 
+/* Moves the views of recognizer's session at once, or at the next display refresh */
+-(void) moveSessionOfRecognizer:(MCKPanGestureRecognizer*)recognizer byTranslation:(CGPoint)translation
+{
+  MCKSession * session = recognizer.session;
+  if ( coalescedSessions[session - sessionStorage] )
+    MCKMovePipelineAddTranslation(&movePipelines[session - sessionStorage], translation.x, translation.y);
+  else
+    MCKSessionMove(session, translation.x, translation.y);
+}
+
+/* Drops the views of recognizer's session where they are */
+-(MCKDropOutcome) dropSessionOfRecognizer:(MCKPanGestureRecognizer*)recognizer
+{
+  MCKSession * session = recognizer.session;
+  // the session may end, and release its payload, during the drop
+  id<NSObject> payload = (__bridge id<NSObject>)session->payload;
+  [self flushMovesOfSession:session];
+  MCKDropOutcome outcome = MCKSessionDrop(session);
+  if ( outcome == MCKDropOutcomeAccepted )
+    PSLogTraceEvent("absorber accepted the drop");
+  else if ( outcome == MCKDropOutcomeRejected ) {
+    PSLogTraceEvent("absorber rejected the drop, or there was no absorber.");
+    [MCKDragDropServer cancelPayloadPromise:payload];
+  }
+  [self.acceptanceCache forgetPayload:payload];
+  // the session now belongs to the pool, even if it is still reclaiming
+  recognizer.session = NULL;
+  return outcome;
+}
+
+#pragma mark Scripted drags
+
+-(id) beginScriptedDragOfView:(UIView*)view
+{
+  if ( ![self canBeginDraggingView:view] )
+    return nil;
+
+  // a recognizer attached to no view never fires, but carries the session and
+  // its cached absorber, as for a gesture. The server keeps it until the
+  // session ends, since the session may outlive the drop while reclaiming.
+  MCKPanGestureRecognizer * recognizer = [[MCKPanGestureRecognizer alloc] initWithTarget:nil action:NULL];
+  recognizer.dragView = view;
+  [self pickUpViewOfRecognizer:recognizer coalescingMoves:NO];
+  if ( !recognizer.session )
+    return nil;
+  [self.scriptedRecognizers addObject:recognizer];
+  return recognizer;
+}
+
+-(UIView*) leadViewOfScriptedDrag:(id)drag
+{
+  MCKSession * session = ((MCKPanGestureRecognizer*)drag).session;
+  return session ? (__bridge UIView*)session->lead_view : nil;
+}
+
+-(void) moveScriptedDrag:(id)drag byTranslation:(CGPoint)translation
+{
+  MCKPanGestureRecognizer * recognizer = drag;
+  if ( recognizer.session )
+    [self moveSessionOfRecognizer:recognizer byTranslation:translation];
+}
+
+-(MCKDropOutcome) dropScriptedDrag:(id)drag
+{
+  MCKPanGestureRecognizer * recognizer = drag;
+  if ( !recognizer.session )
+    return MCKDropOutcomeNone;
+  return [self dropSessionOfRecognizer:recognizer];
+}
+
+#pragma mark Coalesced moves
+
+-(void) startMoveLink
+{
+  if ( self.moveLink )
+    return;
+  self.moveLink = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayWillRefresh:)];
+  [self.moveLink addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+/* Applies one move to each coalesced drag, and stops when there are none left */
+-(void) displayWillRefresh:(CADisplayLink*)link
+{
+  // the frame being prepared is shown at the next refresh
+  double displayTime = link.timestamp + link.duration;
+  BOOL dragging = NO;
+  for (size_t i = 0; i < MCK_MAX_DRAG_SESSIONS; ++i) {
+    MCKSession * session = &sessionStorage[i];
+    if ( !coalescedSessions[i] || session->phase != MCKSessionPhaseDragging )
+      continue;
+    dragging = YES;
+    double dx, dy;
+    if ( MCKMovePipelineNextFrame(&movePipelines[i], displayTime, &dx, &dy) )
+      MCKSessionMove(session, dx, dy);
+  }
+  if ( !dragging ) {
+    [link invalidate];
+    self.moveLink = nil;
+  }
+}
+
+/* Puts a coalesced drag's views under the finger, without prediction, before it ends */
+-(void) flushMovesOfSession:(MCKSession*)session
+{
+  size_t index = session - sessionStorage;
+  double dx, dy;
+  if ( coalescedSessions[index] && MCKMovePipelineFlush(&movePipelines[index], &dx, &dy) )
+    MCKSessionMove(session, dx, dy);
+  coalescedSessions[index] = NO;
+}
+
+// the undo holds no reference to the views: they are the session's
+-(void) applyPickupEffectToSession:(MCKSession*)session
+{
+  pickupEffectUndos[session - sessionStorage] =
+    [self.pickupEffect applyToViews:MCKUIKitFloatingViewsOfSession(session)];
+}
+
+-(void) undoPickupEffectOfSession:(MCKSession*)session
+{
+  size_t index = session - sessionStorage;
+  [pickupEffectUndos[index] restoreViews:MCKUIKitFloatingViewsOfSession(session)];
+  pickupEffectUndos[index] = nil;
+}
+
+/* A promised payload is no use once its drag has been rejected or cancelled */
++(void) cancelPayloadPromise:(id<NSObject>)payload
+{
+  if ( [payload isKindOfClass:[MCKPayloadPromise class]] )
+    [(MCKPayloadPromise*)payload cancel];
+}
+
+-(BOOL) canBeginDraggingView:(UIView*)view
+{
+  return MCKSessionCanBegin(&host, (__bridge MCKHandle)view, NULL);
+}
+
 /**
  Finds the donor UIView of the pickedUpView.
  
@@ -213,26 +558,19 @@ static MCKDragDropServer* sharedServer = nil;
  */
 -(UIView*) donorViewOfView:(UIView*)pickedUpView
 {
-  UIView * retval = pickedUpView;
-  while ( (retval = pickedUpView.superview) )
-  {
-    if ( [self isDesignatedDonorView:retval] )
-      break;
-  }
-
-  if (retval)
-    PSLogInfo(@"search found donor = %@",retval);
-  else
-    PSLogError(@"did not find a donor for view=%@",pickedUpView);
-  
-  return retval;
+  // no logging: a pickup of a selection looks up the donor of every item
+  return [self.registry closestAncestorOfView:pickedUpView
+                                     withRole:MCKDragDropRoleDonor];
 }
 
 /**
- Returns any eligible absorber view beneath the dropped view
+ Returns any eligible absorber view beneath the dragged view
  
- @param justDroppedView view being dropped
- @return the eligible absorber view for the drop, or nil if none was found.
+ @param dragView view being dragged or dropped, or its proxy
+ @param floatView view which carries dragView, and any other view dragged with
+        it. It is never a candidate, nor are its descendants.
+ @param recognizer recognizer of the drag session, which caches the last answer
+ @return the eligible absorber view, or nil if none was found.
 
  The eligible absorber view, for a given drop, is just the first hit test view 
  under the center of the dropped view that is also a designated absorber. A 
@@ -241,72 +579,182 @@ static MCKDragDropServer* sharedServer = nil;
  
  A hit test view must be unhidden, in its superview's bounds, and have
  userInteractionEnabled. The first hit test view is the view meeting those criteria
- that is deepest in view hierarchy. In short, this function traverses possible 
- dropped-on views using the same traversal rule as
- -(UIView*)[UIView hitTest:withEvent:, searching for the first candidate that
- has also been designated as an absorber.
+ that is deepest in view hierarchy. In short, this function finds the dropped-on
+ view using the same traversal rule as -(UIView*)[UIView hitTest:withEvent:],
+ searching for the first candidate that has also been designated as an absorber.
+ Views which are not absorbers never block the search.
  
+ The search is a query on the absorber index, so it does not touch the view
+ hierarchy beyond the few absorbers under the drop point. The answer is cached
+ on the recognizer with the region of the window where it remains valid.
  */
--(UIView*) firstAbsorberOfView:(UIView*)justDroppedView {
-  const UIWindow * win = justDroppedView.window;
-  const CGPoint dropPoint = [win convertPoint:justDroppedView.center
-                                     fromView:justDroppedView.superview];
-  UIView * retval = nil;
-  justDroppedView.hidden = YES; // exclude from search
-  const NSMutableArray * viewsToUnhide = [NSMutableArray arrayWithObject:justDroppedView];
-  // get the next hitTest winner
-  while ( (retval = [win hitTest:dropPoint withEvent:nil]) ) {
-    // if it's an absorber, we're done
-    if ([self isDesignatedAbsorberView:retval])
-      break;
-    else {
-      // it was a hitTestWinner, but not an absorber
-      retval.hidden=YES; // hide to exclude from the next search
-      [viewsToUnhide addObject:retval]; // remember to unhide later
-    }
+-(UIView*) absorberUnderView:(UIView*)dragView
+                excludingView:(UIView*)floatView
+                   recognizer:(MCKPanGestureRecognizer*)recognizer
+{
+  UIWindow * win = dragView.window;
+  const CGPoint point = [win convertPoint:dragView.center fromView:dragView.superview];
+
+  MCKAbsorberHitRegion * region = recognizer.cachedAbsorberRegion;
+  if ( region
+      && recognizer.cachedAbsorberGeneration == self.absorberIndex.generation
+      && [region containsPoint:point] ) {
+    self.absorberCacheHitCount++;
+    return recognizer.cachedAbsorberView;
   }
-  
-  [viewsToUnhide enumerateObjectsUsingBlock:
-   ^(id obj, NSUInteger idx, BOOL *stop) { [obj setHidden:NO]; }];
-  
-  if (retval)
-    PSLogInfo(@"search found absorber = %@",retval);
-  else
-    PSLogError(@"could not find an absorber for dropped view = %@",justDroppedView);
 
+  self.absorberResolutionCount++;
+  region = [[MCKAbsorberHitRegion alloc] init];
+  UIView * retval = [self.absorberIndex absorberAtPoint:point
+                                               inWindow:win
+                                          excludingView:floatView
+                                              hitRegion:region];
+  recognizer.cachedAbsorberView = retval;
+  recognizer.cachedAbsorberRegion = region;
+  recognizer.cachedAbsorberGeneration = self.absorberIndex.generation;
   return retval;
 }
 
-+(void) saveViewHierarchySlotOfView:(UIView*)v toRecognizer:(MCKPanGestureRecognizer*)recognizer {
-  recognizer.initialViewFrame = v.frame;
-  recognizer.initialViewSuperview = v.superview;
-  recognizer.initialSubviewIndex = [v.superview.subviews indexOfObject:v];
+-(void) resetAbsorberResolutionCounters
+{
+  self.absorberResolutionCount = 0;
+  self.absorberCacheHitCount = 0;
+}
+
+-(void) startRecordingTrace
+{
+  if ( host.recorder )
+    MCKTraceRecorderReset(host.recorder);
+  else
+    host.recorder = MCKTraceRecorderCreate(NULL);
 }
 
+-(NSData*) stopRecordingTrace
+{
+  if ( !host.recorder )
+    return nil;
 
-+(void) applyPickupEffectToView:(UIView*)v
-           saveUndoToRecognizer:(MCKPanGestureRecognizer*)recognizer {
-  PSLogInfo(@"");
-  // cache original values in restorer function
-  CGSize  theInitialShadowOffset  = v.layer.shadowOffset;
-  CGFloat theInitialShadowRadius  = v.layer.shadowRadius;
-  CGFloat theInitialShadowOpacity = v.layer.shadowOpacity;
-  UIColor * theInitialColor = v.backgroundColor;
-  
-  recognizer.undoPickupEffectOnView = ^ {
-    // block now holds strong reference to UIVIew, so it will keep the view
-    // alive until its own owning recognizer is dealloced.
-    v.layer.shadowOffset = theInitialShadowOffset;
-    v.layer.shadowRadius = theInitialShadowRadius;
-    v.layer.shadowOpacity = theInitialShadowOpacity;
-    v.backgroundColor = theInitialColor;
-  };
-  
-  // apply a generic pickup animation
-  v.layer.shadowOffset = CGSizeMake(0, 10);
-  v.layer.shadowRadius = 25;
-  v.layer.shadowOpacity = 1.0;
-  v.backgroundColor = [UIColor greenColor]; // for debugging
+  size_t length;
+  const unsigned char * bytes = MCKTraceRecorderBytes(host.recorder, &length);
+  NSData * trace = [NSData dataWithBytes:bytes length:length];
+  MCKTraceRecorderDestroy(host.recorder);
+  host.recorder = NULL;
+  PSLogInfo(@"recorded a trace of %u bytes",[trace length]);
+  return trace;
+}
+
+#pragma mark Performance metrics
+
+-(BOOL) collectsPerformanceMetrics
+{
+  return host.metrics != NULL;
+}
+
+-(void) setCollectsPerformanceMetrics:(BOOL)collects
+{
+  if ( collects && !host.metrics )
+    host.metrics = MCKSessionMetricsCreate(NULL);
+  else if ( !collects && host.metrics ) {
+    MCKSessionMetricsDestroy(host.metrics);
+    host.metrics = NULL;
+  }
+}
+
+-(void) resetPerformanceMetrics
+{
+  if ( host.metrics )
+    MCKSessionMetricsReset(host.metrics);
+}
+
+static NSNumber * MCKMilliseconds(double nanoseconds) {
+  return [NSNumber numberWithDouble:nanoseconds / 1e6];
+}
+
+/* The delegate of the view a callback metric was about, as "<Class: address>", or "none" */
+-(NSString*) describeDelegateOfView:(UIView*)view metric:(MCKMetric)metric
+{
+  NSObject * delegate = nil;
+  if ( view && metric < MCKMetricAbsorberCanAbsorb )
+    delegate = [self.registry donorDelegateForView:view];
+  else if ( view )
+    delegate = [self.registry absorberDelegateForView:view];
+  if ( !delegate )
+    return @"none";
+  return [NSString stringWithFormat:@"<%@: %p>",NSStringFromClass([delegate class]),delegate];
+}
+
+-(NSDictionary*) performanceMetrics
+{
+  const MCKSessionMetrics * metrics = host.metrics;
+  if ( !metrics )
+    return nil;
+
+  NSMutableDictionary * phases = [NSMutableDictionary dictionary];
+  for (int metric = 0; metric < MCKMetricCount; ++metric) {
+    const MCKHistogram * histogram = MCKSessionMetricsHistogram(metrics, metric);
+    if ( histogram->count == 0 )
+      continue;
+    NSDictionary * phase =
+      [NSDictionary dictionaryWithObjectsAndKeys:
+       [NSNumber numberWithUnsignedLongLong:histogram->count], @"count",
+       MCKMilliseconds(MCKHistogramMean(histogram)), @"mean",
+       MCKMilliseconds(MCKHistogramValueAtPercentile(histogram, 50)), @"p50",
+       MCKMilliseconds(MCKHistogramValueAtPercentile(histogram, 90)), @"p90",
+       MCKMilliseconds(MCKHistogramValueAtPercentile(histogram, 99)), @"p99",
+       MCKMilliseconds(histogram->max), @"max",
+       nil];
+    [phases setObject:phase forKey:[NSString stringWithUTF8String:MCKMetricName(metric)]];
+  }
+
+  // views are only compared by address in the table, and may be dead by now
+  NSMutableArray * delegates = [NSMutableArray array];
+  for (size_t i = 0; i < MCKSessionMetricsDelegateStatCount(metrics); ++i) {
+    const MCKDelegateStat * stat = MCKSessionMetricsDelegateStatAt(metrics, i);
+    UIView * view = [self.registry liveViewAtAddress:stat->view];
+    NSDictionary * entry =
+      [NSDictionary dictionaryWithObjectsAndKeys:
+       [NSString stringWithUTF8String:MCKMetricName(stat->metric)], @"callback",
+       view ? NSStringFromClass([view class]) : @"none", @"view",
+       [self describeDelegateOfView:view metric:stat->metric], @"delegate",
+       [NSNumber numberWithUnsignedLongLong:stat->count], @"count",
+       MCKMilliseconds((double)stat->total / stat->count), @"mean",
+       MCKMilliseconds(stat->max), @"max",
+       nil];
+    [delegates addObject:entry];
+  }
+  [delegates sortUsingDescriptors:[NSArray arrayWithObject:[NSSortDescriptor sortDescriptorWithKey:@"max" ascending:NO]]];
+
+  return [NSDictionary dictionaryWithObjectsAndKeys:
+          phases, @"phases",
+          delegates, @"delegates",
+          [NSNumber numberWithUnsignedLongLong:MCKSessionMetricsUntrackedCount(metrics)], @"untracked",
+          nil];
+}
+
+-(void) exportPerformanceMetricsToPath:(NSString*)path interval:(NSTimeInterval)interval
+{
+  [self.metricsExportTimer invalidate];
+  self.metricsExportTimer = nil;
+  self.metricsExportPath = path;
+  if ( !path )
+    return;
+  PSLogInfo(@"exporting performance metrics to %@ every %g s",path,interval);
+  self.metricsExportTimer = [NSTimer scheduledTimerWithTimeInterval:interval
+                                                             target:self
+                                                           selector:@selector(exportPerformanceMetrics:)
+                                                           userInfo:nil
+                                                            repeats:YES];
+}
+
+-(void) exportPerformanceMetrics:(NSTimer*)timer
+{
+  NSDictionary * report = [self performanceMetrics];
+  if ( !report )
+    return;
+  NSError * error = nil;
+  NSData * json = [NSJSONSerialization dataWithJSONObject:report options:NSJSONWritingPrettyPrinted error:&error];
+  if ( !json || ![json writeToFile:self.metricsExportPath options:NSDataWritingAtomic error:&error] )
+    PSLogError(@"could not export performance metrics to %@: %@",self.metricsExportPath,error);
 }
 
 /*
@@ -315,49 +763,649 @@ static MCKDragDropServer* sharedServer = nil;
 -(void) registerDraggableView:(UIView*)draggableView
 {
   PSLogInfo(@"");
-  MCKPanGestureRecognizer * panGestureRecognizer =
-  [[MCKPanGestureRecognizer alloc] initWithTarget:self
-                                           action:@selector(handlePan:)];
-  
-  [draggableView addGestureRecognizer:panGestureRecognizer];
+  if ( !self.donorsShareRecognizers )
+    [draggableView addGestureRecognizer:[self makeRecognizer]];
+  [self.registry addRole:MCKDragDropRoleDraggable toView:draggableView];
+}
+
+-(void) registerDraggableViews:(NSArray*)draggableViews
+{
+  PSLogInfo(@"%u views",[draggableViews count]);
+  if ( !self.donorsShareRecognizers )
+    for (UIView * view in draggableViews)
+      [view addGestureRecognizer:[self makeRecognizer]];
+  [self.registry addRole:MCKDragDropRoleDraggable toViews:draggableViews];
+}
+
+-(MCKPanGestureRecognizer*) makeRecognizer
+{
+  return [[MCKPanGestureRecognizer alloc] initWithTarget:self
+                                                  action:@selector(handlePan:)];
 }
 
+/* The donor's shared recognizer, if it has one */
+-(MCKPanGestureRecognizer*) sharedRecognizerOfDonorView:(UIView*)view
+{
+  for (UIGestureRecognizer * recognizer in view.gestureRecognizers)
+    if ( [recognizer isKindOfClass:[MCKPanGestureRecognizer class]]
+        && ((MCKPanGestureRecognizer*)recognizer).sharedByDonor )
+      return (MCKPanGestureRecognizer*)recognizer;
+  return nil;
+}
 
-/* The following three methods implement a dictionary from views to their delegates. I'm using 
- associated objects rather than dictionary to avoid implementing housekeeping on the dictionary
- for when keys going invalid when views disappear.
+/*
+ Finds the draggable view a gesture on a donor's shared recognizer applies to:
+ the touched view or its closest ancestor which is draggable, provided its
+ donor is donorView and not a donor nested inside it.
  */
-static char donorKey;
+-(UIView*) draggableViewOfTouchedView:(UIView*)touchedView inDonorView:(UIView*)donorView
+{
+  for (UIView * view = touchedView; view && view != donorView; view = view.superview) {
+    MCKDragDropRole roles = [self.registry rolesOfView:view];
+    if ( roles & MCKDragDropRoleDraggable )
+      return view;
+    if ( roles & MCKDragDropRoleDonor )
+      return nil; // a nested donor's recognizer handles its own draggables
+  }
+  return nil;
+}
+
+
+/* The following methods map views to their roles and delegates, via the registry. */
 -(void) registerDonorView:(UIView*)view delegate:(NSObject<MCKDragDropDonorDelegate>*)delegate
 {
-  if ( view )
-    objc_setAssociatedObject(view, &donorKey, delegate, OBJC_ASSOCIATION_ASSIGN);
+  [self.registry setDonorDelegate:delegate forView:view];
+  [self.registry addRole:MCKDragDropRoleDonor toView:view];
+
+  if ( self.donorsShareRecognizers && view && ![self sharedRecognizerOfDonorView:view] ) {
+    MCKPanGestureRecognizer * recognizer = [self makeRecognizer];
+    recognizer.sharedByDonor = YES;
+    [view addGestureRecognizer:recognizer];
+  }
+}
+
+-(void) unregisterDonorView:(UIView*)view
+{
+  [self.registry setDonorDelegate:nil forView:view];
+  [self.registry removeRole:MCKDragDropRoleDonor fromView:view];
+
+  MCKPanGestureRecognizer * recognizer = [self sharedRecognizerOfDonorView:view];
+  if ( recognizer )
+    [view removeGestureRecognizer:recognizer];
 }
 
 -(NSObject<MCKDragDropDonorDelegate>*) delegateForDonorView:(UIView*)view
 {
-  return objc_getAssociatedObject(view, &donorKey);
+  return [self.registry donorDelegateForView:view];
 }
 
 -(BOOL)isDesignatedDonorView:(UIView*)view
 {
-  return ([self delegateForDonorView:view] != nil );
+  return [self.registry view:view hasRole:MCKDragDropRoleDonor];
+}
+
+-(MCKDragDropRole) rolesOfView:(UIView*)view
+{
+  return [self.registry rolesOfView:view];
 }
 
 
-static char absorberKey;
 -(void) registerAbsorberView:(UIView*)view delegate:(NSObject<MCKDragDropAbsorberDelegate>*)delegate
+{
+  if ( view ) {
+    [self.registry setAbsorberDelegate:delegate forView:view];
+    [self.registry addRole:MCKDragDropRoleAbsorber toView:view];
+    [self.absorberIndex addAbsorberView:view];
+  }
+}
+
+-(void) unregisterAbsorberView:(UIView*)view
+{
+  if ( view ) {
+    [self.registry setAbsorberDelegate:nil forView:view];
+    [self.registry removeRole:MCKDragDropRoleAbsorber fromView:view];
+    [self.absorberIndex removeAbsorberView:view];
+    [self.orderedAbsorbers removeObjectForKey:[NSValue valueWithNonretainedObject:view]];
+  }
+}
+
+-(void) setSlotAxis:(MCKSlotAxis)axis forAbsorberView:(UIView*)view
 {
   if ( view )
-    objc_setAssociatedObject(view, &absorberKey, delegate, OBJC_ASSOCIATION_ASSIGN);
+    [self.orderedAbsorbers setObject:[[MCKOrderedAbsorber alloc] initWithView:view axis:axis]
+                              forKey:[NSValue valueWithNonretainedObject:view]];
+}
+
+-(void) absorberViewDidLayoutSlots:(UIView*)view
+{
+  [self orderedAbsorberOfView:view].needsLayout = YES;
+  for (UIView * subview in view.subviews)
+    [self reindexAbsorbersInView:subview];
+}
+
+/* The slots of view, if it is an ordered absorber. The key may outlive its view, so the view is checked. */
+-(MCKOrderedAbsorber*) orderedAbsorberOfView:(UIView*)view
+{
+  if ( !view || [self.orderedAbsorbers count] == 0 )
+    return nil;
+  MCKOrderedAbsorber * ordered = [self.orderedAbsorbers objectForKey:[NSValue valueWithNonretainedObject:view]];
+  return ordered.view == view ? ordered : nil;
+}
+
+-(void) absorberViewDidMove:(UIView*)view
+{
+  [self reindexAbsorbersInView:view];
+}
+
+-(void) absorberViewsDidMove
+{
+  [self.absorberIndex setNeedsUpdate];
+}
+
+/* Refreshes the window frames of view, and of the views inside it, which are absorbers */
+-(void) reindexAbsorbersInView:(UIView*)view
+{
+  if ( [self.registry view:view hasRole:MCKDragDropRoleAbsorber] )
+    [self.absorberIndex absorberViewDidMove:view];
+  for (UIView * subview in view.subviews)
+    [self reindexAbsorbersInView:subview];
 }
 
 -(NSObject<MCKDragDropAbsorberDelegate>*) delegateForAbsorberView:(UIView*)view {
-  return objc_getAssociatedObject(view, &absorberKey);
+  return [self.registry absorberDelegateForView:view];
 }
 
 -(BOOL)isDesignatedAbsorberView:(UIView *)view {
-  return ([self delegateForAbsorberView:view] != nil );
+  return [self.registry view:view hasRole:MCKDragDropRoleAbsorber];
 }
 
 @end
+
+#pragma mark - UIKit host
+
+/*
+ The tree operations and delegate callbacks of the C core, for UIViews.
+
+ Handles are unretained UIView pointers, the context is the server, and each
+ session's user_data is its MCKPanGestureRecognizer.
+ */
+
+static inline CGRect MCKRectToCGRect(MCKRect r) {
+  return CGRectMake(r.origin.x, r.origin.y, r.size.width, r.size.height);
+}
+
+static inline MCKRect MCKRectFromCGRect(CGRect r) {
+  return MCKRectMake(r.origin.x, r.origin.y, r.size.width, r.size.height);
+}
+
+#define MCK_VIEW(handle) ((__bridge UIView*)(handle))
+#define MCK_SERVER(context) ((__bridge MCKDragDropServer*)(context))
+#define MCK_RECOGNIZER(session) ((__bridge MCKPanGestureRecognizer*)(session)->user_data)
+
+/* The payload for a callback which needs the real thing: waits for a promised payload to be built */
+static id<NSObject> MCKUIKitFulfilledPayload(void * payload) {
+  id<NSObject> object = (__bridge id<NSObject>)payload;
+  if ( [object isKindOfClass:[MCKPayloadPromise class]] )
+    return [(MCKPayloadPromise*)object payload];
+  return object;
+}
+
+/* The views of session's items, in the order the core keeps them */
+static NSArray * MCKUIKitViewsOfSession(const MCKSession * session) {
+  NSMutableArray * views = [NSMutableArray arrayWithCapacity:session->item_count];
+  for (size_t i = 0; i < session->item_count; ++i)
+    [views addObject:MCK_VIEW(session->items[i].view)];
+  return views;
+}
+
+/* What floats for session's items: the views, or their proxies */
+static NSArray * MCKUIKitFloatingViewsOfSession(const MCKSession * session) {
+  NSMutableArray * views = [NSMutableArray arrayWithCapacity:session->item_count];
+  for (size_t i = 0; i < session->item_count; ++i)
+    [views addObject:MCK_VIEW(MCKSessionItemFloatingView(&session->items[i]))];
+  return views;
+}
+
+static MCKHandle MCKUIKitParentOf(void * context, MCKHandle view) {
+  return (__bridge MCKHandle)MCK_VIEW(view).superview;
+}
+
+static size_t MCKUIKitIndexInParent(void * context, MCKHandle view) {
+  NSUInteger index = [MCK_VIEW(view).superview.subviews indexOfObject:MCK_VIEW(view)];
+  return index == NSNotFound ? MCKIndexEnd : index;
+}
+
+static MCKHandle MCKUIKitChildAt(void * context, MCKHandle parent, size_t index) {
+  NSArray * subviews = MCK_VIEW(parent).subviews;
+  return index < [subviews count] ? (__bridge MCKHandle)[subviews objectAtIndex:index] : NULL;
+}
+
+// keeps the slots of ordered absorbers in step with the views moved in and out
+static void MCKUIKitInsertChild(void * context, MCKHandle parent, MCKHandle child, size_t index) {
+  MCKDragDropServer * server = MCK_SERVER(context);
+  UIView * view = MCK_VIEW(child);
+  MCKOrderedAbsorber * from = [server orderedAbsorberOfView:view.superview];
+  if ( from && !from.needsLayout )
+    MCKSlotIndexRemove(&from->slots, [view.superview.subviews indexOfObjectIdenticalTo:view]);
+
+  if ( index == MCKIndexEnd || index >= [MCK_VIEW(parent).subviews count] )
+    [MCK_VIEW(parent) addSubview:view];
+  else
+    [MCK_VIEW(parent) insertSubview:view atIndex:index];
+
+  MCKOrderedAbsorber * to = [server orderedAbsorberOfView:MCK_VIEW(parent)];
+  if ( to && !to.needsLayout )
+    MCKSlotIndexInsert(&to->slots, [MCK_VIEW(parent).subviews indexOfObjectIdenticalTo:view],
+                       MCKSizeMake(view.bounds.size.width, view.bounds.size.height));
+}
+
+static MCKRect MCKUIKitFrameOf(void * context, MCKHandle view) {
+  return MCKRectFromCGRect(MCK_VIEW(view).frame);
+}
+
+static void MCKUIKitSetFrame(void * context, MCKHandle view, MCKRect frame) {
+  MCK_VIEW(view).frame = MCKRectToCGRect(frame);
+}
+
+static MCKPoint MCKUIKitCenterOf(void * context, MCKHandle view) {
+  CGPoint center = MCK_VIEW(view).center;
+  return MCKPointMake(center.x, center.y);
+}
+
+static void MCKUIKitSetCenter(void * context, MCKHandle view, MCKPoint center) {
+  MCK_VIEW(view).center = CGPointMake(center.x, center.y);
+}
+
+static MCKRect MCKUIKitConvertRect(void * context, MCKRect rect, MCKHandle from, MCKHandle to) {
+  return MCKRectFromCGRect([MCK_VIEW(from) convertRect:MCKRectToCGRect(rect) toView:MCK_VIEW(to)]);
+}
+
+// dragged views float at the top of the root view controller's view, and
+// proxies in an overlay there, which is added once and then kept in front
+static MCKHandle MCKUIKitDragLayerOf(void * context, MCKHandle view) {
+  UIView * root = MCK_VIEW(view).window.rootViewController.view;
+  if ( !MCK_SERVER(context).usesDragProxies )
+    return (__bridge MCKHandle)root;
+
+  UIView * overlay = [root.subviews lastObject];
+  if ( ![overlay isKindOfClass:[MCKDragOverlayView class]] ) {
+    overlay = nil;
+    for (UIView * subview in root.subviews)
+      if ( [subview isKindOfClass:[MCKDragOverlayView class]] )
+        overlay = subview;
+    if ( overlay )
+      [root bringSubviewToFront:overlay];
+    else {
+      overlay = [[MCKDragOverlayView alloc] initWithFrame:root.bounds];
+      overlay.autoresizingMask = UIViewAutoresizingFlexibleWidth | UIViewAutoresizingFlexibleHeight;
+      overlay.backgroundColor = [UIColor clearColor];
+      overlay.opaque = NO;
+      overlay.userInteractionEnabled = NO;
+      [root addSubview:overlay];
+    }
+  }
+  return (__bridge MCKHandle)overlay;
+}
+
+static MCKHandle MCKUIKitDonorOf(void * context, MCKHandle view) {
+  return (__bridge MCKHandle)[MCK_SERVER(context) donorViewOfView:MCK_VIEW(view)];
+}
+
+static MCKHandle MCKUIKitAbsorberUnder(void * context, MCKSession * session) {
+  MCKHandle floatView = session->float_view ? session->float_view : session->lead_view;
+  return (__bridge MCKHandle)[MCK_SERVER(context) absorberUnderView:MCK_VIEW(session->lead_view)
+                                                      excludingView:MCK_VIEW(floatView)
+                                                         recognizer:MCK_RECOGNIZER(session)];
+}
+
+/* The slot of an ordered absorber under the dragged view, by binary search */
+static size_t MCKUIKitInsertionIndex(void * context, MCKHandle absorber, MCKSession * session) {
+  UIView * absorberView = MCK_VIEW(absorber);
+  MCKOrderedAbsorber * ordered = [MCK_SERVER(context) orderedAbsorberOfView:absorberView];
+  if ( !ordered )
+    return MCKIndexEnd;
+
+  if ( ordered.needsLayout ) {
+    MCKSlotIndexRemoveAll(&ordered->slots);
+    for (UIView * subview in absorberView.subviews)
+      MCKSlotIndexAppend(&ordered->slots, MCKRectFromCGRect(subview.frame));
+    ordered.needsLayout = NO;
+  }
+  UIView * leadView = MCK_VIEW(session->lead_view);
+  CGPoint point = [absorberView convertPoint:leadView.center fromView:leadView.superview];
+  return MCKSlotIndexInsertionIndex(&ordered->slots, MCKPointMake(point.x, point.y));
+}
+
+// the group of a multi-item drag is a transparent view over the drag layer,
+// which the session owns with +1 until it is destroyed
+static MCKHandle MCKUIKitCreateGroup(void * context, MCKHandle parent) {
+  UIView * group = [[UIView alloc] initWithFrame:MCK_VIEW(parent).bounds];
+  group.backgroundColor = [UIColor clearColor];
+  group.opaque = NO;
+  [MCK_VIEW(parent) addSubview:group];
+  return (__bridge_retained MCKHandle)group;
+}
+
+static void MCKUIKitDestroyGroup(void * context, MCKHandle group) {
+  UIView * view = (__bridge_transfer UIView*)group;
+  [view removeFromSuperview];
+}
+
+// hierarchy changes in a batch reach the render server in one commit
+static void MCKUIKitBeginBatch(void * context) {
+  [CATransaction begin];
+  [CATransaction setDisableActions:YES];
+}
+
+static void MCKUIKitEndBatch(void * context) {
+  [CATransaction commit];
+}
+
+// a proxy shows a snapshot of the view, taken once at pickup, and is owned by
+// the session with +1 until it is destroyed
+static MCKHandle MCKUIKitCreateProxy(void * context, MCKHandle layer, MCKHandle view) {
+  UIView * original = MCK_VIEW(view);
+  CGSize size = original.bounds.size;
+  UIView * proxy = [[UIView alloc] initWithFrame:CGRectMake(0, 0, size.width, size.height)];
+  proxy.center = [MCK_VIEW(layer) convertPoint:original.center fromView:original.superview];
+  proxy.transform = original.transform;
+  proxy.userInteractionEnabled = NO;
+
+  UIGraphicsBeginImageContextWithOptions(size, NO, 0);
+  [original.layer renderInContext:UIGraphicsGetCurrentContext()];
+  UIImage * snapshot = UIGraphicsGetImageFromCurrentImageContext();
+  UIGraphicsEndImageContext();
+  proxy.layer.contents = (__bridge id)snapshot.CGImage;
+
+  [MCK_VIEW(layer) addSubview:proxy];
+  return (__bridge_retained MCKHandle)proxy;
+}
+
+static void MCKUIKitDestroyProxy(void * context, MCKHandle proxy) {
+  UIView * view = (__bridge_transfer UIView*)proxy;
+  [view removeFromSuperview];
+}
+
+static void MCKUIKitSetHidden(void * context, MCKHandle view, bool hidden) {
+  MCK_VIEW(view).hidden = hidden;
+}
+
+static void MCKUIKitApplyPickupEffect(void * context, MCKSession * session) {
+  [MCK_SERVER(context) applyPickupEffectToSession:session];
+}
+
+static void MCKUIKitUndoPickupEffect(void * context, MCKSession * session) {
+  [MCK_SERVER(context) undoPickupEffectOfSession:session];
+}
+
+// every item slides back in the same animation, however many there are
+static void MCKUIKitAnimateReclaim(void * context, MCKSession * session,
+                                   void (*completion)(MCKSession * session)) {
+  [UIView animateWithDuration:MCK_RECLAIM_ANIMATION_DURATION
+                   animations:^{
+                     // ... restore absolute frames
+                     for (size_t i = 0; i < session->item_count; ++i)
+                       MCK_VIEW(MCKSessionItemFloatingView(&session->items[i])).frame =
+                         MCKRectToCGRect(session->items[i].restore_frame);
+                   }
+                   completion:^(BOOL finished) {
+                     // ... then restore appearance and view hierarchy
+                     completion(session);
+                   }];
+}
+
+static void MCKUIKitSessionDidEnd(void * context, MCKSession * session) {
+  [MCK_SERVER(context) sessionDidEnd:session];
+}
+
+static void MCKUIKitRetain(void * context, void * object) {
+  CFRetain((CFTypeRef)object);
+}
+
+static void MCKUIKitRelease(void * context, void * object) {
+  CFRelease((CFTypeRef)object);
+}
+
+static bool MCKUIKitDonorShouldBegin(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:shouldBeginDraggingView:)] )
+    return [delegate donorView:MCK_VIEW(donor) shouldBeginDraggingView:MCK_VIEW(drag)];
+  return true;
+}
+
+// the payload is handed to the core with +1, and released when the session ends
+static void * MCKUIKitDonorWillBegin(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:willBeginDraggingView:)] )
+    return (__bridge_retained void*)[delegate donorView:MCK_VIEW(donor) willBeginDraggingView:MCK_VIEW(drag)];
+  return NULL;
+}
+
+static void MCKUIKitDonorDidBegin(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didBeginDraggingView:)] )
+    [delegate donorView:MCK_VIEW(donor) didBeginDraggingView:MCK_VIEW(drag)];
+}
+
+static void MCKUIKitDonorWillDonate(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:willDonateDraggingView:)] )
+    [delegate donorView:MCK_VIEW(donor) willDonateDraggingView:MCK_VIEW(drag)];
+}
+
+static void MCKUIKitDonorDidDonate(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didDonateDraggingView:)] )
+    [delegate donorView:MCK_VIEW(donor) didDonateDraggingView:MCK_VIEW(drag)];
+}
+
+static void MCKUIKitDonorDidReclaim(void * context, MCKHandle donor, MCKHandle drag) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didReclaimDraggingView:)] )
+    [delegate donorView:MCK_VIEW(donor) didReclaimDraggingView:MCK_VIEW(drag)];
+}
+
+static bool MCKUIKitAbsorberCanAbsorb(void * context, MCKHandle absorber, MCKHandle drag, void * payload) {
+  MCKDragDropServer * server = MCK_SERVER(context);
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [server delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:canAbsorbPayload:)] )
+    return [server.acceptanceCache acceptanceOfAbsorberView:MCK_VIEW(absorber)
+                                                   delegate:delegate
+                                                    payload:(__bridge id<NSObject>)payload
+                                                   deadline:server.acceptanceDeadline
+                                                   fallback:server.acceptsDropsPastDeadline];
+  // synchronous delegates predate promises: they get the built payload, at
+  // the cost of waiting for it on the main thread
+  if ( [delegate respondsToSelector:@selector(absorberView:canAbsorbDraggingView:payload:)] )
+    return [delegate absorberView:MCK_VIEW(absorber)
+            canAbsorbDraggingView:MCK_VIEW(drag)
+                          payload:MCKUIKitFulfilledPayload(payload)];
+  return true;
+}
+
+static void MCKUIKitAbsorberDidAbsorb(void * context, MCKHandle absorber, MCKHandle drag, void * payload) {
+  // what the absorber accepts may depend on what it already holds
+  [MCK_SERVER(context).acceptanceCache forgetAbsorberView:MCK_VIEW(absorber)];
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:didAbsorbDraggingView:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+     didAbsorbDraggingView:MCK_VIEW(drag)
+                   payload:MCKUIKitFulfilledPayload(payload)];
+}
+
+static void MCKUIKitAbsorberDidEnter(void * context, MCKHandle absorber, MCKHandle drag, void * payload) {
+  // a drop has become possible, so a promised payload may be needed soon
+  id<NSObject> object = (__bridge id<NSObject>)payload;
+  if ( [object isKindOfClass:[MCKPayloadPromise class]] )
+    [(MCKPayloadPromise*)object start];
+
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  // and so may the absorber's answer
+  if ( [delegate respondsToSelector:@selector(absorberView:canAbsorbPayload:)] )
+    [MCK_SERVER(context).acceptanceCache prefetchAbsorberView:MCK_VIEW(absorber) delegate:delegate payload:object];
+  if ( [delegate respondsToSelector:@selector(absorberView:draggingViewDidEnter:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+      draggingViewDidEnter:MCK_VIEW(drag)
+                   payload:(__bridge id<NSObject>)payload];
+}
+
+static void MCKUIKitAbsorberDidHover(void * context, MCKHandle absorber, MCKHandle drag, void * payload) {
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:draggingViewDidHover:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+      draggingViewDidHover:MCK_VIEW(drag)
+                   payload:(__bridge id<NSObject>)payload];
+}
+
+static void MCKUIKitAbsorberDidHoverAtIndex(void * context, MCKHandle absorber, const MCKSession * session) {
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:draggingView:didHoverAtIndex:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+              draggingView:MCK_VIEW(session->drag_view)
+           didHoverAtIndex:session->insertion_index
+                   payload:(__bridge id<NSObject>)session->payload];
+}
+
+static void MCKUIKitAbsorberDidAbsorbAtIndex(void * context, MCKHandle absorber, const MCKSession * session) {
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:didAbsorbDraggingViews:atIndex:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+    didAbsorbDraggingViews:MCKUIKitViewsOfSession(session)
+                   atIndex:session->insertion_index
+                   payload:MCKUIKitFulfilledPayload(session->payload)];
+}
+
+static void MCKUIKitAbsorberDidExit(void * context, MCKHandle absorber, MCKHandle drag, void * payload) {
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:draggingViewDidExit:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+       draggingViewDidExit:MCK_VIEW(drag)
+                   payload:(__bridge id<NSObject>)payload];
+}
+
+/*
+ The array versions of the donor and absorber callbacks. A delegate which
+ lacks the array method gets the single-view one, per view, as the core would
+ do if these were not set.
+ */
+
+static void * MCKUIKitDonorWillBeginItems(void * context, MCKHandle donor, const MCKSession * session) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:willBeginDraggingViews:)] )
+    return (__bridge_retained void*)[delegate donorView:MCK_VIEW(donor)
+                                 willBeginDraggingViews:MCKUIKitViewsOfSession(session)];
+  return MCKUIKitDonorWillBegin(context, donor, session->drag_view);
+}
+
+static void MCKUIKitDonorDidBeginItems(void * context, MCKHandle donor, const MCKSession * session) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didBeginDraggingViews:)] )
+    [delegate donorView:MCK_VIEW(donor) didBeginDraggingViews:MCKUIKitViewsOfSession(session)];
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKUIKitDonorDidBegin(context, donor, session->items[i].view);
+}
+
+static void MCKUIKitDonorWillDonateItems(void * context, MCKHandle donor, const MCKSession * session) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:willDonateDraggingViews:)] )
+    [delegate donorView:MCK_VIEW(donor) willDonateDraggingViews:MCKUIKitViewsOfSession(session)];
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKUIKitDonorWillDonate(context, donor, session->items[i].view);
+}
+
+static void MCKUIKitDonorDidDonateItems(void * context, MCKHandle donor, const MCKSession * session) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didDonateDraggingViews:)] )
+    [delegate donorView:MCK_VIEW(donor) didDonateDraggingViews:MCKUIKitViewsOfSession(session)];
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKUIKitDonorDidDonate(context, donor, session->items[i].view);
+}
+
+static void MCKUIKitDonorDidReclaimItems(void * context, MCKHandle donor, const MCKSession * session) {
+  NSObject <MCKDragDropDonorDelegate> * delegate = [MCK_SERVER(context) delegateForDonorView:MCK_VIEW(donor)];
+  if ( [delegate respondsToSelector:@selector(donorView:didReclaimDraggingViews:)] )
+    [delegate donorView:MCK_VIEW(donor) didReclaimDraggingViews:MCKUIKitViewsOfSession(session)];
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKUIKitDonorDidReclaim(context, donor, session->items[i].view);
+}
+
+static bool MCKUIKitAbsorberCanAbsorbItems(void * context, MCKHandle absorber, const MCKSession * session) {
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:canAbsorbDraggingViews:payload:)]
+      && ![delegate respondsToSelector:@selector(absorberView:canAbsorbPayload:)] )
+    return [delegate absorberView:MCK_VIEW(absorber)
+           canAbsorbDraggingViews:MCKUIKitViewsOfSession(session)
+                          payload:MCKUIKitFulfilledPayload(session->payload)];
+  return MCKUIKitAbsorberCanAbsorb(context, absorber, session->drag_view, session->payload);
+}
+
+static void MCKUIKitAbsorberDidAbsorbItems(void * context, MCKHandle absorber, const MCKSession * session) {
+  [MCK_SERVER(context).acceptanceCache forgetAbsorberView:MCK_VIEW(absorber)];
+  NSObject <MCKDragDropAbsorberDelegate> * delegate = [MCK_SERVER(context) delegateForAbsorberView:MCK_VIEW(absorber)];
+  if ( [delegate respondsToSelector:@selector(absorberView:didAbsorbDraggingViews:payload:)] )
+    [delegate absorberView:MCK_VIEW(absorber)
+    didAbsorbDraggingViews:MCKUIKitViewsOfSession(session)
+                   payload:MCKUIKitFulfilledPayload(session->payload)];
+  else
+    for (size_t i = 0; i < session->item_count; ++i)
+      MCKUIKitAbsorberDidAbsorb(context, absorber, session->items[i].view, session->payload);
+}
+
+static void MCKDragDropServerHostInit(MCKDragDropHost * host, MCKDragDropServer * server)
+{
+  memset(host, 0, sizeof(*host));
+  // the server is a singleton, so it outlives every session
+  host->context = (__bridge void*)server;
+
+  host->tree.parent_of = MCKUIKitParentOf;
+  host->tree.index_in_parent = MCKUIKitIndexInParent;
+  host->tree.child_at = MCKUIKitChildAt;
+  host->tree.insert_child = MCKUIKitInsertChild;
+  host->tree.frame_of = MCKUIKitFrameOf;
+  host->tree.set_frame = MCKUIKitSetFrame;
+  host->tree.center_of = MCKUIKitCenterOf;
+  host->tree.set_center = MCKUIKitSetCenter;
+  host->tree.convert_rect = MCKUIKitConvertRect;
+  host->tree.drag_layer_of = MCKUIKitDragLayerOf;
+  host->tree.donor_of = MCKUIKitDonorOf;
+  host->tree.absorber_under = MCKUIKitAbsorberUnder;
+  host->tree.insertion_index = MCKUIKitInsertionIndex;
+  host->tree.create_group = MCKUIKitCreateGroup;
+  host->tree.destroy_group = MCKUIKitDestroyGroup;
+  host->tree.begin_batch = MCKUIKitBeginBatch;
+  host->tree.end_batch = MCKUIKitEndBatch;
+  host->tree.create_proxy = MCKUIKitCreateProxy;
+  host->tree.destroy_proxy = MCKUIKitDestroyProxy;
+  host->tree.set_hidden = MCKUIKitSetHidden;
+  host->tree.apply_pickup_effect = MCKUIKitApplyPickupEffect;
+  host->tree.undo_pickup_effect = MCKUIKitUndoPickupEffect;
+  host->tree.animate_reclaim = MCKUIKitAnimateReclaim;
+  host->tree.session_did_end = MCKUIKitSessionDidEnd;
+  host->tree.retain = MCKUIKitRetain;
+  host->tree.release = MCKUIKitRelease;
+
+  host->callbacks.donor_should_begin = MCKUIKitDonorShouldBegin;
+  host->callbacks.donor_will_begin = MCKUIKitDonorWillBegin;
+  host->callbacks.donor_did_begin = MCKUIKitDonorDidBegin;
+  host->callbacks.donor_will_donate = MCKUIKitDonorWillDonate;
+  host->callbacks.donor_did_donate = MCKUIKitDonorDidDonate;
+  host->callbacks.donor_did_reclaim = MCKUIKitDonorDidReclaim;
+  host->callbacks.absorber_can_absorb = MCKUIKitAbsorberCanAbsorb;
+  host->callbacks.absorber_did_absorb = MCKUIKitAbsorberDidAbsorb;
+  host->callbacks.absorber_did_enter = MCKUIKitAbsorberDidEnter;
+  host->callbacks.absorber_did_hover = MCKUIKitAbsorberDidHover;
+  host->callbacks.absorber_did_exit = MCKUIKitAbsorberDidExit;
+  host->callbacks.absorber_did_hover_at_index = MCKUIKitAbsorberDidHoverAtIndex;
+  host->callbacks.absorber_did_absorb_at_index = MCKUIKitAbsorberDidAbsorbAtIndex;
+  host->callbacks.donor_will_begin_items = MCKUIKitDonorWillBeginItems;
+  host->callbacks.donor_did_begin_items = MCKUIKitDonorDidBeginItems;
+  host->callbacks.donor_will_donate_items = MCKUIKitDonorWillDonateItems;
+  host->callbacks.donor_did_donate_items = MCKUIKitDonorDidDonateItems;
+  host->callbacks.donor_did_reclaim_items = MCKUIKitDonorDidReclaimItems;
+  host->callbacks.absorber_can_absorb_items = MCKUIKitAbsorberCanAbsorbItems;
+  host->callbacks.absorber_did_absorb_items = MCKUIKitAbsorberDidAbsorbItems;
+}
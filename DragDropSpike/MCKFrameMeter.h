@@ -0,0 +1,35 @@
+//
+//  MCKFrameMeter.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-21.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+/**
+ Measures the frames the app gets to draw, with a CADisplayLink, while it runs.
+
+ A frame interval longer than the display's refresh period means the main
+ thread, or the commit of its changes, missed refreshes. It does not see
+ work done by the render server alone: use Instruments for that.
+ */
+@interface MCKFrameMeter : NSObject
+
+/** Start measuring, unless already running. Measures add up until reset. */
+-(void) start;
+-(void) stop;
+-(void) reset;
+
+@property (readonly, getter=isRunning) BOOL running;
+
+/** Frames seen while running */
+@property (readonly) NSUInteger frameCount;
+/** Display refreshes missed between those frames */
+@property (readonly) NSUInteger droppedFrameCount;
+/** Mean and longest time between two frames, in seconds */
+@property (readonly) NSTimeInterval meanFrameInterval;
+@property (readonly) NSTimeInterval maxFrameInterval;
+
+@end
@@ -0,0 +1,89 @@
+//
+//  MCKFrameMeter.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-21.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <QuartzCore/QuartzCore.h>
+
+#import "MCKFrameMeter.h"
+
+@interface MCKFrameMeter ()
+{
+  // the link retains the meter, until it is invalidated
+  CADisplayLink * link;
+  CFTimeInterval lastTimestamp;
+  NSTimeInterval totalFrameInterval;
+  // intervals summed in totalFrameInterval
+  NSUInteger intervalCount;
+}
+@property (readwrite) NSUInteger frameCount;
+@property (readwrite) NSUInteger droppedFrameCount;
+@property (readwrite) NSTimeInterval maxFrameInterval;
+@end
+
+@implementation MCKFrameMeter
+@synthesize frameCount, droppedFrameCount, maxFrameInterval;
+
+-(void) dealloc
+{
+  [link invalidate];
+}
+
+-(BOOL) isRunning
+{
+  return link != nil;
+}
+
+-(void) start
+{
+  if ( link )
+    return;
+  lastTimestamp = 0;
+  link = [CADisplayLink displayLinkWithTarget:self selector:@selector(displayDidRefresh:)];
+  [link addToRunLoop:[NSRunLoop mainRunLoop] forMode:NSRunLoopCommonModes];
+}
+
+-(void) stop
+{
+  [link invalidate];
+  link = nil;
+}
+
+-(void) reset
+{
+  self.frameCount = 0;
+  self.droppedFrameCount = 0;
+  self.maxFrameInterval = 0;
+  totalFrameInterval = 0;
+  intervalCount = 0;
+  lastTimestamp = 0;
+}
+
+-(NSTimeInterval) meanFrameInterval
+{
+  return intervalCount ? totalFrameInterval / intervalCount : 0;
+}
+
+-(void) displayDidRefresh:(CADisplayLink*)displayLink
+{
+  self.frameCount++;
+  CFTimeInterval timestamp = displayLink.timestamp;
+  if ( lastTimestamp > 0 ) {
+    NSTimeInterval interval = timestamp - lastTimestamp;
+    // the period is only known once the link has fired
+    NSTimeInterval period = displayLink.duration > 0 ? displayLink.duration : 1.0 / 60;
+    totalFrameInterval += interval;
+    intervalCount++;
+    if ( interval > self.maxFrameInterval )
+      self.maxFrameInterval = interval;
+    NSInteger missed = (NSInteger)(interval / period + 0.5) - 1;
+    if ( missed > 0 )
+      self.droppedFrameCount += missed;
+  }
+  lastTimestamp = timestamp;
+}
+
+@end
@@ -0,0 +1,238 @@
+//
+//  MCKMovePipeline.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-22.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKMovePipeline.h"
+#include "MCKSessionTrace.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// finger positions older than this, before the latest, do not count toward its velocity
+#define MCK_VELOCITY_WINDOW 0.1
+// a finger not reported for this long is taken to have stopped
+#define MCK_VELOCITY_STALE 0.05
+#define MCK_DEFAULT_MAX_PREDICTION_DISTANCE 48
+
+/* ---------- Clock ---------- */
+
+static double MCKClockMonotonicNow(void * context)
+{
+  (void)context;
+  return MCKTraceNow();
+}
+
+static double MCKClockManualNow(void * context)
+{
+  return *(double*)context;
+}
+
+MCKClock MCKClockMonotonic(void)
+{
+  MCKClock clock = { MCKClockMonotonicNow, NULL };
+  return clock;
+}
+
+MCKClock MCKClockManual(double * time)
+{
+  MCKClock clock = { MCKClockManualNow, time };
+  return clock;
+}
+
+/* ---------- Pipeline ---------- */
+
+void MCKMovePipelineInit(MCKMovePipeline * pipeline, MCKClock clock, double prediction)
+{
+  memset(pipeline, 0, sizeof(*pipeline));
+  pipeline->clock = clock;
+  pipeline->prediction = prediction;
+  pipeline->max_prediction_distance = MCK_DEFAULT_MAX_PREDICTION_DISTANCE;
+}
+
+void MCKMovePipelineReset(MCKMovePipeline * pipeline)
+{
+  MCKMovePipelineInit(pipeline, pipeline->clock, pipeline->prediction);
+}
+
+/* The i-th sample, oldest first */
+static const MCKMoveSample * MCKMovePipelineSample(const MCKMovePipeline * pipeline, size_t i)
+{
+  return &pipeline->samples[(pipeline->sample_start + i) % MCK_MOVE_SAMPLE_COUNT];
+}
+
+void MCKMovePipelineAddTranslation(MCKMovePipeline * pipeline, double dx, double dy)
+{
+  pipeline->finger_x += dx;
+  pipeline->finger_y += dy;
+  pipeline->translation_count++;
+
+  MCKMoveSample sample = { pipeline->clock.now(pipeline->clock.context), pipeline->finger_x, pipeline->finger_y };
+  if ( pipeline->sample_count < MCK_MOVE_SAMPLE_COUNT )
+    pipeline->samples[pipeline->sample_count++] = sample;
+  else {
+    pipeline->samples[pipeline->sample_start] = sample;
+    pipeline->sample_start = (pipeline->sample_start + 1) % MCK_MOVE_SAMPLE_COUNT;
+  }
+}
+
+void MCKMovePipelineVelocity(const MCKMovePipeline * pipeline, double time, double * vx, double * vy)
+{
+  *vx = *vy = 0;
+  if ( pipeline->sample_count < 2 )
+    return;
+  const MCKMoveSample * latest = MCKMovePipelineSample(pipeline, pipeline->sample_count - 1);
+  if ( time - latest->time > MCK_VELOCITY_STALE )
+    return;
+
+  // least-squares slope of position over time, with time measured from the latest sample
+  double n = 0, st = 0, sx = 0, sy = 0, stt = 0, stx = 0, sty = 0;
+  for (size_t i = 0; i < pipeline->sample_count; ++i) {
+    const MCKMoveSample * sample = MCKMovePipelineSample(pipeline, i);
+    double t = sample->time - latest->time;
+    if ( t < -MCK_VELOCITY_WINDOW )
+      continue;
+    n++;
+    st += t; sx += sample->x; sy += sample->y;
+    stt += t * t; stx += t * sample->x; sty += t * sample->y;
+  }
+  double denominator = n * stt - st * st;
+  if ( n < 2 || denominator <= 0 )
+    return;
+  *vx = (n * stx - st * sx) / denominator;
+  *vy = (n * sty - st * sy) / denominator;
+}
+
+/* Hands out the move from where the view was shown to (x, y), if there is one */
+static bool MCKMovePipelineMoveTo(MCKMovePipeline * pipeline, double x, double y, double * dx, double * dy)
+{
+  *dx = x - pipeline->shown_x;
+  *dy = y - pipeline->shown_y;
+  if ( *dx == 0 && *dy == 0 )
+    return false;
+  pipeline->shown_x = x;
+  pipeline->shown_y = y;
+  pipeline->move_count++;
+  return true;
+}
+
+bool MCKMovePipelineNextFrame(MCKMovePipeline * pipeline, double display_time, double * dx, double * dy)
+{
+  double x = pipeline->finger_x, y = pipeline->finger_y;
+  if ( pipeline->prediction > 0 ) {
+    double vx, vy;
+    MCKMovePipelineVelocity(pipeline, display_time, &vx, &vy);
+    double leadX = vx * pipeline->prediction, leadY = vy * pipeline->prediction;
+    double lead = sqrt(leadX * leadX + leadY * leadY);
+    double scale = lead > pipeline->max_prediction_distance ? pipeline->max_prediction_distance / lead : 1;
+    x += leadX * scale;
+    y += leadY * scale;
+  }
+  return MCKMovePipelineMoveTo(pipeline, x, y, dx, dy);
+}
+
+bool MCKMovePipelineFlush(MCKMovePipeline * pipeline, double * dx, double * dy)
+{
+  return MCKMovePipelineMoveTo(pipeline, pipeline->finger_x, pipeline->finger_y, dx, dy);
+}
+
+/* ---------- Simulation ---------- */
+
+static double MCKSimulationRandom(unsigned * state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return ((*state >> 16) & 0x7fff) / 32767.0;
+}
+
+/* Where the simulated finger is at time */
+static void MCKSimulationFinger(const MCKMoveSimulationSpec * spec, double time, double * x, double * y)
+{
+  double angle = spec->radius > 0 ? spec->speed * time / spec->radius : 0;
+  *x = spec->radius * cos(angle);
+  *y = spec->radius * sin(angle);
+}
+
+static int MCKSimulationCompareDoubles(const void * a, const void * b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+void MCKMovePipelineSimulate(const MCKMoveSimulationSpec * spec, MCKMoveSimulationReport * report)
+{
+  memset(report, 0, sizeof(*report));
+  if ( spec->touch_rate <= 0 || spec->display_rate <= 0 )
+    return;
+  unsigned state = spec->seed;
+  double now = 0;
+  MCKMovePipeline pipeline;
+  MCKMovePipelineInit(&pipeline, MCKClockManual(&now), spec->prediction);
+
+  double touchPeriod = 1 / spec->touch_rate, framePeriod = 1 / spec->display_rate;
+  size_t frameCapacity = (size_t)(spec->duration / framePeriod) + 1;
+  double * errors = malloc(frameCapacity * sizeof(double));
+
+  // the view starts under the finger; positions are offsets from there
+  double startX, startY, reportedX, reportedY, viewX = 0, viewY = 0;
+  MCKSimulationFinger(spec, 0, &startX, &startY);
+  reportedX = startX;
+  reportedY = startY;
+
+  size_t touch = 1, frame = 1;
+  for (;;) {
+    double touchTime = touch * touchPeriod, frameTime = frame * framePeriod;
+    if ( touchTime > spec->duration && frameTime > spec->duration )
+      break;
+
+    if ( touchTime <= frameTime ) {
+      // a touch event, reporting where the finger was touch_latency ago
+      now = touchTime;
+      double x, y;
+      MCKSimulationFinger(spec, touchTime - spec->touch_latency, &x, &y);
+      x += spec->jitter * (2 * MCKSimulationRandom(&state) - 1);
+      y += spec->jitter * (2 * MCKSimulationRandom(&state) - 1);
+      if ( spec->coalesce )
+        MCKMovePipelineAddTranslation(&pipeline, x - reportedX, y - reportedY);
+      else {
+        viewX += x - reportedX;
+        viewY += y - reportedY;
+        report->moves++;
+      }
+      reportedX = x;
+      reportedY = y;
+      report->touches++;
+      touch++;
+      continue;
+    }
+
+    // a refresh: prepare the frame, which is shown at the next one
+    now = frameTime;
+    double shownTime = frameTime + framePeriod;
+    double dx, dy;
+    if ( spec->coalesce && MCKMovePipelineNextFrame(&pipeline, shownTime, &dx, &dy) ) {
+      viewX += dx;
+      viewY += dy;
+      report->moves++;
+    }
+    double fingerX, fingerY;
+    MCKSimulationFinger(spec, shownTime, &fingerX, &fingerY);
+    double ex = startX + viewX - fingerX, ey = startY + viewY - fingerY;
+    errors[report->frames++] = sqrt(ex * ex + ey * ey);
+    frame++;
+  }
+
+  if ( report->frames > 0 ) {
+    double sum = 0;
+    for (size_t i = 0; i < report->frames; ++i)
+      sum += errors[i];
+    qsort(errors, report->frames, sizeof(double), MCKSimulationCompareDoubles);
+    report->mean_error = sum / report->frames;
+    report->p99_error = errors[(size_t)(0.99 * (report->frames - 1) + 0.5)];
+    report->max_error = errors[report->frames - 1];
+  }
+  free(errors);
+}
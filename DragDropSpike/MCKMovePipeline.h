@@ -0,0 +1,154 @@
+//
+//  MCKMovePipeline.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-22.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKMovePipeline_h
+#define MCKMovePipeline_h
+
+/*
+ Turns the translations of a drag's touch events into one move per display
+ refresh, optionally predicting where the finger will be when the frame is
+ shown.
+
+ Touch events can arrive faster than the display refreshes. Moving the
+ dragged view on each of them writes its position several times per frame,
+ and all but the last write are never seen. The pipeline instead adds up the
+ translations it receives, and gives the host one translation to apply per
+ refresh, or none if the finger did not move.
+
+ A frame prepared at a refresh is shown one refresh later, by which time the
+ finger has moved on: the view lags it. With prediction on, the pipeline
+ estimates the finger's velocity from its recent positions, and places the
+ view where the finger should be when the frame is shown. At the drop, the
+ host flushes the pipeline, which takes the view back to the finger's actual
+ position, so the prediction never decides where a view is dropped.
+
+ DESIGN NOTES:
+ Plain C, like MCKDragDropCore, so it can be driven and measured off device.
+ Time comes from an MCKClock: the UIKit host uses the monotonic clock, tests
+ use a clock they advance by hand (see MCKMovePipelineSimulate).
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/* ---------- Clock ---------- */
+
+typedef struct {
+  /** Seconds, never decreasing, from an arbitrary origin */
+  double (*now)(void * context);
+  void * context;
+} MCKClock;
+
+/** The monotonic clock of MCKTraceNow */
+MCKClock MCKClockMonotonic(void);
+
+/** A clock which reads *time, for tests which set the time themselves */
+MCKClock MCKClockManual(double * time);
+
+/* ---------- Pipeline ---------- */
+
+/** Finger positions kept to estimate its velocity */
+#define MCK_MOVE_SAMPLE_COUNT 8
+
+typedef struct {
+  double time;
+  double x, y;
+} MCKMoveSample;
+
+typedef struct {
+  MCKClock clock;
+  /**
+   How far past the finger's last reported position to predict, in seconds:
+   about the time from a touch to the display of the frame it moves. 0 turns
+   prediction off.
+   */
+  double prediction;
+  /** Longest distance a prediction may lead the finger by */
+  double max_prediction_distance;
+
+  // the finger's position, as the sum of the translations received since the reset
+  double finger_x, finger_y;
+  // where the view was last put, from the same origin
+  double shown_x, shown_y;
+  // the finger's latest positions, oldest first from sample_start, in a ring
+  MCKMoveSample samples[MCK_MOVE_SAMPLE_COUNT];
+  size_t sample_start;
+  size_t sample_count;
+
+  size_t translation_count;  // translations received
+  size_t move_count;         // moves handed out
+} MCKMovePipeline;
+
+void MCKMovePipelineInit(MCKMovePipeline * pipeline, MCKClock clock, double prediction);
+
+/** Forgets the finger's motion and the counts, for a new drag */
+void MCKMovePipelineReset(MCKMovePipeline * pipeline);
+
+/** Adds the translation of a touch event, received now */
+void MCKMovePipelineAddTranslation(MCKMovePipeline * pipeline, double dx, double dy);
+
+/**
+ The finger's velocity at time, in points per second, by a least-squares fit
+ over its recent positions. Zero if it has not moved recently.
+ */
+void MCKMovePipelineVelocity(const MCKMovePipeline * pipeline, double time, double * vx, double * vy);
+
+/**
+ The move for a frame shown at display_time: the translation which takes the
+ view from where it was last put to the finger, or, with prediction on, to
+ where the finger is predicted to be. The prediction lapses if the finger
+ has not been reported for a while by display_time.
+
+ @return false if the view is already there, and there is nothing to apply
+ */
+bool MCKMovePipelineNextFrame(MCKMovePipeline * pipeline, double display_time, double * dx, double * dy);
+
+/**
+ The move which takes the view to the finger's actual position, with no
+ prediction. Call it before a drop.
+
+ @return false if the view is already there
+ */
+bool MCKMovePipelineFlush(MCKMovePipeline * pipeline, double * dx, double * dy);
+
+/* ---------- Simulation ---------- */
+
+typedef struct {
+  double touch_rate;        // touch events per second
+  double display_rate;      // refreshes per second
+  double duration;          // seconds of drag
+  double speed;             // finger speed, in points per second, around a circle
+  double radius;            // of the circle
+  double jitter;            // largest error of a touch position, in points
+  double touch_latency;     // seconds from a touch to its event
+  double prediction;        // the pipeline's prediction, in seconds
+  bool coalesce;            // false: apply every touch event as it comes, as before the pipeline
+  unsigned seed;
+} MCKMoveSimulationSpec;
+
+typedef struct {
+  size_t touches;           // touch events delivered
+  size_t moves;             // moves applied to the view
+  size_t frames;            // display refreshes
+  double mean_error;        // distance between the view and the finger when a frame is shown, in points
+  double p99_error;
+  double max_error;
+} MCKMoveSimulationReport;
+
+/**
+ Drags a view along a circle with a simulated finger, under a manual clock,
+ and measures how far the view shown at each refresh is from the finger.
+
+ Touch events come at touch_rate, each reporting the finger's position
+ touch_latency earlier, give or take jitter. At each refresh the frame is
+ prepared, with one pipeline move or with the moves of the touch events
+ received since the last, and shown one refresh later.
+ */
+void MCKMovePipelineSimulate(const MCKMoveSimulationSpec * spec, MCKMoveSimulationReport * report);
+
+#endif
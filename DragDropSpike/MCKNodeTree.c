@@ -0,0 +1,332 @@
+//
+//  MCKNodeTree.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKNodeTree.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* ---------- Nodes ---------- */
+
+MCKNode * MCKNodeCreate(MCKRect frame)
+{
+  MCKNode * node = calloc(1, sizeof(MCKNode));
+  node->transform = MCKTransformIdentity;
+  node->user_interaction_enabled = true;
+  node->alpha = 1;
+  MCKNodeSetFrame(node, frame);
+  return node;
+}
+
+void MCKNodeDestroy(MCKNode * node)
+{
+  if ( !node )
+    return;
+  MCKNodeRemoveFromParent(node);
+  while ( node->child_count > 0 )
+    MCKNodeDestroy(node->children[node->child_count - 1]);
+  free(node->children);
+  free(node);
+}
+
+void MCKNodeRemoveFromParent(MCKNode * node)
+{
+  MCKNode * parent = node->parent;
+  if ( !parent )
+    return;
+  size_t index = MCKNodeIndexInParent(node);
+  memmove(&parent->children[index], &parent->children[index + 1],
+          (parent->child_count - index - 1) * sizeof(MCKNode*));
+  parent->child_count--;
+  node->parent = NULL;
+}
+
+void MCKNodeInsertChild(MCKNode * parent, MCKNode * child, size_t index)
+{
+  MCKNodeRemoveFromParent(child);
+  if ( parent->child_count == parent->child_capacity ) {
+    parent->child_capacity = parent->child_capacity ? 2 * parent->child_capacity : 4;
+    parent->children = realloc(parent->children, parent->child_capacity * sizeof(MCKNode*));
+  }
+  if ( index > parent->child_count )
+    index = parent->child_count;
+  memmove(&parent->children[index + 1], &parent->children[index],
+          (parent->child_count - index) * sizeof(MCKNode*));
+  parent->children[index] = child;
+  parent->child_count++;
+  child->parent = parent;
+}
+
+void MCKNodeAddChild(MCKNode * parent, MCKNode * child)
+{
+  MCKNodeInsertChild(parent, child, MCKIndexEnd);
+}
+
+size_t MCKNodeIndexInParent(const MCKNode * node)
+{
+  const MCKNode * parent = node->parent;
+  if ( !parent )
+    return MCKIndexEnd;
+  for (size_t i = 0; i < parent->child_count; ++i)
+    if ( parent->children[i] == node )
+      return i;
+  return MCKIndexEnd;
+}
+
+MCKNode * MCKNodeRoot(MCKNode * node)
+{
+  while ( node && node->parent )
+    node = node->parent;
+  return node;
+}
+
+bool MCKNodeIsDescendantOf(const MCKNode * node, const MCKNode * ancestor)
+{
+  for ( ; node; node = node->parent)
+    if ( node == ancestor )
+      return true;
+  return false;
+}
+
+/* ---------- Geometry ---------- */
+
+MCKRect MCKNodeGetFrame(const MCKNode * node)
+{
+  MCKRect centered = MCKRectMake(-node->bounds.size.width / 2, -node->bounds.size.height / 2,
+                                 node->bounds.size.width, node->bounds.size.height);
+  MCKRect r = MCKRectApplyTransform(centered, node->transform);
+  r.origin.x += node->center.x;
+  r.origin.y += node->center.y;
+  return r;
+}
+
+// as with UIView, this is only meaningful for an identity transform
+void MCKNodeSetFrame(MCKNode * node, MCKRect frame)
+{
+  node->bounds.size = frame.size;
+  node->center = MCKRectGetMid(frame);
+}
+
+/* converts a point from node's coordinates to its parent's */
+static MCKPoint MCKNodePointToParent(const MCKNode * node, MCKPoint p)
+{
+  MCKPoint mid = MCKRectGetMid(node->bounds);
+  MCKPoint offset = MCKPointApplyTransform(MCKPointMake(p.x - mid.x, p.y - mid.y), node->transform);
+  return MCKPointMake(node->center.x + offset.x, node->center.y + offset.y);
+}
+
+/* converts a point from node's parent's coordinates to node's */
+static MCKPoint MCKNodePointFromParent(const MCKNode * node, MCKPoint p)
+{
+  MCKPoint mid = MCKRectGetMid(node->bounds);
+  MCKPoint offset = MCKPointApplyTransform(MCKPointMake(p.x - node->center.x, p.y - node->center.y),
+                                           MCKTransformInvert(node->transform));
+  return MCKPointMake(mid.x + offset.x, mid.y + offset.y);
+}
+
+static MCKPoint MCKNodePointToRoot(const MCKNode * node, MCKPoint p)
+{
+  // the root is the window: its own coordinates are the root coordinates
+  for ( ; node && node->parent; node = node->parent)
+    p = MCKNodePointToParent(node, p);
+  return p;
+}
+
+static MCKPoint MCKNodePointFromRoot(const MCKNode * node, MCKPoint p)
+{
+  if ( !node || !node->parent )
+    return p;
+  p = MCKNodePointFromRoot(node->parent, p);
+  return MCKNodePointFromParent(node, p);
+}
+
+MCKPoint MCKNodeConvertPoint(MCKPoint point, const MCKNode * from, const MCKNode * to)
+{
+  return MCKNodePointFromRoot(to, MCKNodePointToRoot(from, point));
+}
+
+MCKRect MCKNodeConvertRect(MCKRect r, const MCKNode * from, const MCKNode * to)
+{
+  MCKPoint corners[4] = {
+    MCKNodeConvertPoint(MCKPointMake(r.origin.x, r.origin.y), from, to),
+    MCKNodeConvertPoint(MCKPointMake(r.origin.x + r.size.width, r.origin.y), from, to),
+    MCKNodeConvertPoint(MCKPointMake(r.origin.x, r.origin.y + r.size.height), from, to),
+    MCKNodeConvertPoint(MCKPointMake(r.origin.x + r.size.width, r.origin.y + r.size.height), from, to)
+  };
+  double minX = corners[0].x, maxX = corners[0].x, minY = corners[0].y, maxY = corners[0].y;
+  for (int i = 1; i < 4; ++i) {
+    if ( corners[i].x < minX ) minX = corners[i].x;
+    if ( corners[i].x > maxX ) maxX = corners[i].x;
+    if ( corners[i].y < minY ) minY = corners[i].y;
+    if ( corners[i].y > maxY ) maxY = corners[i].y;
+  }
+  return MCKRectMake(minX, minY, maxX - minX, maxY - minY);
+}
+
+/* ---------- Hit testing ---------- */
+
+/*
+ Walks the subtree at node in hit-test order: front children before back
+ ones, and children before their parent. Returns the first node accepted by
+ the filter, or NULL. point is in node's parent's coordinates.
+ */
+static MCKNode * MCKNodeHitTestFiltered(MCKNode * node, MCKPoint point, bool isRoot,
+                                        const MCKNode * excluded, unsigned requiredRoles)
+{
+  if ( node == excluded || node->hidden || !node->user_interaction_enabled || node->alpha < 0.01 )
+    return NULL;
+  MCKPoint local = isRoot ? point : MCKNodePointFromParent(node, point);
+  if ( !MCKRectContainsPoint(node->bounds, local) )
+    return NULL;
+
+  for (size_t i = node->child_count; i > 0; --i) {
+    MCKNode * hit = MCKNodeHitTestFiltered(node->children[i - 1], local, false, excluded, requiredRoles);
+    if ( hit )
+      return hit;
+  }
+  return (node->roles & requiredRoles) == requiredRoles ? node : NULL;
+}
+
+MCKNode * MCKNodeHitTest(MCKNode * root, MCKPoint point)
+{
+  return MCKNodeHitTestFiltered(root, point, true, NULL, 0);
+}
+
+MCKNode * MCKNodeFirstAbsorberAt(MCKNode * root, MCKPoint point, const MCKNode * excluded)
+{
+  return MCKNodeHitTestFiltered(root, point, true, excluded, MCKDragDropRoleAbsorber);
+}
+
+MCKNode * MCKNodeClosestAncestorWithRole(MCKNode * node, MCKDragDropRole role)
+{
+  for (MCKNode * ancestor = node->parent; ancestor; ancestor = ancestor->parent)
+    if ( ancestor->roles & role )
+      return ancestor;
+  return NULL;
+}
+
+/* ---------- Host ---------- */
+
+static MCKHandle MCKNodeHostParentOf(void * context, MCKHandle view) {
+  (void)context;
+  return ((MCKNode*)view)->parent;
+}
+
+static size_t MCKNodeHostIndexInParent(void * context, MCKHandle view) {
+  (void)context;
+  return MCKNodeIndexInParent(view);
+}
+
+static MCKHandle MCKNodeHostChildAt(void * context, MCKHandle parent, size_t index) {
+  (void)context;
+  MCKNode * node = parent;
+  return index < node->child_count ? node->children[index] : NULL;
+}
+
+static void MCKNodeHostInsertChild(void * context, MCKHandle parent, MCKHandle child, size_t index) {
+  (void)context;
+  MCKNodeInsertChild(parent, child, index);
+}
+
+static MCKRect MCKNodeHostFrameOf(void * context, MCKHandle view) {
+  (void)context;
+  return MCKNodeGetFrame(view);
+}
+
+static void MCKNodeHostSetFrame(void * context, MCKHandle view, MCKRect frame) {
+  (void)context;
+  MCKNodeSetFrame(view, frame);
+}
+
+static MCKPoint MCKNodeHostCenterOf(void * context, MCKHandle view) {
+  (void)context;
+  return ((MCKNode*)view)->center;
+}
+
+static void MCKNodeHostSetCenter(void * context, MCKHandle view, MCKPoint center) {
+  (void)context;
+  ((MCKNode*)view)->center = center;
+}
+
+static MCKRect MCKNodeHostConvertRect(void * context, MCKRect rect, MCKHandle from, MCKHandle to) {
+  (void)context;
+  return MCKNodeConvertRect(rect, from, to);
+}
+
+static MCKHandle MCKNodeHostDragLayerOf(void * context, MCKHandle view) {
+  (void)context;
+  return MCKNodeRoot(view);
+}
+
+static MCKHandle MCKNodeHostDonorOf(void * context, MCKHandle view) {
+  (void)context;
+  return MCKNodeClosestAncestorWithRole(view, MCKDragDropRoleDonor);
+}
+
+static MCKHandle MCKNodeHostAbsorberUnder(void * context, MCKSession * session) {
+  (void)context;
+  MCKNode * lead = session->lead_view;
+  MCKPoint point = MCKNodeConvertPoint(lead->center, lead->parent, NULL);
+  return MCKNodeFirstAbsorberAt(MCKNodeRoot(lead), point, session->float_view ? session->float_view : lead);
+}
+
+static MCKHandle MCKNodeHostCreateGroup(void * context, MCKHandle parent) {
+  (void)context;
+  MCKNode * group = MCKNodeCreate(MCKRectMake(0, 0, ((MCKNode*)parent)->bounds.size.width,
+                                              ((MCKNode*)parent)->bounds.size.height));
+  MCKNodeAddChild(parent, group);
+  return group;
+}
+
+static void MCKNodeHostDestroyGroup(void * context, MCKHandle group) {
+  (void)context;
+  MCKNodeDestroy(group);
+}
+
+// a proxy is a childless node with the view's bounds, over the view
+static MCKHandle MCKNodeHostCreateProxy(void * context, MCKHandle layer, MCKHandle view) {
+  (void)context;
+  MCKNode * node = view;
+  MCKNode * proxy = MCKNodeCreate(node->bounds);
+  proxy->center = MCKNodeConvertPoint(node->center, node->parent, layer);
+  proxy->transform = node->transform;
+  MCKNodeAddChild(layer, proxy);
+  return proxy;
+}
+
+static void MCKNodeHostDestroyProxy(void * context, MCKHandle proxy) {
+  (void)context;
+  MCKNodeDestroy(proxy);
+}
+
+static void MCKNodeHostSetHidden(void * context, MCKHandle view, bool hidden) {
+  (void)context;
+  ((MCKNode*)view)->hidden = hidden;
+}
+
+void MCKNodeTreeHostInit(MCKDragDropHost * host)
+{
+  memset(host, 0, sizeof(*host));
+  host->tree.parent_of = MCKNodeHostParentOf;
+  host->tree.index_in_parent = MCKNodeHostIndexInParent;
+  host->tree.child_at = MCKNodeHostChildAt;
+  host->tree.insert_child = MCKNodeHostInsertChild;
+  host->tree.frame_of = MCKNodeHostFrameOf;
+  host->tree.set_frame = MCKNodeHostSetFrame;
+  host->tree.center_of = MCKNodeHostCenterOf;
+  host->tree.set_center = MCKNodeHostSetCenter;
+  host->tree.convert_rect = MCKNodeHostConvertRect;
+  host->tree.drag_layer_of = MCKNodeHostDragLayerOf;
+  host->tree.donor_of = MCKNodeHostDonorOf;
+  host->tree.absorber_under = MCKNodeHostAbsorberUnder;
+  host->tree.create_group = MCKNodeHostCreateGroup;
+  host->tree.destroy_group = MCKNodeHostDestroyGroup;
+  host->tree.create_proxy = MCKNodeHostCreateProxy;
+  host->tree.destroy_proxy = MCKNodeHostDestroyProxy;
+  host->tree.set_hidden = MCKNodeHostSetHidden;
+}
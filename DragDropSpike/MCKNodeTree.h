@@ -0,0 +1,93 @@
+//
+//  MCKNodeTree.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKNodeTree_h
+#define MCKNodeTree_h
+
+/*
+ A headless stand-in for a UIView hierarchy, and an MCKDragDropHost over it.
+
+ Nodes follow the UIView geometry model: a node has bounds, a center in its
+ parent's coordinates and a transform about its center, and its frame is
+ derived from those. Hit-testing follows the default rules of
+ -[UIView hitTest:withEvent:]. The root node plays the part of the window.
+
+ This lets the DnD session logic in MCKDragDropCore run without UIKit.
+ */
+
+#include "MCKDragDropCore.h"
+
+typedef struct MCKNode MCKNode;
+
+struct MCKNode {
+  MCKNode * parent;
+  MCKNode ** children;      // back to front, like UIView.subviews
+  size_t child_count;
+  size_t child_capacity;
+
+  MCKRect bounds;
+  MCKPoint center;
+  MCKTransform transform;
+  bool hidden;
+  bool user_interaction_enabled;
+  double alpha;
+
+  unsigned roles;           // MCKDragDropRole bits
+  void * user_data;
+};
+
+/* ---------- Nodes ---------- */
+
+/** Creates a node with the given frame, visible and interactive */
+MCKNode * MCKNodeCreate(MCKRect frame);
+/** Destroys node and all its descendants, detaching it from its parent first */
+void MCKNodeDestroy(MCKNode * node);
+
+/** Inserts child at index, or in front if index is MCKIndexEnd, removing it from any previous parent */
+void MCKNodeInsertChild(MCKNode * parent, MCKNode * child, size_t index);
+void MCKNodeAddChild(MCKNode * parent, MCKNode * child);
+void MCKNodeRemoveFromParent(MCKNode * node);
+size_t MCKNodeIndexInParent(const MCKNode * node);
+MCKNode * MCKNodeRoot(MCKNode * node);
+bool MCKNodeIsDescendantOf(const MCKNode * node, const MCKNode * ancestor);
+
+MCKRect MCKNodeGetFrame(const MCKNode * node);
+void MCKNodeSetFrame(MCKNode * node, MCKRect frame);
+
+/** Converts between the coordinates of two nodes. NULL means the root's coordinates. */
+MCKPoint MCKNodeConvertPoint(MCKPoint point, const MCKNode * from, const MCKNode * to);
+MCKRect MCKNodeConvertRect(MCKRect rect, const MCKNode * from, const MCKNode * to);
+
+/** The deepest node at point, in root coordinates, by the rules of -[UIView hitTest:withEvent:] */
+MCKNode * MCKNodeHitTest(MCKNode * root, MCKPoint point);
+
+/**
+ The first absorber at point, in root coordinates, in hit-test order.
+
+ Nodes which are not absorbers never block the search, and excluded and its
+ descendants are skipped. This is the reference definition of the absorber
+ for a drop.
+ */
+MCKNode * MCKNodeFirstAbsorberAt(MCKNode * root, MCKPoint point, const MCKNode * excluded);
+
+/** The closest strict ancestor of node having role, or NULL */
+MCKNode * MCKNodeClosestAncestorWithRole(MCKNode * node, MCKDragDropRole role);
+
+/* ---------- Host ---------- */
+
+/**
+ Fills in host so its tree operations act on MCKNodes. Callbacks, context and
+ flags are left for the caller to set.
+
+ The drag layer is the root of the dragged node's tree, absorbers are found
+ with MCKNodeFirstAbsorberAt, and the reclaim "animation" is instantaneous.
+ A proxy is a childless node with the bounds of the node it stands for.
+ */
+void MCKNodeTreeHostInit(MCKDragDropHost * host);
+
+#endif
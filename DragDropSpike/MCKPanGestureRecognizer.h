@@ -8,6 +8,10 @@
 
 #import <UIKit/UIKit.h>
 
+#import "MCKDragDropCore.h"
+
+@class MCKAbsorberHitRegion;
+
 /*
  A UIPanGestureRecognizer, but with some additional properties that we need 
  to track over the extent of a DnD session.
@@ -31,19 +35,31 @@
  We could attach them using associated object references, but for now it seems 
  simpler to define a custom subclass.
  
+ The session state proper is an MCKSession of the C core. Sessions are pooled
+ by the server, so several views can be dragged, and reclaimed, at once: the
+ GR only points at its session from pickup to drop. It adds what is
+ UIKit-specific: the pickup effect's undo block and the cached absorber answer.
+
+ A GR either drags the view it is attached to, or belongs to a donor and drags
+ whichever draggable descendant of the donor the gesture starts on. The second
+ kind saves one GR per draggable in large scenes, at the cost of allowing only
+ one drag at a time out of each donor.
  */
 
 @interface MCKPanGestureRecognizer : UIPanGestureRecognizer <UIGestureRecognizerDelegate>
 
-// properties attached to the GR, in order to track the DnD session
-@property (assign) CGRect initialViewFrame;
-@property (strong) UIView * initialViewSuperview;
-@property (assign) NSUInteger initialSubviewIndex;
-@property (strong) UIView * donorView;
-@property (strong) dispatch_block_t undoPickupEffectOnView;
+// the DnD session driven by this GR, from pickup to drop. NULL otherwise.
+@property (assign) MCKSession * session;
+
+// YES if the GR is attached to a donor, and drags its draggable descendants
+@property (assign) BOOL sharedByDonor;
+// view being dragged by the current gesture
+@property (strong) UIView * dragView;
 
-// data transported by DnD from donor to absorber
-@property (strong) id<NSObject> payload;
+// last absorber resolved under the dragged view, and where that answer holds
+@property (strong) UIView * cachedAbsorberView;
+@property (strong) MCKAbsorberHitRegion * cachedAbsorberRegion;
+@property (assign) NSUInteger cachedAbsorberGeneration;
 
 // delegate method to let MCKDragDropDonorDelegate cancel certain pickups
 -(BOOL) gestureRecognizerShouldBegin:(UIGestureRecognizer *)gestureRecognizer;
@@ -7,14 +7,20 @@
 //
 
 #import "MCKPanGestureRecognizer.h"
+#import <UIKit/UIGestureRecognizerSubclass.h>
 
 #import "MCKDragDropServer.h"
 #import "MCKDragDropProtocol.h"
 
+@interface MCKPanGestureRecognizer ()
+// view the first touch of the current gesture landed on
+@property (strong) UIView * touchedView;
+@end
+
 @implementation MCKPanGestureRecognizer
-@synthesize initialViewFrame, initialViewSuperview, initialSubviewIndex,donorView;
-@synthesize undoPickupEffectOnView;
-@synthesize payload;
+@synthesize session;
+@synthesize sharedByDonor, dragView, touchedView;
+@synthesize cachedAbsorberView, cachedAbsorberRegion, cachedAbsorberGeneration;
 
 -(id)initWithTarget:(id)target action:(SEL)action {
   self = [super initWithTarget:target action:action];
@@ -24,21 +30,26 @@
   return self;
 }
 
+-(void)touchesBegan:(NSSet *)touches withEvent:(UIEvent *)event {
+  // UIKit already hit-tested the touch, so its view is where the lookup starts
+  if ( self.sharedByDonor && !self.touchedView )
+    self.touchedView = [[touches anyObject] view];
+  [super touchesBegan:touches withEvent:event];
+}
+
+-(void)reset {
+  [super reset];
+  self.touchedView = nil;
+  self.dragView = nil;
+}
+
 -(BOOL)gestureRecognizerShouldBegin:(UIGestureRecognizer *)gestureRecognizer {
-  UIView * dragView = gestureRecognizer.view;
-  self.donorView = [[MCKDragDropServer sharedServer] donorViewOfView:dragView];
-  if (! self.donorView) {
-    PSLogError(@"drag aborted because no donor view was found");
-    return NO;
-  }
-  else {
-    NSObject <MCKDragDropDonorDelegate> * donorDelegate = [[MCKDragDropServer sharedServer] delegateForDonorView:self.donorView];
-    if ( [donorDelegate respondsToSelector:@selector(donorView:shouldBeginDraggingView:)] )
-      return [donorDelegate donorView:self.donorView shouldBeginDraggingView:dragView];
-    else
-      return YES;
-  }
+  MCKDragDropServer * server = [MCKDragDropServer sharedServer];
+  if ( self.sharedByDonor )
+    self.dragView = [server draggableViewOfTouchedView:self.touchedView inDonorView:self.view];
+  else
+    self.dragView = self.view;
+  return self.dragView && [server canBeginDraggingView:self.dragView];
 }
 
 @end
-
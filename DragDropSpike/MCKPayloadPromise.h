@@ -0,0 +1,66 @@
+//
+//  MCKPayloadPromise.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-16.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <Foundation/Foundation.h>
+
+@class MCKPayloadPromise;
+
+/**
+ Builds a payload. It runs on a background queue, at most once, and may give
+ up early, returning nil, once promise.isCancelled is YES.
+ */
+typedef id<NSObject> (^MCKPayloadProvider)(MCKPayloadPromise * promise);
+
+/**
+ A payload which is built only if, and when, a drop may need it.
+
+ A donor delegate returns a promise from -donorView:willBeginDraggingView:
+ when its payload is slow to build. The DnD server then:
+ - starts building it on a background queue when a candidate absorber first
+   appears under the dragged view (with hover tracking on), or at the drop;
+ - cancels it if the drop is rejected or the drag is cancelled;
+ - waits for it to call the absorber callbacks which decide or complete a
+   drop: canAbsorb... and didAbsorb..., which receive the built payload
+   rather than the promise, as they did before promises existed.
+
+ The hover callbacks receive the promise itself as their payload. They
+ should not wait on it, since they run on the main thread during the drag,
+ but may look at -fulfilledPayload.
+
+ DESIGN NOTES:
+ The lock is an NSCondition rather than a dispatch semaphore because dispatch
+ objects are not managed by ARC before iOS 6.
+ */
+@interface MCKPayloadPromise : NSObject
+
++(MCKPayloadPromise*) promiseWithProvider:(MCKPayloadProvider)provider;
+-(id) initWithProvider:(MCKPayloadProvider)provider;
+
+/** Start building the payload on a background queue, unless already started */
+-(void) start;
+
+/**
+ Give up on the payload. A build in progress is not interrupted, but its
+ provider can see isCancelled, and its result is dropped.
+ */
+-(void) cancel;
+@property (readonly, getter=isCancelled) BOOL cancelled;
+
+/** YES once the provider has returned */
+@property (readonly, getter=isFulfilled) BOOL fulfilled;
+
+/** The payload if it is built, or nil. Never waits. */
+@property (readonly) id<NSObject> fulfilledPayload;
+
+/**
+ The payload, waiting for it if need be. If the build has not started, it
+ runs on the calling thread. Returns nil if the promise was cancelled.
+ */
+-(id<NSObject>) payload;
+
+@end
@@ -0,0 +1,121 @@
+//
+//  MCKPayloadPromise.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-16.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKPayloadPromise.h"
+
+@interface MCKPayloadPromise ()
+{
+  // guards every ivar below, and is signalled when the provider returns
+  NSCondition * condition;
+  // released once it has run, with whatever it captured
+  MCKPayloadProvider provider;
+  BOOL started;
+  BOOL cancelled;
+  BOOL fulfilled;
+  id<NSObject> result;
+}
+@end
+
+@implementation MCKPayloadPromise
+
++(MCKPayloadPromise*) promiseWithProvider:(MCKPayloadProvider)provider
+{
+  return [[self alloc] initWithProvider:provider];
+}
+
+-(id) initWithProvider:(MCKPayloadProvider)aProvider
+{
+  self = [super init];
+  if ( self ) {
+    condition = [[NSCondition alloc] init];
+    provider = [aProvider copy];
+  }
+  return self;
+}
+
+/* Claims the right to run the provider, and returns it, or nil if it has already been claimed */
+-(MCKPayloadProvider) takeProvider
+{
+  [condition lock];
+  MCKPayloadProvider taken = started ? nil : provider;
+  started = YES;
+  provider = nil;
+  [condition unlock];
+  return taken;
+}
+
+-(void) runProvider:(MCKPayloadProvider)taken
+{
+  id<NSObject> built = self.isCancelled ? nil : taken(self);
+  [condition lock];
+  result = cancelled ? nil : built;
+  fulfilled = YES;
+  [condition broadcast];
+  [condition unlock];
+}
+
+-(void) start
+{
+  MCKPayloadProvider taken = [self takeProvider];
+  if ( !taken )
+    return;
+  PSLogInfo(@"materializing payload");
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [self runProvider:taken];
+  });
+}
+
+-(void) cancel
+{
+  [condition lock];
+  cancelled = YES;
+  result = nil;
+  // wakes up the callers of -payload, which give up
+  [condition broadcast];
+  [condition unlock];
+}
+
+-(BOOL) isCancelled
+{
+  [condition lock];
+  BOOL value = cancelled;
+  [condition unlock];
+  return value;
+}
+
+-(BOOL) isFulfilled
+{
+  [condition lock];
+  BOOL value = fulfilled;
+  [condition unlock];
+  return value;
+}
+
+-(id<NSObject>) fulfilledPayload
+{
+  [condition lock];
+  id<NSObject> value = result;
+  [condition unlock];
+  return value;
+}
+
+-(id<NSObject>) payload
+{
+  MCKPayloadProvider taken = [self takeProvider];
+  if ( taken )
+    [self runProvider:taken];
+
+  [condition lock];
+  while ( !fulfilled && !cancelled )
+    [condition wait];
+  id<NSObject> value = result;
+  [condition unlock];
+  return value;
+}
+
+@end
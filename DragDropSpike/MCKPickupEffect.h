@@ -0,0 +1,61 @@
+//
+//  MCKPickupEffect.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-21.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/**
+ How a pickup effect's shadow is drawn while the view moves.
+ */
+typedef enum {
+  // the shadow is traced from the layer's content, offscreen, on every frame
+  MCKPickupEffectStrategyLive,
+  // the shadow is filled from a path of the layer's bounds, cached by size.
+  // It follows the bounds, not the content, so suits opaque rectangular views.
+  MCKPickupEffectStrategyShadowPath,
+  // as ShadowPath, and the layer and its shadow are also rendered once into a
+  // bitmap, which is then only moved around. Best with drag proxies, whose
+  // content never changes during the drag.
+  MCKPickupEffectStrategyRasterized
+} MCKPickupEffectStrategy;
+
+@class MCKPickupEffectUndo;
+
+/**
+ The look of picked-up views, as data.
+
+ The DnD server applies its pickupEffect to what floats for a drag, the
+ dragged views or their proxies, and undoes it at the drop. Applying returns
+ an MCKPickupEffectUndo, which holds the old values of what the effect
+ changed but no reference to the views.
+ */
+@interface MCKPickupEffect : NSObject <NSCopying>
+
+/** The look of the DnD system so far: a large soft shadow, a green background, drawn live */
++(MCKPickupEffect*) defaultEffect;
+
+@property (assign) CGSize shadowOffset;
+@property (assign) CGFloat shadowRadius;
+@property (assign) float shadowOpacity;
+/** Background color of picked-up views, or nil to leave it alone */
+@property (strong) UIColor * backgroundColor;
+@property (assign) MCKPickupEffectStrategy strategy;
+
+/** Change the look of views, and return how to change it back */
+-(MCKPickupEffectUndo*) applyToViews:(NSArray*)views;
+
+@end
+
+/**
+ The look of some views before a pickup effect.
+ */
+@interface MCKPickupEffectUndo : NSObject
+
+/** Give views back their old look. views must be those the effect was applied to, in the same order. */
+-(void) restoreViews:(NSArray*)views;
+
+@end
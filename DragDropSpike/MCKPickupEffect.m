@@ -0,0 +1,165 @@
+//
+//  MCKPickupEffect.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-21.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <QuartzCore/QuartzCore.h>
+
+#import "MCKPickupEffect.h"
+
+// shadow paths kept for reuse, at most
+#define MCK_SHADOW_PATH_CACHE_LIMIT 64
+
+/* What an effect may change on one layer. The CF objects are retained. */
+typedef struct {
+  CGSize shadowOffset;
+  CGFloat shadowRadius;
+  float shadowOpacity;
+  CGPathRef shadowPath;
+  CGColorRef backgroundColor;
+  BOOL shouldRasterize;
+  CGFloat rasterizationScale;
+} MCKLayerLook;
+
+@interface MCKPickupEffectUndo ()
+{
+  // one MCKLayerLook per view, or empty once restored
+  NSMutableData * looks;
+}
+-(id) initWithViews:(NSArray*)views;
+@end
+
+@implementation MCKPickupEffectUndo
+
+-(id) initWithViews:(NSArray*)views
+{
+  self = [super init];
+  if ( self ) {
+    looks = [NSMutableData dataWithLength:[views count] * sizeof(MCKLayerLook)];
+    MCKLayerLook * look = [looks mutableBytes];
+    for (UIView * view in views) {
+      CALayer * layer = view.layer;
+      look->shadowOffset = layer.shadowOffset;
+      look->shadowRadius = layer.shadowRadius;
+      look->shadowOpacity = layer.shadowOpacity;
+      look->shadowPath = CGPathRetain(layer.shadowPath);
+      look->backgroundColor = CGColorRetain(layer.backgroundColor);
+      look->shouldRasterize = layer.shouldRasterize;
+      look->rasterizationScale = layer.rasterizationScale;
+      look++;
+    }
+  }
+  return self;
+}
+
+/* Releases the CF objects of the looks not restored, and forgets them */
+-(void) forgetLooks
+{
+  MCKLayerLook * look = [looks mutableBytes];
+  for (NSUInteger i = 0; i < [looks length] / sizeof(MCKLayerLook); ++i) {
+    CGPathRelease(look[i].shadowPath);
+    CGColorRelease(look[i].backgroundColor);
+  }
+  [looks setLength:0];
+}
+
+-(void) restoreViews:(NSArray*)views
+{
+  const MCKLayerLook * look = [looks bytes];
+  NSUInteger count = MIN([views count], [looks length] / sizeof(MCKLayerLook));
+  for (NSUInteger i = 0; i < count; ++i) {
+    UIView * view = [views objectAtIndex:i];
+    CALayer * layer = view.layer;
+    layer.shadowOffset = look[i].shadowOffset;
+    layer.shadowRadius = look[i].shadowRadius;
+    layer.shadowOpacity = look[i].shadowOpacity;
+    layer.shadowPath = look[i].shadowPath;
+    view.backgroundColor = look[i].backgroundColor ? [UIColor colorWithCGColor:look[i].backgroundColor] : nil;
+    layer.shouldRasterize = look[i].shouldRasterize;
+    layer.rasterizationScale = look[i].rasterizationScale;
+  }
+  [self forgetLooks];
+}
+
+-(void) dealloc
+{
+  [self forgetLooks];
+}
+
+@end
+
+
+@implementation MCKPickupEffect
+@synthesize shadowOffset, shadowRadius, shadowOpacity, backgroundColor, strategy;
+
++(MCKPickupEffect*) defaultEffect
+{
+  MCKPickupEffect * effect = [[MCKPickupEffect alloc] init];
+  effect.shadowOffset = CGSizeMake(0, 10);
+  effect.shadowRadius = 25;
+  effect.shadowOpacity = 1.0;
+  effect.backgroundColor = [UIColor greenColor]; // for debugging
+  effect.strategy = MCKPickupEffectStrategyLive;
+  return effect;
+}
+
+-(id) copyWithZone:(NSZone *)zone
+{
+  MCKPickupEffect * copy = [[MCKPickupEffect allocWithZone:zone] init];
+  copy.shadowOffset = self.shadowOffset;
+  copy.shadowRadius = self.shadowRadius;
+  copy.shadowOpacity = self.shadowOpacity;
+  copy.backgroundColor = self.backgroundColor;
+  copy.strategy = self.strategy;
+  return copy;
+}
+
+/*
+ The shadow path of a layer with bounds, shared by all layers of the same
+ bounds. Picked-up views are usually of a handful of sizes, so the cache is
+ simply emptied when it gets too big.
+ */
++(CGPathRef) shadowPathForBounds:(CGRect)bounds
+{
+  static NSMutableDictionary * paths = nil;
+  if ( !paths )
+    paths = [NSMutableDictionary dictionary];
+
+  NSValue * key = [NSValue valueWithCGRect:bounds];
+  UIBezierPath * path = [paths objectForKey:key];
+  if ( !path ) {
+    if ( [paths count] >= MCK_SHADOW_PATH_CACHE_LIMIT )
+      [paths removeAllObjects];
+    path = [UIBezierPath bezierPathWithRect:bounds];
+    [paths setObject:path forKey:key];
+  }
+  return path.CGPath;
+}
+
+-(MCKPickupEffectUndo*) applyToViews:(NSArray*)views
+{
+  PSLogInfo(@"%u views, strategy %d",[views count],self.strategy);
+  MCKPickupEffectUndo * undo = [[MCKPickupEffectUndo alloc] initWithViews:views];
+
+  CGFloat scale = [[UIScreen mainScreen] scale];
+  for (UIView * view in views) {
+    CALayer * layer = view.layer;
+    layer.shadowOffset = self.shadowOffset;
+    layer.shadowRadius = self.shadowRadius;
+    layer.shadowOpacity = self.shadowOpacity;
+    if ( self.backgroundColor )
+      view.backgroundColor = self.backgroundColor;
+    if ( self.strategy != MCKPickupEffectStrategyLive )
+      layer.shadowPath = [MCKPickupEffect shadowPathForBounds:layer.bounds];
+    if ( self.strategy == MCKPickupEffectStrategyRasterized ) {
+      layer.rasterizationScale = scale;
+      layer.shouldRasterize = YES;
+    }
+  }
+  return undo;
+}
+
+@end
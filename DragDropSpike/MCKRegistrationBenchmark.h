@@ -0,0 +1,39 @@
+//
+//  MCKRegistrationBenchmark.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-03.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+/*
+ Compares the two ways a server can give draggables their gesture
+ recognizers, on a device: one recognizer per draggable view, and one
+ recognizer per donor, shared by its draggables (donorsShareRecognizers).
+
+ Each scene is a donor holding a grid of plain draggable views, in a window
+ of its own, registered with a server of its own. For each mode, it measures
+ the time to register the draggables, the memory it took, and the work of a
+ touch-down at random points of the grid.
+
+ DESIGN NOTES:
+ Touches cannot be synthesized, so a touch-down is timed as the part of it
+ which depends on the mode: hit-testing the window, then collecting the
+ recognizers UIKit would consider, on the hit view and its ancestors, or,
+ in shared mode, walking up to the touched draggable as the shared
+ recognizer does when its gesture begins.
+
+ Memory is the growth of the app's resident size over the registration, so
+ it counts the recognizers and the registry entries, not the views.
+ */
+@interface MCKRegistrationBenchmark : NSObject
+
+/**
+ Registers a scene of each of draggableCounts draggables in both modes, and
+ writes a JSON array of one object per scene and mode to the file at path.
+ */
++(void) runWithDraggableCounts:(NSArray*)draggableCounts touches:(NSUInteger)touches toPath:(NSString*)path;
+
+@end
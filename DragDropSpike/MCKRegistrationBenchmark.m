@@ -0,0 +1,125 @@
+//
+//  MCKRegistrationBenchmark.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-03.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKRegistrationBenchmark.h"
+#import "MCKDragDropServer.h"
+#import "MCKPanGestureRecognizer.h"
+#include "MCKTraceReplay.h"
+#include <mach/mach.h>
+
+static size_t MCKResidentSize(void)
+{
+  struct task_basic_info info;
+  mach_msg_type_number_t count = TASK_BASIC_INFO_COUNT;
+  if ( task_info(mach_task_self(), TASK_BASIC_INFO, (task_info_t)&info, &count) != KERN_SUCCESS )
+    return 0;
+  return info.resident_size;
+}
+
+@implementation MCKRegistrationBenchmark
+
++(void) runWithDraggableCount:(NSUInteger)draggableCount
+                       shared:(BOOL)shared
+                      touches:(NSUInteger)touches
+                       toFile:(FILE*)file
+{
+  UIWindow * appWindow = [[UIApplication sharedApplication] keyWindow];
+  UIWindow * window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]];
+  window.rootViewController = [[UIViewController alloc] init];
+  [window makeKeyAndVisible];
+  UIView * rootView = window.rootViewController.view;
+
+  // a square grid of draggables, filling the donor
+  UIView * donor = [[UIView alloc] initWithFrame:rootView.bounds];
+  [rootView addSubview:donor];
+  NSUInteger columns = (NSUInteger)ceil(sqrt(draggableCount));
+  CGSize cell = CGSizeMake(donor.bounds.size.width / columns, donor.bounds.size.height / columns);
+  NSMutableArray * draggables = [NSMutableArray arrayWithCapacity:draggableCount];
+  for (NSUInteger i = 0; i < draggableCount; ++i) {
+    UIView * view = [[UIView alloc] initWithFrame:CGRectMake((i % columns) * cell.width, (i / columns) * cell.height,
+                                                             cell.width, cell.height)];
+    [donor addSubview:view];
+    [draggables addObject:view];
+  }
+
+  MCKDragDropServer * server = [[MCKDragDropServer alloc] init];
+  server.donorsShareRecognizers = shared;
+  size_t residentBefore = MCKResidentSize();
+  double start = MCKTraceNow();
+  @autoreleasepool {
+    [server registerDonorView:donor delegate:nil];
+    [server registerDraggableViews:draggables];
+  }
+  double registrationTime = MCKTraceNow() - start;
+  size_t residentAfter = MCKResidentSize();
+  size_t memory = residentAfter > residentBefore ? residentAfter - residentBefore : 0;
+
+  double * samples = malloc((touches + 1) * sizeof(double));
+  NSUInteger misses = 0;
+  srandom(1);
+  for (NSUInteger n = 0; n < touches; ++n) {
+    CGPoint point = [donor convertPoint:CGPointMake(random() % (long)donor.bounds.size.width,
+                                                    random() % (long)donor.bounds.size.height)
+                                 toView:nil];
+    start = MCKTraceNow();
+    UIView * hitView = [window hitTest:point withEvent:nil];
+    UIView * dragView = nil;
+    if ( shared )
+      dragView = [server draggableViewOfTouchedView:hitView inDonorView:donor];
+    else
+      for (UIView * view = hitView; view && !dragView; view = view.superview)
+        for (UIGestureRecognizer * recognizer in view.gestureRecognizers)
+          if ( [recognizer isKindOfClass:[MCKPanGestureRecognizer class]] ) {
+            dragView = view;
+            break;
+          }
+    samples[n] = MCKTraceNow() - start;
+    if ( dragView.superview != donor )
+      misses++;
+  }
+  MCKLatencySummary touchDown = MCKLatencySummarize(samples, touches);
+
+  fprintf(file, "{\"draggables\":%u,\"mode\":\"%s\",\"registration_s\":%.6f,\"memory_bytes\":%zu,"
+          "\"memory_bytes_per_draggable\":%.1f,\"touches\":%u,",
+          draggableCount, shared ? "shared" : "per_view", registrationTime, memory,
+          (double)memory / draggableCount, touches);
+  MCKLatencySummaryWriteJSON("touch_down", touchDown, file);
+  fprintf(file, ",\"misses\":%u}", misses);
+  PSLogInfo(@"%u draggables, %@: registration %.1f ms, %.1f KB, touch-down p50 %.1f us p99 %.1f us, %u misses",
+            draggableCount, shared ? @"shared" : @"per view", registrationTime * 1e3, memory / 1024.0,
+            touchDown.p50 * 1e6, touchDown.p99 * 1e6, misses);
+
+  free(samples);
+  [donor removeFromSuperview];
+  window.hidden = YES;
+  [appWindow makeKeyWindow];
+}
+
++(void) runWithDraggableCounts:(NSArray*)draggableCounts touches:(NSUInteger)touches toPath:(NSString*)path
+{
+  FILE * file = fopen([path fileSystemRepresentation], "w");
+  if ( !file ) {
+    PSLogError(@"could not write the benchmark results to %@", path);
+    return;
+  }
+
+  fputs("[", file);
+  BOOL first = YES;
+  for (NSNumber * count in draggableCounts) {
+    for (int shared = 0; shared < 2; ++shared) {
+      fputs(first ? "\n" : ",\n", file);
+      first = NO;
+      [self runWithDraggableCount:[count unsignedIntegerValue] shared:shared touches:touches toFile:file];
+      fflush(file);
+    }
+  }
+  fputs("\n]\n", file);
+  fclose(file);
+}
+
+@end
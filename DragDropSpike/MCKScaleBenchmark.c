@@ -0,0 +1,427 @@
+//
+//  MCKScaleBenchmark.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-29.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKScaleBenchmark.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// frames snap to 1/MCK_SCALE_SNAP of a point
+#define MCK_SCALE_SNAP 4
+
+/* ---------- Randomness ---------- */
+
+static unsigned MCKScaleRandom(unsigned * state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return (*state >> 16) & 0x7fff;
+}
+
+/* Uniform in [0, 1) */
+static double MCKScaleRandomUnit(unsigned * state)
+{
+  return MCKScaleRandom(state) / 32768.0;
+}
+
+/* Uniform in [0, count), for counts past the 15 bits of one draw */
+static size_t MCKScaleRandomIndex(unsigned * state, size_t count)
+{
+  size_t high = MCKScaleRandom(state);
+  return ((high << 15) | MCKScaleRandom(state)) % count;
+}
+
+static double MCKScaleSnap(double value)
+{
+  return floor(value * MCK_SCALE_SNAP + 0.5) / MCK_SCALE_SNAP;
+}
+
+/* ---------- Scenes ---------- */
+
+// depth is left for the caller to choose
+const MCKScaleSceneSpec MCKScaleSceneSpecDefault = { 0, 10, 0, 0.5, 0.3, 0.05, 0.2, 1024, 768, 1 };
+
+MCKNode * MCKScaleSceneCreate(const MCKScaleSceneSpec * spec, size_t * view_count)
+{
+  unsigned state = spec->seed;
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, spec->width, spec->height));
+  size_t count = 0;
+
+  // children are laid out in a grid over their parent, as square as it gets
+  size_t columns = 1;
+  while ( columns * columns < spec->fan_out )
+    columns++;
+  size_t rows = (spec->fan_out + columns - 1) / columns;
+
+  // built level by level, so that max_views cuts the last level short
+  MCKNode ** level = malloc(sizeof(MCKNode*));
+  level[0] = root;
+  size_t levelCount = 1;
+  for (size_t depth = 1; depth <= spec->depth && levelCount > 0 && spec->fan_out > 0; ++depth) {
+    bool last = depth == spec->depth;
+    MCKNode ** next = malloc(levelCount * spec->fan_out * sizeof(MCKNode*));
+    size_t nextCount = 0;
+    for (size_t p = 0; p < levelCount; ++p) {
+      MCKNode * parent = level[p];
+      double cellWidth = parent->bounds.size.width / columns;
+      double cellHeight = parent->bounds.size.height / rows;
+      double spillX = spec->overlap * cellWidth;
+      double spillY = spec->overlap * cellHeight;
+      for (size_t i = 0; i < spec->fan_out && (spec->max_views == 0 || count < spec->max_views); ++i) {
+        double x = (i % columns) * cellWidth - spillX / 2 + (MCKScaleRandomUnit(&state) - 0.5) * spillX;
+        double y = (i / columns) * cellHeight - spillY / 2 + (MCKScaleRandomUnit(&state) - 0.5) * spillY;
+        double width = fmax(MCKScaleSnap(cellWidth + spillX), 1.0 / MCK_SCALE_SNAP);
+        double height = fmax(MCKScaleSnap(cellHeight + spillY), 1.0 / MCK_SCALE_SNAP);
+        MCKNode * node = MCKNodeCreate(MCKRectMake(MCKScaleSnap(x), MCKScaleSnap(y), width, height));
+
+        if ( !last && MCKScaleRandomUnit(&state) < spec->donor_density )
+          node->roles |= MCKDragDropRoleDonor;
+        if ( MCKScaleRandomUnit(&state) < spec->absorber_density )
+          node->roles |= MCKDragDropRoleAbsorber;
+        if ( last )
+          node->roles |= MCKDragDropRoleDraggable;
+        if ( MCKScaleRandomUnit(&state) < spec->inert_density ) {
+          if ( MCKScaleRandom(&state) & 1 )
+            node->hidden = true;
+          else
+            node->user_interaction_enabled = false;
+        }
+
+        MCKNodeAddChild(parent, node);
+        next[nextCount++] = node;
+        count++;
+      }
+    }
+    free(level);
+    level = next;
+    levelCount = nextCount;
+  }
+  free(level);
+
+  if ( view_count )
+    *view_count = count;
+  return root;
+}
+
+/* ---------- Reference ---------- */
+
+MCKNode * MCKReferenceDonorOf(MCKNode * node)
+{
+  for (MCKNode * ancestor = node->parent; ancestor; ancestor = ancestor->parent)
+    if ( ancestor->roles & MCKDragDropRoleDonor )
+      return ancestor;
+  return NULL;
+}
+
+/* Whether node, and every node above it, lets a hit-test at point, in root coordinates, through */
+static bool MCKReferenceIsHitTestable(const MCKNode * node, MCKPoint point)
+{
+  for (const MCKNode * v = node; v; v = v->parent) {
+    if ( v->hidden || !v->user_interaction_enabled || v->alpha < 0.01 )
+      return false;
+    if ( !MCKRectContainsPoint(v->bounds, MCKNodeConvertPoint(point, NULL, v)) )
+      return false;
+  }
+  return true;
+}
+
+/* Visits the subtree at node in drawing order, keeping the last absorber hit at point */
+static void MCKReferenceVisit(MCKNode * node, MCKPoint point, const MCKNode * excluded, MCKNode ** found)
+{
+  if ( node == excluded )
+    return;
+  if ( (node->roles & MCKDragDropRoleAbsorber) && MCKReferenceIsHitTestable(node, point) )
+    *found = node;
+  for (size_t i = 0; i < node->child_count; ++i)
+    MCKReferenceVisit(node->children[i], point, excluded, found);
+}
+
+MCKNode * MCKReferenceAbsorberAt(MCKNode * root, MCKPoint point, const MCKNode * excluded)
+{
+  MCKNode * found = NULL;
+  MCKReferenceVisit(root, point, excluded, &found);
+  return found;
+}
+
+/* ---------- Script ---------- */
+
+/* Whether a touch can reach node: neither it nor a node above it is hidden or ignores touches */
+static bool MCKScaleIsTouchable(const MCKNode * node)
+{
+  for ( ; node; node = node->parent)
+    if ( node->hidden || !node->user_interaction_enabled )
+      return false;
+  return true;
+}
+
+/* Appends the touchable nodes of the subtree at node having role to a growable array */
+static void MCKScaleCollectNodes(MCKNode * node, unsigned role, MCKNode *** nodes, size_t * count)
+{
+  if ( (node->roles & role) && MCKScaleIsTouchable(node) ) {
+    // capacity is the next power of two
+    if ( (*count & (*count - 1)) == 0 )
+      *nodes = realloc(*nodes, (*count ? 2 * *count : 1) * sizeof(MCKNode*));
+    (*nodes)[(*count)++] = node;
+  }
+  for (size_t i = 0; i < node->child_count; ++i)
+    MCKScaleCollectNodes(node->children[i], role, nodes, count);
+}
+
+void MCKScaleScriptInit(MCKScaleScript * script, MCKNode * scene, unsigned seed)
+{
+  memset(script, 0, sizeof(*script));
+  // only what a finger could touch is dragged, or aimed at
+  MCKScaleCollectNodes(scene, MCKDragDropRoleDraggable, &script->draggables, &script->draggable_count);
+  MCKScaleCollectNodes(scene, MCKDragDropRoleAbsorber, &script->absorbers, &script->absorber_count);
+  script->root_bounds = scene->bounds;
+  script->drag_state = seed;
+  script->answer_state = ~seed;
+}
+
+void MCKScaleScriptDispose(MCKScaleScript * script)
+{
+  free(script->draggables);
+  free(script->absorbers);
+  memset(script, 0, sizeof(*script));
+}
+
+void MCKScaleScriptNextDrag(MCKScaleScript * script, MCKNode ** drag, MCKPoint * target)
+{
+  unsigned * state = &script->drag_state;
+  *drag = script->draggable_count ? script->draggables[MCKScaleRandomIndex(state, script->draggable_count)] : NULL;
+  if ( script->absorber_count > 0 && MCKScaleRandom(state) % 4 != 0 ) {
+    // absorbers move when they are dragged, so their middle is looked up now
+    MCKNode * absorber = script->absorbers[MCKScaleRandomIndex(state, script->absorber_count)];
+    *target = MCKNodeConvertPoint(MCKRectGetMid(absorber->bounds), absorber, NULL);
+  }
+  else
+    *target = MCKPointMake(MCKScaleSnap(MCKScaleRandomUnit(state) * script->root_bounds.size.width),
+                           MCKScaleSnap(MCKScaleRandomUnit(state) * script->root_bounds.size.height));
+}
+
+bool MCKScaleScriptNextAnswer(MCKScaleScript * script, double acceptance)
+{
+  return MCKScaleRandomUnit(&script->answer_state) < acceptance;
+}
+
+/* ---------- Reports ---------- */
+
+static void MCKScaleCountNodes(const MCKNode * node, MCKScaleReport * report)
+{
+  report->views++;
+  if ( node->roles & MCKDragDropRoleDonor )
+    report->donors++;
+  if ( node->roles & MCKDragDropRoleAbsorber )
+    report->absorbers++;
+  if ( node->roles & MCKDragDropRoleDraggable )
+    report->draggables++;
+  for (size_t i = 0; i < node->child_count; ++i)
+    MCKScaleCountNodes(node->children[i], report);
+}
+
+void MCKScaleReportInit(MCKScaleReport * report, const char * driver, const MCKScaleSceneSpec * spec,
+                        const MCKScaleRunSpec * run, MCKNode * scene)
+{
+  memset(report, 0, sizeof(*report));
+  report->driver = driver;
+  report->scene = *spec;
+  report->run = *run;
+  MCKScaleCountNodes(scene, report);
+  report->views--; // the root is the window
+}
+
+static double MCKScaleSum(const double * samples, size_t count)
+{
+  double sum = 0;
+  for (size_t i = 0; i < count; ++i)
+    sum += samples[i];
+  return sum;
+}
+
+void MCKScaleReportSummarize(MCKScaleReport * report, double * pickups, size_t pickup_count,
+                             double * moves, size_t move_count, double * drops, size_t drop_count)
+{
+  report->session_time = MCKScaleSum(pickups, pickup_count) + MCKScaleSum(moves, move_count)
+                       + MCKScaleSum(drops, drop_count);
+  report->sessions_per_second = report->session_time > 0 ? report->pickups / report->session_time : 0;
+  report->pickup = MCKLatencySummarize(pickups, pickup_count);
+  report->move = MCKLatencySummarize(moves, move_count);
+  report->drop = MCKLatencySummarize(drops, drop_count);
+}
+
+size_t MCKScaleReportMismatches(const MCKScaleReport * report)
+{
+  return report->donor_mismatches + report->hover_mismatches
+       + report->absorber_mismatches + report->placement_mismatches;
+}
+
+void MCKScaleReportWriteJSON(const MCKScaleReport * report, FILE * file)
+{
+  const MCKScaleSceneSpec * scene = &report->scene;
+  const MCKScaleRunSpec * run = &report->run;
+  fprintf(file, "{\"driver\":\"%s\",", report->driver);
+  fprintf(file, "\"scene\":{\"depth\":%zu,\"fan_out\":%zu,\"max_views\":%zu,\"donor_density\":%g,"
+          "\"absorber_density\":%g,\"inert_density\":%g,\"overlap\":%g,\"width\":%g,\"height\":%g,\"seed\":%u},",
+          scene->depth, scene->fan_out, scene->max_views, scene->donor_density,
+          scene->absorber_density, scene->inert_density, scene->overlap, scene->width, scene->height,
+          scene->seed);
+  fprintf(file, "\"run\":{\"drags\":%zu,\"moves\":%zu,\"acceptance\":%g,\"hover_tracking\":%s,"
+          "\"drag_proxies\":%s,\"seed\":%u},",
+          run->drags, run->moves, run->acceptance, run->hover_tracking ? "true" : "false",
+          run->drag_proxies ? "true" : "false", run->seed);
+  fprintf(file, "\"views\":%zu,\"donors\":%zu,\"absorbers\":%zu,\"draggables\":%zu,\"build_s\":%.6f,",
+          report->views, report->donors, report->absorbers, report->draggables, report->build_time);
+  fprintf(file, "\"pickups\":%zu,\"refusals\":%zu,\"accepted\":%zu,\"rejected\":%zu,",
+          report->pickups, report->refusals, report->accepted, report->rejected);
+  fprintf(file, "\"checks\":%zu,\"mismatches\":{\"donor\":%zu,\"hover\":%zu,\"absorber\":%zu,\"placement\":%zu},",
+          report->checks, report->donor_mismatches, report->hover_mismatches,
+          report->absorber_mismatches, report->placement_mismatches);
+  MCKLatencySummaryWriteJSON("pickup", report->pickup, file);
+  fputc(',', file);
+  MCKLatencySummaryWriteJSON("move", report->move, file);
+  fputc(',', file);
+  MCKLatencySummaryWriteJSON("drop", report->drop, file);
+  fprintf(file, ",\"session_s\":%.6f,\"sessions_per_second\":%.1f}",
+          report->session_time, report->sessions_per_second);
+}
+
+/* ---------- Runs ---------- */
+
+const MCKScaleRunSpec MCKScaleRunSpecDefault = { 500, 10, 0.75, true, false, 1 };
+
+typedef struct {
+  MCKScaleScript * script;
+  double acceptance;
+  MCKNode * donor;          // asked for the payload of the last pickup
+  MCKNode * absorber;       // asked about the last drop
+  size_t absorber_asks;
+} MCKScaleRunContext;
+
+static void * MCKScaleDonorWillBegin(void * context, MCKHandle donor, MCKHandle drag)
+{
+  (void)drag;
+  ((MCKScaleRunContext*)context)->donor = donor;
+  return NULL;
+}
+
+static bool MCKScaleAbsorberCanAbsorb(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)drag; (void)payload;
+  MCKScaleRunContext * run = context;
+  run->absorber = absorber;
+  run->absorber_asks++;
+  return MCKScaleScriptNextAnswer(run->script, run->acceptance);
+}
+
+static bool MCKScaleRectsMatch(MCKRect a, MCKRect b)
+{
+  return fabs(a.origin.x - b.origin.x) < 1e-6 && fabs(a.origin.y - b.origin.y) < 1e-6
+      && fabs(a.size.width - b.size.width) < 1e-6 && fabs(a.size.height - b.size.height) < 1e-6;
+}
+
+void MCKScaleBenchmarkRun(MCKNode * scene, const MCKScaleSceneSpec * spec, const MCKScaleRunSpec * run,
+                          MCKScaleReport * report)
+{
+  MCKScaleReportInit(report, "core", spec, run, scene);
+  MCKScaleScript script;
+  MCKScaleScriptInit(&script, scene, run->seed);
+  MCKScaleRunContext context = { &script, run->acceptance, NULL, NULL, 0 };
+
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  host.context = &context;
+  host.callbacks.donor_will_begin = MCKScaleDonorWillBegin;
+  host.callbacks.absorber_can_absorb = MCKScaleAbsorberCanAbsorb;
+  host.hover_tracking_enabled = run->hover_tracking;
+  host.drag_proxies = run->drag_proxies;
+  // sessions come from a pool, as in MCKDragDropServer
+  MCKSession storage[1];
+  MCKSessionPool pool;
+  MCKSessionPoolInit(&pool, &host, storage, 1);
+
+  size_t moves = run->moves ? run->moves : 1;
+  double * pickupSamples = malloc((run->drags + 1) * sizeof(double));
+  double * moveSamples = malloc((run->drags * moves + 1) * sizeof(double));
+  double * dropSamples = malloc((run->drags + 1) * sizeof(double));
+  size_t moveCount = 0, dropCount = 0;
+
+  for (size_t n = 0; n < run->drags && script.draggable_count > 0; ++n) {
+    MCKNode * drag;
+    MCKPoint target;
+    MCKScaleScriptNextDrag(&script, &drag, &target);
+    MCKNode * parent = drag->parent;
+    size_t index = MCKNodeIndexInParent(drag);
+    MCKRect frame = MCKNodeGetFrame(drag);
+    MCKNode * donor = MCKReferenceDonorOf(drag);
+
+    // PICKUP: the donor must be the reference donor, and without one there is no drag
+    context.donor = NULL;
+    double start = MCKTraceNow();
+    MCKSession * session = MCKSessionPoolPickUp(&pool, drag, NULL);
+    double elapsed = MCKTraceNow() - start;
+    report->checks++;
+    if ( (session != NULL) != (donor != NULL) || context.donor != donor )
+      report->donor_mismatches++;
+    if ( !session ) {
+      report->refusals++;
+      continue;
+    }
+    pickupSamples[report->pickups++] = elapsed;
+
+    // MOVES: what follows the finger floats in the root, so its center is in root coordinates
+    MCKNode * lead = session->lead_view;
+    const MCKNode * excluded = session->float_view ? session->float_view : lead;
+    double dx = (target.x - lead->center.x) / moves;
+    double dy = (target.y - lead->center.y) / moves;
+    for (size_t m = 0; m < moves; ++m) {
+      start = MCKTraceNow();
+      MCKSessionMove(session, dx, dy);
+      moveSamples[moveCount++] = MCKTraceNow() - start;
+      if ( run->hover_tracking ) {
+        report->checks++;
+        if ( session->hover_absorber_view != MCKReferenceAbsorberAt(scene, lead->center, excluded) )
+          report->hover_mismatches++;
+      }
+    }
+
+    // DROP: only the reference absorber may be asked, once
+    MCKNode * absorber = MCKReferenceAbsorberAt(scene, lead->center, excluded);
+    context.absorber = NULL;
+    context.absorber_asks = 0;
+    start = MCKTraceNow();
+    MCKDropOutcome outcome = MCKSessionDrop(session);
+    dropSamples[dropCount++] = MCKTraceNow() - start;
+    report->checks++;
+    if ( context.absorber != absorber || context.absorber_asks != (absorber ? 1 : 0) )
+      report->absorber_mismatches++;
+
+    // the view is in the absorber it was offered to, or back where it was:
+    // reclaiming is instantaneous in the headless host
+    bool placed;
+    if ( outcome == MCKDropOutcomeAccepted ) {
+      report->accepted++;
+      placed = context.absorber && drag->parent == context.absorber;
+    }
+    else {
+      report->rejected++;
+      placed = drag->parent == parent && MCKNodeIndexInParent(drag) == index
+            && MCKScaleRectsMatch(MCKNodeGetFrame(drag), frame);
+    }
+    report->checks++;
+    if ( !placed || drag->hidden || pool.active_count != 0 )
+      report->placement_mismatches++;
+  }
+
+  MCKScaleReportSummarize(report, pickupSamples, report->pickups, moveSamples, moveCount,
+                          dropSamples, dropCount);
+  free(pickupSamples);
+  free(moveSamples);
+  free(dropSamples);
+  MCKSessionDispose(&storage[0]);
+  MCKScaleScriptDispose(&script);
+}
@@ -0,0 +1,179 @@
+//
+//  MCKScaleBenchmark.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-29.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKScaleBenchmark_h
+#define MCKScaleBenchmark_h
+
+/*
+ Measures how DnD sessions scale with the size of the scene, and checks every
+ donor and absorber decision they make against a reference.
+
+ A scene is a synthetic tree of nodes: a complete tree of given depth and
+ fan-out, where a share of the nodes are donors, absorbers, or invisible to
+ hit-testing, and where siblings overlap by a given amount. Runs of drags are
+ scripted over it, pickup, moves and drop, with the same script for every
+ driver:
+
+ - MCKScaleBenchmarkRun drives the C core over the scene itself, through the
+   headless host of MCKNodeTree.h. Tools/mckscalebench sweeps it from 100 to
+   100k views, off device.
+ - MCKScaleBenchmarkRunner drives MCKDragDropServer over a UIView mirror of
+   the scene, on a device.
+
+ Both fill in an MCKScaleReport, written out as one JSON object per run with
+ MCKScaleReportWriteJSON, for regression tracking.
+
+ DESIGN NOTES:
+ The reference functions are deliberately naive. The absorber under a point
+ is found by visiting every node and checking each absorber, and the whole
+ chain of its ancestors, against the hit-test rules. Nothing is pruned or
+ cached, so they share no shortcut with MCKNodeFirstAbsorberAt or with
+ MCKAbsorberIndex, and are slow: checking is left out of the timings.
+
+ Frames are snapped to a quarter point. Sums of them are exact in single
+ precision, so the UIKit mirror of a scene hit-tests exactly like the scene,
+ edges included.
+ */
+
+#include <stdio.h>
+
+#include "MCKNodeTree.h"
+#include "MCKTraceReplay.h"
+
+/* ---------- Scenes ---------- */
+
+typedef struct {
+  size_t depth;             // levels below the root
+  size_t fan_out;           // children of every node above the last level
+  size_t max_views;         // stop adding nodes at this many, or 0 for a complete tree
+  double donor_density;     // share of the nodes above the last level which are donors
+  double absorber_density;  // share of the nodes which are absorbers
+  double inert_density;     // share of the nodes hidden, or not interactive, hiding their subtree from hit-tests
+  double overlap;           // how far each node spills over its neighbours, as a share of its width and height
+  double width, height;     // of the root
+  unsigned seed;
+} MCKScaleSceneSpec;
+
+/** Ten children per node, half the inner nodes donors, 30% absorbers, 5% inert, 20% overlap, 1024 by 768 */
+extern const MCKScaleSceneSpec MCKScaleSceneSpecDefault;
+
+/**
+ Builds a scene from spec. The same spec always gives the same scene.
+
+ The root is the window, and is not counted. Nodes of the last level are the
+ draggables: those without a donor above them cannot be picked up, which is
+ a decision too.
+
+ @param view_count if not NULL, set to the number of nodes below the root
+ */
+MCKNode * MCKScaleSceneCreate(const MCKScaleSceneSpec * spec, size_t * view_count);
+
+/* ---------- Reference ---------- */
+
+/** The donor of node: its closest strict ancestor with the donor role, or NULL */
+MCKNode * MCKReferenceDonorOf(MCKNode * node);
+
+/**
+ The absorber a drop at point, in root coordinates, should go to, or NULL.
+
+ Of the absorbers outside excluded's subtree for which every node from the
+ absorber up to the root is visible, interactive, opaque enough and contains
+ point, it is the one drawn last. That is the first one in hit-test order.
+ */
+MCKNode * MCKReferenceAbsorberAt(MCKNode * root, MCKPoint point, const MCKNode * excluded);
+
+/* ---------- Script ---------- */
+
+/**
+ The drags of a run, drawn from a seed, so that every driver makes the same
+ drags over the same scene, in the same order, with the same answers from
+ absorbers.
+ */
+typedef struct {
+  MCKNode ** draggables;
+  size_t draggable_count;
+  MCKNode ** absorbers;
+  size_t absorber_count;
+  MCKRect root_bounds;
+  unsigned drag_state;
+  unsigned answer_state;
+} MCKScaleScript;
+
+void MCKScaleScriptInit(MCKScaleScript * script, MCKNode * scene, unsigned seed);
+void MCKScaleScriptDispose(MCKScaleScript * script);
+
+/**
+ Draws the next drag: the node to pick up, and where to drop it, in root
+ coordinates. Most drops aim at the middle of an absorber, which may be
+ covered; the others land anywhere.
+ */
+void MCKScaleScriptNextDrag(MCKScaleScript * script, MCKNode ** drag, MCKPoint * target);
+
+/** Draws an absorber's answer to a drop, which is yes for a share acceptance of drops */
+bool MCKScaleScriptNextAnswer(MCKScaleScript * script, double acceptance);
+
+/* ---------- Runs ---------- */
+
+typedef struct {
+  size_t drags;
+  size_t moves;             // moves of each drag, from the pickup to the drop point
+  double acceptance;        // share of drops absorbers accept
+  bool hover_tracking;      // resolve, and check, the absorber on every move
+  bool drag_proxies;
+  unsigned seed;
+} MCKScaleRunSpec;
+
+/** 500 drags of 10 moves, 75% of drops accepted, with hover tracking */
+extern const MCKScaleRunSpec MCKScaleRunSpecDefault;
+
+typedef struct {
+  const char * driver;      // "core" or "server"
+  MCKScaleSceneSpec scene;
+  MCKScaleRunSpec run;
+
+  size_t views, donors, absorbers, draggables;
+  double build_time;        // seconds to build the scene, and its mirror if any, set by whoever built them
+
+  size_t pickups;           // drags picked up
+  size_t refusals;          // drags refused for want of a donor
+  size_t accepted, rejected;
+
+  // decisions checked, and those which differed from the reference
+  size_t checks;
+  size_t donor_mismatches;     // donor of a pickup, or whether it was picked up at all
+  size_t hover_mismatches;     // absorber under the dragged view after a move
+  size_t absorber_mismatches;  // absorber asked about a drop
+  size_t placement_mismatches; // where the view ended up after the drop
+
+  MCKLatencySummary pickup, move, drop;
+  double session_time;      // seconds spent in pickups, moves and drops
+  double sessions_per_second;
+} MCKScaleReport;
+
+/** Clears report, and fills in what it describes: the driver, the specs, and the counts of scene's nodes */
+void MCKScaleReportInit(MCKScaleReport * report, const char * driver, const MCKScaleSceneSpec * spec,
+                        const MCKScaleRunSpec * run, MCKNode * scene);
+
+/** Fills in the latencies and throughput of report from the samples of a run, in seconds, sorting them */
+void MCKScaleReportSummarize(MCKScaleReport * report, double * pickups, size_t pickup_count,
+                             double * moves, size_t move_count, double * drops, size_t drop_count);
+
+/** The mismatches of all kinds in report */
+size_t MCKScaleReportMismatches(const MCKScaleReport * report);
+
+/**
+ Runs run's drags over scene with the headless host, checking each decision.
+ scene is left as the drags leave it.
+ */
+void MCKScaleBenchmarkRun(MCKNode * scene, const MCKScaleSceneSpec * spec, const MCKScaleRunSpec * run,
+                          MCKScaleReport * report);
+
+/** Writes report as a single-line JSON object. Times are in microseconds. */
+void MCKScaleReportWriteJSON(const MCKScaleReport * report, FILE * file);
+
+#endif
@@ -0,0 +1,50 @@
+//
+//  MCKScaleBenchmarkRunner.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-29.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import <UIKit/UIKit.h>
+
+#import "MCKDragDropProtocol.h"
+#include "MCKScaleBenchmark.h"
+
+/*
+ Runs the scale benchmark of MCKScaleBenchmark.h through MCKDragDropServer,
+ on a device.
+
+ Each scene is mirrored into a tree of plain UIViews, in a window of its own
+ over the app's, and registered with the shared server, with the runner as
+ the delegate of every donor and absorber. The script's drags are then made
+ with the server's scripted drags, so they take the same path as gestures:
+ registry lookups, the absorber index and its cache, the delegate callbacks.
+ The node tree stays in step with the views, and is what the reference reads.
+
+ DESIGN NOTES:
+ Animations are off during a run, so a rejected drop is reclaimed at once.
+ The run loop still turns between drops, to let the reclaim complete.
+
+ The server's settings are borrowed for the run, and given back after it. Its
+ registry keeps the dead views of a scene until it sweeps them.
+ */
+@interface MCKScaleBenchmarkRunner : NSObject <MCKDragDropDonorDelegate, MCKDragDropAbsorberDelegate>
+
+/** Builds a scene from spec, mirrors it, runs run over it, and tears it all down */
+-(MCKScaleReport) runScene:(MCKScaleSceneSpec)spec run:(MCKScaleRunSpec)run;
+
+/**
+ Runs the scenes of spec from minDepth to maxDepth, and writes their
+ reports to the file at path as a JSON array, as Tools/mckscalebench does.
+ The scenes take the size of the screen.
+
+ @return the number of decisions which differed from the reference
+ */
++(NSUInteger) runScenesFromDepth:(NSUInteger)minDepth
+                         toDepth:(NSUInteger)maxDepth
+                            spec:(MCKScaleSceneSpec)spec
+                             run:(MCKScaleRunSpec)run
+                          toPath:(NSString*)path;
+
+@end
@@ -0,0 +1,318 @@
+//
+//  MCKScaleBenchmarkRunner.m
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-29.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#import "MCKScaleBenchmarkRunner.h"
+#import "MCKDragDropServer.h"
+
+// longest wait for a rejected view to be back, in seconds
+#define MCK_RECLAIM_TIMEOUT 2.0
+
+#define MCK_NODE_VIEW(node) ((__bridge UIView*)(node)->user_data)
+
+static inline CGRect MCKRectToCGRect(MCKRect r) {
+  return CGRectMake(r.origin.x, r.origin.y, r.size.width, r.size.height);
+}
+
+static inline MCKRect MCKRectFromCGRect(CGRect r) {
+  return MCKRectMake(r.origin.x, r.origin.y, r.size.width, r.size.height);
+}
+
+static inline double MCKSnapToQuarter(double value) {
+  return floor(value * 4 + 0.5) / 4;
+}
+
+// to within the rounding of converting a frame to the drag layer and back
+static BOOL MCKFramesMatch(CGRect a, CGRect b) {
+  return fabs(a.origin.x - b.origin.x) < 0.01 && fabs(a.origin.y - b.origin.y) < 0.01
+      && fabs(a.size.width - b.size.width) < 0.01 && fabs(a.size.height - b.size.height) < 0.01;
+}
+
+@interface MCKScaleBenchmarkRunner ()
+// the donor asked for the payload of the last pickup
+@property (weak) UIView * askedDonor;
+// the absorber asked about the last drop, and how many were asked
+@property (weak) UIView * askedAbsorber;
+@property (assign) NSUInteger absorberAskCount;
+// the absorber the dragged view is over, by the hover callbacks
+@property (weak) UIView * hoveredAbsorber;
+@end
+
+@implementation MCKScaleBenchmarkRunner {
+  MCKScaleScript script;
+  double acceptance;
+  // key = a mirror view, value = its node
+  CFMutableDictionaryRef nodesByView;
+}
+@synthesize askedDonor, askedAbsorber, absorberAskCount, hoveredAbsorber;
+
+#pragma mark Mirror
+
+/* Adds a view for each node below node, under node's view, and registers their roles */
+-(void) mirrorChildrenOfNode:(MCKNode*)node
+                  draggables:(NSMutableArray*)draggables
+                      server:(MCKDragDropServer*)server
+{
+  UIView * parentView = MCK_NODE_VIEW(node);
+  for (size_t i = 0; i < node->child_count; ++i) {
+    MCKNode * child = node->children[i];
+    UIView * view = [[UIView alloc] initWithFrame:MCKRectToCGRect(MCKNodeGetFrame(child))];
+    view.hidden = child->hidden;
+    view.userInteractionEnabled = child->user_interaction_enabled;
+    view.alpha = child->alpha;
+    [parentView addSubview:view];
+    child->user_data = (__bridge void*)view;
+    CFDictionarySetValue(nodesByView, (__bridge void*)view, child);
+
+    if ( child->roles & MCKDragDropRoleDraggable )
+      [draggables addObject:view];
+    if ( child->roles & MCKDragDropRoleDonor )
+      [server registerDonorView:view delegate:self];
+    if ( child->roles & MCKDragDropRoleAbsorber )
+      [server registerAbsorberView:view delegate:self];
+    [self mirrorChildrenOfNode:child draggables:draggables server:server];
+  }
+}
+
+-(void) unregisterChildrenOfNode:(MCKNode*)node server:(MCKDragDropServer*)server
+{
+  for (size_t i = 0; i < node->child_count; ++i) {
+    MCKNode * child = node->children[i];
+    if ( child->roles & MCKDragDropRoleDonor )
+      [server unregisterDonorView:MCK_NODE_VIEW(child)];
+    if ( child->roles & MCKDragDropRoleAbsorber )
+      [server unregisterAbsorberView:MCK_NODE_VIEW(child)];
+    [self unregisterChildrenOfNode:child server:server];
+  }
+}
+
+-(MCKNode*) nodeOfView:(UIView*)view
+{
+  return view ? (MCKNode*)CFDictionaryGetValue(nodesByView, (__bridge void*)view) : NULL;
+}
+
+/* Turns the run loop until no session is left, or the timeout */
+-(BOOL) waitForSessionsToEnd:(MCKDragDropServer*)server
+{
+  NSDate * timeout = [NSDate dateWithTimeIntervalSinceNow:MCK_RECLAIM_TIMEOUT];
+  while ( server.activeSessionCount > 0 && [timeout timeIntervalSinceNow] > 0 )
+    [[NSRunLoop currentRunLoop] runMode:NSDefaultRunLoopMode
+                             beforeDate:[NSDate dateWithTimeIntervalSinceNow:0.01]];
+  return server.activeSessionCount == 0;
+}
+
+#pragma mark Runs
+
+-(MCKScaleReport) runScene:(MCKScaleSceneSpec)spec run:(MCKScaleRunSpec)run
+{
+  MCKDragDropServer * server = [MCKDragDropServer sharedServer];
+  UIWindow * appWindow = [[UIApplication sharedApplication] keyWindow];
+
+  // the root view is the drag layer, and the root of the scene
+  double buildStart = MCKTraceNow();
+  UIWindow * window = [[UIWindow alloc] initWithFrame:[[UIScreen mainScreen] bounds]];
+  window.rootViewController = [[UIViewController alloc] init];
+  [window makeKeyAndVisible];
+  UIView * rootView = window.rootViewController.view;
+  spec.width = rootView.bounds.size.width;
+  spec.height = rootView.bounds.size.height;
+  MCKNode * scene = MCKScaleSceneCreate(&spec, NULL);
+  scene->user_data = (__bridge void*)rootView;
+
+  // the scene is never touched, so its views need no recognizer each
+  BOOL sharedRecognizers = server.donorsShareRecognizers;
+  server.donorsShareRecognizers = YES;
+  nodesByView = CFDictionaryCreateMutable(NULL, 0, NULL, NULL);
+  NSMutableArray * draggables = [NSMutableArray array];
+  [self mirrorChildrenOfNode:scene draggables:draggables server:server];
+  [server registerDraggableViews:draggables];
+  server.donorsShareRecognizers = sharedRecognizers;
+  double buildTime = MCKTraceNow() - buildStart;
+
+  BOOL hoverTracking = server.hoverTrackingEnabled;
+  BOOL dragProxies = server.usesDragProxies;
+  server.hoverTrackingEnabled = run.hover_tracking;
+  server.usesDragProxies = run.drag_proxies;
+  BOOL animations = [UIView areAnimationsEnabled];
+  [UIView setAnimationsEnabled:NO];
+
+  MCKScaleReport report;
+  MCKScaleReportInit(&report, "server", &spec, &run, scene);
+  report.build_time = buildTime;
+  MCKScaleScriptInit(&script, scene, run.seed);
+  acceptance = run.acceptance;
+
+  size_t moves = run.moves ? run.moves : 1;
+  double * pickupSamples = malloc((run.drags + 1) * sizeof(double));
+  double * moveSamples = malloc((run.drags * moves + 1) * sizeof(double));
+  double * dropSamples = malloc((run.drags + 1) * sizeof(double));
+  size_t moveCount = 0, dropCount = 0;
+
+  for (size_t n = 0; n < run.drags && script.draggable_count > 0; ++n) {
+    @autoreleasepool {
+      MCKNode * drag;
+      MCKPoint target;
+      MCKScaleScriptNextDrag(&script, &drag, &target);
+      UIView * dragView = MCK_NODE_VIEW(drag);
+      UIView * superview = dragView.superview;
+      NSUInteger index = [superview.subviews indexOfObjectIdenticalTo:dragView];
+      CGRect frame = dragView.frame;
+      MCKNode * donor = MCKReferenceDonorOf(drag);
+
+      // PICKUP: the donor must be the reference donor, and without one there is no drag
+      self.askedDonor = nil;
+      double start = MCKTraceNow();
+      id token = [server beginScriptedDragOfView:dragView];
+      double elapsed = MCKTraceNow() - start;
+      report.checks++;
+      if ( (token != nil) != (donor != NULL) || self.askedDonor != (donor ? MCK_NODE_VIEW(donor) : nil) )
+        report.donor_mismatches++;
+      if ( !token ) {
+        report.refusals++;
+        continue;
+      }
+      pickupSamples[report.pickups++] = elapsed;
+
+      // MOVES: the lead view floats in the root view, or in an overlay over it
+      UIView * leadView = [server leadViewOfScriptedDrag:token];
+      CGPoint center = [rootView convertPoint:leadView.center fromView:leadView.superview];
+      CGPoint step = CGPointMake((target.x - center.x) / moves, (target.y - center.y) / moves);
+      for (size_t m = 0; m < moves; ++m) {
+        start = MCKTraceNow();
+        [server moveScriptedDrag:token byTranslation:step];
+        moveSamples[moveCount++] = MCKTraceNow() - start;
+        if ( run.hover_tracking ) {
+          // in the node tree, the dragged node has not moved, and is left out
+          center = [rootView convertPoint:leadView.center fromView:leadView.superview];
+          MCKNode * expected = MCKReferenceAbsorberAt(scene, MCKPointMake(center.x, center.y), drag);
+          report.checks++;
+          if ( self.hoveredAbsorber != (expected ? MCK_NODE_VIEW(expected) : nil) )
+            report.hover_mismatches++;
+        }
+      }
+
+      // DROP: only the reference absorber may be asked, once
+      center = [rootView convertPoint:leadView.center fromView:leadView.superview];
+      MCKNode * absorber = MCKReferenceAbsorberAt(scene, MCKPointMake(center.x, center.y), drag);
+      self.askedAbsorber = nil;
+      self.absorberAskCount = 0;
+      start = MCKTraceNow();
+      MCKDropOutcome outcome = [server dropScriptedDrag:token];
+      dropSamples[dropCount++] = MCKTraceNow() - start;
+      report.checks++;
+      if ( self.askedAbsorber != (absorber ? MCK_NODE_VIEW(absorber) : nil)
+          || self.absorberAskCount != (absorber ? 1 : 0) )
+        report.absorber_mismatches++;
+
+      // the view is in the absorber it was offered to, or back where it was
+      BOOL settled = [self waitForSessionsToEnd:server];
+      BOOL placed;
+      MCKNode * absorberNode = [self nodeOfView:self.askedAbsorber];
+      if ( outcome == MCKDropOutcomeAccepted ) {
+        report.accepted++;
+        placed = absorberNode && dragView.superview == self.askedAbsorber;
+        if ( placed ) {
+          // the absorber lays the view out on the quarter-point grid, in both trees
+          CGRect dropped = dragView.frame;
+          dropped.origin = CGPointMake(MCKSnapToQuarter(dropped.origin.x), MCKSnapToQuarter(dropped.origin.y));
+          dragView.frame = dropped;
+          [server absorberViewDidMove:dragView];
+          MCKNodeAddChild(absorberNode, drag);
+          MCKNodeSetFrame(drag, MCKRectFromCGRect(dropped));
+        }
+      }
+      else {
+        report.rejected++;
+        placed = dragView.superview == superview
+              && [superview.subviews indexOfObjectIdenticalTo:dragView] == index
+              && MCKFramesMatch(dragView.frame, frame);
+      }
+      report.checks++;
+      if ( !settled || !placed || dragView.hidden )
+        report.placement_mismatches++;
+      self.hoveredAbsorber = nil;
+    }
+  }
+
+  MCKScaleReportSummarize(&report, pickupSamples, report.pickups, moveSamples, moveCount,
+                          dropSamples, dropCount);
+  free(pickupSamples);
+  free(moveSamples);
+  free(dropSamples);
+  MCKScaleScriptDispose(&script);
+
+  [UIView setAnimationsEnabled:animations];
+  server.hoverTrackingEnabled = hoverTracking;
+  server.usesDragProxies = dragProxies;
+  [self unregisterChildrenOfNode:scene server:server];
+  CFRelease(nodesByView);
+  nodesByView = NULL;
+  MCKNodeDestroy(scene);
+  window.hidden = YES;
+  [appWindow makeKeyWindow];
+  return report;
+}
+
++(NSUInteger) runScenesFromDepth:(NSUInteger)minDepth
+                         toDepth:(NSUInteger)maxDepth
+                            spec:(MCKScaleSceneSpec)spec
+                             run:(MCKScaleRunSpec)run
+                          toPath:(NSString*)path
+{
+  FILE * file = fopen([path fileSystemRepresentation], "w");
+  if ( !file ) {
+    PSLogError(@"could not write the benchmark results to %@", path);
+    return 0;
+  }
+
+  NSUInteger mismatches = 0;
+  fputs("[", file);
+  for (NSUInteger depth = minDepth; depth <= maxDepth; ++depth) {
+    spec.depth = depth;
+    MCKScaleReport report = [[[MCKScaleBenchmarkRunner alloc] init] runScene:spec run:run];
+    fputs(depth == minDepth ? "\n" : ",\n", file);
+    MCKScaleReportWriteJSON(&report, file);
+    fflush(file);
+    mismatches += MCKScaleReportMismatches(&report);
+    PSLogInfo(@"%zu views: %zu sessions, move p99 %.1f us, drop p99 %.1f us, %.0f sessions/s, %zu/%zu mismatches",
+              report.views, report.pickups, report.move.p99 * 1e6, report.drop.p99 * 1e6,
+              report.sessions_per_second, MCKScaleReportMismatches(&report), report.checks);
+  }
+  fputs("\n]\n", file);
+  fclose(file);
+  return mismatches;
+}
+
+#pragma mark MCKDragDropDonor delegate
+
+-(id<NSObject>) donorView:(UIView*)donor willBeginDraggingView:(UIView*)draggingSubview
+{
+  self.askedDonor = donor;
+  return nil;
+}
+
+#pragma mark MCKDragDropAbsorber delegate
+
+-(BOOL) absorberView:(UIView*)absorber canAbsorbDraggingView:(UIView*)draggingSubview payload:(id<NSObject>)payload
+{
+  self.askedAbsorber = absorber;
+  self.absorberAskCount++;
+  return MCKScaleScriptNextAnswer(&script, acceptance);
+}
+
+-(void) absorberView:(UIView*)absorber draggingViewDidEnter:(UIView*)draggingSubview payload:(id<NSObject>)payload
+{
+  self.hoveredAbsorber = absorber;
+}
+
+-(void) absorberView:(UIView*)absorber draggingViewDidExit:(UIView*)draggingSubview payload:(id<NSObject>)payload
+{
+  if ( self.hoveredAbsorber == absorber )
+    self.hoveredAbsorber = nil;
+}
+
+@end
@@ -0,0 +1,197 @@
+//
+//  MCKSessionMetrics.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-23.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKSessionMetrics.h"
+#include "MCKSessionTrace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+// slots of the hash of the delegate table, twice its capacity
+#define MCK_METRICS_DELEGATE_SLOTS (2 * MCK_METRICS_DELEGATE_CAPACITY)
+
+struct MCKSessionMetrics {
+  double (*now)(void);
+  MCKHistogram histograms[MCKMetricCount];
+
+  // the delegate table, in the order entries were added
+  MCKDelegateStat delegates[MCK_METRICS_DELEGATE_CAPACITY];
+  size_t delegate_count;
+  // open-addressed hash of (view, metric) to 1 + index in delegates, or 0 if free
+  uint16_t delegate_slots[MCK_METRICS_DELEGATE_SLOTS];
+  uint64_t untracked_count;
+};
+
+/* ---------- Histogram ---------- */
+
+/* The bucket of value: the value itself below two sub-bucket counts, then 16 buckets per power of two */
+static size_t MCKHistogramBucketOf(uint64_t value)
+{
+  if ( value < 2 * MCK_HISTOGRAM_SUB_BUCKET_COUNT )
+    return (size_t)value;
+  int magnitude = 63 - __builtin_clzll(value) - MCK_HISTOGRAM_SUB_BUCKET_BITS;
+  size_t bucket = (size_t)(magnitude + 1) * MCK_HISTOGRAM_SUB_BUCKET_COUNT
+                + (size_t)(value >> magnitude) - MCK_HISTOGRAM_SUB_BUCKET_COUNT;
+  return bucket < MCK_HISTOGRAM_BUCKET_COUNT ? bucket : MCK_HISTOGRAM_BUCKET_COUNT - 1;
+}
+
+/* The largest value of bucket */
+static uint64_t MCKHistogramBucketTop(size_t bucket)
+{
+  if ( bucket < 2 * MCK_HISTOGRAM_SUB_BUCKET_COUNT )
+    return bucket;
+  int magnitude = (int)(bucket / MCK_HISTOGRAM_SUB_BUCKET_COUNT) - 1;
+  uint64_t bottom = (uint64_t)(MCK_HISTOGRAM_SUB_BUCKET_COUNT + bucket % MCK_HISTOGRAM_SUB_BUCKET_COUNT) << magnitude;
+  return bottom + ((uint64_t)1 << magnitude) - 1;
+}
+
+void MCKHistogramReset(MCKHistogram * histogram)
+{
+  memset(histogram, 0, sizeof(*histogram));
+}
+
+void MCKHistogramRecord(MCKHistogram * histogram, uint64_t value)
+{
+  histogram->counts[MCKHistogramBucketOf(value)]++;
+  if ( histogram->count == 0 || value < histogram->min )
+    histogram->min = value;
+  if ( value > histogram->max )
+    histogram->max = value;
+  histogram->count++;
+  histogram->total += value;
+}
+
+uint64_t MCKHistogramValueAtPercentile(const MCKHistogram * histogram, double percentile)
+{
+  if ( histogram->count == 0 )
+    return 0;
+  if ( percentile > 100 )
+    percentile = 100;
+  uint64_t wanted = (uint64_t)(percentile / 100 * histogram->count + 0.5);
+  if ( wanted == 0 )
+    wanted = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < MCK_HISTOGRAM_BUCKET_COUNT; ++i) {
+    seen += histogram->counts[i];
+    if ( seen >= wanted ) {
+      // the last bucket also holds the values past it
+      uint64_t top = i < MCK_HISTOGRAM_BUCKET_COUNT - 1 ? MCKHistogramBucketTop(i) : histogram->max;
+      return top < histogram->max ? top : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+double MCKHistogramMean(const MCKHistogram * histogram)
+{
+  return histogram->count ? (double)histogram->total / histogram->count : 0;
+}
+
+/* ---------- Metrics ---------- */
+
+const char * MCKMetricName(MCKMetric metric)
+{
+  static const char * const names[MCKMetricCount] = {
+    "session", "pickUp", "move", "hitTest", "drop", "reparent", "reclaim",
+    "donorShouldBegin", "donorWillBegin", "donorDidBegin", "donorWillDonate", "donorDidDonate",
+    "donorDidReclaim",
+    "absorberCanAbsorb", "absorberDidAbsorb", "absorberDidEnter", "absorberDidHover", "absorberDidExit"
+  };
+  return metric < MCKMetricCount ? names[metric] : "unknown";
+}
+
+MCKSessionMetrics * MCKSessionMetricsCreate(double (*now)(void))
+{
+  MCKSessionMetrics * metrics = calloc(1, sizeof(MCKSessionMetrics));
+  metrics->now = now ? now : MCKTraceNow;
+  MCKSessionMetricsReset(metrics);
+  return metrics;
+}
+
+void MCKSessionMetricsDestroy(MCKSessionMetrics * metrics)
+{
+  free(metrics);
+}
+
+void MCKSessionMetricsReset(MCKSessionMetrics * metrics)
+{
+  for (size_t i = 0; i < MCKMetricCount; ++i)
+    MCKHistogramReset(&metrics->histograms[i]);
+  metrics->delegate_count = 0;
+  memset(metrics->delegate_slots, 0, sizeof(metrics->delegate_slots));
+  metrics->untracked_count = 0;
+}
+
+double MCKSessionMetricsNow(const MCKSessionMetrics * metrics)
+{
+  return metrics->now();
+}
+
+/* The delegate table entry of view and metric, added if there is room, or NULL */
+static MCKDelegateStat * MCKSessionMetricsDelegateStat(MCKSessionMetrics * metrics, MCKHandle view, MCKMetric metric)
+{
+  uintptr_t key = (uintptr_t)view ^ ((uintptr_t)metric * 0x9E3779B9u);
+  size_t slot = (size_t)((key >> 4) ^ key) % MCK_METRICS_DELEGATE_SLOTS;
+  for (;;) {
+    uint16_t entry = metrics->delegate_slots[slot];
+    if ( entry == 0 )
+      break;
+    MCKDelegateStat * stat = &metrics->delegates[entry - 1];
+    if ( stat->view == view && stat->metric == metric )
+      return stat;
+    slot = (slot + 1) % MCK_METRICS_DELEGATE_SLOTS;
+  }
+  if ( metrics->delegate_count == MCK_METRICS_DELEGATE_CAPACITY )
+    return NULL;
+
+  MCKDelegateStat * stat = &metrics->delegates[metrics->delegate_count++];
+  memset(stat, 0, sizeof(*stat));
+  stat->view = view;
+  stat->metric = metric;
+  metrics->delegate_slots[slot] = (uint16_t)metrics->delegate_count;
+  return stat;
+}
+
+void MCKSessionMetricsRecord(MCKSessionMetrics * metrics, MCKMetric metric, MCKHandle view, double start)
+{
+  double elapsed = metrics->now() - start;
+  uint64_t nanos = elapsed <= 0 ? 0 : (uint64_t)(elapsed * 1e9);
+  MCKHistogramRecord(&metrics->histograms[metric], nanos);
+
+  if ( metric < MCKMetricFirstCallback || !view )
+    return;
+  MCKDelegateStat * stat = MCKSessionMetricsDelegateStat(metrics, view, metric);
+  if ( !stat ) {
+    metrics->untracked_count++;
+    return;
+  }
+  stat->count++;
+  stat->total += nanos;
+  if ( nanos > stat->max )
+    stat->max = nanos;
+}
+
+const MCKHistogram * MCKSessionMetricsHistogram(const MCKSessionMetrics * metrics, MCKMetric metric)
+{
+  return &metrics->histograms[metric];
+}
+
+size_t MCKSessionMetricsDelegateStatCount(const MCKSessionMetrics * metrics)
+{
+  return metrics->delegate_count;
+}
+
+const MCKDelegateStat * MCKSessionMetricsDelegateStatAt(const MCKSessionMetrics * metrics, size_t index)
+{
+  return index < metrics->delegate_count ? &metrics->delegates[index] : NULL;
+}
+
+uint64_t MCKSessionMetricsUntrackedCount(const MCKSessionMetrics * metrics)
+{
+  return metrics->untracked_count;
+}
@@ -0,0 +1,135 @@
+//
+//  MCKSessionMetrics.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-23.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKSessionMetrics_h
+#define MCKSessionMetrics_h
+
+/*
+ Where DnD sessions spend their time: how long each phase of a session, and
+ each delegate callback, takes, as histograms.
+
+ Collecting: set an MCKSessionMetrics as the metrics of an MCKDragDropHost.
+ The session functions of MCKDragDropCore then time themselves, and the
+ callbacks they make, on a monotonic clock. A host without metrics only pays
+ for a NULL test at each timed step.
+
+ Reading: pull the histograms at any time with MCKSessionMetricsHistogram, and
+ the slowest delegates with MCKSessionMetricsDelegateStatAt.
+
+ DESIGN NOTES:
+ Histograms are log-linear, like HdrHistogram: durations in nanoseconds fall
+ in buckets 1/16 of a power of two wide, so any recorded value is known to
+ within about 6%, from 1 ns to about 18 minutes, in a fixed array of counts.
+ Recording is a bit scan and an increment, and never allocates.
+
+ Callbacks are also counted per donor or absorber view, in a small fixed
+ table, so the host can name the delegate behind a slow callback. Views are
+ compared by address and never retained: a host must check that a view it
+ reads from the table is still alive before touching it.
+ */
+
+#include <stdint.h>
+
+#include "MCKDragDropCore.h"
+
+/* ---------- Histogram ---------- */
+
+#define MCK_HISTOGRAM_SUB_BUCKET_BITS 4
+#define MCK_HISTOGRAM_SUB_BUCKET_COUNT (1 << MCK_HISTOGRAM_SUB_BUCKET_BITS)
+/** Enough buckets for values up to 2^40 ns */
+#define MCK_HISTOGRAM_BUCKET_COUNT ((40 - MCK_HISTOGRAM_SUB_BUCKET_BITS + 1) * MCK_HISTOGRAM_SUB_BUCKET_COUNT)
+
+typedef struct {
+  uint32_t counts[MCK_HISTOGRAM_BUCKET_COUNT];
+  uint64_t count;
+  uint64_t total;   // sum of the values, in ns
+  uint64_t min;
+  uint64_t max;
+} MCKHistogram;
+
+void MCKHistogramReset(MCKHistogram * histogram);
+/** Counts a value, in ns. Values past the last bucket count in it. */
+void MCKHistogramRecord(MCKHistogram * histogram, uint64_t value);
+/** The smallest value at or below which percentile% of the recorded values lie, to bucket precision */
+uint64_t MCKHistogramValueAtPercentile(const MCKHistogram * histogram, double percentile);
+double MCKHistogramMean(const MCKHistogram * histogram);
+
+/* ---------- Metrics ---------- */
+
+/**
+ What is timed. Phases include the callbacks made during them. Each callback
+ is timed whether the core makes it in its single-view, _items or _at_index
+ form.
+ */
+typedef enum {
+  MCKMetricSession = 0,           // pickup to end, after the drop or the reclaim has settled
+  MCKMetricPickUp,                // MCKSessionPickUp(Items)
+  MCKMetricMove,                  // MCKSessionMove, with hover tracking
+  MCKMetricHitTest,               // finding the absorber under the drag, and the insertion index
+  MCKMetricDrop,                  // MCKSessionDrop, until it is absorbed or starts reclaiming
+  MCKMetricReparent,              // moving one view into another superview
+  MCKMetricReclaim,               // start of the reclaim to its end, animation included
+
+  MCKMetricDonorShouldBegin,
+  MCKMetricDonorWillBegin,
+  MCKMetricDonorDidBegin,
+  MCKMetricDonorWillDonate,
+  MCKMetricDonorDidDonate,
+  MCKMetricDonorDidReclaim,
+  MCKMetricAbsorberCanAbsorb,
+  MCKMetricAbsorberDidAbsorb,
+  MCKMetricAbsorberDidEnter,
+  MCKMetricAbsorberDidHover,
+  MCKMetricAbsorberDidExit,
+
+  MCKMetricCount
+} MCKMetric;
+
+/** The first callback metric: metrics from here on are counted per view too */
+#define MCKMetricFirstCallback MCKMetricDonorShouldBegin
+
+/** A short name for metric, e.g. "pickUp" or "absorberCanAbsorb" */
+const char * MCKMetricName(MCKMetric metric);
+
+/** Callbacks to one donor or absorber view */
+typedef struct {
+  MCKHandle view;
+  MCKMetric metric;
+  uint64_t count;
+  uint64_t total;   // ns
+  uint64_t max;     // ns
+} MCKDelegateStat;
+
+/** Distinct views and callbacks counted, at most, per MCKSessionMetrics */
+#define MCK_METRICS_DELEGATE_CAPACITY 128
+
+/** @param now clock, in seconds, or NULL for MCKTraceNow */
+MCKSessionMetrics * MCKSessionMetricsCreate(double (*now)(void));
+void MCKSessionMetricsDestroy(MCKSessionMetrics * metrics);
+
+/** Empties the histograms and the delegate table */
+void MCKSessionMetricsReset(MCKSessionMetrics * metrics);
+
+/** The current time of metrics' clock, to pass to MCKSessionMetricsRecord later */
+double MCKSessionMetricsNow(const MCKSessionMetrics * metrics);
+
+/**
+ Counts a duration, from start, a time of metrics' clock, until now. For a
+ callback metric, view is the donor or absorber called about.
+ */
+void MCKSessionMetricsRecord(MCKSessionMetrics * metrics, MCKMetric metric, MCKHandle view, double start);
+
+const MCKHistogram * MCKSessionMetricsHistogram(const MCKSessionMetrics * metrics, MCKMetric metric);
+
+/** Entries in the delegate table */
+size_t MCKSessionMetricsDelegateStatCount(const MCKSessionMetrics * metrics);
+const MCKDelegateStat * MCKSessionMetricsDelegateStatAt(const MCKSessionMetrics * metrics, size_t index);
+/** Callbacks not counted per view because the delegate table was full */
+uint64_t MCKSessionMetricsUntrackedCount(const MCKSessionMetrics * metrics);
+
+#endif
@@ -0,0 +1,247 @@
+//
+//  MCKSessionTrace.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-13.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef __APPLE__
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "MCKSessionTrace.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+#define MCK_TRACE_HEADER_LENGTH 8
+
+struct MCKTraceRecorder {
+  unsigned char * bytes;
+  size_t length;
+  size_t capacity;
+  double (*now)(void);
+  double start;
+};
+
+/* ---------- Clock ---------- */
+
+double MCKTraceNow(void)
+{
+#ifdef __APPLE__
+  static double secondsPerTick;
+  if ( secondsPerTick == 0 ) {
+    mach_timebase_info_data_t info;
+    mach_timebase_info(&info);
+    secondsPerTick = 1e-9 * info.numer / info.denom;
+  }
+  return mach_absolute_time() * secondsPerTick;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + 1e-9 * ts.tv_nsec;
+#endif
+}
+
+/* ---------- Encoding ---------- */
+
+static unsigned char * MCKTraceReserve(MCKTraceRecorder * recorder, size_t count)
+{
+  if ( recorder->length + count > recorder->capacity ) {
+    size_t capacity = recorder->capacity ? 2 * recorder->capacity : 4096;
+    while ( capacity < recorder->length + count )
+      capacity *= 2;
+    recorder->bytes = realloc(recorder->bytes, capacity);
+    recorder->capacity = capacity;
+  }
+  unsigned char * p = recorder->bytes + recorder->length;
+  recorder->length += count;
+  return p;
+}
+
+static unsigned char * MCKPutU16(unsigned char * p, uint16_t v)
+{
+  p[0] = v & 0xff; p[1] = v >> 8;
+  return p + 2;
+}
+
+static unsigned char * MCKPutU32(unsigned char * p, uint32_t v)
+{
+  p[0] = v & 0xff; p[1] = (v >> 8) & 0xff; p[2] = (v >> 16) & 0xff; p[3] = v >> 24;
+  return p + 4;
+}
+
+static unsigned char * MCKPutF32(unsigned char * p, float f)
+{
+  uint32_t v;
+  memcpy(&v, &f, sizeof(v));
+  return MCKPutU32(p, v);
+}
+
+static uint16_t MCKGetU16(const unsigned char * p)
+{
+  return (uint16_t)(p[0] | p[1] << 8);
+}
+
+static uint32_t MCKGetU32(const unsigned char * p)
+{
+  return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static float MCKGetF32(const unsigned char * p)
+{
+  uint32_t v = MCKGetU32(p);
+  float f;
+  memcpy(&f, &v, sizeof(f));
+  return f;
+}
+
+static bool MCKTraceEventHasValue(MCKTraceEventType type)
+{
+  return type == MCKTraceEventOutcome || type == MCKTraceEventInsert;
+}
+
+/* Appends the fixed part of an event and returns where its path goes */
+static unsigned char * MCKTraceBeginEvent(MCKTraceRecorder * recorder, MCKTraceEventType type,
+                                          size_t pathLength, size_t payloadLength)
+{
+  double elapsed = recorder->now() - recorder->start;
+  uint32_t micros = elapsed <= 0 ? 0 : elapsed >= 4294.967295 ? UINT32_MAX : (uint32_t)(elapsed * 1e6);
+
+  unsigned char * p = MCKTraceReserve(recorder, 6 + 2 * pathLength + payloadLength);
+  p[0] = (unsigned char)type;
+  p[1] = (unsigned char)pathLength;
+  return MCKPutU32(p + 2, micros);
+}
+
+/* ---------- Recording ---------- */
+
+MCKTraceRecorder * MCKTraceRecorderCreate(double (*now)(void))
+{
+  MCKTraceRecorder * recorder = calloc(1, sizeof(MCKTraceRecorder));
+  recorder->now = now ? now : MCKTraceNow;
+  MCKTraceRecorderReset(recorder);
+  return recorder;
+}
+
+void MCKTraceRecorderDestroy(MCKTraceRecorder * recorder)
+{
+  if ( !recorder )
+    return;
+  free(recorder->bytes);
+  free(recorder);
+}
+
+void MCKTraceRecorderReset(MCKTraceRecorder * recorder)
+{
+  recorder->length = 0;
+  unsigned char * p = MCKTraceReserve(recorder, MCK_TRACE_HEADER_LENGTH);
+  memcpy(p, "MCKT", 4);
+  MCKPutU32(p + 4, MCK_TRACE_VERSION);
+  recorder->start = recorder->now();
+}
+
+const unsigned char * MCKTraceRecorderBytes(const MCKTraceRecorder * recorder, size_t * length)
+{
+  *length = recorder->length;
+  return recorder->bytes;
+}
+
+void MCKTraceRecordView(MCKTraceRecorder * recorder, const MCKDragDropHost * host,
+                        MCKTraceEventType type, MCKHandle view, int32_t value)
+{
+  // collect the path leaf first
+  uint16_t reversed[MCK_TRACE_MAX_DEPTH];
+  size_t depth = 0;
+  MCKHandle parent;
+  for (MCKHandle v = view; v && (parent = host->tree.parent_of(host->context, v)); v = parent) {
+    if ( depth == MCK_TRACE_MAX_DEPTH ) {
+      depth = 0;
+      break;
+    }
+    reversed[depth++] = (uint16_t)host->tree.index_in_parent(host->context, v);
+  }
+
+  size_t payloadLength = MCKTraceEventHasValue(type) ? 4 : 0;
+  unsigned char * p = MCKTraceBeginEvent(recorder, type, depth, payloadLength);
+  for (size_t i = depth; i > 0; --i)
+    p = MCKPutU16(p, reversed[i - 1]);
+  if ( payloadLength )
+    MCKPutU32(p, (uint32_t)value);
+}
+
+void MCKTraceRecordMove(MCKTraceRecorder * recorder, double dx, double dy)
+{
+  unsigned char * p = MCKTraceBeginEvent(recorder, MCKTraceEventMove, 0, 8);
+  p = MCKPutF32(p, (float)dx);
+  MCKPutF32(p, (float)dy);
+}
+
+void MCKTraceRecordValue(MCKTraceRecorder * recorder, MCKTraceEventType type, int32_t value)
+{
+  size_t payloadLength = MCKTraceEventHasValue(type) ? 4 : 0;
+  unsigned char * p = MCKTraceBeginEvent(recorder, type, 0, payloadLength);
+  if ( payloadLength )
+    MCKPutU32(p, (uint32_t)value);
+}
+
+/* ---------- Reading ---------- */
+
+bool MCKTraceReaderInit(MCKTraceReader * reader, const unsigned char * bytes, size_t length)
+{
+  reader->bytes = bytes;
+  reader->length = length;
+  reader->offset = MCK_TRACE_HEADER_LENGTH;
+  return length >= MCK_TRACE_HEADER_LENGTH
+      && memcmp(bytes, "MCKT", 4) == 0
+      && MCKGetU32(bytes + 4) == MCK_TRACE_VERSION;
+}
+
+bool MCKTraceReaderNext(MCKTraceReader * reader, MCKTraceEvent * event)
+{
+  const unsigned char * p = reader->bytes + reader->offset;
+  size_t remaining = reader->length - reader->offset;
+  if ( remaining < 6 )
+    return false;
+
+  MCKTraceEventType type = p[0];
+  size_t pathLength = p[1];
+  size_t payloadLength = type == MCKTraceEventMove ? 8 : MCKTraceEventHasValue(type) ? 4 : 0;
+  size_t length = 6 + 2 * pathLength + payloadLength;
+  if ( type < MCKTraceEventPickUp || type > MCKTraceEventProxies
+      || pathLength > MCK_TRACE_MAX_DEPTH || remaining < length )
+    return false;
+
+  memset(event, 0, sizeof(*event));
+  event->type = type;
+  event->time = 1e-6 * MCKGetU32(p + 2);
+  event->path_length = (uint8_t)pathLength;
+  p += 6;
+  for (size_t i = 0; i < pathLength; ++i, p += 2)
+    event->path[i] = MCKGetU16(p);
+  if ( type == MCKTraceEventMove ) {
+    event->dx = MCKGetF32(p);
+    event->dy = MCKGetF32(p + 4);
+  }
+  else if ( payloadLength )
+    event->value = (int32_t)MCKGetU32(p);
+
+  reader->offset += length;
+  return true;
+}
+
+bool MCKTraceEventsMatch(const MCKTraceEvent * a, const MCKTraceEvent * b)
+{
+  return a->type == b->type
+      && a->path_length == b->path_length
+      && memcmp(a->path, b->path, a->path_length * sizeof(a->path[0])) == 0
+      && a->dx == b->dx && a->dy == b->dy
+      && a->value == b->value;
+}
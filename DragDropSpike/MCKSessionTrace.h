@@ -0,0 +1,107 @@
+//
+//  MCKSessionTrace.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-13.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKSessionTrace_h
+#define MCKSessionTrace_h
+
+/*
+ A compact binary record of DnD sessions: the pan events the session received,
+ the decisions it took, and the changes it made to the view hierarchy.
+
+ Recording: set an MCKTraceRecorder as the recorder of an MCKDragDropHost.
+ The session functions of MCKDragDropCore then append to it as they run.
+
+ Replaying: see MCKTraceReplay.h, which drives a headless MCKNodeTree from a
+ trace and checks that it takes the same decisions.
+
+ DESIGN NOTES:
+ Views are recorded as index paths from the root of their tree (the window,
+ for UIKit), built with the host's parent_of and index_in_parent. A path
+ means the same view in any tree of the same shape, so a trace captured on a
+ device can be replayed against a synthetic copy of the scene.
+
+ Format, all integers little-endian:
+   header:  "MCKT", uint32 version
+   event:   uint8 type, uint8 path length, uint32 time in microseconds since
+            recording began, uint16 path[path length], then
+            two float32 (dx, dy) for a move, or one int32 value for an event
+            type which carries one
+ */
+
+#include <stdint.h>
+
+#include "MCKDragDropCore.h"
+
+#define MCK_TRACE_VERSION 3
+/** Views nested deeper than this are recorded with an empty path */
+#define MCK_TRACE_MAX_DEPTH 64
+
+typedef enum {
+  MCKTraceEventPickUp = 1,  // path: the dragged view
+  MCKTraceEventMove,        // dx, dy
+  MCKTraceEventDrop,
+  MCKTraceEventDonor,       // path: donor found at pickup
+  MCKTraceEventHover,       // path: new hover absorber, empty when it left all absorbers
+  MCKTraceEventAbsorber,    // path: absorber of the drop, empty if there was none
+  MCKTraceEventOutcome,     // value: the MCKDropOutcome
+  MCKTraceEventInsert,      // path: new superview of the dragged view, value: index or -1 for the end
+  MCKTraceEventCompanion,   // path: a view to pick up along with the next PickUp's view
+  MCKTraceEventProxies      // the next PickUp drags proxies of its views
+} MCKTraceEventType;
+
+typedef struct {
+  MCKTraceEventType type;
+  double time;              // seconds since recording began
+  uint8_t path_length;
+  uint16_t path[MCK_TRACE_MAX_DEPTH];
+  float dx, dy;
+  int32_t value;
+} MCKTraceEvent;
+
+/* ---------- Recording ---------- */
+
+/**
+ Seconds on a monotonic clock, with an arbitrary origin. The default clock of
+ a recorder, and the one used to measure latencies.
+ */
+double MCKTraceNow(void);
+
+/** @param now clock for event times, or NULL for MCKTraceNow */
+MCKTraceRecorder * MCKTraceRecorderCreate(double (*now)(void));
+void MCKTraceRecorderDestroy(MCKTraceRecorder * recorder);
+
+/** Discards all events, and restarts the clock */
+void MCKTraceRecorderReset(MCKTraceRecorder * recorder);
+
+/** The encoded trace, valid until the next change to recorder */
+const unsigned char * MCKTraceRecorderBytes(const MCKTraceRecorder * recorder, size_t * length);
+
+/** Appends an event about view, which may be NULL for an empty path */
+void MCKTraceRecordView(MCKTraceRecorder * recorder, const MCKDragDropHost * host,
+                        MCKTraceEventType type, MCKHandle view, int32_t value);
+void MCKTraceRecordMove(MCKTraceRecorder * recorder, double dx, double dy);
+void MCKTraceRecordValue(MCKTraceRecorder * recorder, MCKTraceEventType type, int32_t value);
+
+/* ---------- Reading ---------- */
+
+typedef struct {
+  const unsigned char * bytes;
+  size_t length;
+  size_t offset;
+} MCKTraceReader;
+
+/** @return false if bytes do not start with a trace header of a known version */
+bool MCKTraceReaderInit(MCKTraceReader * reader, const unsigned char * bytes, size_t length);
+
+/** @return false at the end of the trace, or if the rest of it is truncated or corrupt */
+bool MCKTraceReaderNext(MCKTraceReader * reader, MCKTraceEvent * event);
+
+/** True if the events are equal, ignoring their times */
+bool MCKTraceEventsMatch(const MCKTraceEvent * a, const MCKTraceEvent * b);
+
+#endif
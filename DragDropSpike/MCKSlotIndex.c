@@ -0,0 +1,208 @@
+//
+//  MCKSlotIndex.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-20.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKSlotIndex.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+void MCKSlotIndexInit(MCKSlotIndex * index, MCKSlotAxis axis)
+{
+  memset(index, 0, sizeof(*index));
+  index->axis = axis;
+}
+
+void MCKSlotIndexDispose(MCKSlotIndex * index)
+{
+  free(index->slots);
+  MCKSlotIndexInit(index, index->axis);
+}
+
+void MCKSlotIndexRemoveAll(MCKSlotIndex * index)
+{
+  index->count = 0;
+  index->columns = 0;
+  index->origin = MCKPointMake(0, 0);
+  index->spacing = 0;
+}
+
+static void MCKSlotIndexReserve(MCKSlotIndex * index, size_t count)
+{
+  if ( count <= index->capacity )
+    return;
+  size_t capacity = index->capacity ? 2 * index->capacity : 64;
+  while ( capacity < count )
+    capacity *= 2;
+  index->slots = realloc(index->slots, capacity * sizeof(MCKRect));
+  index->capacity = capacity;
+}
+
+/* Start and extent of a list slot along the axis */
+static double MCKSlotStart(MCKSlotAxis axis, MCKRect slot)
+{
+  return axis == MCKSlotAxisHorizontal ? slot.origin.x : slot.origin.y;
+}
+
+static double MCKSlotExtent(MCKSlotAxis axis, MCKRect slot)
+{
+  return axis == MCKSlotAxisHorizontal ? slot.size.width : slot.size.height;
+}
+
+void MCKSlotIndexAppend(MCKSlotIndex * index, MCKRect frame)
+{
+  if ( index->count == 0 )
+    index->origin = frame.origin;
+  else {
+    // the first slot whose middle is below the first row starts the second row
+    if ( index->axis == MCKSlotAxisGrid && index->columns == 0
+        && MCKRectGetMid(frame).y >= index->slots[0].origin.y + index->slots[0].size.height )
+      index->columns = index->count;
+    if ( index->count == 1 && index->columns == 0 ) {
+      MCKSlotAxis along = index->axis == MCKSlotAxisGrid ? MCKSlotAxisHorizontal : index->axis;
+      index->spacing = MCKSlotStart(along, frame) - MCKSlotStart(along, index->slots[0])
+                       - MCKSlotExtent(along, index->slots[0]);
+    }
+  }
+
+  MCKSlotIndexReserve(index, index->count + 1);
+  index->slots[index->count++] = frame;
+}
+
+/* Position along the axis of a list, and the same for a slot's middle */
+static double MCKSlotAlong(MCKSlotAxis axis, MCKPoint point)
+{
+  return axis == MCKSlotAxisHorizontal ? point.x : point.y;
+}
+
+/* The first slot in [start, end) whose middle along x (grid) or the axis (list) is past value */
+static size_t MCKSlotIndexLowerBound(const MCKSlotIndex * index, size_t start, size_t end, double value,
+                                     bool alongX)
+{
+  while ( start < end ) {
+    size_t mid = start + (end - start) / 2;
+    MCKPoint middle = MCKRectGetMid(index->slots[mid]);
+    if ( (alongX ? middle.x : MCKSlotAlong(index->axis, middle)) > value )
+      end = mid;
+    else
+      start = mid + 1;
+  }
+  return start;
+}
+
+/* Slots per row of a grid. A grid with a single row is as long as it needs to be. */
+static size_t MCKSlotIndexColumns(const MCKSlotIndex * index)
+{
+  return index->columns ? index->columns : index->count;
+}
+
+size_t MCKSlotIndexInsertionIndex(const MCKSlotIndex * index, MCKPoint point)
+{
+  if ( index->count == 0 )
+    return 0;
+  if ( index->axis != MCKSlotAxisGrid )
+    return MCKSlotIndexLowerBound(index, 0, index->count, MCKSlotAlong(index->axis, point), false);
+
+  // the row is the one whose band, halfway to the rows around it, holds point
+  size_t columns = MCKSlotIndexColumns(index);
+  size_t rows = (index->count + columns - 1) / columns;
+  size_t low = 0, high = rows - 1;
+  while ( low < high ) {
+    size_t row = low + (high - low) / 2;
+    double boundary = (MCKRectGetMid(index->slots[row * columns]).y
+                       + MCKRectGetMid(index->slots[(row + 1) * columns]).y) / 2;
+    if ( point.y < boundary )
+      high = row;
+    else
+      low = row + 1;
+  }
+  size_t start = low * columns;
+  size_t end = start + columns < index->count ? start + columns : index->count;
+  return MCKSlotIndexLowerBound(index, start, end, point.x, true);
+}
+
+/* Moves a list slot by delta along the axis */
+static void MCKSlotIndexShiftSlot(MCKSlotAxis axis, MCKRect * slot, double delta)
+{
+  if ( axis == MCKSlotAxisHorizontal )
+    slot->origin.x += delta;
+  else
+    slot->origin.y += delta;
+}
+
+/* Moves the list slots from position on by delta along the axis */
+static void MCKSlotIndexShift(MCKSlotIndex * index, size_t position, double delta)
+{
+  for (size_t i = position; i < index->count; ++i)
+    MCKSlotIndexShiftSlot(index->axis, &index->slots[i], delta);
+}
+
+/* The frame of the grid cell after the last one */
+static MCKRect MCKSlotIndexNextCell(const MCKSlotIndex * index, MCKSize size)
+{
+  size_t n = index->count;
+  if ( n == 0 )
+    return MCKRectMake(index->origin.x, index->origin.y, size.width, size.height);
+  const MCKRect * first = &index->slots[0];
+  size_t columns = index->columns;
+  if ( n < columns || columns == 0 ) {
+    const MCKRect * last = &index->slots[n - 1];
+    return MCKRectMake(last->origin.x + last->size.width + index->spacing, first->origin.y, size.width, size.height);
+  }
+  double rowPitch = n > columns ? index->slots[columns].origin.y - first->origin.y : first->size.height;
+  const MCKRect * column = &index->slots[n % columns];
+  return MCKRectMake(column->origin.x, first->origin.y + (n / columns) * rowPitch,
+                     column->size.width, column->size.height);
+}
+
+void MCKSlotIndexInsert(MCKSlotIndex * index, size_t position, MCKSize size)
+{
+  if ( position > index->count )
+    position = index->count;
+
+  if ( index->axis == MCKSlotAxisGrid ) {
+    MCKRect cell = MCKSlotIndexNextCell(index, size);
+    MCKSlotIndexReserve(index, index->count + 1);
+    index->slots[index->count++] = cell;
+    return;
+  }
+
+  // the new slot starts where the one it displaces started, or after the
+  // last and the spacing, or where the first slot was
+  MCKRect slot;
+  if ( position < index->count )
+    slot = index->slots[position];
+  else if ( index->count > 0 ) {
+    slot = index->slots[index->count - 1];
+    MCKSlotIndexShiftSlot(index->axis, &slot, MCKSlotExtent(index->axis, slot) + index->spacing);
+  }
+  else
+    slot = MCKRectMake(index->origin.x, index->origin.y, 0, 0);
+  slot.size = size;
+
+  MCKSlotIndexReserve(index, index->count + 1);
+  memmove(&index->slots[position + 1], &index->slots[position], (index->count - position) * sizeof(MCKRect));
+  index->slots[position] = slot;
+  index->count++;
+  MCKSlotIndexShift(index, position + 1, MCKSlotExtent(index->axis, slot) + index->spacing);
+}
+
+void MCKSlotIndexRemove(MCKSlotIndex * index, size_t position)
+{
+  if ( position >= index->count )
+    return;
+
+  if ( index->axis == MCKSlotAxisGrid ) {
+    index->count--;
+    return;
+  }
+
+  MCKRect slot = index->slots[position];
+  memmove(&index->slots[position], &index->slots[position + 1], (index->count - position - 1) * sizeof(MCKRect));
+  index->count--;
+  MCKSlotIndexShift(index, position, -(MCKSlotExtent(index->axis, slot) + index->spacing));
+}
@@ -0,0 +1,74 @@
+//
+//  MCKSlotIndex.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-20.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKSlotIndex_h
+#define MCKSlotIndex_h
+
+/*
+ The slots of an ordered container, for finding where a dropped view goes.
+
+ An ordered container lays its children out in order along an axis: a column
+ (vertical), a row (horizontal), or a grid filled row by row. The index keeps
+ the frame of each slot, in child order, and answers "at which child index
+ would a view dropped at this point go" by binary search.
+
+ DESIGN NOTES:
+ Inserting or removing a slot keeps the index in step with the reflow the
+ container is expected to do, without asking the host for every frame again:
+ - in a column or a row, the slots after it move by its extent along the
+   axis, plus the spacing between the first two slots appended;
+ - in a grid, cells stay where they are, and one is added or removed at the
+   end, in the column it takes, or after the last cell of a partial first
+   row.
+ The origin of the first slot appended is kept, so a slot inserted once all
+ of them were removed goes where the first one was.
+ Insertion and removal move the following frames in memory, which is linear
+ but a single pass over a flat array. Queries are logarithmic. If the
+ container lays out differently, the host rebuilds the index from the actual
+ frames after each layout.
+ */
+
+#include "MCKDragDropCore.h"
+
+typedef enum {
+  MCKSlotAxisVertical,
+  MCKSlotAxisHorizontal,
+  MCKSlotAxisGrid
+} MCKSlotAxis;
+
+typedef struct {
+  MCKSlotAxis axis;
+  MCKRect * slots;        // frame of each slot, in child order, in the container's coordinates
+  size_t count;
+  size_t capacity;
+  size_t columns;         // grid only: slots in the first row, 0 until known
+  MCKPoint origin;        // of the first slot appended
+  double spacing;         // gap between the first two slots appended, along the axis, or across a grid's first row
+} MCKSlotIndex;
+
+void MCKSlotIndexInit(MCKSlotIndex * index, MCKSlotAxis axis);
+void MCKSlotIndexDispose(MCKSlotIndex * index);
+
+/** Empties the index, to rebuild it with MCKSlotIndexAppend */
+void MCKSlotIndexRemoveAll(MCKSlotIndex * index);
+/** Adds a slot after the last, with its actual frame */
+void MCKSlotIndexAppend(MCKSlotIndex * index, MCKRect frame);
+
+/**
+ The child index at which a view dropped at point goes: before the first slot
+ whose middle is past point along the axis, in reading order for a grid.
+ Ranges from 0 to count.
+ */
+size_t MCKSlotIndexInsertionIndex(const MCKSlotIndex * index, MCKPoint point);
+
+/** A child of the given size was inserted at position: reflow the slots */
+void MCKSlotIndexInsert(MCKSlotIndex * index, size_t position, MCKSize size);
+/** The child at position was removed: reflow the slots */
+void MCKSlotIndexRemove(MCKSlotIndex * index, size_t position);
+
+#endif
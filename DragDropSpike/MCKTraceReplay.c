@@ -0,0 +1,317 @@
+//
+//  MCKTraceReplay.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-13.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTraceReplay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define MCK_SCENE_WIDTH 1024
+#define MCK_ITEM_SIZE 56
+#define MCK_ITEMS_PER_ROW 8
+#define MCK_ABSORBER_SIZE 120
+#define MCK_ABSORBERS_PER_ROW 4
+#define MCK_ABSORBER_INSET 8
+
+/* ---------- Synthetic scenes ---------- */
+
+static unsigned MCKRandom(unsigned * state)
+{
+  *state = *state * 1103515245u + 12345u;
+  return (*state >> 16) & 0x7fff;
+}
+
+static double MCKRandomBetween(unsigned * state, double low, double high)
+{
+  return low + (high - low) * MCKRandom(state) / 32767.0;
+}
+
+MCKNode * MCKSyntheticSceneCreate(const MCKSyntheticSceneSpec * spec)
+{
+  unsigned state = spec->seed;
+  size_t itemRows = (spec->items_per_donor + MCK_ITEMS_PER_ROW - 1) / MCK_ITEMS_PER_ROW;
+  double donorHeight = itemRows * (MCK_ITEM_SIZE + 4) + 4;
+  size_t absorberRows = (spec->absorbers + MCK_ABSORBERS_PER_ROW - 1) / MCK_ABSORBERS_PER_ROW;
+  double absorbersHeight = absorberRows * (MCK_ABSORBER_SIZE + 8);
+  double donorsHeight = spec->donors * (donorHeight + 8);
+
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, MCK_SCENE_WIDTH,
+                                             donorsHeight > absorbersHeight ? donorsHeight : absorbersHeight));
+
+  for (size_t d = 0; d < spec->donors; ++d) {
+    MCKNode * donor = MCKNodeCreate(MCKRectMake(0, d * (donorHeight + 8), 480, donorHeight));
+    donor->roles = MCKDragDropRoleDonor;
+    MCKNodeAddChild(root, donor);
+    for (size_t i = 0; i < spec->items_per_donor; ++i) {
+      MCKNode * item = MCKNodeCreate(MCKRectMake(4 + (i % MCK_ITEMS_PER_ROW) * (MCK_ITEM_SIZE + 4),
+                                                 4 + (i / MCK_ITEMS_PER_ROW) * (MCK_ITEM_SIZE + 4),
+                                                 MCK_ITEM_SIZE, MCK_ITEM_SIZE));
+      item->roles = MCKDragDropRoleDraggable;
+      MCKNodeAddChild(donor, item);
+    }
+  }
+
+  for (size_t a = 0; a < spec->absorbers; ++a) {
+    MCKRect frame = MCKRectMake(520 + (a % MCK_ABSORBERS_PER_ROW) * (MCK_ABSORBER_SIZE + 8),
+                                (a / MCK_ABSORBERS_PER_ROW) * (MCK_ABSORBER_SIZE + 8),
+                                MCK_ABSORBER_SIZE, MCK_ABSORBER_SIZE);
+    MCKNode * outer = MCKNodeCreate(frame);
+    outer->roles = MCKDragDropRoleAbsorber;
+    MCKNodeAddChild(root, outer);
+
+    MCKNode * parent = outer;
+    for (size_t level = 0; level < spec->absorber_depth; ++level) {
+      MCKRect inner = MCKRectMake(MCK_ABSORBER_INSET, MCK_ABSORBER_INSET,
+                                  parent->bounds.size.width - 2 * MCK_ABSORBER_INSET,
+                                  parent->bounds.size.height - 2 * MCK_ABSORBER_INSET);
+      if ( inner.size.width <= 0 || inner.size.height <= 0 )
+        break;
+      MCKNode * child = MCKNodeCreate(inner);
+      child->roles = MCKDragDropRoleAbsorber;
+      MCKNodeAddChild(parent, child);
+      parent = child;
+    }
+
+    for (size_t f = 0; f < spec->fillers; ++f) {
+      MCKNode * filler = MCKNodeCreate(MCKRectMake(MCKRandomBetween(&state, 0, MCK_ABSORBER_SIZE - 10),
+                                                   MCKRandomBetween(&state, 0, MCK_ABSORBER_SIZE - 10),
+                                                   10, 10));
+      MCKNodeAddChild(outer, filler);
+    }
+  }
+  return root;
+}
+
+/* Appends the nodes of the subtree at node having role to a growable array */
+static void MCKCollectNodes(MCKNode * node, unsigned role, MCKNode *** nodes, size_t * count, size_t * capacity)
+{
+  if ( node->roles & role ) {
+    if ( *count == *capacity ) {
+      *capacity = *capacity ? 2 * *capacity : 64;
+      *nodes = realloc(*nodes, *capacity * sizeof(MCKNode*));
+    }
+    (*nodes)[(*count)++] = node;
+  }
+  for (size_t i = 0; i < node->child_count; ++i)
+    MCKCollectNodes(node->children[i], role, nodes, count, capacity);
+}
+
+size_t MCKSyntheticTraceRecord(MCKNode * scene, size_t drags, size_t group_size, size_t moves,
+                               unsigned seed, MCKTraceRecorder * recorder)
+{
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  host.hover_tracking_enabled = true;
+  host.recorder = recorder;
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+
+  MCKNode ** items = NULL, ** absorbers = NULL;
+  size_t itemCount = 0, itemCapacity = 0, absorberCount = 0, absorberCapacity = 0;
+  MCKCollectNodes(scene, MCKDragDropRoleDraggable, &items, &itemCount, &itemCapacity);
+  MCKCollectNodes(scene, MCKDragDropRoleAbsorber, &absorbers, &absorberCount, &absorberCapacity);
+
+  unsigned state = seed;
+  size_t pickedUp = 0;
+  if ( moves == 0 )
+    moves = 1;
+  size_t otherCount = group_size > 1 ? group_size - 1 : 0;
+  MCKHandle * others = otherCount ? malloc(otherCount * sizeof(MCKHandle)) : NULL;
+  for (size_t n = 0; n < drags && itemCount > 0; ++n) {
+    MCKNode * item = items[MCKRandom(&state) % itemCount];
+    // the session leaves out any of these not in the same donor as item
+    for (size_t i = 0; i < otherCount; ++i)
+      others[i] = items[MCKRandom(&state) % itemCount];
+    if ( !MCKSessionCanBegin(&host, item, NULL) || !MCKSessionPickUpItems(&session, item, others, otherCount) )
+      continue;
+    pickedUp++;
+
+    // the item, or its proxy, now floats in the root, so its center is in root coordinates
+    MCKPoint start = ((MCKNode*)session.lead_view)->center;
+    MCKPoint target;
+    if ( absorberCount == 0 || MCKRandom(&state) % 5 == 0 )
+      target = MCKPointMake(MCKRandomBetween(&state, 0, 480),
+                            MCKRandomBetween(&state, 0, scene->bounds.size.height));
+    else {
+      MCKNode * absorber = absorbers[MCKRandom(&state) % absorberCount];
+      target = MCKNodeConvertPoint(MCKRectGetMid(absorber->bounds), absorber, NULL);
+    }
+
+    // round steps as a trace stores them, so replays move identically
+    double dx = (float)((target.x - start.x) / moves);
+    double dy = (float)((target.y - start.y) / moves);
+    for (size_t m = 0; m < moves; ++m)
+      MCKSessionMove(&session, dx, dy);
+    MCKSessionDrop(&session);
+  }
+
+  MCKSessionDispose(&session);
+  free(others);
+  free(items);
+  free(absorbers);
+  return pickedUp;
+}
+
+MCKNode * MCKNodeAtPath(MCKNode * root, const uint16_t * path, size_t length)
+{
+  MCKNode * node = root;
+  for (size_t i = 0; i < length && node; ++i)
+    node = path[i] < node->child_count ? node->children[path[i]] : NULL;
+  return node;
+}
+
+/* ---------- Replay ---------- */
+
+typedef struct {
+  double * samples;
+  size_t count;
+  size_t capacity;
+} MCKSampleBuffer;
+
+static void MCKSampleBufferAdd(MCKSampleBuffer * buffer, double sample)
+{
+  if ( buffer->count == buffer->capacity ) {
+    buffer->capacity = buffer->capacity ? 2 * buffer->capacity : 1024;
+    buffer->samples = realloc(buffer->samples, buffer->capacity * sizeof(double));
+  }
+  buffer->samples[buffer->count++] = sample;
+}
+
+static int MCKCompareDoubles(const void * a, const void * b)
+{
+  double x = *(const double*)a, y = *(const double*)b;
+  return x < y ? -1 : x > y;
+}
+
+MCKLatencySummary MCKLatencySummarize(double * samples, size_t count)
+{
+  MCKLatencySummary summary;
+  memset(&summary, 0, sizeof(summary));
+  summary.count = count;
+  if ( count > 0 ) {
+    qsort(samples, count, sizeof(double), MCKCompareDoubles);
+    size_t last = count - 1;
+    summary.p50 = samples[(size_t)(0.50 * last + 0.5)];
+    summary.p90 = samples[(size_t)(0.90 * last + 0.5)];
+    summary.p99 = samples[(size_t)(0.99 * last + 0.5)];
+    summary.max = samples[last];
+  }
+  return summary;
+}
+
+void MCKLatencySummaryWriteJSON(const char * name, MCKLatencySummary summary, FILE * file)
+{
+  fprintf(file, "\"%s\":{\"count\":%zu,\"p50_us\":%.3f,\"p90_us\":%.3f,\"p99_us\":%.3f,\"max_us\":%.3f}",
+          name, summary.count, summary.p50 * 1e6, summary.p90 * 1e6, summary.p99 * 1e6, summary.max * 1e6);
+}
+
+/* Summarizes, and frees, the samples in buffer */
+static MCKLatencySummary MCKSampleBufferSummarize(MCKSampleBuffer * buffer)
+{
+  MCKLatencySummary summary = MCKLatencySummarize(buffer->samples, buffer->count);
+  free(buffer->samples);
+  memset(buffer, 0, sizeof(*buffer));
+  return summary;
+}
+
+static void MCKReplaySessionDidEnd(void * context, MCKSession * session)
+{
+  ((MCKReplayReport*)context)->reparents += session->reparent_count;
+}
+
+/* Counts the events where two traces differ, walking them in lockstep */
+static size_t MCKTraceCountDivergences(MCKTraceReader expected, MCKTraceReader actual)
+{
+  size_t divergences = 0;
+  MCKTraceEvent a, b;
+  for (;;) {
+    bool hasA = MCKTraceReaderNext(&expected, &a);
+    bool hasB = MCKTraceReaderNext(&actual, &b);
+    if ( !hasA && !hasB )
+      break;
+    if ( !hasA || !hasB || !MCKTraceEventsMatch(&a, &b) )
+      divergences++;
+  }
+  return divergences;
+}
+
+bool MCKTraceReplay(const unsigned char * bytes, size_t length, MCKNode * root, MCKReplayReport * report)
+{
+  memset(report, 0, sizeof(*report));
+  MCKTraceReader reader;
+  if ( !MCKTraceReaderInit(&reader, bytes, length) )
+    return false;
+  MCKTraceReader expected = reader;
+
+  MCKTraceRecorder * recorder = MCKTraceRecorderCreate(NULL);
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  host.context = report;
+  host.tree.session_did_end = MCKReplaySessionDidEnd;
+  host.hover_tracking_enabled = true;
+  host.recorder = recorder;
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+
+  MCKSampleBuffer pickups = { 0 }, moves = { 0 }, drops = { 0 };
+  // views to pick up along with the next pickup's
+  MCKHandle * companions = NULL;
+  size_t companionCount = 0, companionCapacity = 0;
+  MCKTraceEvent event;
+  while ( MCKTraceReaderNext(&reader, &event) ) {
+    report->events++;
+    double start = MCKTraceNow();
+    switch ( event.type ) {
+      case MCKTraceEventCompanion:
+        if ( companionCount == companionCapacity ) {
+          companionCapacity = companionCapacity ? 2 * companionCapacity : 64;
+          companions = realloc(companions, companionCapacity * sizeof(MCKHandle));
+        }
+        companions[companionCount++] = MCKNodeAtPath(root, event.path, event.path_length);
+        break;
+      case MCKTraceEventProxies:
+        host.drag_proxies = true;
+        break;
+      case MCKTraceEventPickUp: {
+        MCKNode * drag = MCKNodeAtPath(root, event.path, event.path_length);
+        if ( drag )
+          MCKSessionPickUpItems(&session, drag, companions, companionCount);
+        companionCount = 0;
+        host.drag_proxies = false;
+        MCKSampleBufferAdd(&pickups, MCKTraceNow() - start);
+        break;
+      }
+      case MCKTraceEventMove:
+        MCKSessionMove(&session, event.dx, event.dy);
+        MCKSampleBufferAdd(&moves, MCKTraceNow() - start);
+        break;
+      case MCKTraceEventDrop:
+        MCKSessionDrop(&session);
+        MCKSampleBufferAdd(&drops, MCKTraceNow() - start);
+        break;
+      default:
+        // a decision or a consequence of the input: checked below, not applied
+        break;
+    }
+  }
+
+  free(companions);
+  MCKSessionDispose(&session);
+  report->pickup = MCKSampleBufferSummarize(&pickups);
+  report->move = MCKSampleBufferSummarize(&moves);
+  report->drop = MCKSampleBufferSummarize(&drops);
+
+  size_t replayLength;
+  const unsigned char * replayBytes = MCKTraceRecorderBytes(recorder, &replayLength);
+  MCKTraceReader actual;
+  MCKTraceReaderInit(&actual, replayBytes, replayLength);
+  report->divergences = MCKTraceCountDivergences(expected, actual);
+
+  MCKTraceRecorderDestroy(recorder);
+  return true;
+}
@@ -0,0 +1,99 @@
+//
+//  MCKTraceReplay.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-13.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKTraceReplay_h
+#define MCKTraceReplay_h
+
+/*
+ Replays session traces (see MCKSessionTrace.h) against a headless MCKNodeTree,
+ and measures how long the session logic takes per event.
+
+ Everything here is plain C over MCKNodeTree, so it runs off device. A
+ typical regression check:
+
+   MCKNode * scene = MCKSyntheticSceneCreate(&spec);
+   MCKTraceRecorder * recorder = MCKTraceRecorderCreate(NULL);
+   MCKSyntheticTraceRecord(scene, 1000, 1, 20, 1, recorder); // or a trace from a device
+   MCKNodeDestroy(scene);
+
+   scene = MCKSyntheticSceneCreate(&spec);                   // same spec, same scene
+   MCKReplayReport report;
+   MCKTraceReplay(bytes, length, scene, &report);
+   // report.divergences must be 0; compare report.move.p99 etc. to a baseline
+
+ DESIGN NOTES:
+ The replay does not wait out the recorded times: events are fed back to back,
+ so the latencies measure the session logic alone. The recorded decisions and
+ hierarchy changes are not applied, they are checked: the replay records its
+ own trace and compares it, event by event, with the original.
+ */
+
+#include <stdio.h>
+
+#include "MCKNodeTree.h"
+#include "MCKSessionTrace.h"
+
+/* ---------- Synthetic scenes ---------- */
+
+typedef struct {
+  size_t donors;            // donor columns down the left of the scene
+  size_t items_per_donor;   // draggable nodes in each donor
+  size_t absorbers;         // absorbers in a grid on the right
+  size_t absorber_depth;    // each absorber holds a chain of this many nested absorbers
+  size_t fillers;           // plain nodes over each absorber, which hit-testing must see through
+  unsigned seed;
+} MCKSyntheticSceneSpec;
+
+/** Builds a scene from spec. The same spec always gives the same scene. */
+MCKNode * MCKSyntheticSceneCreate(const MCKSyntheticSceneSpec * spec);
+
+/**
+ Runs drags over scene with recorder attached, so that the trace captures
+ them. Each drag picks a draggable node still in a donor, moves it toward a
+ random absorber in moves steps, and drops it. Some drops miss on purpose, to
+ exercise reclaiming.
+
+ With a group_size above 1, each drag also draws group_size - 1 more nodes at
+ random and picks up, along with the first, those in the same donor.
+
+ @return the number of drags that were picked up
+ */
+size_t MCKSyntheticTraceRecord(MCKNode * scene, size_t drags, size_t group_size, size_t moves,
+                               unsigned seed, MCKTraceRecorder * recorder);
+
+/** The node at path under root, or NULL if the tree has no such node */
+MCKNode * MCKNodeAtPath(MCKNode * root, const uint16_t * path, size_t length);
+
+/* ---------- Replay ---------- */
+
+typedef struct {
+  size_t count;
+  double p50, p90, p99, max;  // seconds
+} MCKLatencySummary;
+
+/** Summarizes count samples, in seconds, sorting them in place */
+MCKLatencySummary MCKLatencySummarize(double * samples, size_t count);
+
+/** Writes summary as the JSON member "name":{"count":..,"p50_us":..}, in microseconds */
+void MCKLatencySummaryWriteJSON(const char * name, MCKLatencySummary summary, FILE * file);
+
+typedef struct {
+  MCKLatencySummary pickup, move, drop;
+  size_t events;              // events read from the trace
+  size_t divergences;         // events where the replay differed from the trace
+  size_t reparents;           // views the replayed sessions moved between superviews
+} MCKReplayReport;
+
+/**
+ Replays a trace against the tree at root, with hover tracking on.
+
+ @return false if bytes is not a readable trace
+ */
+bool MCKTraceReplay(const unsigned char * bytes, size_t length, MCKNode * root, MCKReplayReport * report);
+
+#endif
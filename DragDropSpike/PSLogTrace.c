@@ -0,0 +1,261 @@
+//
+//  PSLogTrace.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-14.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef __APPLE__
+#define _POSIX_C_SOURCE 199309L
+#endif
+
+#include "PSLogTrace.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __APPLE__
+#include <mach/mach_time.h>
+#endif
+
+#define PSLOG_TRACE_RING_CAPACITY 2048   // records per thread, a power of two
+#define PSLOG_TRACE_MAX_THREADS 64
+
+typedef struct {
+  PSLogTraceRecord records[PSLOG_TRACE_RING_CAPACITY];
+  volatile uint64_t head;   // next slot to write. Written by the owning thread only.
+  volatile uint64_t tail;   // next slot to read. Written by the drainer only.
+  volatile int orphaned;    // the owning thread has exited
+  uint64_t dropped;         // written by the owning thread only
+  uint64_t overwritten;     // written by the drainer only
+} PSLogTraceRing;
+
+volatile int PSLogTraceEnabled = 1;
+
+// full rings overwrite their oldest records, while no flusher runs
+static volatile int overwriteWhenFull = 1;
+
+static PSLogTraceRing * rings[PSLOG_TRACE_MAX_THREADS];
+static volatile uint32_t ringCount;
+static volatile uint64_t unregisteredDropped;
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drainLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t ringKey;
+static pthread_once_t ringKeyOnce = PTHREAD_ONCE_INIT;
+
+/* ---------- Clock ---------- */
+
+uint64_t PSLogTraceTime(void)
+{
+#ifdef __APPLE__
+  static mach_timebase_info_data_t info;
+  if ( info.denom == 0 )
+    mach_timebase_info(&info);
+  return mach_absolute_time() * info.numer / info.denom;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+#endif
+}
+
+/* ---------- Rings ---------- */
+
+static void PSLogTraceRingOrphan(void * ring)
+{
+  ((PSLogTraceRing*)ring)->orphaned = 1;
+}
+
+static void PSLogTraceMakeKey(void)
+{
+  pthread_key_create(&ringKey, PSLogTraceRingOrphan);
+}
+
+/*
+ Finds or creates the calling thread's ring. Runs once per thread, so it may
+ lock: it reuses the ring of an exited thread once that ring has been drained.
+ */
+static PSLogTraceRing * PSLogTraceRegisterThread(void)
+{
+  PSLogTraceRing * ring = NULL;
+  pthread_mutex_lock(&registryLock);
+  for (uint32_t i = 0; i < ringCount && !ring; ++i)
+    if ( rings[i]->orphaned && rings[i]->head == rings[i]->tail )
+      ring = rings[i];
+  if ( ring )
+    ring->orphaned = 0;
+  else if ( ringCount < PSLOG_TRACE_MAX_THREADS ) {
+    ring = calloc(1, sizeof(PSLogTraceRing));
+    rings[ringCount] = ring;
+    __sync_synchronize();
+    ringCount++;
+  }
+  pthread_mutex_unlock(&registryLock);
+
+  if ( ring )
+    pthread_setspecific(ringKey, ring);
+  return ring;
+}
+
+void PSLogTraceWrite(const PSLogTraceSite * site, const double values[4])
+{
+  pthread_once(&ringKeyOnce, PSLogTraceMakeKey);
+  PSLogTraceRing * ring = pthread_getspecific(ringKey);
+  if ( !ring && !(ring = PSLogTraceRegisterThread()) ) {
+    __sync_fetch_and_add(&unregisteredDropped, 1);
+    return;
+  }
+
+  uint64_t head = ring->head;
+  if ( head - ring->tail >= PSLOG_TRACE_RING_CAPACITY ) {
+    if ( !overwriteWhenFull ) {
+      ring->dropped++;
+      return;
+    }
+    // the slot holds the unread record head - CAPACITY. The new head is only
+    // published once the record is written, below; a reader copying the slot
+    // meanwhile already drops its copy, since it treats record n as lapped
+    // whenever head >= n + CAPACITY, which the current head satisfies
+    __sync_synchronize();
+  }
+
+  PSLogTraceRecord * record = &ring->records[head & (PSLOG_TRACE_RING_CAPACITY - 1)];
+  record->time = PSLogTraceTime();
+  record->site = site;
+  if ( values )
+    memcpy(record->values, values, sizeof(record->values));
+  else
+    memset(record->values, 0, sizeof(record->values));
+  // publish the record only once it is complete
+  __sync_synchronize();
+  ring->head = head + 1;
+}
+
+size_t PSLogTraceDrain(void (*sink)(void * context, const PSLogTraceRecord * record), void * context)
+{
+  size_t drained = 0;
+  pthread_mutex_lock(&drainLock);
+  uint32_t count = ringCount;
+  __sync_synchronize();
+  for (uint32_t i = 0; i < count; ++i) {
+    PSLogTraceRing * ring = rings[i];
+    uint64_t head = ring->head;
+    __sync_synchronize();
+    uint64_t n = ring->tail;
+    if ( head - n > PSLOG_TRACE_RING_CAPACITY ) {
+      ring->overwritten += head - n - PSLOG_TRACE_RING_CAPACITY;
+      n = head - PSLOG_TRACE_RING_CAPACITY;
+    }
+    for (; n < head; ++n) {
+      PSLogTraceRecord record = ring->records[n & (PSLOG_TRACE_RING_CAPACITY - 1)];
+      // the writer is at most one record past head: if it has reached the
+      // slot of n since, the copy may be torn
+      __sync_synchronize();
+      if ( ring->head >= n + PSLOG_TRACE_RING_CAPACITY ) {
+        ring->overwritten++;
+        continue;
+      }
+      record.thread = i;
+      sink(context, &record);
+      drained++;
+    }
+    // the writer may reuse the slots once tail moves past them
+    __sync_synchronize();
+    ring->tail = head;
+  }
+  pthread_mutex_unlock(&drainLock);
+  return drained;
+}
+
+uint64_t PSLogTraceDroppedCount(void)
+{
+  uint64_t dropped = unregisteredDropped;
+  uint32_t count = ringCount;
+  __sync_synchronize();
+  for (uint32_t i = 0; i < count; ++i)
+    dropped += rings[i]->dropped + rings[i]->overwritten;
+  return dropped;
+}
+
+/* ---------- Text ---------- */
+
+int PSLogTraceFormat(const PSLogTraceRecord * record, char * buffer, size_t size)
+{
+  const PSLogTraceSite * site = record->site;
+  const double * v = record->values;
+  int prefix = snprintf(buffer, size, "%llu.%06llu [T%u] %s:%d ",
+                        (unsigned long long)(record->time / 1000000000u),
+                        (unsigned long long)(record->time % 1000000000u / 1000u),
+                        record->thread, site->function, site->line);
+  if ( prefix < 0 || (size_t)prefix >= size )
+    return prefix;
+  int body = snprintf(buffer + prefix, size - prefix, site->format, v[0], v[1], v[2], v[3]);
+  return body < 0 ? body : prefix + body;
+}
+
+static void PSLogTracePrintRecord(void * out, const PSLogTraceRecord * record)
+{
+  char line[512];
+  PSLogTraceFormat(record, line, sizeof(line));
+  fprintf(out, "%s\n", line);
+}
+
+size_t PSLogTraceDump(FILE * out)
+{
+  size_t drained = PSLogTraceDrain(PSLogTracePrintRecord, out);
+  fflush(out);
+  return drained;
+}
+
+/* ---------- Background flushing ---------- */
+
+typedef struct {
+  FILE * out;
+  double interval;
+  volatile int stop;
+} PSLogTraceFlusher;
+
+static pthread_t flusherThread;
+static PSLogTraceFlusher * flusher;
+
+static void * PSLogTraceFlushLoop(void * argument)
+{
+  PSLogTraceFlusher * f = argument;
+  struct timespec pause;
+  pause.tv_sec = (time_t)f->interval;
+  pause.tv_nsec = (long)((f->interval - pause.tv_sec) * 1e9);
+  while ( !f->stop ) {
+    nanosleep(&pause, NULL);
+    PSLogTraceDump(f->out);
+  }
+  PSLogTraceDump(f->out);
+  return NULL;
+}
+
+void PSLogTraceStartFlushing(FILE * out, double interval)
+{
+  PSLogTraceStopFlushing();
+  flusher = calloc(1, sizeof(PSLogTraceFlusher));
+  flusher->out = out;
+  flusher->interval = interval > 0 ? interval : 0.5;
+  if ( pthread_create(&flusherThread, NULL, PSLogTraceFlushLoop, flusher) != 0 ) {
+    free(flusher);
+    flusher = NULL;
+    return;
+  }
+  overwriteWhenFull = 0;
+}
+
+void PSLogTraceStopFlushing(void)
+{
+  if ( !flusher )
+    return;
+  flusher->stop = 1;
+  pthread_join(flusherThread, NULL);
+  free(flusher);
+  flusher = NULL;
+  overwriteWhenFull = 1;
+}
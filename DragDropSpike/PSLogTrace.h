@@ -0,0 +1,115 @@
+//
+//  PSLogTrace.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-14.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef PSLogTrace_h
+#define PSLogTrace_h
+
+/*
+ Structured tracing, cheap enough for the drag hot path and for release builds.
+
+ PSLogTrace is the binary counterpart of PSLogInfo. Instead of formatting a
+ string and calling NSLog, it copies a fixed-size record (call site, time, up
+ to four numbers) into a ring buffer owned by the calling thread:
+
+   PSLogTrace("dragView.frame = {{%g, %g}, {%g, %g}}",
+              frame.origin.x, frame.origin.y, frame.size.width, frame.size.height);
+
+ The format is a printf format taking only doubles, and is applied when the
+ record is printed, not when it is written. An event which has no value is
+ traced with PSLogTraceEvent:
+
+   PSLogTraceEvent("absorber accepted the drop");
+
+ Records are printed by PSLogTraceDump, or continuously by a background thread
+ started with PSLogTraceStartFlushing. Without that thread, tracing works as a
+ flight recorder: each ring keeps the last records its thread wrote, for
+ PSLogTraceDump(stderr) from the debugger.
+
+ DESIGN NOTES:
+ Writing takes no lock, makes no allocation and no Objective-C call. Each
+ thread has its own ring, allocated the first time the thread traces, with a
+ single writer (its thread) and a single reader (whoever drains). While a
+ flusher runs, a full ring drops new records and counts them, since the
+ flusher will soon make room. Otherwise, nothing makes room, so new records
+ overwrite the oldest ones; the reader checks after copying a record that the
+ writer has not lapped it meanwhile, and discards it if it has.
+
+ A call site is identified by the address of a static descriptor, so records
+ can only be formatted inside the process that wrote them.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+  const char * format;
+  const char * function;
+  int line;
+} PSLogTraceSite;
+
+typedef struct {
+  uint64_t time;                // nanoseconds on a monotonic clock
+  const PSLogTraceSite * site;  // identifies the event
+  uint32_t thread;              // index of the writing thread's ring
+  double values[4];
+} PSLogTraceRecord;
+
+/** Set to 0 to make PSLogTrace a single load and branch. Default: 1. */
+extern volatile int PSLogTraceEnabled;
+
+#define PSLogTrace(fmt, ...) do { \
+    if ( PSLogTraceEnabled ) { \
+      static const PSLogTraceSite psLogTraceSite = { fmt, __func__, __LINE__ }; \
+      const double psLogTraceValues[4] = { __VA_ARGS__ }; \
+      PSLogTraceWrite(&psLogTraceSite, psLogTraceValues); \
+    } \
+  } while(0)
+
+#define PSLogTraceEvent(fmt) do { \
+    if ( PSLogTraceEnabled ) { \
+      static const PSLogTraceSite psLogTraceSite = { fmt, __func__, __LINE__ }; \
+      PSLogTraceWrite(&psLogTraceSite, NULL); \
+    } \
+  } while(0)
+
+/** Writes a record of site. values may be NULL for an event which has none. */
+void PSLogTraceWrite(const PSLogTraceSite * site, const double values[4]);
+
+/** Nanoseconds on the clock used to stamp records */
+uint64_t PSLogTraceTime(void);
+
+/**
+ Removes every record written so far from the rings and passes it to sink,
+ ring by ring, in the order each thread wrote them.
+
+ @return the number of records drained
+ */
+size_t PSLogTraceDrain(void (*sink)(void * context, const PSLogTraceRecord * record), void * context);
+
+/** Formats record as one line of text, like snprintf */
+int PSLogTraceFormat(const PSLogTraceRecord * record, char * buffer, size_t size);
+
+/**
+ Records lost because a ring was full, or too many threads were tracing. Records
+ overwritten in flight-recorder mode are counted as their ring is drained.
+ */
+uint64_t PSLogTraceDroppedCount(void);
+
+/** Drains all records to out as text. Handy from the debugger: call PSLogTraceDump(stderr). */
+size_t PSLogTraceDump(FILE * out);
+
+/**
+ Starts a background thread which drains the rings to out every interval
+ seconds, and stops the flight-recorder mode. Replaces any flusher already
+ running.
+ */
+void PSLogTraceStartFlushing(FILE * out, double interval);
+/** Stops the background flusher, after a final drain, back to flight-recorder mode */
+void PSLogTraceStopFlushing(void);
+
+#endif
@@ -49,6 +49,12 @@
   return YES;
 }
 
+- (void)didRotateFromInterfaceOrientation:(UIInterfaceOrientation)fromInterfaceOrientation
+{
+  // the containers were laid out again
+  [[MCKDragDropServer sharedServer] absorberViewsDidMove];
+}
+
 
 #pragma mark MCKDragDropDonor delegate
 
@@ -0,0 +1,187 @@
+//
+//  MCKDonorLookupTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-06.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+/*
+ Donor lookup with nested donors. The outer donor holds a card and an inner
+ donor, which is draggable itself, and holds a card and a plain container
+ with a card of its own:
+
+   root
+     outer (donor)
+       card
+       inner (donor, draggable)
+         innerCard
+         container
+           deepCard
+     absorber
+ */
+
+typedef struct {
+  MCKNode * root;
+  MCKNode * outer;
+  MCKNode * card;
+  MCKNode * inner;
+  MCKNode * innerCard;
+  MCKNode * container;
+  MCKNode * deepCard;
+  MCKNode * absorber;
+  MCKNode * refusingDonor;
+} MCKNestedDonors;
+
+static bool MCKNestedDonorsAccept(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)context; (void)absorber; (void)drag; (void)payload;
+  return true;
+}
+
+static bool MCKNestedDonorsShouldBegin(void * context, MCKHandle donor, MCKHandle drag)
+{
+  (void)drag;
+  return donor != ((MCKNestedDonors*)context)->refusingDonor;
+}
+
+static MCKNode * MCKNestedDonorsAdd(MCKNode * parent, MCKRect frame, unsigned roles)
+{
+  MCKNode * node = MCKNodeCreate(frame);
+  node->roles = roles;
+  MCKNodeAddChild(parent, node);
+  return node;
+}
+
+static void MCKNestedDonorsInit(MCKNestedDonors * scene, MCKDragDropHost * host)
+{
+  memset(scene, 0, sizeof(*scene));
+  scene->root = MCKNodeCreate(MCKRectMake(0, 0, 1000, 1000));
+  scene->outer = MCKNestedDonorsAdd(scene->root, MCKRectMake(0, 0, 600, 1000), MCKDragDropRoleDonor);
+  scene->card = MCKNestedDonorsAdd(scene->outer, MCKRectMake(10, 10, 50, 50), MCKDragDropRoleDraggable);
+  scene->inner = MCKNestedDonorsAdd(scene->outer, MCKRectMake(100, 100, 400, 400),
+                                    MCKDragDropRoleDonor | MCKDragDropRoleDraggable);
+  scene->innerCard = MCKNestedDonorsAdd(scene->inner, MCKRectMake(10, 10, 50, 50), MCKDragDropRoleDraggable);
+  scene->container = MCKNestedDonorsAdd(scene->inner, MCKRectMake(100, 100, 200, 200), MCKDragDropRoleNone);
+  scene->deepCard = MCKNestedDonorsAdd(scene->container, MCKRectMake(20, 20, 50, 50), MCKDragDropRoleDraggable);
+  scene->absorber = MCKNestedDonorsAdd(scene->root, MCKRectMake(700, 0, 300, 1000), MCKDragDropRoleAbsorber);
+
+  MCKNodeTreeHostInit(host);
+  host->context = scene;
+  host->callbacks.absorber_can_absorb = MCKNestedDonorsAccept;
+  host->callbacks.donor_should_begin = MCKNestedDonorsShouldBegin;
+}
+
+static void MCKTestClosestDonor(void)
+{
+  MCKNestedDonors scene;
+  MCKDragDropHost host;
+  MCKNestedDonorsInit(&scene, &host);
+
+  // the closest donor wins, through views which are not donors
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.card, MCKDragDropRoleDonor) == scene.outer);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.innerCard, MCKDragDropRoleDonor) == scene.inner);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.deepCard, MCKDragDropRoleDonor) == scene.inner);
+  // a donor is not its own donor
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.inner, MCKDragDropRoleDonor) == scene.outer);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.outer, MCKDragDropRoleDonor) == NULL);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.absorber, MCKDragDropRoleDonor) == NULL);
+
+  MCKHandle donor = NULL;
+  MCK_CHECK(MCKSessionCanBegin(&host, scene.deepCard, &donor));
+  MCK_CHECK(donor == scene.inner);
+  MCK_CHECK(!MCKSessionCanBegin(&host, scene.absorber, &donor));
+  MCK_CHECK(donor == NULL);
+
+  // a refusing inner donor does not hand its cards to the outer one
+  scene.refusingDonor = scene.inner;
+  MCK_CHECK(!MCKSessionCanBegin(&host, scene.innerCard, &donor));
+  MCK_CHECK(donor == scene.inner);
+  MCK_CHECK(MCKSessionCanBegin(&host, scene.card, NULL));
+
+  MCKNodeDestroy(scene.root);
+}
+
+static void MCKTestPickUpFromNestedDonor(void)
+{
+  MCKNestedDonors scene;
+  MCKDragDropHost host;
+  MCKNestedDonorsInit(&scene, &host);
+
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+  MCK_CHECK(MCKSessionPickUp(&session, scene.deepCard));
+  MCK_CHECK(session.donor_view == scene.inner);
+  MCKSessionCancel(&session);
+  MCK_CHECK(scene.deepCard->parent == scene.container);
+
+  // the inner donor is dragged out of the outer one, with its cards
+  MCK_CHECK(MCKSessionPickUp(&session, scene.inner));
+  MCK_CHECK(session.donor_view == scene.outer);
+  MCKSessionMove(&session, 550, 0);
+  MCK_CHECK(MCKSessionDrop(&session) == MCKDropOutcomeAccepted);
+  MCK_CHECK(scene.inner->parent == scene.absorber);
+  MCK_CHECK(scene.outer->child_count == 1);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(scene.deepCard, MCKDragDropRoleDonor) == scene.inner);
+  MCK_CHECK(MCKSessionPickUp(&session, scene.innerCard));
+  MCK_CHECK(session.donor_view == scene.inner);
+  MCKSessionCancel(&session);
+
+  MCKSessionDispose(&session);
+  MCKNodeDestroy(scene.root);
+}
+
+static void MCKTestCompanionsOfOtherDonors(void)
+{
+  MCKNestedDonors scene;
+  MCKDragDropHost host;
+  MCKNestedDonorsInit(&scene, &host);
+
+  // the outer donor's card stays, the inner donor's deep card goes along
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+  MCKHandle others[] = { scene.card, scene.deepCard };
+  MCK_CHECK(MCKSessionPickUpItems(&session, scene.innerCard, others, 2));
+  MCK_CHECK(session.item_count == 2);
+  MCK_CHECK(scene.card->parent == scene.outer);
+  MCK_CHECK(scene.deepCard->parent != scene.container);
+  MCKSessionCancel(&session);
+  MCK_CHECK(scene.deepCard->parent == scene.container);
+  MCK_CHECK(scene.innerCard->parent == scene.inner);
+  MCK_CHECK(MCKNodeIndexInParent(scene.innerCard) == 0);
+
+  MCKSessionDispose(&session);
+  MCKNodeDestroy(scene.root);
+}
+
+static void MCKTestDeepDonorChain(void)
+{
+  // a card 1000 levels below its donor, with a nested donor half way down
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+  MCKNode * donor = MCKNestedDonorsAdd(root, MCKRectMake(0, 0, 100, 100), MCKDragDropRoleDonor);
+  MCKNode * middle = NULL;
+  MCKNode * node = donor;
+  for (size_t depth = 1; depth <= 1000; ++depth) {
+    node = MCKNestedDonorsAdd(node, MCKRectMake(0, 0, 100, 100), MCKDragDropRoleNone);
+    if ( depth == 500 )
+      middle = node;
+  }
+  MCKNode * card = MCKNestedDonorsAdd(node, MCKRectMake(0, 0, 10, 10), MCKDragDropRoleDraggable);
+
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(card, MCKDragDropRoleDonor) == donor);
+  middle->roles = MCKDragDropRoleDonor;
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(card, MCKDragDropRoleDonor) == middle);
+  MCK_CHECK(MCKNodeClosestAncestorWithRole(middle, MCKDragDropRoleDonor) == donor);
+
+  MCKNodeDestroy(root);
+}
+
+void MCKRunDonorLookupTests(void)
+{
+  MCKTestClosestDonor();
+  MCKTestPickUpFromNestedDonor();
+  MCKTestCompanionsOfOtherDonors();
+  MCKTestDeepDonorChain();
+}
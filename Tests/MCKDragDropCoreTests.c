@@ -0,0 +1,230 @@
+//
+//  MCKDragDropCoreTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+/*
+ The node tree's geometry and hit-testing, and single-view sessions over the
+ headless host: a donor column on the left of a 1000 by 1000 root, holding
+ three cards, and an absorber on the right.
+ */
+
+typedef struct {
+  MCKNode * root;
+  MCKNode * donor;
+  MCKNode * cards[3];
+  MCKNode * absorber;
+  bool accepts;
+  size_t absorber_asks;
+  size_t reclaims;
+} MCKCoreFixture;
+
+static bool MCKCoreFixtureCanAbsorb(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)absorber; (void)drag; (void)payload;
+  MCKCoreFixture * fixture = context;
+  fixture->absorber_asks++;
+  return fixture->accepts;
+}
+
+static void MCKCoreFixtureDidReclaim(void * context, MCKHandle donor, MCKHandle drag)
+{
+  (void)donor; (void)drag;
+  ((MCKCoreFixture*)context)->reclaims++;
+}
+
+static void MCKCoreFixtureInit(MCKCoreFixture * fixture, MCKDragDropHost * host)
+{
+  memset(fixture, 0, sizeof(*fixture));
+  fixture->root = MCKNodeCreate(MCKRectMake(0, 0, 1000, 1000));
+  fixture->donor = MCKNodeCreate(MCKRectMake(0, 0, 400, 1000));
+  fixture->donor->roles = MCKDragDropRoleDonor;
+  MCKNodeAddChild(fixture->root, fixture->donor);
+  for (size_t i = 0; i < 3; ++i) {
+    fixture->cards[i] = MCKNodeCreate(MCKRectMake(10, 10 + 100 * i, 80, 80));
+    fixture->cards[i]->roles = MCKDragDropRoleDraggable;
+    MCKNodeAddChild(fixture->donor, fixture->cards[i]);
+  }
+  fixture->absorber = MCKNodeCreate(MCKRectMake(500, 0, 400, 1000));
+  fixture->absorber->roles = MCKDragDropRoleAbsorber;
+  MCKNodeAddChild(fixture->root, fixture->absorber);
+
+  MCKNodeTreeHostInit(host);
+  host->context = fixture;
+  host->callbacks.absorber_can_absorb = MCKCoreFixtureCanAbsorb;
+  host->callbacks.donor_did_reclaim = MCKCoreFixtureDidReclaim;
+}
+
+/* ---------- Geometry ---------- */
+
+static void MCKTestConvertPoint(void)
+{
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 1000, 1000));
+  MCKNode * outer = MCKNodeCreate(MCKRectMake(100, 200, 300, 300));
+  MCKNode * inner = MCKNodeCreate(MCKRectMake(10, 20, 100, 100));
+  MCKNodeAddChild(root, outer);
+  MCKNodeAddChild(outer, inner);
+
+  MCKPoint p = MCKNodeConvertPoint(MCKPointMake(5, 5), inner, NULL);
+  MCK_CHECK_NEAR(p.x, 115);
+  MCK_CHECK_NEAR(p.y, 225);
+  p = MCKNodeConvertPoint(p, NULL, inner);
+  MCK_CHECK_NEAR(p.x, 5);
+  MCK_CHECK_NEAR(p.y, 5);
+
+  // a half turn about the center of outer
+  outer->transform = (MCKTransform){ -1, 0, 0, -1, 0, 0 };
+  p = MCKNodeConvertPoint(MCKPointMake(0, 0), outer, NULL);
+  MCK_CHECK_NEAR(p.x, 400);
+  MCK_CHECK_NEAR(p.y, 500);
+  p = MCKNodeConvertPoint(p, NULL, outer);
+  MCK_CHECK_NEAR(p.x, 0);
+  MCK_CHECK_NEAR(p.y, 0);
+
+  MCKNodeDestroy(root);
+}
+
+static void MCKTestHitTest(void)
+{
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+  MCKNode * back = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+  MCKNode * front = MCKNodeCreate(MCKRectMake(0, 0, 50, 50));
+  MCKNodeAddChild(root, back);
+  MCKNodeAddChild(root, front);
+  MCKPoint point = MCKPointMake(25, 25);
+
+  // the front sibling wins, unless it ignores touches
+  MCK_CHECK(MCKNodeHitTest(root, point) == front);
+  front->hidden = true;
+  MCK_CHECK(MCKNodeHitTest(root, point) == back);
+  front->hidden = false;
+  front->user_interaction_enabled = false;
+  MCK_CHECK(MCKNodeHitTest(root, point) == back);
+  front->user_interaction_enabled = true;
+  front->alpha = 0.005;
+  MCK_CHECK(MCKNodeHitTest(root, point) == back);
+  front->alpha = 1;
+  MCK_CHECK(MCKNodeHitTest(root, MCKPointMake(75, 75)) == back);
+  MCK_CHECK(MCKNodeHitTest(root, MCKPointMake(150, 75)) == NULL);
+
+  // non-absorbers never block absorbers behind them
+  back->roles = MCKDragDropRoleAbsorber;
+  MCK_CHECK(MCKNodeFirstAbsorberAt(root, point, NULL) == back);
+  MCK_CHECK(MCKNodeFirstAbsorberAt(root, point, back) == NULL);
+
+  MCKNodeDestroy(root);
+}
+
+static void MCKTestMotionlessInsert(void)
+{
+  MCKCoreFixture fixture;
+  MCKDragDropHost host;
+  MCKCoreFixtureInit(&fixture, &host);
+
+  MCKNode * card = fixture.cards[1];
+  MCKRect before = MCKNodeConvertRect(MCKNodeGetFrame(card), card->parent, NULL);
+  MCKMotionlessInsert(&host, fixture.absorber, card, 0);
+  MCK_CHECK(card->parent == fixture.absorber);
+  MCK_CHECK(MCKNodeIndexInParent(card) == 0);
+  MCK_CHECK_RECT(MCKNodeGetFrame(card), -490, 110, 80, 80);
+  MCKRect after = MCKNodeConvertRect(MCKNodeGetFrame(card), card->parent, NULL);
+  MCK_CHECK_RECT(after, before.origin.x, before.origin.y, before.size.width, before.size.height);
+
+  MCKNodeDestroy(fixture.root);
+}
+
+/* ---------- Sessions ---------- */
+
+static void MCKTestDropAccepted(void)
+{
+  MCKCoreFixture fixture;
+  MCKDragDropHost host;
+  MCKCoreFixtureInit(&fixture, &host);
+  fixture.accepts = true;
+
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+  MCKNode * card = fixture.cards[0];
+  MCK_CHECK(MCKSessionPickUp(&session, card));
+  MCK_CHECK(session.phase == MCKSessionPhaseDragging);
+  MCK_CHECK(session.donor_view == fixture.donor);
+  MCK_CHECK(card->parent == fixture.root);
+
+  for (int i = 0; i < 10; ++i)
+    MCKSessionMove(&session, 60, 0);
+  MCK_CHECK(MCKSessionDrop(&session) == MCKDropOutcomeAccepted);
+  MCK_CHECK(fixture.absorber_asks == 1);
+  MCK_CHECK(session.phase == MCKSessionPhaseIdle);
+  MCK_CHECK(card->parent == fixture.absorber);
+  MCK_CHECK(fixture.donor->child_count == 2);
+  MCKRect frame = MCKNodeConvertRect(MCKNodeGetFrame(card), card->parent, NULL);
+  MCK_CHECK_RECT(frame, 610, 10, 80, 80);
+
+  MCKSessionDispose(&session);
+  MCKNodeDestroy(fixture.root);
+}
+
+static void MCKTestDropRejected(void)
+{
+  MCKCoreFixture fixture;
+  MCKDragDropHost host;
+  MCKCoreFixtureInit(&fixture, &host);
+
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+  MCKNode * card = fixture.cards[1];
+  MCK_CHECK(MCKSessionPickUp(&session, card));
+  MCKSessionMove(&session, 600, 0);
+  MCK_CHECK(MCKSessionDrop(&session) == MCKDropOutcomeRejected);
+  MCK_CHECK(fixture.absorber_asks == 1);
+
+  // the reclaim is instantaneous, and puts the card back in its slot
+  MCK_CHECK(session.phase == MCKSessionPhaseIdle);
+  MCK_CHECK(fixture.reclaims == 1);
+  MCK_CHECK(card->parent == fixture.donor);
+  MCK_CHECK(MCKNodeIndexInParent(card) == 1);
+  MCK_CHECK_RECT(MCKNodeGetFrame(card), 10, 110, 80, 80);
+
+  // a drop over no absorber asks no one
+  MCK_CHECK(MCKSessionPickUp(&session, card));
+  MCK_CHECK(MCKSessionDrop(&session) == MCKDropOutcomeRejected);
+  MCK_CHECK(fixture.absorber_asks == 1);
+  MCK_CHECK(MCKNodeIndexInParent(card) == 1);
+
+  MCKSessionDispose(&session);
+  MCKNodeDestroy(fixture.root);
+}
+
+static void MCKTestPickUpNeedsDonor(void)
+{
+  MCKCoreFixture fixture;
+  MCKDragDropHost host;
+  MCKCoreFixtureInit(&fixture, &host);
+
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+  MCKNode * stray = MCKNodeCreate(MCKRectMake(0, 0, 10, 10));
+  MCKNodeAddChild(fixture.absorber, stray);
+  MCK_CHECK(!MCKSessionCanBegin(&host, stray, NULL));
+  MCK_CHECK(!MCKSessionPickUp(&session, stray));
+  MCK_CHECK(session.phase == MCKSessionPhaseIdle);
+  MCK_CHECK(stray->parent == fixture.absorber);
+
+  MCKSessionDispose(&session);
+  MCKNodeDestroy(fixture.root);
+}
+
+void MCKRunDragDropCoreTests(void)
+{
+  MCKTestConvertPoint();
+  MCKTestHitTest();
+  MCKTestMotionlessInsert();
+  MCKTestDropAccepted();
+  MCKTestDropRejected();
+  MCKTestPickUpNeedsDonor();
+}
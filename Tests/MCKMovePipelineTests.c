@@ -0,0 +1,146 @@
+//
+//  MCKMovePipelineTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-22.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+#include "MCKMovePipeline.h"
+
+// touch events every 8 ms, a little faster than a 60 Hz display
+#define MCK_TEST_TOUCH_PERIOD 0.008
+
+/* Moves the finger by (dx, dy) at each of count touch events, from time *now */
+static void MCKTestFingerMoves(MCKMovePipeline * pipeline, double * now, size_t count, double dx, double dy)
+{
+  for (size_t i = 0; i < count; ++i) {
+    *now += MCK_TEST_TOUCH_PERIOD;
+    MCKMovePipelineAddTranslation(pipeline, dx, dy);
+  }
+}
+
+static void MCKTestCoalescing(void)
+{
+  double now = 0, dx, dy;
+  MCKMovePipeline pipeline;
+  MCKMovePipelineInit(&pipeline, MCKClockManual(&now), 0);
+
+  // the translations of a frame come out as one move, to the finger
+  MCKTestFingerMoves(&pipeline, &now, 10, 3, -1);
+  MCK_CHECK(pipeline.translation_count == 10);
+  MCK_CHECK(MCKMovePipelineNextFrame(&pipeline, now + 1.0 / 60, &dx, &dy));
+  MCK_CHECK_NEAR(dx, 30);
+  MCK_CHECK_NEAR(dy, -10);
+  MCK_CHECK(!MCKMovePipelineNextFrame(&pipeline, now + 2.0 / 60, &dx, &dy));
+  MCK_CHECK(pipeline.move_count == 1);
+
+  // and a frame never gets more than one move, however many events it had
+  for (size_t frame = 0; frame < 50; ++frame) {
+    MCKTestFingerMoves(&pipeline, &now, frame % 4, 1, 2);
+    size_t moves = pipeline.move_count;
+    MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy);
+    MCK_CHECK(pipeline.move_count - moves == (frame % 4 > 0));
+  }
+  MCK_CHECK_NEAR(pipeline.shown_x, pipeline.finger_x);
+  MCK_CHECK_NEAR(pipeline.shown_y, pipeline.finger_y);
+
+  // a finger moved back to where the view is needs no move
+  MCKMovePipelineAddTranslation(&pipeline, 5, 5);
+  MCKMovePipelineAddTranslation(&pipeline, -5, -5);
+  MCK_CHECK(!MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy));
+
+  MCKMovePipelineReset(&pipeline);
+  MCK_CHECK(pipeline.translation_count == 0 && pipeline.move_count == 0);
+  MCK_CHECK(!MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy));
+}
+
+static void MCKTestVelocity(void)
+{
+  double now = 0, vx, vy;
+  MCKMovePipeline pipeline;
+  MCKMovePipelineInit(&pipeline, MCKClockManual(&now), 0.03);
+
+  MCKMovePipelineVelocity(&pipeline, now, &vx, &vy);
+  MCK_CHECK(vx == 0 && vy == 0);
+
+  // 2 pt right and 1 pt up every 8 ms
+  MCKTestFingerMoves(&pipeline, &now, 20, 2, -1);
+  MCKMovePipelineVelocity(&pipeline, now, &vx, &vy);
+  MCK_CHECK(fabs(vx - 2 / MCK_TEST_TOUCH_PERIOD) < 1e-3);
+  MCK_CHECK(fabs(vy + 1 / MCK_TEST_TOUCH_PERIOD) < 1e-3);
+
+  // the velocity lapses once the latest sample is 50 ms old
+  MCKMovePipelineVelocity(&pipeline, now + 0.049, &vx, &vy);
+  MCK_CHECK(vx != 0 && vy != 0);
+  MCKMovePipelineVelocity(&pipeline, now + 0.051, &vx, &vy);
+  MCK_CHECK(vx == 0 && vy == 0);
+
+  // and so does the prediction, which leaves the view on the finger
+  double dx, dy;
+  MCK_CHECK(MCKMovePipelineNextFrame(&pipeline, now + 0.051, &dx, &dy));
+  MCK_CHECK_NEAR(pipeline.shown_x, pipeline.finger_x);
+  MCK_CHECK_NEAR(pipeline.shown_y, pipeline.finger_y);
+}
+
+static void MCKTestPrediction(void)
+{
+  double now = 0, dx, dy;
+  MCKMovePipeline pipeline;
+  MCKMovePipelineInit(&pipeline, MCKClockManual(&now), 0.03);
+
+  // 250 pt/s to the right: 7.5 pt of lead over 30 ms
+  MCKTestFingerMoves(&pipeline, &now, 10, 2, 0);
+  MCK_CHECK(MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy));
+  MCK_CHECK(fabs(pipeline.shown_x - pipeline.finger_x - 7.5) < 1e-6);
+  MCK_CHECK_NEAR(pipeline.shown_y, pipeline.finger_y);
+
+  // the flush takes the view back to the finger exactly, once
+  MCK_CHECK(MCKMovePipelineFlush(&pipeline, &dx, &dy));
+  MCK_CHECK(fabs(dx + 7.5) < 1e-6);
+  MCK_CHECK(pipeline.shown_x == pipeline.finger_x && pipeline.shown_y == pipeline.finger_y);
+  MCK_CHECK(!MCKMovePipelineFlush(&pipeline, &dx, &dy));
+
+  // a fast finger leads by max_prediction_distance at most, in its direction
+  MCKTestFingerMoves(&pipeline, &now, 10, 60, 80);
+  MCK_CHECK(MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy));
+  double leadX = pipeline.shown_x - pipeline.finger_x, leadY = pipeline.shown_y - pipeline.finger_y;
+  MCK_CHECK(fabs(sqrt(leadX * leadX + leadY * leadY) - pipeline.max_prediction_distance) < 1e-6);
+  MCK_CHECK(fabs(leadX * 4 - leadY * 3) < 1e-6);
+
+  pipeline.max_prediction_distance = 10;
+  MCKTestFingerMoves(&pipeline, &now, 1, 60, 80);
+  MCK_CHECK(MCKMovePipelineNextFrame(&pipeline, now, &dx, &dy));
+  leadX = pipeline.shown_x - pipeline.finger_x;
+  leadY = pipeline.shown_y - pipeline.finger_y;
+  MCK_CHECK(fabs(sqrt(leadX * leadX + leadY * leadY) - 10) < 1e-6);
+  MCK_CHECK(MCKMovePipelineFlush(&pipeline, &dx, &dy));
+  MCK_CHECK(pipeline.shown_x == pipeline.finger_x && pipeline.shown_y == pipeline.finger_y);
+}
+
+static void MCKTestSimulation(void)
+{
+  // 120 Hz touches on a 60 Hz display, as in MCKMovePipeline.h
+  MCKMoveSimulationSpec spec = { 120, 60, 5, 600, 150, 0.5, 0.012, 0, false, 1 };
+  MCKMoveSimulationReport direct, coalesced, predicted;
+  MCKMovePipelineSimulate(&spec, &direct);
+  spec.coalesce = true;
+  MCKMovePipelineSimulate(&spec, &coalesced);
+  spec.prediction = spec.touch_latency + 1 / spec.display_rate;
+  MCKMovePipelineSimulate(&spec, &predicted);
+
+  MCK_CHECK(direct.touches == 600 && direct.moves == 600);
+  MCK_CHECK(coalesced.touches == 600 && coalesced.moves <= coalesced.frames);
+  MCK_CHECK(predicted.moves <= predicted.frames);
+  MCK_CHECK(predicted.mean_error < coalesced.mean_error / 2);
+}
+
+void MCKRunMovePipelineTests(void)
+{
+  MCKTestCoalescing();
+  MCKTestVelocity();
+  MCKTestPrediction();
+  MCKTestSimulation();
+}
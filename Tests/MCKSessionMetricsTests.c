@@ -0,0 +1,265 @@
+//
+//  MCKSessionMetricsTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-23.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+#include "MCKSessionMetrics.h"
+#include "MCKSessionTrace.h"
+
+// how long the slow absorber takes to answer on the test clock: about 2 ms,
+// and a power of two, so that the clock adds it up exactly
+#define MCK_TEST_SLOW_CALLBACK (1.0 / 512)
+
+/* The clock of the metrics, which only the slow absorber moves. The core
+   takes a start time of 0 for a step begun while it was not collecting. */
+static double MCKTestMetricsTime = 1;
+
+static double MCKTestMetricsNow(void)
+{
+  return MCKTestMetricsTime;
+}
+
+/*
+ Two donors which are also absorbers, side by side in a 1000 by 500 root. A
+ card goes back and forth between them; the one on the right is slow to
+ accept it.
+ */
+
+typedef struct {
+  MCKNode * root;
+  MCKNode * fast;
+  MCKNode * slow;
+  MCKNode * card;
+} MCKMetricsScene;
+
+static bool MCKMetricsSceneCanAbsorb(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)drag; (void)payload;
+  if ( absorber == ((MCKMetricsScene*)context)->slow )
+    MCKTestMetricsTime += MCK_TEST_SLOW_CALLBACK;
+  return true;
+}
+
+static void MCKMetricsSceneDidHover(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)context; (void)absorber; (void)drag; (void)payload;
+}
+
+static MCKNode * MCKMetricsSceneAdd(MCKNode * parent, MCKRect frame, unsigned roles)
+{
+  MCKNode * node = MCKNodeCreate(frame);
+  node->roles = roles;
+  MCKNodeAddChild(parent, node);
+  return node;
+}
+
+static void MCKMetricsSceneInit(MCKMetricsScene * scene, MCKDragDropHost * host)
+{
+  scene->root = MCKNodeCreate(MCKRectMake(0, 0, 1000, 500));
+  scene->fast = MCKMetricsSceneAdd(scene->root, MCKRectMake(0, 0, 500, 500),
+                                   MCKDragDropRoleDonor | MCKDragDropRoleAbsorber);
+  scene->slow = MCKMetricsSceneAdd(scene->root, MCKRectMake(500, 0, 500, 500),
+                                   MCKDragDropRoleDonor | MCKDragDropRoleAbsorber);
+  scene->card = MCKMetricsSceneAdd(scene->fast, MCKRectMake(10, 10, 40, 40), MCKDragDropRoleDraggable);
+
+  MCKNodeTreeHostInit(host);
+  host->context = scene;
+  host->hover_tracking_enabled = true;
+  host->callbacks.absorber_can_absorb = MCKMetricsSceneCanAbsorb;
+  host->callbacks.absorber_did_hover = MCKMetricsSceneDidHover;
+}
+
+/* Drags the card to the other absorber in moves steps, and drops it there */
+static void MCKMetricsSceneDragAcross(MCKMetricsScene * scene, MCKSession * session, size_t moves)
+{
+  double dx = (scene->card->parent == scene->fast ? 500.0 : -500.0) / moves;
+  MCKSessionPickUp(session, scene->card);
+  for (size_t i = 0; i < moves; ++i)
+    MCKSessionMove(session, dx, 0);
+  MCKSessionDrop(session);
+}
+
+static void MCKTestHistogramBuckets(void)
+{
+  MCKHistogram histogram;
+  MCKHistogramReset(&histogram);
+  MCK_CHECK(MCKHistogramValueAtPercentile(&histogram, 50) == 0);
+  MCK_CHECK(MCKHistogramMean(&histogram) == 0);
+
+  // below 32 ns, each value has its own bucket; above, a bucket is 1/16 of
+  // its power of two wide, and a percentile gives the top of its bucket
+  for (uint64_t value = 1; value < ((uint64_t)1 << 38); value = value * 9 / 8 + 1) {
+    MCKHistogramReset(&histogram);
+    MCKHistogramRecord(&histogram, value);
+    MCKHistogramRecord(&histogram, (uint64_t)1 << 39);
+    uint64_t top = MCKHistogramValueAtPercentile(&histogram, 50);
+    MCK_CHECK(top >= value);
+    MCK_CHECK(value < 32 ? top == value : top - value < value / 16);
+  }
+
+  // values past the last bucket count in it, and keep their max
+  MCKHistogramReset(&histogram);
+  MCKHistogramRecord(&histogram, (uint64_t)1 << 50);
+  MCK_CHECK(histogram.counts[MCK_HISTOGRAM_BUCKET_COUNT - 1] == 1);
+  MCK_CHECK(MCKHistogramValueAtPercentile(&histogram, 100) == (uint64_t)1 << 50);
+}
+
+static void MCKTestHistogramPercentiles(void)
+{
+  // 1 us to 100 ms, evenly
+  MCKHistogram histogram;
+  MCKHistogramReset(&histogram);
+  for (uint64_t value = 1; value <= 100000; ++value)
+    MCKHistogramRecord(&histogram, value * 1000);
+  MCK_CHECK(histogram.count == 100000);
+  MCK_CHECK(histogram.min == 1000);
+  MCK_CHECK(histogram.max == 100000000);
+  MCK_CHECK_NEAR(MCKHistogramMean(&histogram), 50000500);
+
+  static const double percentiles[] = { 50, 90, 99 };
+  for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+    double exact = percentiles[i] * 1000000;
+    uint64_t value = MCKHistogramValueAtPercentile(&histogram, percentiles[i]);
+    MCK_CHECK(value >= exact && value < exact * (1 + 1.0 / 16));
+  }
+  MCK_CHECK(MCKHistogramValueAtPercentile(&histogram, 100) == 100000000);
+  MCK_CHECK(MCKHistogramValueAtPercentile(&histogram, 150) == 100000000);
+  MCK_CHECK(MCKHistogramValueAtPercentile(&histogram, 0) <= 1000 * (1 + 1.0 / 16));
+}
+
+static void MCKTestSlowCallbackAttribution(void)
+{
+  MCKMetricsScene scene;
+  MCKDragDropHost host;
+  MCKMetricsSceneInit(&scene, &host);
+  host.metrics = MCKSessionMetricsCreate(MCKTestMetricsNow);
+  MCKSession session;
+  MCKSessionInit(&session, &host, NULL);
+
+  for (size_t drag = 0; drag < 20; ++drag)
+    MCKMetricsSceneDragAcross(&scene, &session, 10);
+  MCK_CHECK(scene.card->parent == scene.fast);
+
+  const MCKHistogram * pickUp = MCKSessionMetricsHistogram(host.metrics, MCKMetricPickUp);
+  const MCKHistogram * move = MCKSessionMetricsHistogram(host.metrics, MCKMetricMove);
+  const MCKHistogram * drop = MCKSessionMetricsHistogram(host.metrics, MCKMetricDrop);
+  const MCKHistogram * canAbsorb = MCKSessionMetricsHistogram(host.metrics, MCKMetricAbsorberCanAbsorb);
+  MCK_CHECK(pickUp->count == 20 && move->count == 200 && drop->count == 20);
+  MCK_CHECK(move->max == 0);
+  // the slow answers show in the drops which waited for them, and no others
+  MCK_CHECK(MCKHistogramValueAtPercentile(drop, 99) == MCK_TEST_SLOW_CALLBACK * 1e9);
+  MCK_CHECK(MCKHistogramValueAtPercentile(drop, 40) == 0);
+  MCK_CHECK(canAbsorb->max == MCK_TEST_SLOW_CALLBACK * 1e9);
+
+  // and in the slow absorber's entry of the delegate table
+  size_t slowCallbacks = 0, fastCallbacks = 0;
+  for (size_t i = 0; i < MCKSessionMetricsDelegateStatCount(host.metrics); ++i) {
+    const MCKDelegateStat * stat = MCKSessionMetricsDelegateStatAt(host.metrics, i);
+    MCK_CHECK(stat->view == scene.fast || stat->view == scene.slow);
+    if ( stat->metric != MCKMetricAbsorberCanAbsorb )
+      MCK_CHECK(stat->max == 0);
+    else if ( stat->view == scene.slow ) {
+      slowCallbacks += stat->count;
+      MCK_CHECK(stat->max == MCK_TEST_SLOW_CALLBACK * 1e9);
+      MCK_CHECK(stat->total == stat->count * stat->max);
+    }
+    else {
+      fastCallbacks += stat->count;
+      MCK_CHECK(stat->max == 0);
+    }
+  }
+  MCK_CHECK(slowCallbacks >= 10 && fastCallbacks >= 10);
+  MCK_CHECK(slowCallbacks + fastCallbacks == canAbsorb->count);
+  MCK_CHECK(MCKSessionMetricsDelegateStatAt(host.metrics, MCKSessionMetricsDelegateStatCount(host.metrics)) == NULL);
+
+  MCKSessionDispose(&session);
+  MCKSessionMetricsDestroy(host.metrics);
+  MCKNodeDestroy(scene.root);
+}
+
+static void MCKTestFullDelegateTable(void)
+{
+  MCKSessionMetrics * metrics = MCKSessionMetricsCreate(MCKTestMetricsNow);
+  char views[MCK_METRICS_DELEGATE_CAPACITY + 72];
+  double start = MCKSessionMetricsNow(metrics);
+
+  // phases are not counted per view
+  MCKSessionMetricsRecord(metrics, MCKMetricMove, &views[0], start);
+  MCK_CHECK(MCKSessionMetricsDelegateStatCount(metrics) == 0);
+
+  // once the table is full, new views go uncounted, but known ones still count
+  for (size_t i = 0; i < sizeof(views); ++i)
+    MCKSessionMetricsRecord(metrics, MCKMetricAbsorberDidHover, &views[i], start);
+  MCK_CHECK(MCKSessionMetricsDelegateStatCount(metrics) == MCK_METRICS_DELEGATE_CAPACITY);
+  MCK_CHECK(MCKSessionMetricsUntrackedCount(metrics) == 72);
+  MCKSessionMetricsRecord(metrics, MCKMetricAbsorberDidHover, &views[MCK_METRICS_DELEGATE_CAPACITY - 1], start);
+  MCKSessionMetricsRecord(metrics, MCKMetricAbsorberDidHover, &views[MCK_METRICS_DELEGATE_CAPACITY], start);
+  MCK_CHECK(MCKSessionMetricsUntrackedCount(metrics) == 73);
+  const MCKDelegateStat * last = MCKSessionMetricsDelegateStatAt(metrics, MCK_METRICS_DELEGATE_CAPACITY - 1);
+  MCK_CHECK(last->view == &views[MCK_METRICS_DELEGATE_CAPACITY - 1] && last->count == 2);
+  // a known view with another callback is a new entry
+  MCKSessionMetricsRecord(metrics, MCKMetricAbsorberDidExit, &views[0], start);
+  MCK_CHECK(MCKSessionMetricsUntrackedCount(metrics) == 74);
+  MCK_CHECK(MCKSessionMetricsHistogram(metrics, MCKMetricAbsorberDidHover)->count == sizeof(views) + 2);
+
+  MCKSessionMetricsReset(metrics);
+  MCK_CHECK(MCKSessionMetricsDelegateStatCount(metrics) == 0);
+  MCK_CHECK(MCKSessionMetricsUntrackedCount(metrics) == 0);
+  MCK_CHECK(MCKSessionMetricsHistogram(metrics, MCKMetricAbsorberDidHover)->count == 0);
+  MCKSessionMetricsRecord(metrics, MCKMetricAbsorberDidExit, &views[0], start);
+  MCK_CHECK(MCKSessionMetricsDelegateStatCount(metrics) == 1);
+  MCKSessionMetricsDestroy(metrics);
+}
+
+/* Seconds per move of the card over an absorber of 200 views, at best of 3 runs */
+static double MCKTestTimeMoves(MCKDragDropHost * host, MCKNode * card, size_t moves)
+{
+  double best = 0;
+  for (size_t run = 0; run < 3; ++run) {
+    MCKSession session;
+    MCKSessionInit(&session, host, NULL);
+    MCKSessionPickUp(&session, card);
+    double start = MCKTraceNow();
+    for (size_t i = 0; i < moves; ++i)
+      MCKSessionMove(&session, (i & 1) ? -1 : 1, 0);
+    double time = (MCKTraceNow() - start) / moves;
+    MCKSessionCancel(&session);
+    MCKSessionDispose(&session);
+    if ( run == 0 || time < best )
+      best = time;
+  }
+  return best;
+}
+
+static void MCKTestCollectionOverhead(void)
+{
+  MCKMetricsScene scene;
+  MCKDragDropHost host;
+  MCKMetricsSceneInit(&scene, &host);
+  for (size_t i = 0; i < 200; ++i)
+    MCKMetricsSceneAdd(scene.fast, MCKRectMake(i, i, 5, 5), MCKDragDropRoleNone);
+
+  // collecting on the monotonic clock costs a few clock reads per move
+  double off = MCKTestTimeMoves(&host, scene.card, 20000);
+  host.metrics = MCKSessionMetricsCreate(NULL);
+  double on = MCKTestTimeMoves(&host, scene.card, 20000);
+  MCK_CHECK(MCKSessionMetricsHistogram(host.metrics, MCKMetricMove)->count == 3 * 20000);
+  MCK_CHECK(on < 1.5 * off + 1e-6);
+
+  MCKSessionMetricsDestroy(host.metrics);
+  MCKNodeDestroy(scene.root);
+}
+
+void MCKRunSessionMetricsTests(void)
+{
+  MCKTestHistogramBuckets();
+  MCKTestHistogramPercentiles();
+  MCKTestSlowCallbackAttribution();
+  MCKTestFullDelegateTable();
+  MCKTestCollectionOverhead();
+}
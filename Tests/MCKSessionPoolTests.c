@@ -0,0 +1,168 @@
+//
+//  MCKSessionPoolTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-07.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+/*
+ Twelve fingers dragging from the same donor at random, over a pool of
+ sessions, with reclaim animations which complete in any order. Views of
+ drops and cancels may still be reclaiming when other fingers pick up
+ their neighbours, or the same views again.
+
+ Whenever no session is active, the donor must hold its cards in their
+ original order: a reclaim must put each view back at its index among the
+ views present when it was picked up, whatever was reclaimed meanwhile.
+ */
+
+#define MCK_STRESS_FINGERS 12
+#define MCK_STRESS_CARDS 40
+#define MCK_STRESS_SESSIONS 16
+#define MCK_STRESS_OPERATIONS 20000
+
+typedef struct {
+  MCKSession * sessions[MCK_STRESS_SESSIONS];
+  void (*completions[MCK_STRESS_SESSIONS])(MCKSession * session);
+  size_t count;
+  size_t most;
+} MCKPendingReclaims;
+
+// a small LCG, so the run is the same on every platform
+static unsigned MCKStressRandom(unsigned * state, unsigned bound)
+{
+  *state = *state * 1103515245u + 12345u;
+  return (*state >> 16) % bound;
+}
+
+static void MCKStressAnimateReclaim(void * context, MCKSession * session,
+                                    void (*completion)(MCKSession * session))
+{
+  MCKPendingReclaims * pending = context;
+  pending->sessions[pending->count] = session;
+  pending->completions[pending->count] = completion;
+  if ( ++pending->count > pending->most )
+    pending->most = pending->count;
+}
+
+static void MCKStressCompleteReclaim(MCKPendingReclaims * pending, size_t index)
+{
+  MCKSession * session = pending->sessions[index];
+  void (*completion)(MCKSession * session) = pending->completions[index];
+  pending->count--;
+  pending->sessions[index] = pending->sessions[pending->count];
+  pending->completions[index] = pending->completions[pending->count];
+  completion(session);
+}
+
+static bool MCKStressCardsInOrder(const MCKNode * donor)
+{
+  if ( donor->child_count != MCK_STRESS_CARDS )
+    return false;
+  for (size_t i = 0; i < donor->child_count; ++i)
+    if ( (size_t)donor->children[i]->user_data != i )
+      return false;
+  return true;
+}
+
+static void MCKTestPoolStress(bool proxies, unsigned seed)
+{
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 1000, 1000));
+  MCKNode * donor = MCKNodeCreate(MCKRectMake(0, 0, 500, 1000));
+  donor->roles = MCKDragDropRoleDonor;
+  MCKNodeAddChild(root, donor);
+  MCKNode * cards[MCK_STRESS_CARDS];
+  for (size_t i = 0; i < MCK_STRESS_CARDS; ++i) {
+    cards[i] = MCKNodeCreate(MCKRectMake(i * 10, i * 10, 50, 50));
+    cards[i]->roles = MCKDragDropRoleDraggable;
+    cards[i]->user_data = (void*)i;
+    MCKNodeAddChild(donor, cards[i]);
+  }
+
+  MCKPendingReclaims pending = { { NULL }, { NULL }, 0, 0 };
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  host.context = &pending;
+  host.tree.animate_reclaim = MCKStressAnimateReclaim;
+  host.drag_proxies = proxies;
+  MCKSession storage[MCK_STRESS_SESSIONS];
+  MCKSessionPool pool;
+  MCKSessionPoolInit(&pool, &host, storage, MCK_STRESS_SESSIONS);
+
+  MCKSession * fingers[MCK_STRESS_FINGERS] = { NULL };
+  size_t pickups = 0, idleChecks = 0, misplaced = 0, shared = 0;
+  for (size_t step = 0; step < MCK_STRESS_OPERATIONS; ++step) {
+    unsigned f = MCKStressRandom(&seed, MCK_STRESS_FINGERS);
+    switch ( MCKStressRandom(&seed, 4) ) {
+      case 0:
+        if ( !fingers[f] ) {
+          MCKHandle others[3];
+          unsigned otherCount = MCKStressRandom(&seed, 3);
+          for (unsigned o = 0; o < otherCount; ++o)
+            others[o] = cards[MCKStressRandom(&seed, MCK_STRESS_CARDS)];
+          MCKNode * drag = cards[MCKStressRandom(&seed, MCK_STRESS_CARDS)];
+          fingers[f] = MCKSessionPoolPickUpItems(&pool, drag, others, otherCount, NULL);
+          if ( fingers[f] ) {
+            pickups++;
+            // a view belongs to a single session
+            for (size_t i = 0; i < fingers[f]->item_count; ++i)
+              if ( MCKSessionPoolSessionOfView(&pool, fingers[f]->items[i].view) != fingers[f] )
+                shared++;
+          }
+        }
+        break;
+      case 1:
+        if ( fingers[f] )
+          MCKSessionMove(fingers[f], (double)MCKStressRandom(&seed, 21) - 10, (double)MCKStressRandom(&seed, 21) - 10);
+        break;
+      case 2:
+        if ( fingers[f] ) {
+          if ( MCKStressRandom(&seed, 2) )
+            MCKSessionDrop(fingers[f]);
+          else
+            MCKSessionCancel(fingers[f]);
+          fingers[f] = NULL;
+        }
+        break;
+      default:
+        if ( pending.count > 0 )
+          MCKStressCompleteReclaim(&pending, MCKStressRandom(&seed, (unsigned)pending.count));
+        break;
+    }
+    if ( pool.active_count == 0 ) {
+      idleChecks++;
+      if ( !MCKStressCardsInOrder(donor) )
+        misplaced++;
+    }
+  }
+
+  for (size_t f = 0; f < MCK_STRESS_FINGERS; ++f)
+    if ( fingers[f] )
+      MCKSessionCancel(fingers[f]);
+  while ( pending.count > 0 )
+    MCKStressCompleteReclaim(&pending, MCKStressRandom(&seed, (unsigned)pending.count));
+
+  // the run exercised overlapping reclaims, with the pool idle now and then
+  MCK_CHECK(pickups > MCK_STRESS_OPERATIONS / 20);
+  MCK_CHECK(pending.most >= 4);
+  MCK_CHECK(idleChecks > 0);
+  MCK_CHECK(shared == 0);
+  MCK_CHECK(misplaced == 0);
+  MCK_CHECK(pool.active_count == 0);
+  MCK_CHECK(MCKStressCardsInOrder(donor));
+  MCK_CHECK(root->child_count == 1);
+
+  for (size_t s = 0; s < MCK_STRESS_SESSIONS; ++s)
+    MCKSessionDispose(&storage[s]);
+  MCKNodeDestroy(root);
+}
+
+void MCKRunSessionPoolTests(void)
+{
+  MCKTestPoolStress(false, 3);
+  MCKTestPoolStress(true, 3);
+  MCKTestPoolStress(false, 11);
+}
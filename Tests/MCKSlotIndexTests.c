@@ -0,0 +1,203 @@
+//
+//  MCKSlotIndexTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-20.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+#include "MCKSessionTrace.h"
+#include "MCKSlotIndex.h"
+
+// a drag move must leave most of a 60 Hz frame to drawing
+#define MCK_TEST_MOVE_BUDGET 0.001
+
+/* Appends count slots of size, 10 pt apart along axis, from (x, y) */
+static void MCKTestAppendList(MCKSlotIndex * index, size_t count, double x, double y, MCKSize size)
+{
+  for (size_t i = 0; i < count; ++i) {
+    double along = i * ((index->axis == MCKSlotAxisHorizontal ? size.width : size.height) + 10);
+    MCKSlotIndexAppend(index, index->axis == MCKSlotAxisHorizontal ? MCKRectMake(x + along, y, size.width, size.height)
+                                                                   : MCKRectMake(x, y + along, size.width, size.height));
+  }
+}
+
+/* Appends count cells of 50 by 50, 10 pt apart, in rows of columns, from (x, y) */
+static void MCKTestAppendGrid(MCKSlotIndex * index, size_t count, size_t columns, double x, double y)
+{
+  for (size_t i = 0; i < count; ++i)
+    MCKSlotIndexAppend(index, MCKRectMake(x + (i % columns) * 60, y + (i / columns) * 60, 50, 50));
+}
+
+static void MCKTestListQueries(void)
+{
+  // a column of 5 slots, 40 pt tall, from y = 20
+  MCKSlotIndex index;
+  MCKSlotIndexInit(&index, MCKSlotAxisVertical);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 100)) == 0);
+  MCKTestAppendList(&index, 5, 0, 20, MCKSizeMake(100, 40));
+  MCK_CHECK_NEAR(index.spacing, 10);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 0)) == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 39)) == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 41)) == 1);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(500, 145)) == 3);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 1000)) == 5);
+  MCKSlotIndexDispose(&index);
+
+  // a row goes by x alone
+  MCKSlotIndexInit(&index, MCKSlotAxisHorizontal);
+  MCKTestAppendList(&index, 4, 5, 0, MCKSizeMake(30, 80));
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 500)) == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(61, 0)) == 2);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(146, 0)) == 4);
+  MCKSlotIndexDispose(&index);
+}
+
+static void MCKTestGridQueries(void)
+{
+  // 8 cells in rows of 3: the last row has 2
+  MCKSlotIndex index;
+  MCKSlotIndexInit(&index, MCKSlotAxisGrid);
+  MCKTestAppendGrid(&index, 8, 3, 0, 0);
+  MCK_CHECK(index.columns == 3);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(0, 0)) == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(200, 10)) == 3);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(70, 65)) == 4);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(10, 130)) == 6);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(200, 1000)) == 8);
+  // between rows, the row whose middle is nearer
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(10, 54)) == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(10, 56)) == 3);
+
+  // a single row does not know its columns, and takes every cell
+  MCKSlotIndexRemoveAll(&index);
+  MCKTestAppendGrid(&index, 5, 10, 0, 0);
+  MCK_CHECK(index.columns == 0);
+  MCK_CHECK(MCKSlotIndexInsertionIndex(&index, MCKPointMake(190, 500)) == 3);
+  MCKSlotIndexInsert(&index, 2, MCKSizeMake(50, 50));
+  MCK_CHECK_RECT(index.slots[5], 300, 0, 50, 50);
+  MCKSlotIndexDispose(&index);
+}
+
+static void MCKTestListReflow(void)
+{
+  MCKSlotIndex index;
+  MCKSlotIndexInit(&index, MCKSlotAxisVertical);
+  MCKTestAppendList(&index, 5, 0, 20, MCKSizeMake(100, 40));
+
+  // the slots after an insert move by its height and the spacing
+  MCKSlotIndexInsert(&index, 1, MCKSizeMake(100, 30));
+  MCK_CHECK(index.count == 6);
+  MCK_CHECK_RECT(index.slots[1], 0, 70, 100, 30);
+  MCK_CHECK_RECT(index.slots[2], 0, 110, 100, 40);
+  MCK_CHECK_RECT(index.slots[5], 0, 260, 100, 40);
+
+  // and move back when it is removed
+  MCKSlotIndexRemove(&index, 1);
+  MCK_CHECK(index.count == 5);
+  for (size_t i = 0; i < 5; ++i)
+    MCK_CHECK_RECT(index.slots[i], 0, 20 + i * 50, 100, 40);
+
+  // a slot inserted at the end keeps the spacing
+  MCKSlotIndexInsert(&index, 5, MCKSizeMake(100, 40));
+  MCK_CHECK_RECT(index.slots[5], 0, 270, 100, 40);
+  MCKSlotIndexInsert(&index, 100, MCKSizeMake(100, 40));
+  MCK_CHECK_RECT(index.slots[6], 0, 320, 100, 40);
+
+  // an emptied list starts again at the first slot's origin
+  while ( index.count > 0 )
+    MCKSlotIndexRemove(&index, 0);
+  MCKSlotIndexRemove(&index, 0);
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(100, 40));
+  MCK_CHECK_RECT(index.slots[0], 0, 20, 100, 40);
+  MCKSlotIndexDispose(&index);
+
+  // the same along a row
+  MCKSlotIndexInit(&index, MCKSlotAxisHorizontal);
+  MCKTestAppendList(&index, 3, 5, 0, MCKSizeMake(30, 80));
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(20, 80));
+  MCK_CHECK_RECT(index.slots[0], 5, 0, 20, 80);
+  MCK_CHECK_RECT(index.slots[1], 35, 0, 30, 80);
+  MCK_CHECK_RECT(index.slots[3], 115, 0, 30, 80);
+  MCKSlotIndexDispose(&index);
+}
+
+static void MCKTestGridReflow(void)
+{
+  MCKSlotIndex index;
+  MCKSlotIndexInit(&index, MCKSlotAxisGrid);
+  MCKTestAppendGrid(&index, 8, 3, 100, 200);
+
+  // cells stay put, and one is added or removed at the end
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(50, 50));
+  MCK_CHECK(index.count == 9);
+  MCK_CHECK_RECT(index.slots[0], 100, 200, 50, 50);
+  MCK_CHECK_RECT(index.slots[8], 220, 320, 50, 50);
+  MCKSlotIndexInsert(&index, 9, MCKSizeMake(50, 50));
+  MCK_CHECK_RECT(index.slots[9], 100, 380, 50, 50);
+  MCKSlotIndexRemove(&index, 4);
+  MCK_CHECK(index.count == 9);
+  MCK_CHECK_RECT(index.slots[8], 220, 320, 50, 50);
+
+  // an emptied grid starts again at the first cell's origin
+  while ( index.count > 0 )
+    MCKSlotIndexRemove(&index, 0);
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(50, 50));
+  MCK_CHECK_RECT(index.slots[0], 100, 200, 50, 50);
+  MCKSlotIndexInsert(&index, 1, MCKSizeMake(50, 50));
+  MCK_CHECK_RECT(index.slots[1], 160, 200, 50, 50);
+  MCKSlotIndexDispose(&index);
+
+  // a grid never laid out starts at its own origin
+  MCKSlotIndexInit(&index, MCKSlotAxisGrid);
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(50, 50));
+  MCK_CHECK_RECT(index.slots[0], 0, 0, 50, 50);
+  MCKSlotIndexDispose(&index);
+}
+
+static void MCKTestLongColumn(void)
+{
+  // a 10k-row column: each move queries the index, and a drop into it
+  // reflows every row after the insertion point, as does a pickup out of it
+  MCKSlotIndex index;
+  MCKSlotIndexInit(&index, MCKSlotAxisVertical);
+  MCKTestAppendList(&index, 10000, 0, 0, MCKSizeMake(320, 44));
+  double height = 10000 * 54;
+
+  unsigned state = 7;
+  size_t moves = 10000, misplaced = 0;
+  double start = MCKTraceNow();
+  for (size_t i = 0; i < moves; ++i) {
+    state = state * 1103515245u + 12345u;
+    double y = (state >> 8) % (unsigned)height;
+    size_t position = MCKSlotIndexInsertionIndex(&index, MCKPointMake(10, y));
+    if ( position != (size_t)((y + 32) / 54) )
+      misplaced++;
+    if ( i % 100 == 0 ) {
+      MCKSlotIndexInsert(&index, position, MCKSizeMake(320, 44));
+      MCKSlotIndexRemove(&index, position);
+    }
+  }
+  double perMove = (MCKTraceNow() - start) / moves;
+  MCK_CHECK(misplaced == 0);
+  MCK_CHECK(perMove < MCK_TEST_MOVE_BUDGET);
+  MCK_CHECK_RECT(index.slots[9999], 0, 9999 * 54, 320, 44);
+
+  // a reflow of the whole column fits in the budget too
+  start = MCKTraceNow();
+  MCKSlotIndexInsert(&index, 0, MCKSizeMake(320, 44));
+  MCKSlotIndexRemove(&index, 0);
+  MCK_CHECK(MCKTraceNow() - start < MCK_TEST_MOVE_BUDGET);
+  MCKSlotIndexDispose(&index);
+}
+
+void MCKRunSlotIndexTests(void)
+{
+  MCKTestListQueries();
+  MCKTestGridQueries();
+  MCKTestListReflow();
+  MCKTestGridReflow();
+  MCKTestLongColumn();
+}
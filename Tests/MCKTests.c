@@ -0,0 +1,26 @@
+//
+//  MCKTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+size_t MCKTestChecks = 0;
+size_t MCKTestFailures = 0;
+
+int main(void)
+{
+  MCKRunDragDropCoreTests();
+  MCKRunDonorLookupTests();
+  MCKRunSessionPoolTests();
+  MCKRunMovePipelineTests();
+  MCKRunSlotIndexTests();
+  MCKRunSessionMetricsTests();
+  PSRunLogTraceTests();
+
+  fprintf(stderr, "%zu checks, %zu failed\n", MCKTestChecks, MCKTestFailures);
+  return MCKTestFailures > 0;
+}
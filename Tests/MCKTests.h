@@ -0,0 +1,55 @@
+//
+//  MCKTests.h
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-09.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#ifndef MCKTests_h
+#define MCKTests_h
+
+/*
+ A minimal harness for the tests of the headless DnD core, built by the
+ mcktests target of CMakeLists.txt and run by ctest.
+
+ Each file of Tests/ holds one group of tests, run by its MCKRun...Tests
+ function. A failed check is reported with its file and line, and the run
+ goes on; the exit status is 1 if any check failed.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "MCKNodeTree.h"
+
+extern size_t MCKTestChecks;
+extern size_t MCKTestFailures;
+
+#define MCK_CHECK(condition) do { \
+    MCKTestChecks++; \
+    if ( !(condition) ) { \
+      MCKTestFailures++; \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+    } \
+  } while (0)
+
+#define MCK_CHECK_NEAR(a, b) MCK_CHECK(fabs((double)(a) - (double)(b)) < 1e-6)
+
+#define MCK_CHECK_RECT(rect, left, top, width_, height_) do { \
+    MCK_CHECK_NEAR((rect).origin.x, left); MCK_CHECK_NEAR((rect).origin.y, top); \
+    MCK_CHECK_NEAR((rect).size.width, width_); MCK_CHECK_NEAR((rect).size.height, height_); \
+  } while (0)
+
+/* ---------- Groups ---------- */
+
+void MCKRunDragDropCoreTests(void);
+void MCKRunDonorLookupTests(void);
+void MCKRunSessionPoolTests(void);
+void MCKRunMovePipelineTests(void);
+void MCKRunSlotIndexTests(void);
+void MCKRunSessionMetricsTests(void);
+void PSRunLogTraceTests(void);
+
+#endif
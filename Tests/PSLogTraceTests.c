@@ -0,0 +1,72 @@
+//
+//  PSLogTraceTests.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-14.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+
+#include "MCKTests.h"
+
+#include "PSLogTrace.h"
+
+// the records per thread of PSLogTrace.c
+#define PS_TEST_RING_CAPACITY 2048
+
+typedef struct {
+  size_t count;
+  double first;
+  double last;
+  double eventValues[4];
+  const char * lastFormat;
+} PSTestDrained;
+
+static void PSTestSink(void * context, const PSLogTraceRecord * record)
+{
+  PSTestDrained * drained = context;
+  if ( drained->count++ == 0 )
+    drained->first = record->values[0];
+  drained->last = record->values[0];
+  drained->lastFormat = record->site->format;
+  memcpy(drained->eventValues, record->values, sizeof(drained->eventValues));
+}
+
+static void PSTestFlightRecorder(void)
+{
+  PSLogTraceDrain(PSTestSink, &(PSTestDrained){ 0 });
+  uint64_t droppedBefore = PSLogTraceDroppedCount();
+
+  // without a flusher, a full ring keeps the newest records, but for the
+  // oldest one, whose slot the writer may be reusing as it is drained
+  for (int n = 0; n < PS_TEST_RING_CAPACITY + 1000; ++n)
+    PSLogTrace("record %g", (double)n);
+  PSTestDrained drained = { 0 };
+  MCK_CHECK(PSLogTraceDrain(PSTestSink, &drained) == PS_TEST_RING_CAPACITY - 1);
+  MCK_CHECK(drained.count == PS_TEST_RING_CAPACITY - 1);
+  MCK_CHECK_NEAR(drained.first, 1001);
+  MCK_CHECK_NEAR(drained.last, PS_TEST_RING_CAPACITY + 999);
+  MCK_CHECK(PSLogTraceDroppedCount() - droppedBefore == 1001);
+
+  // and goes on recording once drained
+  PSLogTrace("record %g", 1.0);
+  memset(&drained, 0, sizeof(drained));
+  MCK_CHECK(PSLogTraceDrain(PSTestSink, &drained) == 1);
+}
+
+static void PSTestEvent(void)
+{
+  PSLogTraceDrain(PSTestSink, &(PSTestDrained){ 0 });
+  PSLogTrace("record %g", 42.0);
+  PSLogTraceEvent("an event");
+  PSTestDrained drained = { 0 };
+  MCK_CHECK(PSLogTraceDrain(PSTestSink, &drained) == 2);
+  MCK_CHECK(strcmp(drained.lastFormat, "an event") == 0);
+  for (int v = 0; v < 4; ++v)
+    MCK_CHECK(drained.eventValues[v] == 0);
+}
+
+void PSRunLogTraceTests(void)
+{
+  PSTestFlightRecorder();
+  PSTestEvent();
+}
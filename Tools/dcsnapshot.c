@@ -0,0 +1,665 @@
+//
+//  dcsnapshot.c
+//
+//  Created by Alexis Gallagher on 2012-08-27.
+//
+//  Reads the view hierarchy snapshots DCIntrospect writes, on the Mac or on Linux:
+//
+//    cc -std=c99 -O2 -I.. -o dcsnapshot dcsnapshot.c ../DCSnapshotFormat.c
+//
+//    dcsnapshot list <file>                 the snapshots in the file
+//    dcsnapshot dump <file> [sequence]      the hierarchy as of a snapshot, the last by default
+//    dcsnapshot diff <file> [from [to]]     what changed between two snapshots, the last two by default
+//
+//  Incremental snapshots are played over the ones before them, so any snapshot in a
+//  file can be shown whole.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "DCSnapshotFormat.h"
+
+typedef struct DCNode
+{
+	DCSnapshotNode values;				// its strings belong to the decoder
+	uint64_t parentId;
+	uint64_t *childIds;
+	uint32_t childCount;
+} DCNode;
+
+// the hierarchy as of the last snapshot played
+typedef struct
+{
+	uint64_t rootId;
+	uint64_t *keys;						// open-addressed by id, 0 if free
+	DCNode **nodes;						// NULL for a removed node
+	size_t slotCount;
+	size_t usedCount;					// slots with a key, removed or not
+} DCHierarchy;
+
+// a node of the hierarchy with its place in it, for diffing
+typedef struct
+{
+	DCSnapshotNode values;
+	uint64_t parentId;
+	uint32_t index;
+	char *path;
+} DCFlatNode;
+
+typedef struct
+{
+	uint32_t sequence;
+	bool incremental;
+	double time;
+	uint32_t visitedCount, writtenCount, treeCount;
+	size_t offset;						// of its begin record
+	bool complete;
+} DCSnapshotInfo;
+
+static void *DCAllocate(size_t size)
+{
+	void *memory = calloc(1, size);
+	if (!memory)
+	{
+		fprintf(stderr, "dcsnapshot: out of memory\n");
+		exit(1);
+	}
+	return memory;
+}
+
+#pragma mark Hierarchy
+
+static size_t DCSlotOfId(uint64_t id, size_t slotCount)
+{
+	return (size_t)((id >> 4) * 11400714819323198485ull >> 20) & (slotCount - 1);
+}
+
+static void DCHierarchyRehash(DCHierarchy *hierarchy, size_t slotCount)
+{
+	uint64_t *oldKeys = hierarchy->keys;
+	DCNode **oldNodes = hierarchy->nodes;
+	size_t oldSlotCount = hierarchy->slotCount;
+
+	hierarchy->keys = DCAllocate(slotCount * sizeof(uint64_t));
+	hierarchy->nodes = DCAllocate(slotCount * sizeof(DCNode *));
+	hierarchy->slotCount = slotCount;
+	hierarchy->usedCount = 0;
+	for (size_t i = 0; i < oldSlotCount; i++)
+	{
+		if (!oldNodes[i])
+			continue;
+		size_t slot = DCSlotOfId(oldKeys[i], slotCount);
+		while (hierarchy->keys[slot])
+			slot = (slot + 1) & (slotCount - 1);
+		hierarchy->keys[slot] = oldKeys[i];
+		hierarchy->nodes[slot] = oldNodes[i];
+		hierarchy->usedCount++;
+	}
+	free(oldKeys);
+	free(oldNodes);
+}
+
+static size_t DCHierarchySlot(DCHierarchy *hierarchy, uint64_t id)
+{
+	size_t slot = DCSlotOfId(id, hierarchy->slotCount);
+	while (hierarchy->keys[slot] && hierarchy->keys[slot] != id)
+		slot = (slot + 1) & (hierarchy->slotCount - 1);
+	return slot;
+}
+
+static DCNode *DCHierarchyNode(DCHierarchy *hierarchy, uint64_t id)
+{
+	if (!hierarchy->slotCount || !id)
+		return NULL;
+	return hierarchy->nodes[DCHierarchySlot(hierarchy, id)];
+}
+
+static void DCHierarchyInsert(DCHierarchy *hierarchy, DCNode *node)
+{
+	if ((hierarchy->usedCount + 1) * 2 > hierarchy->slotCount)
+		DCHierarchyRehash(hierarchy, hierarchy->slotCount ? hierarchy->slotCount * 2 : 1024);
+	size_t slot = DCHierarchySlot(hierarchy, node->values.id);
+	if (!hierarchy->keys[slot])
+	{
+		hierarchy->keys[slot] = node->values.id;
+		hierarchy->usedCount++;
+	}
+	hierarchy->nodes[slot] = node;
+}
+
+static void DCNodeFree(DCNode *node)
+{
+	free(node->childIds);
+	free(node);
+}
+
+// Removes the node and everything under it, leaving its place in its parent. A child
+// which a tree played earlier in the snapshot has moved elsewhere stays.
+static void DCHierarchyRemoveSubtree(DCHierarchy *hierarchy, uint64_t id, uint64_t parentId)
+{
+	if (!hierarchy->slotCount)
+		return;
+	size_t slot = DCHierarchySlot(hierarchy, id);
+	DCNode *node = hierarchy->nodes[slot];
+	if (!node || node->parentId != parentId)
+		return;
+	hierarchy->nodes[slot] = NULL;
+	for (uint32_t i = 0; i < node->childCount; i++)
+		DCHierarchyRemoveSubtree(hierarchy, node->childIds[i], id);
+	DCNodeFree(node);
+}
+
+static void DCHierarchyClear(DCHierarchy *hierarchy)
+{
+	for (size_t i = 0; i < hierarchy->slotCount; i++)
+		if (hierarchy->nodes[i])
+			DCNodeFree(hierarchy->nodes[i]);
+	free(hierarchy->keys);
+	free(hierarchy->nodes);
+	memset(hierarchy, 0, sizeof(*hierarchy));
+}
+
+#pragma mark Playing
+
+// Reads the nodes of a tree record into the hierarchy, in place of the subtree they
+// replace. false if the data is broken.
+static bool DCPlayTree(DCHierarchy *hierarchy, DCSnapshotDecoder *decoder, uint64_t parentId)
+{
+	DCSnapshotRecord record;
+	if (DCSnapshotDecoderNext(decoder, &record) != DCSnapshotRecordNode)
+		return false;
+
+	uint64_t rootId = record.node.id;
+	DCNode *oldRoot = DCHierarchyNode(hierarchy, rootId);
+	if (oldRoot)
+		DCHierarchyRemoveSubtree(hierarchy, rootId, oldRoot->parentId);
+	if (parentId == 0)
+	{
+		DCHierarchyClear(hierarchy);
+		hierarchy->rootId = rootId;
+	}
+	else
+	{
+		// the parent is unchanged, so the root keeps its place in it
+		DCNode *parent = DCHierarchyNode(hierarchy, parentId);
+		if (!parent)
+			return false;
+		bool found = false;
+		for (uint32_t i = 0; i < parent->childCount && !found; i++)
+			found = parent->childIds[i] == rootId;
+		if (!found)
+			return false;
+	}
+
+	// the nodes still to fill in children, deepest last
+	DCNode **stack = NULL;
+	size_t stackCount = 0, stackCapacity = 0;
+	uint32_t *filled = NULL;
+	for (;;)
+	{
+		// a view moved here, from a subtree which is played later in the snapshot, if at all
+		DCNode *oldNode = DCHierarchyNode(hierarchy, record.node.id);
+		for (size_t i = 0; i < stackCount && oldNode; i++)
+		{
+			// a view under itself
+			if (stack[i] == oldNode)
+			{
+				free(stack);
+				free(filled);
+				return false;
+			}
+		}
+		if (oldNode)
+			DCHierarchyRemoveSubtree(hierarchy, record.node.id, oldNode->parentId);
+
+		DCNode *node = DCAllocate(sizeof(DCNode));
+		node->values = record.node;
+		node->childIds = DCAllocate((node->values.childCount ? node->values.childCount : 1) * sizeof(uint64_t));
+		if (stackCount == 0)
+			node->parentId = parentId;
+		else
+		{
+			DCNode *parent = stack[stackCount - 1];
+			node->parentId = parent->values.id;
+			parent->childIds[filled[stackCount - 1]++] = node->values.id;
+			parent->childCount = filled[stackCount - 1];
+		}
+		DCHierarchyInsert(hierarchy, node);
+
+		if (node->values.childCount > 0)
+		{
+			if (stackCount == stackCapacity)
+			{
+				stackCapacity = stackCapacity ? stackCapacity * 2 : 64;
+				stack = realloc(stack, stackCapacity * sizeof(DCNode *));
+				filled = realloc(filled, stackCapacity * sizeof(uint32_t));
+			}
+			stack[stackCount] = node;
+			filled[stackCount] = 0;
+			stackCount++;
+		}
+		while (stackCount > 0 && filled[stackCount - 1] == stack[stackCount - 1]->values.childCount)
+			stackCount--;
+		if (stackCount == 0)
+			break;
+
+		if (DCSnapshotDecoderNext(decoder, &record) != DCSnapshotRecordNode)
+		{
+			free(stack);
+			free(filled);
+			return false;
+		}
+	}
+	free(stack);
+	free(filled);
+	return true;
+}
+
+// A file cut short, e.g. by the app being killed, keeps the snapshots which were complete
+static bool DCPlayBroken(DCSnapshotDecoder *decoder, size_t *infoCount, DCSnapshotInfo *info)
+{
+	fprintf(stderr, "dcsnapshot: %s at byte %zu\n", decoder->error ? decoder->error : "broken tree", decoder->offset);
+	if (info && !info->complete)
+		(*infoCount)--;
+	return *infoCount > 0;
+}
+
+// Reads the file's snapshots into infos, and plays them into the hierarchy up to and
+// including the one with the sequence number stopSequence, or all of them.
+static bool DCPlay(const uint8_t *bytes, size_t length, DCSnapshotDecoder *decoder, DCHierarchy *hierarchy,
+				   bool stopAtSequence, uint32_t stopSequence, DCSnapshotInfo **infos, size_t *infoCount)
+{
+	size_t capacity = 0;
+	*infos = NULL;
+	*infoCount = 0;
+	if (!DCSnapshotDecoderInit(decoder, bytes, length))
+	{
+		fprintf(stderr, "dcsnapshot: %s\n", decoder->error);
+		return false;
+	}
+
+	DCSnapshotInfo *info = NULL;
+	for (;;)
+	{
+		size_t offset = decoder->offset;
+		DCSnapshotRecord record;
+		switch (DCSnapshotDecoderNext(decoder, &record))
+		{
+			case DCSnapshotRecordEnd:
+				if (info && !info->complete)
+					(*infoCount)--;
+				return true;
+
+			case DCSnapshotRecordBeginSnapshot:
+				if (*infoCount == capacity)
+				{
+					capacity = capacity ? capacity * 2 : 16;
+					*infos = realloc(*infos, capacity * sizeof(DCSnapshotInfo));
+				}
+				info = &(*infos)[(*infoCount)++];
+				memset(info, 0, sizeof(*info));
+				info->sequence = record.sequence;
+				info->incremental = record.incremental;
+				info->time = record.time;
+				info->offset = offset;
+				break;
+
+			case DCSnapshotRecordTree:
+				if (!info || !DCPlayTree(hierarchy, decoder, record.parentId))
+					return DCPlayBroken(decoder, infoCount, info);
+				info->treeCount++;
+				break;
+
+			case DCSnapshotRecordEndSnapshot:
+				if (!info)
+					break;
+				info->visitedCount = record.visitedCount;
+				info->writtenCount = record.writtenCount;
+				info->complete = true;
+				if (stopAtSequence && info->sequence == stopSequence)
+					return true;
+				break;
+
+			case DCSnapshotRecordNode:
+			case DCSnapshotRecordError:
+				return DCPlayBroken(decoder, infoCount, info);
+		}
+	}
+}
+
+static uint8_t *DCReadFile(const char *path, size_t *length)
+{
+	FILE *file = fopen(path, "rb");
+	if (!file)
+	{
+		perror(path);
+		return NULL;
+	}
+	size_t capacity = 1 << 16;
+	uint8_t *bytes = DCAllocate(capacity);
+	*length = 0;
+	size_t count;
+	while ((count = fread(bytes + *length, 1, capacity - *length, file)) > 0)
+	{
+		*length += count;
+		if (*length == capacity)
+		{
+			capacity *= 2;
+			bytes = realloc(bytes, capacity);
+		}
+	}
+	fclose(file);
+	return bytes;
+}
+
+#pragma mark Printing
+
+static void DCPrintValues(const DCSnapshotNode *values)
+{
+	printf("%s", values->className);
+	if (values->name)
+		printf(" '%s'", values->name);
+	printf(" %#" PRIx64 " {{%g, %g}, {%g, %g}}", values->id, values->x, values->y, values->width, values->height);
+	if (values->alpha != 1.0f)
+		printf(" alpha %g", values->alpha);
+	if (values->tag)
+		printf(" tag %d", values->tag);
+	if (values->flags & DCSnapshotFlagHidden)
+		printf(" hidden");
+	if (values->flags & DCSnapshotFlagOpaque)
+		printf(" opaque");
+	if (values->flags & DCSnapshotFlagClipsToBounds)
+		printf(" clips");
+	if (!(values->flags & DCSnapshotFlagUserInteractionEnabled))
+		printf(" no-interaction");
+	if (values->roles & DCSnapshotRoleDraggable)
+		printf(" draggable");
+	if (values->roles & DCSnapshotRoleDonor)
+		printf(" donor");
+	if (values->roles & DCSnapshotRoleAbsorber)
+		printf(" absorber");
+}
+
+// the node, if it is still the child of the parent which lists it
+static DCNode *DCHierarchyChild(DCHierarchy *hierarchy, uint64_t id, uint64_t parentId)
+{
+	DCNode *node = DCHierarchyNode(hierarchy, id);
+	return node && node->parentId == parentId ? node : NULL;
+}
+
+static void DCDumpNode(DCHierarchy *hierarchy, uint64_t id, uint64_t parentId, int depth)
+{
+	DCNode *node = DCHierarchyChild(hierarchy, id, parentId);
+	if (!node)
+		return;
+	printf("%*s", depth * 2, "");
+	DCPrintValues(&node->values);
+	printf("\n");
+	for (uint32_t i = 0; i < node->childCount; i++)
+		DCDumpNode(hierarchy, node->childIds[i], id, depth + 1);
+}
+
+static void DCFlattenNode(DCHierarchy *hierarchy, uint64_t id, uint64_t parentId, uint32_t index, const char *parentPath,
+						  DCFlatNode **flat, size_t *count, size_t *capacity)
+{
+	DCNode *node = DCHierarchyChild(hierarchy, id, parentId);
+	if (!node)
+		return;
+	if (*count == *capacity)
+	{
+		*capacity = *capacity ? *capacity * 2 : 1024;
+		*flat = realloc(*flat, *capacity * sizeof(DCFlatNode));
+	}
+	DCFlatNode *flatNode = &(*flat)[(*count)++];
+	flatNode->values = node->values;
+	flatNode->parentId = node->parentId;
+	flatNode->index = index;
+
+	const char *segment = node->values.name ? node->values.name : node->values.className;
+	size_t length = strlen(parentPath) + strlen(segment) + 16;
+	flatNode->path = DCAllocate(length);
+	if (parentPath[0])
+		snprintf(flatNode->path, length, "%s/%s[%u]", parentPath, segment, index);
+	else
+		snprintf(flatNode->path, length, "%s", segment);
+
+	// flatNode may move as the array grows
+	char *path = flatNode->path;
+	for (uint32_t i = 0; i < node->childCount; i++)
+		DCFlattenNode(hierarchy, node->childIds[i], id, i, path, flat, count, capacity);
+}
+
+static int DCCompareFlatNodes(const void *a, const void *b)
+{
+	uint64_t idA = ((const DCFlatNode *)a)->values.id, idB = ((const DCFlatNode *)b)->values.id;
+	return idA < idB ? -1 : idA > idB;
+}
+
+static DCFlatNode *DCFlatten(DCHierarchy *hierarchy, size_t *count)
+{
+	DCFlatNode *flat = NULL;
+	size_t capacity = 0;
+	*count = 0;
+	DCFlattenNode(hierarchy, hierarchy->rootId, 0, 0, "", &flat, count, &capacity);
+	qsort(flat, *count, sizeof(DCFlatNode), DCCompareFlatNodes);
+	return flat;
+}
+
+static void DCFreeFlat(DCFlatNode *flat, size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		free(flat[i].path);
+	free(flat);
+}
+
+static bool DCStringsDiffer(const char *a, const char *b)
+{
+	if (!a || !b)
+		return a != b;
+	return strcmp(a, b) != 0;
+}
+
+// prints what changed in a view, if anything, and whether it did
+static bool DCPrintChanges(const DCFlatNode *from, const DCFlatNode *to)
+{
+	const DCSnapshotNode *a = &from->values, *b = &to->values;
+	bool changed = false;
+#define DCChange(...) do { printf(changed ? ", " : "~ %s: ", to->path); printf(__VA_ARGS__); changed = true; } while (0)
+	if (DCStringsDiffer(a->className, b->className))
+		DCChange("class %s -> %s", a->className, b->className);
+	if (DCStringsDiffer(a->name, b->name))
+		DCChange("name %s -> %s", a->name ? a->name : "(none)", b->name ? b->name : "(none)");
+	if (a->x != b->x || a->y != b->y || a->width != b->width || a->height != b->height)
+		DCChange("frame {{%g, %g}, {%g, %g}} -> {{%g, %g}, {%g, %g}}", a->x, a->y, a->width, a->height, b->x, b->y, b->width, b->height);
+	if (a->alpha != b->alpha)
+		DCChange("alpha %g -> %g", a->alpha, b->alpha);
+	if (a->tag != b->tag)
+		DCChange("tag %d -> %d", a->tag, b->tag);
+	if (a->flags != b->flags)
+		DCChange("flags %#x -> %#x", a->flags, b->flags);
+	if (a->roles != b->roles)
+		DCChange("roles %#x -> %#x", a->roles, b->roles);
+	if (from->parentId != to->parentId)
+		DCChange("moved from %s", from->path);
+	else if (from->index != to->index)
+		DCChange("index %u -> %u", from->index, to->index);
+#undef DCChange
+	if (changed)
+		printf("\n");
+	return changed;
+}
+
+#pragma mark Commands
+
+static const DCSnapshotInfo *DCFindSnapshot(const DCSnapshotInfo *infos, size_t count, uint32_t sequence)
+{
+	for (size_t i = 0; i < count; i++)
+		if (infos[i].sequence == sequence)
+			return &infos[i];
+	fprintf(stderr, "dcsnapshot: no snapshot %u\n", sequence);
+	return NULL;
+}
+
+// the complete snapshots in the file
+static bool DCReadInfos(const uint8_t *bytes, size_t length, DCSnapshotInfo **infos, size_t *count)
+{
+	DCSnapshotDecoder decoder;
+	DCHierarchy hierarchy = {0};
+	bool ok = DCPlay(bytes, length, &decoder, &hierarchy, false, 0, infos, count);
+	DCHierarchyClear(&hierarchy);
+	DCSnapshotDecoderFree(&decoder);
+	if (ok && *count == 0)
+	{
+		fprintf(stderr, "dcsnapshot: no snapshots\n");
+		ok = false;
+	}
+	if (!ok)
+		free(*infos);
+	return ok;
+}
+
+static int DCList(const uint8_t *bytes, size_t length)
+{
+	DCSnapshotDecoder decoder;
+	DCHierarchy hierarchy = {0};
+	DCSnapshotInfo *infos;
+	size_t count;
+	bool ok = DCPlay(bytes, length, &decoder, &hierarchy, false, 0, &infos, &count);
+	for (size_t i = 0; i < count; i++)
+		printf("%u\t%s\t%.3f s\t%u views, %u written in %u trees, at byte %zu\n", infos[i].sequence,
+			   infos[i].incremental ? "incremental" : "full", infos[i].time - infos[0].time,
+			   infos[i].visitedCount, infos[i].writtenCount, infos[i].treeCount, infos[i].offset);
+	free(infos);
+	DCHierarchyClear(&hierarchy);
+	DCSnapshotDecoderFree(&decoder);
+	return ok ? 0 : 1;
+}
+
+static int DCDump(const uint8_t *bytes, size_t length, bool hasSequence, uint32_t sequence)
+{
+	DCSnapshotInfo *infos;
+	size_t count;
+	if (!DCReadInfos(bytes, length, &infos, &count))
+		return 1;
+	if (!hasSequence)
+		sequence = infos[count - 1].sequence;
+	bool ok = DCFindSnapshot(infos, count, sequence) != NULL;
+	free(infos);
+	if (!ok)
+		return 1;
+
+	DCSnapshotDecoder decoder;
+	DCHierarchy hierarchy = {0};
+	DCPlay(bytes, length, &decoder, &hierarchy, true, sequence, &infos, &count);
+	DCDumpNode(&hierarchy, hierarchy.rootId, 0, 0);
+	free(infos);
+	DCHierarchyClear(&hierarchy);
+	DCSnapshotDecoderFree(&decoder);
+	return 0;
+}
+
+// sequenceCount of fromSequence and toSequence are given; the last two snapshots by default
+static int DCDiff(const uint8_t *bytes, size_t length, int sequenceCount, uint32_t fromSequence, uint32_t toSequence)
+{
+	DCSnapshotInfo *infos;
+	size_t count;
+	if (!DCReadInfos(bytes, length, &infos, &count))
+		return 1;
+	if (sequenceCount < 2)
+		toSequence = infos[count - 1].sequence;
+	if (sequenceCount < 1)
+		fromSequence = count >= 2 ? infos[count - 2].sequence : toSequence;
+	bool ok = DCFindSnapshot(infos, count, fromSequence) && DCFindSnapshot(infos, count, toSequence);
+	free(infos);
+	if (!ok)
+		return 1;
+
+	// the flattened nodes' strings belong to the decoders, kept to the end
+	DCSnapshotDecoder fromDecoder, toDecoder;
+	DCHierarchy hierarchy = {0};
+	size_t fromCount, toCount;
+	DCPlay(bytes, length, &fromDecoder, &hierarchy, true, fromSequence, &infos, &count);
+	DCFlatNode *from = DCFlatten(&hierarchy, &fromCount);
+	free(infos);
+	DCHierarchyClear(&hierarchy);
+
+	DCPlay(bytes, length, &toDecoder, &hierarchy, true, toSequence, &infos, &count);
+	DCFlatNode *to = DCFlatten(&hierarchy, &toCount);
+	free(infos);
+	DCHierarchyClear(&hierarchy);
+
+	size_t added = 0, removed = 0, changed = 0;
+	size_t i = 0, j = 0;
+	while (i < fromCount || j < toCount)
+	{
+		if (j == toCount || (i < fromCount && from[i].values.id < to[j].values.id))
+		{
+			printf("- %s: ", from[i].path);
+			DCPrintValues(&from[i].values);
+			printf("\n");
+			removed++;
+			i++;
+		}
+		else if (i == fromCount || to[j].values.id < from[i].values.id)
+		{
+			printf("+ %s: ", to[j].path);
+			DCPrintValues(&to[j].values);
+			printf("\n");
+			added++;
+			j++;
+		}
+		else
+		{
+			if (DCPrintChanges(&from[i], &to[j]))
+				changed++;
+			i++;
+			j++;
+		}
+	}
+	printf("%zu added, %zu removed, %zu changed, of %zu views in %u and %zu in %u\n",
+		   added, removed, changed, fromCount, fromSequence, toCount, toSequence);
+
+	DCFreeFlat(from, fromCount);
+	DCFreeFlat(to, toCount);
+	DCSnapshotDecoderFree(&fromDecoder);
+	DCSnapshotDecoderFree(&toDecoder);
+	return 0;
+}
+
+static int DCUsage(void)
+{
+	fprintf(stderr, "usage: dcsnapshot list <file>\n"
+					"       dcsnapshot dump <file> [sequence]\n"
+					"       dcsnapshot diff <file> [from [to]]\n");
+	return 2;
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+		return DCUsage();
+
+	const char *command = argv[1];
+	size_t length;
+	uint8_t *bytes = DCReadFile(argv[2], &length);
+	if (!bytes)
+		return 1;
+
+	int status;
+	if (strcmp(command, "list") == 0 && argc == 3)
+		status = DCList(bytes, length);
+	else if (strcmp(command, "dump") == 0 && argc <= 4)
+		status = DCDump(bytes, length, argc == 4, argc == 4 ? (uint32_t)strtoul(argv[3], NULL, 10) : 0);
+	else if (strcmp(command, "diff") == 0 && argc <= 5)
+		status = DCDiff(bytes, length, argc - 3,
+						argc >= 4 ? (uint32_t)strtoul(argv[3], NULL, 10) : 0,
+						argc == 5 ? (uint32_t)strtoul(argv[4], NULL, 10) : 0);
+	else
+		status = DCUsage();
+
+	free(bytes);
+	return status;
+}
@@ -0,0 +1,85 @@
+//
+//  mckdonorbench.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-06.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+//  Measures the cost of finding the donor of a view as it gets deeper below
+//  the donor, off device:
+//
+//    cd DragDropSpike
+//    cc -std=c99 -O2 -I. -o mckdonorbench ../Tools/mckdonorbench.c MCKNodeTree.c MCKDragDropCore.c
+//       MCKTraceReplay.c MCKSessionTrace.c MCKSessionMetrics.c -lm
+//
+//    mckdonorbench [lookups] > results.json
+//
+//  For each depth from 10 to 1000, a card is nested that many levels below its
+//  donor, and its donor is looked up the way a pickup does, with
+//  MCKSessionCanBegin over the headless host. The results are a JSON array of
+//  one object per depth, on stdout; a summary goes to stderr.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MCKNodeTree.h"
+#include "MCKTraceReplay.h"
+
+// lookups timed together, to be well above the clock's resolution
+#define MCK_LOOKUPS_PER_SAMPLE 100
+
+int main(int argc, char * argv[])
+{
+  static const size_t depths[] = { 10, 30, 100, 300, 1000 };
+  size_t lookups = argc > 1 ? strtoul(argv[1], NULL, 10) : 100000;
+  size_t samples = lookups / MCK_LOOKUPS_PER_SAMPLE;
+  if ( samples == 0 ) {
+    fprintf(stderr, "usage: mckdonorbench [lookups, at least %d]\n", MCK_LOOKUPS_PER_SAMPLE);
+    return 2;
+  }
+
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  double * times = malloc(samples * sizeof(double));
+  size_t failures = 0;
+
+  printf("[");
+  for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); ++d) {
+    MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+    MCKNode * donor = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+    donor->roles = MCKDragDropRoleDonor;
+    MCKNodeAddChild(root, donor);
+    MCKNode * card = donor;
+    for (size_t level = 0; level < depths[d]; ++level) {
+      MCKNode * child = MCKNodeCreate(MCKRectMake(0, 0, 100, 100));
+      MCKNodeAddChild(card, child);
+      card = child;
+    }
+
+    for (size_t s = 0; s < samples; ++s) {
+      double start = MCKTraceNow();
+      for (size_t n = 0; n < MCK_LOOKUPS_PER_SAMPLE; ++n) {
+        MCKHandle found = NULL;
+        if ( !MCKSessionCanBegin(&host, card, &found) || found != donor )
+          failures++;
+      }
+      times[s] = (MCKTraceNow() - start) / MCK_LOOKUPS_PER_SAMPLE;
+    }
+    MCKLatencySummary lookup = MCKLatencySummarize(times, samples);
+    MCKNodeDestroy(root);
+
+    printf(d == 0 ? "\n" : ",\n");
+    printf("{\"depth\":%zu,\"lookups\":%zu,", depths[d], samples * MCK_LOOKUPS_PER_SAMPLE);
+    MCKLatencySummaryWriteJSON("lookup", lookup, stdout);
+    printf(",\"ns_per_level\":%.3f}", lookup.p50 * 1e9 / depths[d]);
+    fprintf(stderr, "depth %5zu  lookup p50 %9.3f us  p99 %9.3f us  %6.2f ns per level\n",
+            depths[d], lookup.p50 * 1e6, lookup.p99 * 1e6, lookup.p50 * 1e9 / depths[d]);
+  }
+  printf("\n]\n");
+
+  free(times);
+  if ( failures > 0 )
+    fprintf(stderr, "%zu lookups found the wrong donor\n", failures);
+  return failures > 0;
+}
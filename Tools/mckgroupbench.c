@@ -0,0 +1,215 @@
+//
+//  mckgroupbench.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-08.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+//  Times dragging a selection of many views at once, off device, against
+//  dragging each of them in a session of its own:
+//
+//    cd DragDropSpike
+//    cc -std=c99 -O2 -I. -o mckgroupbench ../Tools/mckgroupbench.c MCKNodeTree.c MCKDragDropCore.c
+//       MCKTraceReplay.c MCKSessionTrace.c MCKSessionMetrics.c -lm
+//
+//    mckgroupbench [items [runs]] > results.json
+//
+//  A donor holds a grid of cards, and an absorber sits beside it. Each run
+//  picks up items cards at random, moves them over the absorber in 60 steps,
+//  and drops them there, or cancels the drag so they are reclaimed. This is
+//  done with one multi-item session, with and without drag proxies, and with
+//  one session per card, all moved together on each step.
+//
+//  Each phase of a run, the pickup, each move step and the drop or reclaim,
+//  stands for the work of one frame. The results give the percentiles of
+//  each phase and the number of frames over the 60 Hz budget, as a JSON
+//  array on stdout; a summary goes to stderr. Reclaims are instantaneous
+//  here, as in MCKNodeTree.h, so they time the reparenting alone.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "MCKNodeTree.h"
+#include "MCKTraceReplay.h"
+
+#define MCK_GROUP_CARDS 2000
+#define MCK_GROUP_MOVES 60
+#define MCK_GROUP_FRAME_BUDGET (1.0 / 60)
+
+typedef enum {
+  MCKGroupModeReparenting,
+  MCKGroupModeProxies,
+  MCKGroupModeSessionPerItem,
+} MCKGroupMode;
+
+static const char * const MCKGroupModeNames[] = { "group", "group_proxies", "session_per_item" };
+
+typedef struct {
+  double * pickup;
+  double * move;
+  double * end;
+  size_t moves;
+  size_t frameDrops;
+  size_t failures;
+} MCKGroupSamples;
+
+static bool MCKGroupAccept(void * context, MCKHandle absorber, MCKHandle drag, void * payload)
+{
+  (void)context; (void)absorber; (void)drag; (void)payload;
+  return true;
+}
+
+static bool MCKGroupAcceptItems(void * context, MCKHandle absorber, const MCKSession * session)
+{
+  (void)context; (void)absorber; (void)session;
+  return true;
+}
+
+static double MCKGroupTimeFrame(double start, MCKGroupSamples * samples)
+{
+  double elapsed = MCKTraceNow() - start;
+  if ( elapsed > MCK_GROUP_FRAME_BUDGET )
+    samples->frameDrops++;
+  return elapsed;
+}
+
+/* One run: picks up the cards at picks, moves them onto the absorber, and drops or cancels */
+static void MCKGroupRun(MCKGroupMode mode, bool absorb, const size_t * picks, size_t items, size_t run,
+                        MCKSession * sessions, MCKHandle * others, double * steps, MCKGroupSamples * samples)
+{
+  MCKNode * root = MCKNodeCreate(MCKRectMake(0, 0, 2048, 1536));
+  MCKNode * donor = MCKNodeCreate(MCKRectMake(0, 0, 1024, 1536));
+  donor->roles = MCKDragDropRoleDonor;
+  MCKNodeAddChild(root, donor);
+  MCKNode * absorber = MCKNodeCreate(MCKRectMake(1024, 0, 1024, 1536));
+  absorber->roles = MCKDragDropRoleAbsorber;
+  MCKNodeAddChild(root, absorber);
+  MCKNode * cards[MCK_GROUP_CARDS];
+  for (size_t i = 0; i < MCK_GROUP_CARDS; ++i) {
+    cards[i] = MCKNodeCreate(MCKRectMake((i % 40) * 25, (i / 40) * 30, 20, 20));
+    cards[i]->roles = MCKDragDropRoleDraggable;
+    MCKNodeAddChild(donor, cards[i]);
+  }
+
+  MCKDragDropHost host;
+  MCKNodeTreeHostInit(&host);
+  host.callbacks.absorber_can_absorb = MCKGroupAccept;
+  host.callbacks.absorber_can_absorb_items = MCKGroupAcceptItems;
+  host.drag_proxies = mode == MCKGroupModeProxies;
+  size_t sessionCount = mode == MCKGroupModeSessionPerItem ? items : 1;
+  for (size_t s = 0; s < sessionCount; ++s)
+    MCKSessionInit(&sessions[s], &host, NULL);
+
+  // the card under the finger of each session ends up well inside the absorber
+  MCKNode * drag = cards[picks[0]];
+  for (size_t s = 0; s < sessionCount; ++s)
+    steps[s] = (1536 - MCKNodeGetFrame(cards[picks[s]]).origin.x) / MCK_GROUP_MOVES;
+
+  double start = MCKTraceNow();
+  if ( mode == MCKGroupModeSessionPerItem ) {
+    for (size_t s = 0; s < items; ++s)
+      if ( !MCKSessionPickUp(&sessions[s], cards[picks[s]]) )
+        samples->failures++;
+  }
+  else {
+    for (size_t i = 1; i < items; ++i)
+      others[i - 1] = cards[picks[i]];
+    if ( !MCKSessionPickUpItems(&sessions[0], drag, others, items - 1) || sessions[0].item_count != items )
+      samples->failures++;
+  }
+  samples->pickup[run] = MCKGroupTimeFrame(start, samples);
+
+  for (size_t m = 0; m < MCK_GROUP_MOVES; ++m) {
+    start = MCKTraceNow();
+    for (size_t s = 0; s < sessionCount; ++s)
+      MCKSessionMove(&sessions[s], steps[s], 0);
+    samples->move[samples->moves++] = MCKGroupTimeFrame(start, samples);
+  }
+
+  start = MCKTraceNow();
+  for (size_t s = 0; s < sessionCount; ++s) {
+    if ( !absorb )
+      MCKSessionCancel(&sessions[s]);
+    else if ( MCKSessionDrop(&sessions[s]) != MCKDropOutcomeAccepted )
+      samples->failures++;
+  }
+  samples->end[run] = MCKGroupTimeFrame(start, samples);
+
+  if ( (absorb ? absorber : donor)->child_count != (absorb ? items : MCK_GROUP_CARDS) )
+    samples->failures++;
+  for (size_t s = 0; s < sessionCount; ++s)
+    MCKSessionDispose(&sessions[s]);
+  MCKNodeDestroy(root);
+}
+
+int main(int argc, char * argv[])
+{
+  size_t items = argc > 1 ? strtoul(argv[1], NULL, 10) : 500;
+  size_t runs = argc > 2 ? strtoul(argv[2], NULL, 10) : 20;
+  if ( items < 1 || items > MCK_GROUP_CARDS || runs < 1 ) {
+    fprintf(stderr, "usage: mckgroupbench [items, at most %d [runs]]\n", MCK_GROUP_CARDS);
+    return 2;
+  }
+
+  MCKSession * sessions = calloc(items, sizeof(MCKSession));
+  MCKHandle * others = malloc(items * sizeof(MCKHandle));
+  double * steps = malloc(items * sizeof(double));
+  size_t * picks = malloc(MCK_GROUP_CARDS * sizeof(size_t));
+  MCKGroupSamples samples;
+  samples.pickup = malloc(runs * sizeof(double));
+  samples.move = malloc(runs * MCK_GROUP_MOVES * sizeof(double));
+  samples.end = malloc(runs * sizeof(double));
+  size_t failures = 0;
+
+  printf("[");
+  for (int mode = MCKGroupModeReparenting; mode <= MCKGroupModeSessionPerItem; ++mode) {
+    for (int absorb = 1; absorb >= 0; --absorb) {
+      samples.moves = samples.frameDrops = samples.failures = 0;
+      srand(1);
+      for (size_t run = 0; run < runs; ++run) {
+        // items distinct cards, at random
+        for (size_t i = 0; i < MCK_GROUP_CARDS; ++i)
+          picks[i] = i;
+        for (size_t i = 0; i < items; ++i) {
+          size_t j = i + (size_t)rand() % (MCK_GROUP_CARDS - i);
+          size_t pick = picks[j];
+          picks[j] = picks[i];
+          picks[i] = pick;
+        }
+        MCKGroupRun(mode, absorb, picks, items, run, sessions, others, steps, &samples);
+      }
+      MCKLatencySummary pickup = MCKLatencySummarize(samples.pickup, runs);
+      MCKLatencySummary move = MCKLatencySummarize(samples.move, samples.moves);
+      MCKLatencySummary end = MCKLatencySummarize(samples.end, runs);
+      failures += samples.failures;
+
+      printf(mode == 0 && absorb ? "\n" : ",\n");
+      printf("{\"mode\":\"%s\",\"end\":\"%s\",\"items\":%zu,\"runs\":%zu,",
+             MCKGroupModeNames[mode], absorb ? "absorb" : "reclaim", items, runs);
+      MCKLatencySummaryWriteJSON("pickup", pickup, stdout);
+      putchar(',');
+      MCKLatencySummaryWriteJSON("move", move, stdout);
+      putchar(',');
+      MCKLatencySummaryWriteJSON(absorb ? "drop" : "reclaim", end, stdout);
+      printf(",\"frame_drops\":%zu,\"frames\":%zu,\"failures\":%zu}",
+             samples.frameDrops, runs * (MCK_GROUP_MOVES + 2), samples.failures);
+      fprintf(stderr, "%-16s %-7s %4zu items  pickup p50 %8.1f us  move p50 %8.1f us  %s p50 %8.1f us"
+              "  %zu/%zu frames dropped\n",
+              MCKGroupModeNames[mode], absorb ? "absorb" : "reclaim", items, pickup.p50 * 1e6, move.p50 * 1e6,
+              absorb ? "drop   " : "reclaim", end.p50 * 1e6, samples.frameDrops, runs * (MCK_GROUP_MOVES + 2));
+    }
+  }
+  printf("\n]\n");
+
+  free(samples.pickup);
+  free(samples.move);
+  free(samples.end);
+  free(picks);
+  free(steps);
+  free(others);
+  free(sessions);
+  if ( failures > 0 )
+    fprintf(stderr, "%zu runs did not move every card\n", failures);
+  return failures > 0;
+}
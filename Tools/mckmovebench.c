@@ -0,0 +1,106 @@
+//
+//  mckmovebench.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-22.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+//  Measures how far a dragged view lags the finger, with and without the move
+//  pipeline and its prediction, off device (see MCKMovePipeline.h):
+//
+//    cd DragDropSpike
+//    cc -std=c99 -O2 -I. -o mckmovebench ../Tools/mckmovebench.c MCKMovePipeline.c MCKSessionTrace.c -lm
+//
+//    mckmovebench [options] > results.json
+//
+//  For each touch rate and display rate, a simulated finger drags a view
+//  around a circle three times: with each touch event applied as it comes,
+//  with the events coalesced to one move per refresh, and coalesced with a
+//  prediction of the touch latency plus one refresh. The results are a JSON
+//  array of one object per run, on stdout; a summary goes to stderr. The exit
+//  status is 1 if a coalesced run moved the view more than once per refresh.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MCKMovePipeline.h"
+
+static const double MCKMoveTouchRates[] = { 60, 120, 240 };
+static const double MCKMoveDisplayRates[] = { 60, 120 };
+
+typedef enum {
+  MCKMoveModeDirect,
+  MCKMoveModeCoalesce,
+  MCKMoveModePredict,
+} MCKMoveMode;
+
+static const char * const MCKMoveModeNames[] = { "direct", "coalesce", "predict" };
+
+static int MCKUsage(void)
+{
+  fprintf(stderr,
+          "usage: mckmovebench [options]\n"
+          "  --duration S        seconds of each drag (5)\n"
+          "  --speed F           finger speed, in points per second (600)\n"
+          "  --radius F          radius of the finger's circle, in points (150)\n"
+          "  --jitter F          largest error of a touch position, in points (0.5)\n"
+          "  --latency S         seconds from a touch to its event (0.012)\n"
+          "  --seed N            seed of the jitter (1)\n");
+  return 2;
+}
+
+int main(int argc, char * argv[])
+{
+  MCKMoveSimulationSpec spec = { 0, 0, 5, 600, 150, 0.5, 0.012, 0, false, 1 };
+
+  for (int i = 1; i < argc; ++i) {
+    const char * option = argv[i];
+    const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+    if ( !value )
+      return MCKUsage();
+    if ( strcmp(option, "--duration") == 0 ) spec.duration = strtod(value, NULL);
+    else if ( strcmp(option, "--speed") == 0 ) spec.speed = strtod(value, NULL);
+    else if ( strcmp(option, "--radius") == 0 ) spec.radius = strtod(value, NULL);
+    else if ( strcmp(option, "--jitter") == 0 ) spec.jitter = strtod(value, NULL);
+    else if ( strcmp(option, "--latency") == 0 ) spec.touch_latency = strtod(value, NULL);
+    else if ( strcmp(option, "--seed") == 0 ) spec.seed = (unsigned)strtoul(value, NULL, 10);
+    else return MCKUsage();
+    ++i;
+  }
+
+  size_t failures = 0;
+  bool first = true;
+  printf("[");
+  for (size_t d = 0; d < sizeof(MCKMoveDisplayRates) / sizeof(MCKMoveDisplayRates[0]); ++d) {
+    for (size_t t = 0; t < sizeof(MCKMoveTouchRates) / sizeof(MCKMoveTouchRates[0]); ++t) {
+      for (MCKMoveMode mode = MCKMoveModeDirect; mode <= MCKMoveModePredict; ++mode) {
+        spec.touch_rate = MCKMoveTouchRates[t];
+        spec.display_rate = MCKMoveDisplayRates[d];
+        spec.coalesce = mode != MCKMoveModeDirect;
+        spec.prediction = mode == MCKMoveModePredict ? spec.touch_latency + 1 / spec.display_rate : 0;
+        MCKMoveSimulationReport report;
+        MCKMovePipelineSimulate(&spec, &report);
+        if ( spec.coalesce && report.moves > report.frames )
+          failures++;
+
+        printf(first ? "\n" : ",\n");
+        first = false;
+        printf("{\"mode\":\"%s\",\"touch_rate\":%g,\"display_rate\":%g,\"prediction\":%g,\"touches\":%zu,"
+               "\"moves\":%zu,\"frames\":%zu,\"mean_error\":%.3f,\"p99_error\":%.3f,\"max_error\":%.3f}",
+               MCKMoveModeNames[mode], spec.touch_rate, spec.display_rate, spec.prediction, report.touches,
+               report.moves, report.frames, report.mean_error, report.p99_error, report.max_error);
+        fprintf(stderr, "touch %3.0f Hz  display %3.0f Hz  %-8s  %5zu touches  %5zu moves  "
+                "error mean %6.2f  p99 %6.2f  max %6.2f pt\n",
+                spec.touch_rate, spec.display_rate, MCKMoveModeNames[mode], report.touches, report.moves,
+                report.mean_error, report.p99_error, report.max_error);
+      }
+    }
+  }
+  printf("\n]\n");
+
+  if ( failures > 0 )
+    fprintf(stderr, "%zu coalesced runs moved the view more than once per refresh\n", failures);
+  return failures > 0;
+}
@@ -0,0 +1,187 @@
+//
+//  mckreplaybench.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-13.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+//  Replays DnD session traces against headless scenes, off device, and prints
+//  the latency percentiles of pickups, moves and drops (see MCKTraceReplay.h):
+//
+//    cd DragDropSpike
+//    cc -std=c99 -O2 -I. -o mckreplaybench ../Tools/mckreplaybench.c MCKTraceReplay.c MCKSessionTrace.c
+//       MCKNodeTree.c MCKDragDropCore.c MCKSessionMetrics.c -lm
+//
+//    mckreplaybench [options] > results.json
+//
+//  By default, it runs the suite: synthetic traces recorded over small, medium
+//  and large scenes, with single-view and grouped drags, then replayed against
+//  fresh copies of their scenes. With --trace, it replays a trace file instead,
+//  recorded on a device or with --save, against the synthetic scene given by
+//  the scene options, which must have the shape of the recorded one.
+//
+//  The results are a JSON array of one object per replay, on stdout; a
+//  summary goes to stderr. The exit status is 1 if any replay diverged from
+//  its trace.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MCKTraceReplay.h"
+
+typedef struct {
+  const char * name;
+  MCKSyntheticSceneSpec scene;
+} MCKReplaySuiteScene;
+
+static const MCKReplaySuiteScene MCKReplaySuite[] = {
+  { "small",  { 4, 25, 16, 2, 1, 1 } },
+  { "medium", { 20, 50, 40, 4, 3, 1 } },
+  { "large",  { 50, 200, 200, 8, 5, 1 } },
+};
+
+static const size_t MCKReplaySuiteGroupSizes[] = { 1, 8 };
+
+static int MCKUsage(void)
+{
+  fprintf(stderr,
+          "usage: mckreplaybench [options]\n"
+          "  --drags N           drags of each synthetic trace (2000)\n"
+          "  --moves N           moves of each drag (20)\n"
+          "  --seed N            seed of the scenes and drags (1)\n"
+          "  --save FILE         also write the trace of the last suite run to FILE\n"
+          "  --trace FILE        replay FILE instead of the suite, against the scene:\n"
+          "  --donors N          donor columns (20)\n"
+          "  --items N           draggables in each donor (50)\n"
+          "  --absorbers N       absorbers (40)\n"
+          "  --depth N           nested absorbers in each absorber (4)\n"
+          "  --fillers N         plain nodes over each absorber (3)\n");
+  return 2;
+}
+
+/* Replays length bytes of trace against a new scene of spec, and writes its report */
+static bool MCKReplayAndReport(const char * name, const MCKSyntheticSceneSpec * spec, size_t groupSize,
+                               const unsigned char * bytes, size_t length, bool first, size_t * divergences)
+{
+  MCKNode * scene = MCKSyntheticSceneCreate(spec);
+  MCKReplayReport report;
+  bool read = MCKTraceReplay(bytes, length, scene, &report);
+  MCKNodeDestroy(scene);
+  if ( !read ) {
+    fprintf(stderr, "%s: not a readable trace\n", name);
+    return false;
+  }
+  *divergences += report.divergences;
+
+  printf(first ? "\n" : ",\n");
+  printf("{\"scene\":\"%s\",\"donors\":%zu,\"items_per_donor\":%zu,\"absorbers\":%zu,\"absorber_depth\":%zu,"
+         "\"fillers\":%zu,\"seed\":%u,\"group_size\":%zu,\"trace_bytes\":%zu,\"events\":%zu,"
+         "\"divergences\":%zu,\"reparents\":%zu,",
+         name, spec->donors, spec->items_per_donor, spec->absorbers, spec->absorber_depth, spec->fillers,
+         spec->seed, groupSize, length, report.events, report.divergences, report.reparents);
+  MCKLatencySummaryWriteJSON("pickup", report.pickup, stdout);
+  putchar(',');
+  MCKLatencySummaryWriteJSON("move", report.move, stdout);
+  putchar(',');
+  MCKLatencySummaryWriteJSON("drop", report.drop, stdout);
+  printf("}");
+  fflush(stdout);
+
+  fprintf(stderr, "%-8s group %2zu  %7zu events  pickup p50 %7.2f p99 %7.2f us  move p50 %7.2f p99 %7.2f us"
+          "  drop p50 %7.2f p99 %7.2f us  %zu divergences\n",
+          name, groupSize, report.events, report.pickup.p50 * 1e6, report.pickup.p99 * 1e6,
+          report.move.p50 * 1e6, report.move.p99 * 1e6, report.drop.p50 * 1e6, report.drop.p99 * 1e6,
+          report.divergences);
+  return true;
+}
+
+static unsigned char * MCKReadFile(const char * path, size_t * length)
+{
+  FILE * file = fopen(path, "rb");
+  if ( !file )
+    return NULL;
+  size_t capacity = 1 << 16;
+  unsigned char * bytes = malloc(capacity);
+  *length = 0;
+  size_t n;
+  while ( (n = fread(bytes + *length, 1, capacity - *length, file)) > 0 ) {
+    *length += n;
+    if ( *length == capacity )
+      bytes = realloc(bytes, capacity *= 2);
+  }
+  fclose(file);
+  return bytes;
+}
+
+int main(int argc, char * argv[])
+{
+  size_t drags = 2000, moves = 20;
+  unsigned seed = 1;
+  const char * tracePath = NULL, * savePath = NULL;
+  MCKSyntheticSceneSpec traceScene = MCKReplaySuite[1].scene;
+
+  for (int i = 1; i < argc; ++i) {
+    const char * option = argv[i];
+    const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+    if ( !value )
+      return MCKUsage();
+    if ( strcmp(option, "--drags") == 0 ) drags = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--moves") == 0 ) moves = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--seed") == 0 ) seed = traceScene.seed = (unsigned)strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--save") == 0 ) savePath = value;
+    else if ( strcmp(option, "--trace") == 0 ) tracePath = value;
+    else if ( strcmp(option, "--donors") == 0 ) traceScene.donors = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--items") == 0 ) traceScene.items_per_donor = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--absorbers") == 0 ) traceScene.absorbers = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--depth") == 0 ) traceScene.absorber_depth = strtoul(value, NULL, 10);
+    else if ( strcmp(option, "--fillers") == 0 ) traceScene.fillers = strtoul(value, NULL, 10);
+    else return MCKUsage();
+    ++i;
+  }
+
+  size_t divergences = 0;
+  bool ok = true;
+  printf("[");
+  if ( tracePath ) {
+    size_t length = 0;
+    unsigned char * bytes = MCKReadFile(tracePath, &length);
+    if ( !bytes ) {
+      fprintf(stderr, "could not read %s\n", tracePath);
+      return 2;
+    }
+    ok = MCKReplayAndReport(tracePath, &traceScene, 0, bytes, length, true, &divergences);
+    free(bytes);
+  }
+  else {
+    bool first = true;
+    MCKTraceRecorder * recorder = MCKTraceRecorderCreate(NULL);
+    for (size_t s = 0; s < sizeof(MCKReplaySuite) / sizeof(MCKReplaySuite[0]); ++s) {
+      MCKSyntheticSceneSpec spec = MCKReplaySuite[s].scene;
+      spec.seed = seed;
+      for (size_t g = 0; g < sizeof(MCKReplaySuiteGroupSizes) / sizeof(MCKReplaySuiteGroupSizes[0]); ++g) {
+        MCKTraceRecorderReset(recorder);
+        MCKNode * scene = MCKSyntheticSceneCreate(&spec);
+        MCKSyntheticTraceRecord(scene, drags, MCKReplaySuiteGroupSizes[g], moves, seed, recorder);
+        MCKNodeDestroy(scene);
+
+        size_t length = 0;
+        const unsigned char * bytes = MCKTraceRecorderBytes(recorder, &length);
+        ok &= MCKReplayAndReport(MCKReplaySuite[s].name, &spec, MCKReplaySuiteGroupSizes[g], bytes, length,
+                                 first, &divergences);
+        first = false;
+        if ( savePath ) {
+          FILE * file = fopen(savePath, "wb");
+          if ( !file || fwrite(bytes, 1, length, file) != length )
+            fprintf(stderr, "could not write %s\n", savePath);
+          if ( file )
+            fclose(file);
+        }
+      }
+    }
+    MCKTraceRecorderDestroy(recorder);
+  }
+  printf("\n]\n");
+  return !ok || divergences > 0;
+}
@@ -0,0 +1,123 @@
+//
+//  mckscalebench.c
+//  DragDropSpike
+//
+//  Created by Alexis Gallagher on 2012-08-29.
+//  Copyright (c) 2012 McKinsey. All rights reserved.
+//
+//  Sweeps DnD sessions over synthetic scenes of growing size, off device, and
+//  checks each of their decisions against a reference (see MCKScaleBenchmark.h):
+//
+//    cd DragDropSpike
+//    cc -std=c99 -O2 -I. -o mckscalebench ../Tools/mckscalebench.c MCKScaleBenchmark.c MCKNodeTree.c
+//       MCKDragDropCore.c MCKTraceReplay.c MCKSessionTrace.c MCKSessionMetrics.c -lm
+//
+//    mckscalebench [options] > results.json
+//
+//  Each scene has fan-out children per node and one more level than the last,
+//  from --min-depth to --max-depth. With the defaults, that is 110 to 111110
+//  views. The results are a JSON array of one object per scene, on stdout or
+//  in the file given with --output; a summary goes to stderr. The exit status is 1 if any decision differed from
+//  the reference.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "MCKScaleBenchmark.h"
+
+static int MCKUsage(void)
+{
+  fprintf(stderr,
+          "usage: mckscalebench [options]\n"
+          "  --fan-out N         children of each node (10)\n"
+          "  --min-depth N       depth of the smallest scene (2)\n"
+          "  --max-depth N       depth of the largest scene (5)\n"
+          "  --max-views N       cap on the views of each scene (none)\n"
+          "  --donors F          share of nodes which are donors (0.5)\n"
+          "  --absorbers F       share of nodes which are absorbers (0.3)\n"
+          "  --inert F           share of nodes hidden or ignoring touches (0.05)\n"
+          "  --overlap F         how far siblings spill over each other (0.2)\n"
+          "  --drags N           drags in each scene (500)\n"
+          "  --moves N           moves in each drag (10)\n"
+          "  --acceptance F      share of drops absorbers accept (0.75)\n"
+          "  --no-hover          resolve the absorber at the drop only\n"
+          "  --proxies           drag proxies of the views\n"
+          "  --seed N            seed of the scenes and drags (1)\n"
+          "  --output FILE       write the results to FILE instead of stdout\n");
+  return 2;
+}
+
+int main(int argc, char * argv[])
+{
+  MCKScaleSceneSpec scene = MCKScaleSceneSpecDefault;
+  MCKScaleRunSpec run = MCKScaleRunSpecDefault;
+  size_t minDepth = 2, maxDepth = 5;
+  const char * outputPath = NULL;
+
+  for (int i = 1; i < argc; ++i) {
+    const char * option = argv[i];
+    const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+    if ( strcmp(option, "--no-hover") == 0 )
+      run.hover_tracking = false;
+    else if ( strcmp(option, "--proxies") == 0 )
+      run.drag_proxies = true;
+    else if ( !value )
+      return MCKUsage();
+    else {
+      if ( strcmp(option, "--fan-out") == 0 ) scene.fan_out = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--min-depth") == 0 ) minDepth = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--max-depth") == 0 ) maxDepth = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--max-views") == 0 ) scene.max_views = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--donors") == 0 ) scene.donor_density = strtod(value, NULL);
+      else if ( strcmp(option, "--absorbers") == 0 ) scene.absorber_density = strtod(value, NULL);
+      else if ( strcmp(option, "--inert") == 0 ) scene.inert_density = strtod(value, NULL);
+      else if ( strcmp(option, "--overlap") == 0 ) scene.overlap = strtod(value, NULL);
+      else if ( strcmp(option, "--drags") == 0 ) run.drags = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--moves") == 0 ) run.moves = strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--acceptance") == 0 ) run.acceptance = strtod(value, NULL);
+      else if ( strcmp(option, "--seed") == 0 ) scene.seed = run.seed = (unsigned)strtoul(value, NULL, 10);
+      else if ( strcmp(option, "--output") == 0 ) outputPath = value;
+      else return MCKUsage();
+      ++i;
+    }
+  }
+  if ( minDepth > maxDepth )
+    return MCKUsage();
+  FILE * output = outputPath ? fopen(outputPath, "w") : stdout;
+  if ( !output ) {
+    fprintf(stderr, "could not write %s\n", outputPath);
+    return 2;
+  }
+
+  size_t mismatches = 0;
+  fprintf(output, "[");
+  for (size_t depth = minDepth; depth <= maxDepth; ++depth) {
+    scene.depth = depth;
+    double start = MCKTraceNow();
+    MCKNode * root = MCKScaleSceneCreate(&scene, NULL);
+    double buildTime = MCKTraceNow() - start;
+
+    MCKScaleReport report;
+    MCKScaleBenchmarkRun(root, &scene, &run, &report);
+    report.build_time = buildTime;
+    MCKNodeDestroy(root);
+
+    fprintf(output, depth == minDepth ? "\n" : ",\n");
+    MCKScaleReportWriteJSON(&report, output);
+    fflush(output);
+    mismatches += MCKScaleReportMismatches(&report);
+    fprintf(stderr, "%7zu views  %5zu sessions  move p50 %7.2f us  p99 %7.2f us  drop p99 %7.2f us"
+            "  %9.0f sessions/s  %zu/%zu mismatches\n",
+            report.views, report.pickups, report.move.p50 * 1e6, report.move.p99 * 1e6,
+            report.drop.p99 * 1e6, report.sessions_per_second,
+            MCKScaleReportMismatches(&report), report.checks);
+  }
+  fprintf(output, "\n]\n");
+  if ( output != stdout && fclose(output) != 0 ) {
+    fprintf(stderr, "could not write %s\n", outputPath);
+    return 2;
+  }
+  return mismatches > 0;
+}